@@ -46,6 +46,9 @@ static unsigned _nblocks = 128;
 static unsigned _nblocks = 4096;
 #endif
 static unsigned _entries_per_block = 1024;
+/* Benchmark mode: number of dot products to compute and time */
+static unsigned _niter = 1;
+static int _bench = 0;
 
 static DOT_TYPE _dot = 0.0f;
 static starpu_data_handle_t _dot_handle;
@@ -322,14 +325,43 @@ static struct starpu_codelet dot_codelet =
 	.name = "dot"
 };
 
+static void parse_args(int argc, char **argv)
+{
+	int i;
+	for (i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "-nblocks") == 0 && i+1 < argc)
+		{
+			_nblocks = atoi(argv[++i]);
+		}
+		else if (strcmp(argv[i], "-entries") == 0 && i+1 < argc)
+		{
+			_entries_per_block = atoi(argv[++i]);
+		}
+		else if (strcmp(argv[i], "-bench") == 0 && i+1 < argc)
+		{
+			_bench = 1;
+			_niter = atoi(argv[++i]);
+		}
+		else
+		{
+			fprintf(stderr, "Usage: %s [-nblocks n] [-entries n] [-bench niter]\n", argv[0]);
+			fprintf(stderr, "-bench computes the dot product niter times, and reports the time taken by each of them, including the reduction\n");
+			exit(EXIT_FAILURE);
+		}
+	}
+}
+
 /*
  *	Tasks initialization
  */
 
-int main(void)
+int main(int argc, char **argv)
 {
 	int ret;
 
+	parse_args(argc, argv);
+
 	/* Not supported yet */
 	if (starpu_getenv_number_default("STARPU_GLOBAL_ARBITER", 0) > 0)
 		return 77;
@@ -402,21 +434,45 @@ int main(void)
 	 */
 	starpu_data_set_reduction_methods(_dot_handle, &redux_codelet, &init_codelet);
 
-	for (block = 0; block < _nblocks; block++)
+	unsigned iter;
+	double timing = 0.;
+	for (iter = 0; iter < _niter; iter++)
 	{
-		struct starpu_task *task = starpu_task_create();
-
-		task->cl = &dot_codelet;
-		task->destroy = 1;
-
-		task->handles[0] = _x_handles[block];
-		task->handles[1] = _y_handles[block];
-		task->handles[2] = _dot_handle;
+		double start = starpu_timing_now();
+
+		for (block = 0; block < _nblocks; block++)
+		{
+			struct starpu_task *task = starpu_task_create();
+
+			task->cl = &dot_codelet;
+			task->destroy = 1;
+
+			task->handles[0] = _x_handles[block];
+			task->handles[1] = _y_handles[block];
+			task->handles[2] = _dot_handle;
+
+			ret = starpu_task_submit(task);
+			if (ret == -ENODEV) goto enodev;
+			STARPU_ASSERT(!ret);
+		}
+
+		if (_bench)
+		{
+			/* Wait for the reduction */
+			ret = starpu_data_acquire(_dot_handle, STARPU_R);
+			STARPU_CHECK_RETURN_VALUE(ret, "starpu_data_acquire");
+			starpu_data_release(_dot_handle);
+			timing += starpu_timing_now() - start;
+		}
+	}
 
-		ret = starpu_task_submit(task);
-		if (ret == -ENODEV) goto enodev;
-		STARPU_ASSERT(!ret);
+	if (_bench)
+	{
+		FPRINTF(stdout, "# nblocks\tentries\tus/dot\tGFlop/s\n");
+		FPRINTF(stdout, "%u\t%u\t%.2f\t%.3f\n", _nblocks, _entries_per_block, timing / _niter,
+			(2. * nelems * _niter) / timing / 1000.);
 	}
+	reference_dot *= _niter;
 
 	for (block = 0; block < _nblocks; block++)
 	{
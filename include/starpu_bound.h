@@ -62,6 +62,32 @@ void starpu_bound_print_dot(FILE *output);
 */
 void starpu_bound_compute(double *res, double *integer_res, int integer);
 
+/**
+   Get the bounds (in ms) which are computed on the fly while tasks are
+   recorded, without needing glpk nor keeping the task graph: \p
+   critical_path gets the length of the longest chain of dependent tasks,
+   each task taking its fastest expected duration, \p area gets the sum
+   of these durations divided by the number of workers, and if \p
+   per_arch_area is not <c>NULL</c>, it gets for each of the
+   ::STARPU_NARCH worker types the time needed to run all tasks with
+   only the workers of this type (<c>INFINITY</c> if they can not run
+   some of them). Task dependencies are taken into account even if \p
+   deps was not set in starpu_bound_start(), but tag dependencies and
+   dependencies on tasks submitted later are not. These bounds are also
+   available through the performance counters
+   <c>starpu.bound.g_critical_path</c>, <c>starpu.bound.g_area</c> and
+   <c>starpu.bound.g_<arch>_area</c>.
+
+   Return 0 if the expected durations of all the recorded tasks were
+   known, and <c>-EAGAIN</c> if some performance models were not
+   calibrated yet, in which case the corresponding tasks were counted
+   with only their known durations, and the bounds are incomplete
+   (performance counter <c>starpu.bound.g_incomplete</c>).
+
+   See \ref TheoreticalLowerBoundOnExecutionTime for more details.
+*/
+int starpu_bound_compute_critical_path(double *critical_path, double *area, double *per_arch_area);
+
 /**
    Emit the Linear Programming system on \p output for the recorded
    tasks, in the lp format
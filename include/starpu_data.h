@@ -215,6 +215,15 @@ void starpu_data_unregister_no_coherency(starpu_data_handle_t handle);
 */
 void starpu_data_unregister_submit(starpu_data_handle_t handle);
 
+/**
+   Same as starpu_data_unregister_submit() for the \p nhandles handles of the
+   array \p handles, but wait for the tasks working on all of them at once,
+   instead of submitting a synchronization for each of them. This is notably
+   meant for the handles registered with starpu_data_register_array(), whose
+   memory is freed as a whole once the last of them is destroyed.
+*/
+void starpu_data_unregister_submit_array(unsigned nhandles, starpu_data_handle_t *handles);
+
 /**
    Deinitialize all replicates of the data \p handle immediately. After
    data deinitialization, the first access to \p handle must be performed
@@ -325,6 +334,19 @@ int starpu_data_acquire_cb(starpu_data_handle_t handle, enum starpu_data_access_
 */
 int starpu_data_acquire_on_node_cb(starpu_data_handle_t handle, int node, enum starpu_data_access_mode mode, void (*callback)(void *), void *arg);
 
+/**
+   Similar to starpu_data_acquire_on_node_cb(), but acquire the \p nhandles
+   handles of the array \p handles at once, and call \p callback only once,
+   when all of them are available on the memory \p node. The implicit data
+   dependencies of all handles are enforced with a single synchronization
+   task, which terminates only once all handles are released, so
+   starpu_task_wait_for_all() must not be called before that. The fetches
+   are started with the longest expected transfers first. The handles must
+   be distinct, and released with starpu_data_release_on_node() or
+   starpu_data_release_on_node_array(). See \ref DataAccess for more details.
+*/
+int starpu_data_acquire_on_node_array_cb(unsigned nhandles, starpu_data_handle_t *handles, int node, enum starpu_data_access_mode mode, void (*callback)(void *), void *arg);
+
 /**
    Similar to starpu_data_acquire_cb() with the possibility of
    enabling or disabling data dependencies.
@@ -423,6 +445,13 @@ void starpu_data_release(starpu_data_handle_t handle);
 */
 void starpu_data_release_on_node(starpu_data_handle_t handle, int node);
 
+/**
+   Release the \p nhandles handles of the array \p handles, acquired on the
+   given memory \p node by starpu_data_acquire_on_node_array_cb() for
+   instance. See \ref DataAccess for more details.
+*/
+void starpu_data_release_on_node_array(unsigned nhandles, starpu_data_handle_t *handles, int node);
+
 /**
    Partly release the piece of data acquired by the application either by
    starpu_data_acquire() or by starpu_data_acquire_cb(), switching the
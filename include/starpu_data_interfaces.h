@@ -738,6 +738,20 @@ struct starpu_data_interface_ops
 */
 void starpu_data_register(starpu_data_handle_t *handleptr, int home_node, void *data_interface, struct starpu_data_interface_ops *ops);
 
+/**
+   Register \p nhandles pieces of data at once, located in the same
+   \p home_node, into the handles of the array \p handleptrs. \p data_interfaces
+   is an array of \p nhandles interfaces of type \p ops, e.g. an array of
+   struct starpu_matrix_interface, each of them containing the description of
+   one piece of data as for starpu_data_register().
+
+   The handles are allocated as a whole, and can be unregistered at once with
+   starpu_data_unregister_submit_array(). When there are many of them, they
+   are initialized by \ref STARPU_PARTITION_NTHREADS threads, the
+   \c register_data_handle method of \p ops must then be thread-safe.
+*/
+void starpu_data_register_array(unsigned nhandles, starpu_data_handle_t *handleptrs, int home_node, void *data_interfaces, struct starpu_data_interface_ops *ops);
+
 /**
    Register the given data interface operations. If the field
    starpu_data_interface_ops::field is set to
@@ -137,6 +137,58 @@ struct starpu_disk_ops
 	*/
 	void (*free_request)(void *async_channel);
 
+	/**
+	   Map \p size bytes of data of \p obj in \p base, at offset \p
+	   offset, in the address space of the process. The mapping must be
+	   shared with the data on the disk, so that it can be used in main
+	   memory in place of a copy of the data. Return NULL if it could not
+	   be mapped. This method is optional, and only used when \ref
+	   STARPU_ENABLE_MAP is set.
+	*/
+	void *(*map)(void *base, void *obj, off_t offset, size_t size);
+	/**
+	   Write back to the disk the modifications made through the mapping
+	   \p ptr returned by starpu_disk_ops::map for \p obj, \p offset and
+	   \p size. Return 0 on success.
+	*/
+	int (*sync)(void *base, void *obj, void *ptr, off_t offset, size_t size);
+	/**
+	   Remove the mapping \p ptr returned by starpu_disk_ops::map for \p
+	   obj, \p offset and \p size.
+	*/
+	void (*unmap)(void *base, void *obj, void *ptr, off_t offset, size_t size);
+
+	/**
+	   Create a location of data of size \p size at a specific position
+	   \p pos dependent on the backend, which is kept when closing it,
+	   and can thus be opened again later with starpu_disk_ops::open.
+	   If it already exists, it is truncated to \p size. Return an
+	   opaque object pointer, or NULL on failure. This method is
+	   optional, and only needed for the persistent store, see
+	   starpu_disk_store_create().
+	*/
+	void *(*create)(void *base, void *pos, size_t size);
+	/**
+	   Rename the location of data at position \p pos, which is not
+	   opened, to the position \p new_pos, replacing any location at
+	   \p new_pos atomically. The content at \p pos must be flushed to
+	   the disk first, so that \p new_pos never gets an incomplete
+	   content, even on a crash. Return 0 on success. This method is
+	   optional, and only needed for the persistent store, see
+	   starpu_disk_store_create().
+	*/
+	int (*rename)(void *base, void *pos, void *new_pos);
+	/**
+	   Tell that the \p size bytes of \p obj in \p base at offset \p
+	   offset do not need to be kept, so that the backend can release
+	   the corresponding disk space, e.g. by punching a hole in the
+	   file. Reading them afterwards returns zeroes. Return 0 on
+	   success. This method is optional, it is used by
+	   #starpu_disk_compress_ops to release the room left by chunks
+	   which got compressed better than before.
+	*/
+	int (*discard)(void *base, void *obj, off_t offset, size_t size);
+
 	/* TODO: readv, writev, read2d, write2d, etc. */
 };
 
@@ -176,12 +228,132 @@ extern struct starpu_disk_ops starpu_disk_unistd_ops;
 */
 extern struct starpu_disk_ops starpu_disk_unistd_o_direct_ops;
 
+/**
+   Use the unistd library (write, read...) to read/write on disk, and
+   mmap() to map data in main memory instead of reading them, when \ref
+   STARPU_ENABLE_MAP is set. The kernel page cache then holds the data
+   used in main memory.
+
+   <strong>Warning: It creates one file per allocation !</strong>
+*/
+extern struct starpu_disk_ops starpu_disk_mmap_ops;
+
 /**
    Use the leveldb created by Google. More information at https://code.google.com/p/leveldb/
    Do not support asynchronous transfers.
 */
 extern struct starpu_disk_ops starpu_disk_leveldb_ops;
 
+/**
+   Use one single file, preallocated to the size of the disk and grown if
+   needed, in which data are stored at offsets managed by an allocator
+   which coalesces free ranges. This avoids creating one file per
+   allocation.
+
+   Does not support opening existing data with starpu_disk_open().
+*/
+extern struct starpu_disk_ops starpu_disk_slab_ops;
+
+/**
+   Statistics about the space management of a disk registered with
+   ::starpu_disk_slab_ops, see starpu_disk_slab_get_stats().
+*/
+struct starpu_disk_slab_stats
+{
+	size_t file_size;	/**< Current size of the file */
+	size_t used;		/**< Space used by data */
+	size_t free;		/**< Free space between data */
+	size_t largest_free;	/**< Size of the largest free range, 1 - largest_free/free measures the fragmentation */
+	unsigned nobjects;	/**< Number of data stored */
+	unsigned nfree_extents;	/**< Number of free ranges between data */
+	unsigned long ncoalesced;	/**< Number of times free ranges were merged */
+};
+
+/**
+   Fill \p stats with the statistics of the disk memory node \p node,
+   which must have been registered with ::starpu_disk_slab_ops. Return
+   -EINVAL otherwise.
+*/
+int starpu_disk_slab_get_stats(unsigned node, struct starpu_disk_slab_stats *stats);
+
+/**
+   Codec used by ::starpu_disk_compress_ops to compress data, see
+   starpu_disk_compress_parameter::codec.
+*/
+struct starpu_disk_compress_codec
+{
+	/**
+	   Name of the codec, for the statistics
+	*/
+	const char *name;
+	/**
+	   Compress \p src_size bytes from \p src into \p dst, which
+	   can hold \p dst_size bytes. Return the size of the compressed
+	   data, or 0 if it does not fit in \p dst.
+	*/
+	size_t (*compress)(const void *src, size_t src_size, void *dst, size_t dst_size);
+	/**
+	   Decompress \p src_size bytes from \p src into \p dst, which
+	   must get exactly \p dst_size bytes. Return 0 on success.
+	*/
+	int (*decompress)(const void *src, size_t src_size, void *dst, size_t dst_size);
+};
+
+/**
+   Built-in codec used by default by ::starpu_disk_compress_ops. It is a
+   simple LZ77 variant which favors speed over compression ratio, and
+   is efficient for data with runs of zeroes or repeated values.
+*/
+extern struct starpu_disk_compress_codec starpu_disk_compress_lz_codec;
+
+/**
+   Parameter to be passed to starpu_disk_register() with
+   ::starpu_disk_compress_ops.
+*/
+struct starpu_disk_compress_parameter
+{
+	struct starpu_disk_ops *ops;	/**< Backend which actually stores the data */
+	void *parameter;		/**< Parameter to be passed to the \c plug method of \p ops */
+	struct starpu_disk_compress_codec *codec;	/**< Codec, or NULL for ::starpu_disk_compress_lz_codec */
+};
+
+/**
+   Compress data before storing them with another backend, given by a
+   struct starpu_disk_compress_parameter, and decompress them when
+   reading them back. Data are processed by chunks on a few threads, see
+   \ref STARPU_DISK_COMPRESS_NTHREADS, which also perform the
+   asynchronous transfers.
+
+   The underlying backend must support reading and writing arbitrary
+   sizes at arbitrary offsets, so it can not be
+   ::starpu_disk_unistd_o_direct_ops. Does not support opening existing
+   data with starpu_disk_open().
+*/
+extern struct starpu_disk_ops starpu_disk_compress_ops;
+
+/**
+   Statistics about the compression on a disk registered with
+   ::starpu_disk_compress_ops, see starpu_disk_compress_get_stats().
+   The compression ratio is \c written / \c written_stored.
+*/
+struct starpu_disk_compress_stats
+{
+	size_t written;		/**< Amount of data written */
+	size_t written_stored;	/**< Amount of data actually written to the underlying backend */
+	size_t read;		/**< Amount of data read */
+	size_t read_stored;	/**< Amount of data actually read from the underlying backend */
+	double compress_time;	/**< Time spent compressing, in µs */
+	double decompress_time;	/**< Time spent decompressing, in µs */
+	unsigned long nuncompressed;	/**< Number of chunks which were stored uncompressed since they could not be compressed */
+};
+
+/**
+   Fill \p stats with the statistics of the disk memory node \p node,
+   which must have been registered with ::starpu_disk_compress_ops.
+   Return -EINVAL otherwise.
+*/
+int starpu_disk_compress_get_stats(unsigned node, struct starpu_disk_compress_stats *stats);
+
 /**
    Close an existing data opened with starpu_disk_open(). See \ref OutOfCore_Introduction for more details.
 */
@@ -195,6 +367,44 @@ void starpu_disk_close(unsigned node, void *obj, size_t size);
 */
 void *starpu_disk_open(unsigned node, void *pos, size_t size);
 
+/**
+   Look up \p name in the persistent store of the disk node \p node,
+   and open it. The size of the data is returned in \p size. Return an
+   opaque object pointer, which can be used to register a handle on \p
+   node, and must be closed with starpu_disk_close(). Return NULL if
+   \p name is not in the store, and set \c errno to \c ENOENT, to \c
+   EINVAL if \p name is not a valid name or the index of the store is
+   corrupted, or to \c ENOTSUP if the backend of the disk does not
+   support the persistent store. See \ref OutOfCore_PersistentStore for
+   more details.
+*/
+void *starpu_disk_store_open(unsigned node, const char *name, size_t *size);
+
+/**
+   Create the data \p name of size \p size in the persistent store of
+   the disk node \p node, replacing any existing data with that name.
+   The data and its entry in the store are kept after closing it with
+   starpu_disk_close(), across executions. \p name must not contain
+   <c>/</c> or <c>..</c>. Return an opaque object pointer, or NULL on
+   failure, with \c errno set to \c EINVAL if \p name is not a valid
+   name or the index of the store is corrupted, to \c ENOTSUP if the
+   backend of the disk does not support the persistent store, or to
+   another error code if the data or the index could not be written. See \ref
+   OutOfCore_PersistentStore for more details.
+*/
+void *starpu_disk_store_create(unsigned node, const char *name, size_t size);
+
+/**
+   Remove the data \p name from the persistent store of the disk node
+   \p node, and delete it. It must not be opened. Return -ENOENT if
+   \p name is not in the store, -EINVAL if it is not a valid name or
+   the index of the store is corrupted, -ENOTSUP if the backend of the
+   disk does not support the persistent store, and another negative
+   error code if the index could not be written. See \ref
+   OutOfCore_PersistentStore for more details.
+*/
+int starpu_disk_store_remove(unsigned node, const char *name);
+
 /**
    Register a disk memory node with a set of functions to manipulate
    data. The \c plug member of \p func will be passed \p parameter,
@@ -205,6 +415,10 @@ void *starpu_disk_open(unsigned node, void *pos, size_t size);
    \p size must be at least \ref STARPU_DISK_SIZE_MIN bytes ! \p size
    being negative means infinite size.
 
+   Data handles only get room for the memory nodes present when the first
+   of them is registered, plus \ref STARPU_DISK_RESERVED_NODES, -ENOSPC is
+   returned when the disk does not fit any more.
+
    See \ref OutOfCore_Introduction for more details.
 */
 int starpu_disk_register(struct starpu_disk_ops *func, void *parameter, starpu_ssize_t size);
@@ -180,6 +180,16 @@ void starpu_perf_counter_set_enable_id(struct starpu_perf_counter_set *set, int
 */
 void starpu_perf_counter_set_disable_id(struct starpu_perf_counter_set *set, int id);
 
+/**
+   Only refresh the value of a given counter of the set every \p period
+   microseconds at most, instead of on each event. Listeners are still called
+   on each event, with the last refreshed value of the counter. This permits to
+   avoid the cost of computing counters which are expensive to aggregate, such
+   as the global and per-codelet task counters. Setting \p period to 0, the
+   default, refreshes the counter on each event again.
+*/
+void starpu_perf_counter_set_sample_period_id(struct starpu_perf_counter_set *set, int id, unsigned period);
+
 /**
    Initialize a new performance counter listener.
 */
@@ -118,6 +118,14 @@ extern "C" {
 */
 #define STARPU_CODELET_NOPLANS (1 << 2)
 
+/**
+   Value to be set in starpu_codelet::flags to let CPU workers execute
+   several ready tasks of the codelet in a row, in only one iteration of
+   their driver. This reduces the runtime overhead of very short tasks,
+   while keeping the semantic of each task. See \ref STARPU_CPU_COARSEN_MAX
+*/
+#define STARPU_CODELET_COARSEN (1 << 3)
+
 /**
    Value to be set in starpu_codelet::cuda_flags to allow asynchronous
    CUDA kernel execution. This requires to use the proper CUDA stream,
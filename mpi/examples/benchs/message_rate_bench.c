@@ -0,0 +1,164 @@
+/* StarPU --- Runtime system for heterogeneous multicore architectures.
+ *
+ * Copyright (C) 2023       Université de Bordeaux, CNRS (LaBRI UMR 5800), Inria
+ *
+ * StarPU is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or (at
+ * your option) any later version.
+ *
+ * StarPU is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU Lesser General Public License in COPYING.LGPL for more details.
+ */
+
+/*
+ * Measure the rate of small messages StarPU-MPI can emit: every node sends
+ * count messages to every other node, with detached requests.
+ *
+ * The number of progression threads can be selected with the
+ * STARPU_MPI_NPROGRESS_THREADS environment variable.
+ */
+
+#include <starpu_mpi.h>
+#include "helper.h"
+
+#define SERVER_PRINTF(fmt, ...) do { if(rank == 0) { printf(fmt, ## __VA_ARGS__); fflush(stdout); }} while(0)
+
+#ifdef STARPU_QUICK_CHECK
+#define COUNT_DEFAULT	100
+#define LOOPS_DEFAULT_MR	2
+#else
+#define COUNT_DEFAULT	2000
+#define LOOPS_DEFAULT_MR	10
+#endif
+
+static int count = COUNT_DEFAULT;
+static int size = 8;
+static int iterations = LOOPS_DEFAULT_MR;
+
+static void parse_args(int argc, char **argv)
+{
+	int i;
+	for (i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "-count") == 0)
+		{
+			count = atoi(argv[++i]);
+		}
+		else if (strcmp(argv[i], "-size") == 0)
+		{
+			size = atoi(argv[++i]);
+		}
+		else if (strcmp(argv[i], "-N") == 0)
+		{
+			iterations = atoi(argv[++i]);
+		}
+		else if (strcmp(argv[i], "-help") == 0 || strcmp(argv[i], "--help") == 0 || strcmp(argv[i], "-h") == 0)
+		{
+			fprintf(stderr,"Usage: %s [-count count] [-size size] [-N iterations]\n", argv[0]);
+			exit(EXIT_SUCCESS);
+		}
+		else
+		{
+			fprintf(stderr,"Unrecognized option %s\n", argv[i]);
+			exit(EXIT_FAILURE);
+		}
+	}
+}
+
+int main(int argc, char **argv)
+{
+	int ret, rank, worldsize;
+	int peer, x, k;
+	double total_time = 0.;
+
+	parse_args(argc, argv);
+
+	ret = starpu_mpi_init_conf(&argc, &argv, 1, MPI_COMM_WORLD, NULL);
+	STARPU_CHECK_RETURN_VALUE(ret, "starpu_mpi_init_conf");
+
+	starpu_mpi_comm_rank(MPI_COMM_WORLD, &rank);
+	starpu_mpi_comm_size(MPI_COMM_WORLD, &worldsize);
+
+	if (worldsize < 2)
+	{
+		if (rank == 0)
+			FPRINTF(stderr, "We need at least 2 processes.\n");
+
+		starpu_mpi_shutdown();
+		return rank == 0 ? STARPU_TEST_SKIPPED : 0;
+	}
+
+	SERVER_PRINTF("# nodes            = %d\n", worldsize);
+	SERVER_PRINTF("# progress threads = %d\n", starpu_getenv_number_default("STARPU_MPI_NPROGRESS_THREADS", 1));
+	SERVER_PRINTF("# count            = %d\n", count);
+	SERVER_PRINTF("# size             = %d\n", size);
+	SERVER_PRINTF("# iterations       = %d\n", iterations);
+
+	char *buffer;
+	starpu_data_handle_t *send_handles, *recv_handles;
+	buffer = calloc(2 * worldsize * count, size);
+	send_handles = calloc(worldsize * count, sizeof(*send_handles));
+	recv_handles = calloc(worldsize * count, sizeof(*recv_handles));
+
+	for (peer = 0; peer < worldsize; peer++)
+	{
+		if (peer == rank)
+			continue;
+		for (x = 0; x < count; x++)
+		{
+			int i = peer * count + x;
+			starpu_vector_data_register(&send_handles[i], STARPU_MAIN_RAM, (uintptr_t) &buffer[i * size], size, 1);
+			starpu_vector_data_register(&recv_handles[i], STARPU_MAIN_RAM, (uintptr_t) &buffer[(worldsize * count + i) * size], size, 1);
+		}
+	}
+
+	for (k = 0; k < iterations; k++)
+	{
+		double start, end;
+
+		starpu_mpi_barrier(MPI_COMM_WORLD);
+		start = starpu_timing_now();
+		for (x = 0; x < count; x++)
+		{
+			for (peer = 0; peer < worldsize; peer++)
+			{
+				if (peer == rank)
+					continue;
+				ret = starpu_mpi_irecv_detached(recv_handles[peer * count + x], peer, x, MPI_COMM_WORLD, NULL, NULL);
+				STARPU_CHECK_RETURN_VALUE(ret, "starpu_mpi_irecv_detached");
+				ret = starpu_mpi_isend_detached(send_handles[peer * count + x], peer, x, MPI_COMM_WORLD, NULL, NULL);
+				STARPU_CHECK_RETURN_VALUE(ret, "starpu_mpi_isend_detached");
+			}
+		}
+		starpu_mpi_wait_for_all(MPI_COMM_WORLD);
+		end = starpu_timing_now();
+		total_time += end - start;
+	}
+
+	total_time /= iterations;
+	SERVER_PRINTF("# time.us\tsent.msg/s\n");
+	SERVER_PRINTF("%.3f\t%.0f\n", total_time, (double) count * (worldsize - 1) / (total_time / 1000000.));
+
+	for (peer = 0; peer < worldsize; peer++)
+	{
+		if (peer == rank)
+			continue;
+		for (x = 0; x < count; x++)
+		{
+			starpu_data_unregister(send_handles[peer * count + x]);
+			starpu_data_unregister(recv_handles[peer * count + x]);
+		}
+	}
+
+	free(send_handles);
+	free(recv_handles);
+	free(buffer);
+
+	starpu_mpi_shutdown();
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,179 @@
+/* StarPU --- Runtime system for heterogeneous multicore architectures.
+ *
+ * Copyright (C) 2023       Université de Bordeaux, CNRS (LaBRI UMR 5800), Inria
+ *
+ * StarPU is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or (at
+ * your option) any later version.
+ *
+ * StarPU is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU Lesser General Public License in COPYING.LGPL for more details.
+ */
+
+/*
+ * Measure the bandwidth of starpu_mpi_scatter_detached() and
+ * starpu_mpi_gather_detached() for various numbers and sizes of pieces of data
+ * distributed over all nodes.
+ *
+ * The collective algorithm can be selected with the
+ * STARPU_MPI_COLLECTIVE_ARITY and STARPU_MPI_COLLECTIVE_TREE_THRESHOLD
+ * environment variables.
+ */
+
+#include <starpu_mpi.h>
+#include "helper.h"
+
+#define SERVER_PRINTF(fmt, ...) do { if(rank == 0) { printf(fmt, ## __VA_ARGS__); fflush(stdout); }} while(0)
+
+#ifdef STARPU_QUICK_CHECK
+#define COUNT_DEFAULT	64
+#define SIZE_MAX_DEFAULT	(64*1024)
+#define LOOPS_DEFAULT_SG	2
+#else
+#define COUNT_DEFAULT	1024
+#define SIZE_MAX_DEFAULT	(4*1024*1024)
+#define LOOPS_DEFAULT_SG	10
+#endif
+
+static int count = COUNT_DEFAULT;
+static int size_max = SIZE_MAX_DEFAULT;
+static int iterations = LOOPS_DEFAULT_SG;
+
+static void parse_args(int argc, char **argv)
+{
+	int i;
+	for (i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "-count") == 0)
+		{
+			count = atoi(argv[++i]);
+		}
+		else if (strcmp(argv[i], "-size") == 0)
+		{
+			size_max = atoi(argv[++i]);
+		}
+		else if (strcmp(argv[i], "-N") == 0)
+		{
+			iterations = atoi(argv[++i]);
+		}
+		else if (strcmp(argv[i], "-help") == 0 || strcmp(argv[i], "--help") == 0 || strcmp(argv[i], "-h") == 0)
+		{
+			fprintf(stderr,"Usage: %s [-count count] [-size max_size] [-N iterations]\n", argv[0]);
+			exit(EXIT_SUCCESS);
+		}
+		else
+		{
+			fprintf(stderr,"Unrecognized option %s\n", argv[i]);
+			exit(EXIT_FAILURE);
+		}
+	}
+}
+
+int main(int argc, char **argv)
+{
+	int ret, rank, worldsize;
+	int x, k, len;
+	int failed = 0;
+
+	parse_args(argc, argv);
+
+	ret = starpu_mpi_init_conf(&argc, &argv, 1, MPI_COMM_WORLD, NULL);
+	STARPU_CHECK_RETURN_VALUE(ret, "starpu_mpi_init_conf");
+
+	starpu_mpi_comm_rank(MPI_COMM_WORLD, &rank);
+	starpu_mpi_comm_size(MPI_COMM_WORLD, &worldsize);
+
+	if (worldsize < 2)
+	{
+		if (rank == 0)
+			FPRINTF(stderr, "We need at least 2 processes.\n");
+
+		starpu_mpi_shutdown();
+		return rank == 0 ? STARPU_TEST_SKIPPED : 0;
+	}
+
+	SERVER_PRINTF("# nodes      = %d\n", worldsize);
+	SERVER_PRINTF("# count      = %d\n", count);
+	SERVER_PRINTF("# iterations = %d\n", iterations);
+	SERVER_PRINTF("# size\tscatter.us\tscatter.MB/s\tgather.us\tgather.MB/s\n");
+
+	starpu_data_handle_t *data_handles;
+	char **buffers;
+	data_handles = calloc(count, sizeof(*data_handles));
+	buffers = calloc(count, sizeof(*buffers));
+
+	for (len = 1; len <= size_max; len *= 4)
+	{
+		double scatter_time = 0., gather_time = 0.;
+		/* Amount of data going through the root */
+		double bytes = 0.;
+
+		for (x = 0; x < count; x++)
+		{
+			int owner = x % worldsize;
+			/* Every node registers every piece of data, so that it
+			 * can relay it in the tree algorithms */
+			if (rank == 0)
+			{
+				buffers[x] = malloc(len);
+				memset(buffers[x], x, len);
+				starpu_vector_data_register(&data_handles[x], STARPU_MAIN_RAM, (uintptr_t) buffers[x], len, 1);
+			}
+			else
+				starpu_vector_data_register(&data_handles[x], -1, (uintptr_t) NULL, len, 1);
+			starpu_mpi_data_register(data_handles[x], x, owner);
+			if (owner != 0)
+				bytes += len;
+		}
+
+		for (k = 0; k < iterations; k++)
+		{
+			double start, end;
+
+			starpu_mpi_barrier(MPI_COMM_WORLD);
+			start = starpu_timing_now();
+			ret = starpu_mpi_scatter_detached(data_handles, count, 0, MPI_COMM_WORLD, NULL, NULL, NULL, NULL);
+			STARPU_CHECK_RETURN_VALUE(ret, "starpu_mpi_scatter_detached");
+			starpu_mpi_wait_for_all(MPI_COMM_WORLD);
+			end = starpu_timing_now();
+			scatter_time += end - start;
+
+			start = starpu_timing_now();
+			ret = starpu_mpi_gather_detached(data_handles, count, 0, MPI_COMM_WORLD, NULL, NULL, NULL, NULL);
+			STARPU_CHECK_RETURN_VALUE(ret, "starpu_mpi_gather_detached");
+			starpu_mpi_wait_for_all(MPI_COMM_WORLD);
+			end = starpu_timing_now();
+			gather_time += end - start;
+		}
+
+		scatter_time /= iterations;
+		gather_time /= iterations;
+		SERVER_PRINTF("%d\t%.3f\t%.3f\t%.3f\t%.3f\n", len, scatter_time, bytes / scatter_time, gather_time, bytes / gather_time);
+
+		for (x = 0; x < count; x++)
+		{
+			starpu_data_unregister(data_handles[x]);
+			if (rank == 0)
+			{
+				int i;
+				for (i = 0; i < len; i++)
+					if (buffers[x][i] != (char) x)
+						failed = 1;
+				free(buffers[x]);
+			}
+		}
+	}
+
+	free(data_handles);
+	free(buffers);
+
+	starpu_mpi_shutdown();
+
+	if (failed)
+		FPRINTF(stderr, "The gathered data is wrong\n");
+	return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
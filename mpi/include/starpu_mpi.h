@@ -786,6 +786,14 @@ void starpu_mpi_data_migrate(MPI_Comm comm, starpu_data_handle_t handle, int new
    most data in ::STARPU_R mode
 */
 #define STARPU_MPI_NODE_SELECTION_MOST_R_DATA 0
+/**
+   Define the policy in which the selected node is the one which would
+   need to receive and send back the least amount of data, taking into
+   account the data which have already been received by the nodes and
+   kept in the MPI cache. Ties are broken by selecting the node to which
+   this policy has given the least tasks so far.
+*/
+#define STARPU_MPI_NODE_SELECTION_MIN_COMM 1
 
 typedef int (*starpu_mpi_select_node_policy_func_t)(int me, int nb_nodes, struct starpu_data_descr *descr, int nb_data);
 
@@ -836,7 +844,9 @@ int starpu_mpi_node_selection_get_current_policy(void);
    Set the current policy used to select the node which will execute
    the codelet. The policy ::STARPU_MPI_NODE_SELECTION_MOST_R_DATA
    selects the node having the most data in ::STARPU_R mode so as to
-   minimize the amount of data to be transferred.
+   minimize the amount of data to be transferred. The policy
+   ::STARPU_MPI_NODE_SELECTION_MIN_COMM selects the node which needs the
+   least communications, taking the MPI cache into account.
 */
 int starpu_mpi_node_selection_set_current_policy(int policy);
 
@@ -31,29 +31,54 @@ struct _starpu_mpi_early_data_handle_hashlist
 	struct _starpu_mpi_node node;
 };
 
-/** stores data which have been received by MPI but have not been requested by the application */
-static starpu_pthread_mutex_t _starpu_mpi_early_data_handle_mutex;
-static struct _starpu_mpi_early_data_handle_hashlist *_starpu_mpi_early_data_handle_hashmap = NULL;
+/** stores data which have been received by MPI but have not been requested by the application.
+ * The top level is split among several stripes according to the source, each
+ * with its own lock, so that looking for the data of different nodes does not
+ * contend */
+struct _starpu_mpi_early_data_stripe
+{
+	starpu_pthread_mutex_t mutex;
+	struct _starpu_mpi_early_data_handle_hashlist *hashmap;
+};
+
+static struct _starpu_mpi_early_data_stripe _starpu_mpi_early_data_stripes[_STARPU_MPI_EARLY_NSTRIPES];
 static int _starpu_mpi_early_data_handle_hashmap_count = 0;
 
+/** memory used by the data received before being requested, and its limit */
+static starpu_pthread_mutex_t _starpu_mpi_early_data_mem_mutex;
+static starpu_ssize_t _starpu_mpi_early_data_mem_used;
+static starpu_ssize_t _starpu_mpi_early_data_mem_max;
+
 void _starpu_mpi_early_data_init(void)
 {
-	_starpu_mpi_early_data_handle_hashmap = NULL;
+	unsigned i;
+	for (i = 0; i < _STARPU_MPI_EARLY_NSTRIPES; i++)
+	{
+		_starpu_mpi_early_data_stripes[i].hashmap = NULL;
+		STARPU_PTHREAD_MUTEX_INIT(&_starpu_mpi_early_data_stripes[i].mutex, NULL);
+	}
 	_starpu_mpi_early_data_handle_hashmap_count = 0;
-	STARPU_PTHREAD_MUTEX_INIT(&_starpu_mpi_early_data_handle_mutex, NULL);
+
+	STARPU_PTHREAD_MUTEX_INIT(&_starpu_mpi_early_data_mem_mutex, NULL);
+	_starpu_mpi_early_data_mem_used = 0;
+	_starpu_mpi_early_data_mem_max = (starpu_ssize_t) starpu_getenv_number_default("STARPU_MPI_EARLYDATA_MAX_MEM", 0) * 1024 * 1024;
 }
 
 void _starpu_mpi_early_data_check_termination(void)
 {
 	if (_starpu_mpi_early_data_handle_hashmap_count != 0)
 	{
-		struct _starpu_mpi_early_data_handle_hashlist *current=NULL, *tmp=NULL;
-		HASH_ITER(hh, _starpu_mpi_early_data_handle_hashmap, current, tmp)
+		unsigned i;
+		for (i = 0; i < _STARPU_MPI_EARLY_NSTRIPES; i++)
 		{
-			struct _starpu_mpi_early_data_handle_tag_hashlist *tag_current=NULL, *tag_tmp=NULL;
-			HASH_ITER(hh, current->datahash, tag_current, tag_tmp)
+			struct _starpu_mpi_early_data_handle_hashlist *current=NULL, *tmp=NULL;
+			HASH_ITER(hh, _starpu_mpi_early_data_stripes[i].hashmap, current, tmp)
 			{
-				_STARPU_MSG("Unexpected message with comm %ld source %d tag %ld\n", (long int)current->node.comm, current->node.rank, tag_current->data_tag);
+				struct _starpu_mpi_early_data_handle_tag_hashlist *tag_current=NULL, *tag_tmp=NULL;
+				HASH_ITER(hh, current->datahash, tag_current, tag_tmp)
+				{
+					_STARPU_MSG("Unexpected message with comm %ld source %d tag %ld\n", (long int)current->node.comm, current->node.rank, tag_current->data_tag);
+				}
 			}
 		}
 		STARPU_ASSERT_MSG(_starpu_mpi_early_data_handle_hashmap_count == 0, "Number of unexpected received messages left is not 0 (but %d), did you forget to post a receive corresponding to a send?", _starpu_mpi_early_data_handle_hashmap_count);
@@ -62,22 +87,43 @@ void _starpu_mpi_early_data_check_termination(void)
 
 void _starpu_mpi_early_data_shutdown(void)
 {
-	struct _starpu_mpi_early_data_handle_hashlist *current=NULL, *tmp=NULL;
-	HASH_ITER(hh, _starpu_mpi_early_data_handle_hashmap, current, tmp)
+	unsigned i;
+	for (i = 0; i < _STARPU_MPI_EARLY_NSTRIPES; i++)
 	{
-		_STARPU_MPI_DEBUG(600, "Hash early_data with comm %ld source %d\n", (long int) current->node.comm, current->node.rank);
-		struct _starpu_mpi_early_data_handle_tag_hashlist *tag_entry=NULL, *tag_tmp=NULL;
-		HASH_ITER(hh, current->datahash, tag_entry, tag_tmp)
+		struct _starpu_mpi_early_data_stripe *stripe = &_starpu_mpi_early_data_stripes[i];
+		struct _starpu_mpi_early_data_handle_hashlist *current=NULL, *tmp=NULL;
+		HASH_ITER(hh, stripe->hashmap, current, tmp)
 		{
-			_STARPU_MPI_DEBUG(600, "Hash 2nd level with tag %ld\n", tag_entry->data_tag);
-			STARPU_ASSERT(_starpu_mpi_early_data_handle_list_empty(&tag_entry->list));
-			HASH_DEL(current->datahash, tag_entry);
-			free(tag_entry);
+			_STARPU_MPI_DEBUG(600, "Hash early_data with comm %ld source %d\n", (long int) current->node.comm, current->node.rank);
+			struct _starpu_mpi_early_data_handle_tag_hashlist *tag_entry=NULL, *tag_tmp=NULL;
+			HASH_ITER(hh, current->datahash, tag_entry, tag_tmp)
+			{
+				_STARPU_MPI_DEBUG(600, "Hash 2nd level with tag %ld\n", tag_entry->data_tag);
+				STARPU_ASSERT(_starpu_mpi_early_data_handle_list_empty(&tag_entry->list));
+				HASH_DEL(current->datahash, tag_entry);
+				free(tag_entry);
+			}
+			HASH_DEL(stripe->hashmap, current);
+			free(current);
 		}
-		HASH_DEL(_starpu_mpi_early_data_handle_hashmap, current);
-		free(current);
+		STARPU_PTHREAD_MUTEX_DESTROY(&stripe->mutex);
 	}
-	STARPU_PTHREAD_MUTEX_DESTROY(&_starpu_mpi_early_data_handle_mutex);
+	STARPU_ASSERT_MSG(_starpu_mpi_early_data_mem_used == 0, "Memory of unexpected received messages left is not 0 (but %ld)", (long) _starpu_mpi_early_data_mem_used);
+	STARPU_PTHREAD_MUTEX_DESTROY(&_starpu_mpi_early_data_mem_mutex);
+}
+
+int _starpu_mpi_early_data_reserve(starpu_ssize_t size, int force)
+{
+	int ret = 1;
+	STARPU_PTHREAD_MUTEX_LOCK(&_starpu_mpi_early_data_mem_mutex);
+	/* Always accept a message when nothing is buffered, otherwise a message
+	 * bigger than the limit could never be received */
+	if (!force && _starpu_mpi_early_data_mem_max > 0 && _starpu_mpi_early_data_mem_used > 0 && _starpu_mpi_early_data_mem_used + size > _starpu_mpi_early_data_mem_max)
+		ret = 0;
+	else
+		_starpu_mpi_early_data_mem_used += size;
+	STARPU_PTHREAD_MUTEX_UNLOCK(&_starpu_mpi_early_data_mem_mutex);
+	return ret;
 }
 
 struct _starpu_mpi_early_data_handle *_starpu_mpi_early_data_create(struct _starpu_mpi_envelope *envelope, int source, MPI_Comm comm)
@@ -94,17 +140,21 @@ struct _starpu_mpi_early_data_handle *_starpu_mpi_early_data_create(struct _star
 
 void _starpu_mpi_early_data_delete(struct _starpu_mpi_early_data_handle *early_data_handle)
 {
+	STARPU_PTHREAD_MUTEX_LOCK(&_starpu_mpi_early_data_mem_mutex);
+	_starpu_mpi_early_data_mem_used -= early_data_handle->reserved;
+	STARPU_PTHREAD_MUTEX_UNLOCK(&_starpu_mpi_early_data_mem_mutex);
 	free(early_data_handle);
 }
 
 struct _starpu_mpi_early_data_handle *_starpu_mpi_early_data_find(struct _starpu_mpi_node_tag *node_tag)
 {
+	struct _starpu_mpi_early_data_stripe *stripe = &_starpu_mpi_early_data_stripes[_STARPU_MPI_EARLY_STRIPE(node_tag->node.rank)];
 	struct _starpu_mpi_early_data_handle_hashlist *hashlist;
 	struct _starpu_mpi_early_data_handle *early_data_handle;
 
-	STARPU_PTHREAD_MUTEX_LOCK(&_starpu_mpi_early_data_handle_mutex);
+	STARPU_PTHREAD_MUTEX_LOCK(&stripe->mutex);
 	_STARPU_MPI_DEBUG(60, "Looking for early_data_handle with comm %ld source %d tag %ld\n", (long int)node_tag->node.comm, node_tag->node.rank, node_tag->data_tag);
-	HASH_FIND(hh, _starpu_mpi_early_data_handle_hashmap, &node_tag->node, sizeof(struct _starpu_mpi_node), hashlist);
+	HASH_FIND(hh, stripe->hashmap, &node_tag->node, sizeof(struct _starpu_mpi_node), hashlist);
 	if (hashlist == NULL)
 	{
 		_STARPU_MPI_DEBUG(600, "No entry for (comm %ld, source %d)\n", (long int)node_tag->node.comm, node_tag->node.rank);
@@ -126,51 +176,54 @@ struct _starpu_mpi_early_data_handle *_starpu_mpi_early_data_find(struct _starpu
 		}
 		else
 		{
-			_starpu_mpi_early_data_handle_hashmap_count --;
+			(void) STARPU_ATOMIC_ADD(&_starpu_mpi_early_data_handle_hashmap_count, -1);
 			early_data_handle = _starpu_mpi_early_data_handle_list_pop_front(&tag_hashlist->list);
 		}
 	}
 	_STARPU_MPI_DEBUG(60, "Found early_data_handle %p with comm %ld source %d tag %ld\n", early_data_handle, (long int)node_tag->node.comm, node_tag->node.rank, node_tag->data_tag);
-	STARPU_PTHREAD_MUTEX_UNLOCK(&_starpu_mpi_early_data_handle_mutex);
+	STARPU_PTHREAD_MUTEX_UNLOCK(&stripe->mutex);
 	return early_data_handle;
 }
 
 struct _starpu_mpi_early_data_handle_tag_hashlist *_starpu_mpi_early_data_extract(struct _starpu_mpi_node_tag *node_tag)
 {
+	struct _starpu_mpi_early_data_stripe *stripe = &_starpu_mpi_early_data_stripes[_STARPU_MPI_EARLY_STRIPE(node_tag->node.rank)];
 	struct _starpu_mpi_early_data_handle_hashlist *hashlist;
 	struct _starpu_mpi_early_data_handle_tag_hashlist *tag_hashlist = NULL;
 
-	STARPU_PTHREAD_MUTEX_LOCK(&_starpu_mpi_early_data_handle_mutex);
+	STARPU_PTHREAD_MUTEX_LOCK(&stripe->mutex);
 	_STARPU_MPI_DEBUG(60, "Looking for hashlist for (comm %ld, source %d)\n", (long int)node_tag->node.comm, node_tag->node.rank);
-	HASH_FIND(hh, _starpu_mpi_early_data_handle_hashmap, &node_tag->node, sizeof(struct _starpu_mpi_node), hashlist);
+	HASH_FIND(hh, stripe->hashmap, &node_tag->node, sizeof(struct _starpu_mpi_node), hashlist);
 	if (hashlist)
 	{
 		_STARPU_MPI_DEBUG(60, "Looking for hashlist for (tag %ld)\n", node_tag->data_tag);
 		HASH_FIND(hh, hashlist->datahash, &node_tag->data_tag, sizeof(starpu_mpi_tag_t), tag_hashlist);
 		if (tag_hashlist)
 		{
-			_starpu_mpi_early_data_handle_hashmap_count -= _starpu_mpi_early_data_handle_list_size(&tag_hashlist->list);
+			(void) STARPU_ATOMIC_ADD(&_starpu_mpi_early_data_handle_hashmap_count, -(int)_starpu_mpi_early_data_handle_list_size(&tag_hashlist->list));
 			HASH_DEL(hashlist->datahash, tag_hashlist);
 		}
 	}
 	_STARPU_MPI_DEBUG(60, "Found hashlist %p for (comm %ld, source %d) and (tag %ld)\n", tag_hashlist, (long int)node_tag->node.comm, node_tag->node.rank, node_tag->data_tag);
-	STARPU_PTHREAD_MUTEX_UNLOCK(&_starpu_mpi_early_data_handle_mutex);
+	STARPU_PTHREAD_MUTEX_UNLOCK(&stripe->mutex);
 	return tag_hashlist;
 }
 
 void _starpu_mpi_early_data_add(struct _starpu_mpi_early_data_handle *early_data_handle)
 {
-	STARPU_PTHREAD_MUTEX_LOCK(&_starpu_mpi_early_data_handle_mutex);
+	struct _starpu_mpi_early_data_stripe *stripe = &_starpu_mpi_early_data_stripes[_STARPU_MPI_EARLY_STRIPE(early_data_handle->node_tag.node.rank)];
+
+	STARPU_PTHREAD_MUTEX_LOCK(&stripe->mutex);
 	_STARPU_MPI_DEBUG(60, "Adding early_data_handle %p with comm %ld source %d tag %ld (%p)\n", early_data_handle, (long int)early_data_handle->node_tag.node.comm, early_data_handle->node_tag.node.rank, early_data_handle->node_tag.data_tag, &early_data_handle->node_tag.node);
 
 	struct _starpu_mpi_early_data_handle_hashlist *hashlist;
-	HASH_FIND(hh, _starpu_mpi_early_data_handle_hashmap, &early_data_handle->node_tag.node, sizeof(struct _starpu_mpi_node), hashlist);
+	HASH_FIND(hh, stripe->hashmap, &early_data_handle->node_tag.node, sizeof(struct _starpu_mpi_node), hashlist);
 	if (hashlist == NULL)
 	{
 		_STARPU_MPI_MALLOC(hashlist, sizeof(struct _starpu_mpi_early_data_handle_hashlist));
 		hashlist->node = early_data_handle->node_tag.node;
 		hashlist->datahash = NULL;
-		HASH_ADD(hh, _starpu_mpi_early_data_handle_hashmap, node, sizeof(hashlist->node), hashlist);
+		HASH_ADD(hh, stripe->hashmap, node, sizeof(hashlist->node), hashlist);
 	}
 
 	struct _starpu_mpi_early_data_handle_tag_hashlist *tag_hashlist;
@@ -184,8 +237,8 @@ void _starpu_mpi_early_data_add(struct _starpu_mpi_early_data_handle *early_data
 	}
 
 	_starpu_mpi_early_data_handle_list_push_back(&tag_hashlist->list, early_data_handle);
-	_starpu_mpi_early_data_handle_hashmap_count ++;
-	STARPU_PTHREAD_MUTEX_UNLOCK(&_starpu_mpi_early_data_handle_mutex);
+	(void) STARPU_ATOMIC_ADD(&_starpu_mpi_early_data_handle_hashmap_count, 1);
+	STARPU_PTHREAD_MUTEX_UNLOCK(&stripe->mutex);
 }
 
 #endif // STARPU_USE_MPI_MPI
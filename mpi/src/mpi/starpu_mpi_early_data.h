@@ -41,6 +41,8 @@ LIST_TYPE(_starpu_mpi_early_data_handle,
 	  size_t size;
 	  unsigned buffer_node;
 	  struct _starpu_mpi_node_tag node_tag;
+	  /** memory accounted for this data in the limit of unexpected messages */
+	  starpu_ssize_t reserved;
 	  starpu_pthread_mutex_t req_mutex;
 	  starpu_pthread_cond_t req_cond;
 );
@@ -62,6 +64,11 @@ struct _starpu_mpi_early_data_handle *_starpu_mpi_early_data_create(struct _star
 struct _starpu_mpi_early_data_handle *_starpu_mpi_early_data_find(struct _starpu_mpi_node_tag *node_tag);
 void _starpu_mpi_early_data_add(struct _starpu_mpi_early_data_handle *early_data_handle);
 void _starpu_mpi_early_data_delete(struct _starpu_mpi_early_data_handle *early_data_handle);
+/** Account size bytes of memory for a message received before being
+ * requested. Returns 0 if this would exceed STARPU_MPI_EARLYDATA_MAX_MEM, the
+ * message should then rather be kept pending until some memory is released by
+ * _starpu_mpi_early_data_delete(). With \p force, the limit is ignored. */
+int _starpu_mpi_early_data_reserve(starpu_ssize_t size, int force);
 
 // Not used now but needed for fault tolerance
 struct _starpu_mpi_early_data_handle_tag_hashlist *_starpu_mpi_early_data_extract(struct _starpu_mpi_node_tag *node_tag);
@@ -18,6 +18,7 @@
 #include <starpu_mpi.h>
 #include <starpu_mpi_private.h>
 #include <mpi/starpu_mpi_early_request.h>
+#include <mpi/starpu_mpi_mpi_backend.h>
 #include <common/uthash.h>
 
 #ifdef STARPU_USE_MPI_MPI
@@ -31,34 +32,50 @@ struct _starpu_mpi_early_request_hashlist
 	struct _starpu_mpi_node node;
 };
 
-static starpu_pthread_mutex_t _starpu_mpi_early_request_mutex;
-struct _starpu_mpi_early_request_hashlist *_starpu_mpi_early_request_hash;
-int _starpu_mpi_early_request_hash_count;
+/** the top level is split among several stripes according to the source,
+ * each with its own lock */
+struct _starpu_mpi_early_request_stripe
+{
+	starpu_pthread_mutex_t mutex;
+	struct _starpu_mpi_early_request_hashlist *hash;
+};
+
+static struct _starpu_mpi_early_request_stripe _starpu_mpi_early_request_stripes[_STARPU_MPI_EARLY_NSTRIPES];
+static int _starpu_mpi_early_request_hash_count;
 
 void _starpu_mpi_early_request_init()
 {
-	_starpu_mpi_early_request_hash = NULL;
+	unsigned i;
+	for (i = 0; i < _STARPU_MPI_EARLY_NSTRIPES; i++)
+	{
+		_starpu_mpi_early_request_stripes[i].hash = NULL;
+		STARPU_PTHREAD_MUTEX_INIT(&_starpu_mpi_early_request_stripes[i].mutex, NULL);
+	}
 	_starpu_mpi_early_request_hash_count = 0;
-	STARPU_PTHREAD_MUTEX_INIT(&_starpu_mpi_early_request_mutex, NULL);
 }
 
 void _starpu_mpi_early_request_shutdown()
 {
-	struct _starpu_mpi_early_request_hashlist *entry=NULL, *tmp=NULL;
-	HASH_ITER(hh, _starpu_mpi_early_request_hash, entry, tmp)
+	unsigned i;
+	for (i = 0; i < _STARPU_MPI_EARLY_NSTRIPES; i++)
 	{
-		struct _starpu_mpi_early_request_tag_hashlist *tag_entry=NULL, *tag_tmp=NULL;
-		HASH_ITER(hh, entry->datahash, tag_entry, tag_tmp)
+		struct _starpu_mpi_early_request_stripe *stripe = &_starpu_mpi_early_request_stripes[i];
+		struct _starpu_mpi_early_request_hashlist *entry=NULL, *tmp=NULL;
+		HASH_ITER(hh, stripe->hash, entry, tmp)
 		{
-			STARPU_ASSERT(_starpu_mpi_req_list_empty(&tag_entry->list));
-			HASH_DEL(entry->datahash, tag_entry);
-			free(tag_entry);
+			struct _starpu_mpi_early_request_tag_hashlist *tag_entry=NULL, *tag_tmp=NULL;
+			HASH_ITER(hh, entry->datahash, tag_entry, tag_tmp)
+			{
+				STARPU_ASSERT(_starpu_mpi_req_list_empty(&tag_entry->list));
+				HASH_DEL(entry->datahash, tag_entry);
+				free(tag_entry);
+			}
+
+			HASH_DEL(stripe->hash, entry);
+			free(entry);
 		}
-
-		HASH_DEL(_starpu_mpi_early_request_hash, entry);
-		free(entry);
+		STARPU_PTHREAD_MUTEX_DESTROY(&stripe->mutex);
 	}
-	STARPU_PTHREAD_MUTEX_DESTROY(&_starpu_mpi_early_request_mutex);
 }
 
 int _starpu_mpi_early_request_count()
@@ -76,15 +93,16 @@ struct _starpu_mpi_req* _starpu_mpi_early_request_dequeue(starpu_mpi_tag_t data_
 	struct _starpu_mpi_node_tag node_tag;
 	struct _starpu_mpi_req *found;
 	struct _starpu_mpi_early_request_hashlist *hashlist;
+	struct _starpu_mpi_early_request_stripe *stripe = &_starpu_mpi_early_request_stripes[_STARPU_MPI_EARLY_STRIPE(source)];
 
 	memset(&node_tag, 0, sizeof(struct _starpu_mpi_node_tag));
 	node_tag.node.comm = comm;
 	node_tag.node.rank = source;
 	node_tag.data_tag = data_tag;
 
-	STARPU_PTHREAD_MUTEX_LOCK(&_starpu_mpi_early_request_mutex);
+	STARPU_PTHREAD_MUTEX_LOCK(&stripe->mutex);
 	_STARPU_MPI_DEBUG(100, "Looking for early_request with comm %ld source %d tag %ld\n", (long int)node_tag.node.comm, node_tag.node.rank, node_tag.data_tag);
-	HASH_FIND(hh, _starpu_mpi_early_request_hash, &node_tag.node, sizeof(struct _starpu_mpi_node), hashlist);
+	HASH_FIND(hh, stripe->hash, &node_tag.node, sizeof(struct _starpu_mpi_node), hashlist);
 	if (hashlist == NULL)
 	{
 		found = NULL;
@@ -104,55 +122,81 @@ struct _starpu_mpi_req* _starpu_mpi_early_request_dequeue(starpu_mpi_tag_t data_
 		else
 		{
 			found = _starpu_mpi_req_list_pop_front(&tag_hashlist->list);
-			_starpu_mpi_early_request_hash_count --;
+			(void) STARPU_ATOMIC_ADD(&_starpu_mpi_early_request_hash_count, -1);
 		}
 	}
 	_STARPU_MPI_DEBUG(100, "Found early_request %p with comm %ld source %d tag %ld\n", found, (long int)node_tag.node.comm, node_tag.node.rank, node_tag.data_tag);
-	STARPU_PTHREAD_MUTEX_UNLOCK(&_starpu_mpi_early_request_mutex);
+	STARPU_PTHREAD_MUTEX_UNLOCK(&stripe->mutex);
 	return found;
 }
 
+int _starpu_mpi_early_request_pending(starpu_mpi_tag_t data_tag, int source, MPI_Comm comm)
+{
+	struct _starpu_mpi_node node;
+	struct _starpu_mpi_early_request_hashlist *hashlist;
+	struct _starpu_mpi_early_request_tag_hashlist *tag_hashlist = NULL;
+	struct _starpu_mpi_early_request_stripe *stripe = &_starpu_mpi_early_request_stripes[_STARPU_MPI_EARLY_STRIPE(source)];
+	int pending = 0;
+
+	memset(&node, 0, sizeof(node));
+	node.comm = comm;
+	node.rank = source;
+
+	STARPU_PTHREAD_MUTEX_LOCK(&stripe->mutex);
+	HASH_FIND(hh, stripe->hash, &node, sizeof(struct _starpu_mpi_node), hashlist);
+	if (hashlist)
+	{
+		HASH_FIND(hh, hashlist->datahash, &data_tag, sizeof(starpu_mpi_tag_t), tag_hashlist);
+		pending = tag_hashlist && !_starpu_mpi_req_list_empty(&tag_hashlist->list);
+	}
+	STARPU_PTHREAD_MUTEX_UNLOCK(&stripe->mutex);
+	return pending;
+}
+
 struct _starpu_mpi_early_request_tag_hashlist *_starpu_mpi_early_request_extract(starpu_mpi_tag_t data_tag, int source, MPI_Comm comm)
 {
 	struct _starpu_mpi_node_tag node_tag;
 	struct _starpu_mpi_early_request_hashlist *hashlist;
 	struct _starpu_mpi_early_request_tag_hashlist *tag_hashlist = NULL;
+	struct _starpu_mpi_early_request_stripe *stripe = &_starpu_mpi_early_request_stripes[_STARPU_MPI_EARLY_STRIPE(source)];
 
 	memset(&node_tag, 0, sizeof(struct _starpu_mpi_node_tag));
 	node_tag.node.comm = comm;
 	node_tag.node.rank = source;
 	node_tag.data_tag = data_tag;
 
-	STARPU_PTHREAD_MUTEX_LOCK(&_starpu_mpi_early_request_mutex);
+	STARPU_PTHREAD_MUTEX_LOCK(&stripe->mutex);
 	_STARPU_MPI_DEBUG(100, "Looking for early_request with comm %ld source %d tag %ld\n", (long int)node_tag.node.comm, node_tag.node.rank, node_tag.data_tag);
-	HASH_FIND(hh, _starpu_mpi_early_request_hash, &node_tag.node, sizeof(struct _starpu_mpi_node), hashlist);
+	HASH_FIND(hh, stripe->hash, &node_tag.node, sizeof(struct _starpu_mpi_node), hashlist);
 	if (hashlist)
 	{
 		HASH_FIND(hh, hashlist->datahash, &node_tag.data_tag, sizeof(starpu_mpi_tag_t), tag_hashlist);
 		if (tag_hashlist)
 		{
-			_starpu_mpi_early_request_hash_count -= _starpu_mpi_req_list_size(&tag_hashlist->list);
+			(void) STARPU_ATOMIC_ADD(&_starpu_mpi_early_request_hash_count, -(int)_starpu_mpi_req_list_size(&tag_hashlist->list));
 			HASH_DEL(hashlist->datahash, tag_hashlist);
 		}
 	}
 	_STARPU_MPI_DEBUG(100, "Found hashlist %p with comm %ld source %d tag %ld\n", hashlist, (long int)node_tag.node.comm, node_tag.node.rank, node_tag.data_tag);
-	STARPU_PTHREAD_MUTEX_UNLOCK(&_starpu_mpi_early_request_mutex);
+	STARPU_PTHREAD_MUTEX_UNLOCK(&stripe->mutex);
 	return tag_hashlist;
 }
 
 void _starpu_mpi_early_request_enqueue(struct _starpu_mpi_req *req)
 {
-	STARPU_PTHREAD_MUTEX_LOCK(&_starpu_mpi_early_request_mutex);
+	struct _starpu_mpi_early_request_stripe *stripe = &_starpu_mpi_early_request_stripes[_STARPU_MPI_EARLY_STRIPE(req->node_tag.node.rank)];
+
+	STARPU_PTHREAD_MUTEX_LOCK(&stripe->mutex);
 	_STARPU_MPI_DEBUG(100, "Adding request %p with comm %ld source %d tag %ld in the application request hashmap\n", req, (long int)req->node_tag.node.comm, req->node_tag.node.rank, req->node_tag.data_tag);
 
 	struct _starpu_mpi_early_request_hashlist *hashlist;
-	HASH_FIND(hh, _starpu_mpi_early_request_hash, &req->node_tag.node, sizeof(struct _starpu_mpi_node), hashlist);
+	HASH_FIND(hh, stripe->hash, &req->node_tag.node, sizeof(struct _starpu_mpi_node), hashlist);
 	if (hashlist == NULL)
 	{
 		_STARPU_MPI_MALLOC(hashlist, sizeof(struct _starpu_mpi_early_request_hashlist));
 		hashlist->node = req->node_tag.node;
 		hashlist->datahash = NULL;
-		HASH_ADD(hh, _starpu_mpi_early_request_hash, node, sizeof(hashlist->node), hashlist);
+		HASH_ADD(hh, stripe->hash, node, sizeof(hashlist->node), hashlist);
 	}
 
 	struct _starpu_mpi_early_request_tag_hashlist *tag_hashlist;
@@ -166,8 +210,8 @@ void _starpu_mpi_early_request_enqueue(struct _starpu_mpi_req *req)
 	}
 
 	_starpu_mpi_req_list_push_back(&tag_hashlist->list, req);
-	_starpu_mpi_early_request_hash_count ++;
-	STARPU_PTHREAD_MUTEX_UNLOCK(&_starpu_mpi_early_request_mutex);
+	(void) STARPU_ATOMIC_ADD(&_starpu_mpi_early_request_hash_count, 1);
+	STARPU_PTHREAD_MUTEX_UNLOCK(&stripe->mutex);
 }
 
 #endif // STARPU_USE_MPI_MPI
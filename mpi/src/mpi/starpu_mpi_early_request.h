@@ -46,6 +46,8 @@ void _starpu_mpi_early_request_check_termination(void);
 
 void _starpu_mpi_early_request_enqueue(struct _starpu_mpi_req *req);
 struct _starpu_mpi_req* _starpu_mpi_early_request_dequeue(starpu_mpi_tag_t data_tag, int source, MPI_Comm comm);
+/** Whether the application has posted a receive for this data */
+int _starpu_mpi_early_request_pending(starpu_mpi_tag_t data_tag, int source, MPI_Comm comm);
 
 // Not used now but needed for fault tolerance
 struct _starpu_mpi_early_request_tag_hashlist *_starpu_mpi_early_request_extract(starpu_mpi_tag_t data_tag, int source, MPI_Comm comm);
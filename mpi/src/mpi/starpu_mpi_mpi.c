@@ -76,6 +76,9 @@ static unsigned ndetached_send_requests = 0;
 
 /* Condition to wake up progression thread */
 static starpu_pthread_cond_t progress_cond;
+/* Set when early data memory is released while envelopes are deferred,
+ * protected by progress_mutex */
+static int deferred_envelopes_retry;
 static starpu_pthread_mutex_t progress_mutex;
 /* Condition to wake up waiting for all current MPI requests to finish */
 static starpu_pthread_cond_t barrier_cond;
@@ -84,10 +87,30 @@ static starpu_pthread_t progress_thread;
 #endif
 static int running = 0;
 
+/* Additional progression threads, see STARPU_MPI_NPROGRESS_THREADS. Each of
+ * them submits and polls the send requests towards a subset of the nodes, so
+ * that the messages to a given node are still emitted in order. The main
+ * progression thread keeps handling the receptions. */
+struct _starpu_mpi_progress_shard
+{
+	starpu_pthread_t thread;
+	starpu_pthread_mutex_t mutex;
+	starpu_pthread_cond_t cond;
+	struct _starpu_mpi_req_prio_list ready_send_requests;
+	struct _starpu_mpi_req_list detached_requests;
+	unsigned ndetached_send_requests;
+	int running;
+};
+static struct _starpu_mpi_progress_shard *progress_shards;
+static unsigned nprogress_shards;
+
 /* Provides synchronization between an early request, a sync request, and an early data handle:
  * we keep it held while checking and posting one to prevent the other.
- * This is to be taken always before the progress_mutex. */
-static starpu_pthread_mutex_t early_data_mutex;
+ * These only ever match for the same source node, so there is one lock per
+ * stripe of source nodes, like the early data and request tables.
+ * This is to be taken always before the progress_mutex, and only one at a time. */
+static starpu_pthread_mutex_t early_data_mutex[_STARPU_MPI_EARLY_NSTRIPES];
+#define EARLY_DATA_MUTEX(rank) (&early_data_mutex[_STARPU_MPI_EARLY_STRIPE(rank)])
 
 /* Driver taken by StarPU-MPI to process tasks when there is no requests to
  * handle instead of polling endlessly */
@@ -171,6 +194,15 @@ void _starpu_mpi_submit_coop_sends(struct _starpu_mpi_coop_sends *coop_sends, in
 	}
 }
 
+/* Returns the progression thread which handles the request, or NULL if it is
+ * handled by the main progression thread */
+static struct _starpu_mpi_progress_shard *_starpu_mpi_progress_shard_get(struct _starpu_mpi_req *req)
+{
+	if (nprogress_shards == 0 || req->request_type != SEND_REQ)
+		return NULL;
+	return &progress_shards[req->node_tag.node.rank % nprogress_shards];
+}
+
 void _starpu_mpi_submit_ready_request(void *arg)
 {
 	_STARPU_MPI_LOG_IN();
@@ -198,7 +230,6 @@ void _starpu_mpi_submit_ready_request(void *arg)
 			_starpu_mpi_datatype_allocate(req->data_handle, req);
 			if (req->registered_datatype == 1)
 			{
-				req->count = 1;
 				req->ptr = starpu_data_handle_to_pointer(req->data_handle, req->node);
 			}
 			else
@@ -219,14 +250,15 @@ void _starpu_mpi_submit_ready_request(void *arg)
 		}
 		else
 		{
-			STARPU_PTHREAD_MUTEX_LOCK(&early_data_mutex);
+			starpu_pthread_mutex_t *early_mutex = EARLY_DATA_MUTEX(req->node_tag.node.rank);
+			STARPU_PTHREAD_MUTEX_LOCK(early_mutex);
 			/* test whether some data with the given tag and source have already been received by StarPU-MPI*/
 			struct _starpu_mpi_early_data_handle *early_data_handle = _starpu_mpi_early_data_find(&req->node_tag);
 
 			if (early_data_handle)
 			{
 				/* Got the early_data_handle */
-				STARPU_PTHREAD_MUTEX_UNLOCK(&early_data_mutex);
+				STARPU_PTHREAD_MUTEX_UNLOCK(early_mutex);
 
 				/* Case: a receive request for a data with the given tag and source has already been
 				 * posted to MPI by StarPU. Asynchronously requests a Read permission over the temporary handle ,
@@ -259,13 +291,12 @@ void _starpu_mpi_submit_ready_request(void *arg)
 				if (sync_req)
 				{
 					/* Got the sync req */
-					STARPU_PTHREAD_MUTEX_UNLOCK(&early_data_mutex);
+					STARPU_PTHREAD_MUTEX_UNLOCK(early_mutex);
 					/* Case: we already received the send envelope, we can proceed with the receive */
 					req->sync = 1;
 					_starpu_mpi_datatype_allocate(req->data_handle, req);
 					if (req->registered_datatype == 1)
 					{
-						req->count = 1;
 						req->ptr = starpu_data_handle_to_pointer(req->data_handle, req->node);
 					}
 					else
@@ -286,18 +317,30 @@ void _starpu_mpi_submit_ready_request(void *arg)
 					STARPU_PTHREAD_MUTEX_LOCK(&progress_mutex);
 					_starpu_mpi_early_request_enqueue(req);
 					/* We have queued our early request, we can let the progression thread look at it */
-					STARPU_PTHREAD_MUTEX_UNLOCK(&early_data_mutex);
+					STARPU_PTHREAD_MUTEX_UNLOCK(early_mutex);
 				}
 			}
 		}
 	}
 	else
 	{
+		struct _starpu_mpi_progress_shard *shard = _starpu_mpi_progress_shard_get(req);
+		if (shard)
+		{
+			STARPU_PTHREAD_MUTEX_LOCK(&shard->mutex);
+			_starpu_mpi_req_prio_list_push_front(&shard->ready_send_requests, req);
+			STARPU_PTHREAD_COND_SIGNAL(&shard->cond);
+			STARPU_PTHREAD_MUTEX_UNLOCK(&shard->mutex);
+		}
+
 		STARPU_PTHREAD_MUTEX_LOCK(&progress_mutex);
-		if (req->request_type == SEND_REQ)
-			_starpu_mpi_req_prio_list_push_front(&ready_send_requests, req);
-		else
-			_starpu_mpi_req_list_push_front(&ready_recv_requests, req);
+		if (!shard)
+		{
+			if (req->request_type == SEND_REQ)
+				_starpu_mpi_req_prio_list_push_front(&ready_send_requests, req);
+			else
+				_starpu_mpi_req_list_push_front(&ready_recv_requests, req);
+		}
 		_STARPU_MPI_DEBUG(3, "Pushing new request %p type %s tag %"PRIi64" src %d data %p ptr %p datatype '%s' count %d registered_datatype %d \n",
 				  req, _starpu_mpi_request_type(req->request_type), req->node_tag.data_tag, req->node_tag.node.rank, req->data_handle, req->ptr,
 				  req->datatype_name, (int)req->count, req->registered_datatype);
@@ -436,7 +479,6 @@ void _starpu_mpi_isend_size_func(struct _starpu_mpi_req *req)
 	if (req->registered_datatype == 1)
 	{
 		int size, ret;
-		req->count = 1;
 		req->ptr = starpu_data_handle_to_pointer(req->data_handle, req->node);
 
 		MPI_Type_size(req->datatype, &size);
@@ -867,6 +909,13 @@ static void _starpu_mpi_handle_request_termination(struct _starpu_mpi_req *req)
 	if (req->backend->internal_req)
 	{
 		_starpu_mpi_early_data_delete(req->backend->early_data_handle);
+
+		/* Some early data memory was released, let the progression
+		 * thread retry the envelopes which it had to defer */
+		STARPU_PTHREAD_MUTEX_LOCK(&progress_mutex);
+		deferred_envelopes_retry = 1;
+		STARPU_PTHREAD_COND_SIGNAL(&progress_cond);
+		STARPU_PTHREAD_MUTEX_UNLOCK(&progress_mutex);
 	}
 	else
 	{
@@ -1039,24 +1088,26 @@ static void _starpu_mpi_early_data_cb(void* arg)
 	args = NULL;
 }
 
-// We suppose progress_mutex is locked
-static void _starpu_mpi_test_detached_requests(void)
+// We suppose mutex is locked
+// Returns the number of requests which have completed
+static unsigned _starpu_mpi_test_detached_requests(struct _starpu_mpi_req_list *list, starpu_pthread_mutex_t *mutex, unsigned *ndetached_send)
 {
 	//_STARPU_MPI_LOG_IN();
 	int flag;
+	unsigned ncompleted = 0;
 	struct _starpu_mpi_req *req;
 
-	if (_starpu_mpi_req_list_empty(&detached_requests))
+	if (_starpu_mpi_req_list_empty(list))
 	{
 		//_STARPU_MPI_LOG_OUT();
-		return;
+		return 0;
 	}
 
 	_STARPU_MPI_TRACE_TESTING_DETACHED_BEGIN();
-	req = _starpu_mpi_req_list_begin(&detached_requests);
-	while (req != _starpu_mpi_req_list_end(&detached_requests))
+	req = _starpu_mpi_req_list_begin(list);
+	while (req != _starpu_mpi_req_list_end(list))
 	{
-		STARPU_PTHREAD_MUTEX_UNLOCK(&progress_mutex);
+		STARPU_PTHREAD_MUTEX_UNLOCK(mutex);
 
 		_STARPU_MPI_TRACE_TEST_BEGIN(req->node_tag.node.rank, req->node_tag.data_tag);
 		//_STARPU_MPI_DEBUG(3, "Test detached request %p - mpitag %"PRIi64" - TYPE %s %d\n", &req->backend->data_request, req->node_tag.data_tag, _starpu_mpi_request_type(req->request_type), req->node_tag.node.rank);
@@ -1083,13 +1134,14 @@ static void _starpu_mpi_test_detached_requests(void)
 			_STARPU_MPI_TRACE_COMPLETE_BEGIN(req->request_type, req->node_tag.node.rank, req->node_tag.data_tag);
 
 			_starpu_mpi_handle_request_termination(req);
+			ncompleted++;
 
-			STARPU_PTHREAD_MUTEX_LOCK(&progress_mutex);
+			STARPU_PTHREAD_MUTEX_LOCK(mutex);
 			if (req->request_type == SEND_REQ && ndetached_send_requests_max > 0)
 				// if ndetached_send_requests_max == 0, we don't limit the number of concurrent MPI send requests
-				ndetached_send_requests--;
-			_starpu_mpi_req_list_erase(&detached_requests, req);
-			STARPU_PTHREAD_MUTEX_UNLOCK(&progress_mutex);
+				(*ndetached_send)--;
+			_starpu_mpi_req_list_erase(list, req);
+			STARPU_PTHREAD_MUTEX_UNLOCK(mutex);
 
 			_STARPU_MPI_TRACE_COMPLETE_END(req->request_type, req->node_tag.node.rank, req->node_tag.data_tag);
 
@@ -1113,17 +1165,30 @@ static void _starpu_mpi_test_detached_requests(void)
 			_STARPU_MPI_TRACE_POLLING_BEGIN();
 		}
 
-		STARPU_PTHREAD_MUTEX_LOCK(&progress_mutex);
+		STARPU_PTHREAD_MUTEX_LOCK(mutex);
 	}
 	_STARPU_MPI_TRACE_TESTING_DETACHED_END();
 
 	//_STARPU_MPI_LOG_OUT();
+	return ncompleted;
 }
 
 static void _starpu_mpi_handle_detached_request(struct _starpu_mpi_req *req)
 {
 	if (req->detached)
 	{
+		struct _starpu_mpi_progress_shard *shard = _starpu_mpi_progress_shard_get(req);
+		if (shard)
+		{
+			STARPU_PTHREAD_MUTEX_LOCK(&shard->mutex);
+			if (ndetached_send_requests_max > 0)
+				shard->ndetached_send_requests++;
+			_starpu_mpi_req_list_push_back(&shard->detached_requests, req);
+			STARPU_PTHREAD_COND_SIGNAL(&shard->cond);
+			STARPU_PTHREAD_MUTEX_UNLOCK(&shard->mutex);
+			return;
+		}
+
 		STARPU_PTHREAD_MUTEX_LOCK(&progress_mutex);
 
 		if (req->request_type == SEND_REQ && ndetached_send_requests_max > 0)
@@ -1191,6 +1256,8 @@ static void _starpu_mpi_receive_early_data(struct _starpu_mpi_envelope *envelope
 	_STARPU_MPI_DEBUG(20, "Request sync %d\n", envelope->sync);
 
 	struct _starpu_mpi_early_data_handle* early_data_handle = _starpu_mpi_early_data_create(envelope, status.MPI_SOURCE, comm);
+	/* Accounted by _starpu_mpi_early_data_reserve() */
+	early_data_handle->reserved = envelope->size;
 	_starpu_mpi_early_data_add(early_data_handle);
 
 	starpu_data_handle_t data_handle;
@@ -1228,7 +1295,7 @@ static void _starpu_mpi_receive_early_data(struct _starpu_mpi_envelope *envelope
 							  NULL, NULL, 1, 1, envelope->size, STARPU_DEFAULT_PRIO);
 	/* The early data handle is ready, we can let _starpu_mpi_submit_ready_request
 	 * proceed with acquiring it */
-	STARPU_PTHREAD_MUTEX_UNLOCK(&early_data_mutex);
+	STARPU_PTHREAD_MUTEX_UNLOCK(EARLY_DATA_MUTEX(status.MPI_SOURCE));
 
 	STARPU_PTHREAD_MUTEX_LOCK(&progress_mutex);
 	// We wait until the request is pushed in the
@@ -1244,6 +1311,291 @@ static void _starpu_mpi_receive_early_data(struct _starpu_mpi_envelope *envelope
 	STARPU_PTHREAD_MUTEX_LOCK(&progress_mutex);
 }
 
+#ifndef STARPU_SIMGRID
+static void *_starpu_mpi_progress_shard_func(void *arg)
+{
+	struct _starpu_mpi_progress_shard *shard = arg;
+
+	starpu_pthread_setname("MPI send");
+	if (!_starpu_mpi_nobind)
+	{
+		int cpuid = starpu_get_next_bindid(STARPU_THREAD_ACTIVE, NULL, 0);
+		if (starpu_bind_thread_on(cpuid, STARPU_THREAD_ACTIVE, "MPI send") < 0)
+			_STARPU_DISP("No core was available for an additional MPI thread. You should use STARPU_RESERVE_NCPU to leave cores available for MPI\n");
+	}
+
+	STARPU_PTHREAD_MUTEX_LOCK(&shard->mutex);
+	while (shard->running || !_starpu_mpi_req_prio_list_empty(&shard->ready_send_requests) || !_starpu_mpi_req_list_empty(&shard->detached_requests))
+	{
+		unsigned progress = 0;
+
+		if (_starpu_mpi_req_prio_list_empty(&shard->ready_send_requests) && _starpu_mpi_req_list_empty(&shard->detached_requests))
+		{
+			STARPU_PTHREAD_COND_WAIT(&shard->cond, &shard->mutex);
+			continue;
+		}
+
+		unsigned n = 0;
+		while (!_starpu_mpi_req_prio_list_empty(&shard->ready_send_requests) && (ndetached_send_requests_max == 0 || shard->ndetached_send_requests < ndetached_send_requests_max))
+		{
+			struct _starpu_mpi_req *req;
+
+			if (n++ == nready_process)
+				/* Already spent some time on submitting ready send requests, poll before processing more ready send requests */
+				break;
+
+			req = _starpu_mpi_req_prio_list_pop_back_highest(&shard->ready_send_requests);
+
+			STARPU_PTHREAD_MUTEX_UNLOCK(&shard->mutex);
+			_starpu_mpi_handle_ready_request(req);
+			STARPU_PTHREAD_MUTEX_LOCK(&shard->mutex);
+			progress++;
+		}
+
+		progress += _starpu_mpi_test_detached_requests(&shard->detached_requests, &shard->mutex, &shard->ndetached_send_requests);
+		STARPU_PTHREAD_MUTEX_UNLOCK(&shard->mutex);
+
+		if (progress)
+		{
+			/* Let the main progression thread notice new synchronous
+			 * sends and notify barriers of terminations */
+			STARPU_PTHREAD_MUTEX_LOCK(&progress_mutex);
+			STARPU_PTHREAD_COND_BROADCAST(&progress_cond);
+			STARPU_PTHREAD_MUTEX_UNLOCK(&progress_mutex);
+		}
+
+		STARPU_VALGRIND_YIELD();
+		STARPU_PTHREAD_MUTEX_LOCK(&shard->mutex);
+	}
+	STARPU_PTHREAD_MUTEX_UNLOCK(&shard->mutex);
+
+	return NULL;
+}
+
+static void _starpu_mpi_progress_shards_init(void)
+{
+	unsigned i;
+
+	if (_starpu_mpi_nprogress_threads <= 1)
+		return;
+
+	nprogress_shards = _starpu_mpi_nprogress_threads - 1;
+	_STARPU_MPI_CALLOC(progress_shards, nprogress_shards, sizeof(*progress_shards));
+	for (i = 0; i < nprogress_shards; i++)
+	{
+		struct _starpu_mpi_progress_shard *shard = &progress_shards[i];
+		STARPU_PTHREAD_MUTEX_INIT(&shard->mutex, NULL);
+		STARPU_PTHREAD_COND_INIT(&shard->cond, NULL);
+		_starpu_mpi_req_prio_list_init(&shard->ready_send_requests);
+		_starpu_mpi_req_list_init(&shard->detached_requests);
+		shard->running = 1;
+		STARPU_PTHREAD_CREATE(&shard->thread, NULL, _starpu_mpi_progress_shard_func, shard);
+	}
+}
+
+static void _starpu_mpi_progress_shards_shutdown(void)
+{
+	unsigned i;
+
+	for (i = 0; i < nprogress_shards; i++)
+	{
+		struct _starpu_mpi_progress_shard *shard = &progress_shards[i];
+		STARPU_PTHREAD_MUTEX_LOCK(&shard->mutex);
+		shard->running = 0;
+		STARPU_PTHREAD_COND_SIGNAL(&shard->cond);
+		STARPU_PTHREAD_MUTEX_UNLOCK(&shard->mutex);
+		STARPU_PTHREAD_JOIN(shard->thread, NULL);
+
+		STARPU_MPI_ASSERT_MSG(_starpu_mpi_req_list_empty(&shard->detached_requests), "List of detached requests not empty");
+		STARPU_MPI_ASSERT_MSG(shard->ndetached_send_requests == 0, "Number of detached send requests not 0");
+		_starpu_mpi_req_prio_list_deinit(&shard->ready_send_requests);
+		STARPU_PTHREAD_MUTEX_DESTROY(&shard->mutex);
+		STARPU_PTHREAD_COND_DESTROY(&shard->cond);
+	}
+	free(progress_shards);
+	progress_shards = NULL;
+	nprogress_shards = 0;
+}
+#endif
+
+/* Handle an envelope announcing some data, called with progress_mutex held.
+ * Returns 0 if the data can not be received as early data yet because of
+ * STARPU_MPI_EARLYDATA_MAX_MEM, the envelope then has to be retried later,
+ * unless force is set. */
+static int _starpu_mpi_handle_data_envelope(struct _starpu_mpi_envelope *envelope, MPI_Status envelope_status, MPI_Comm envelope_comm, int force)
+{
+	_STARPU_MPI_DEBUG(3, "Searching for application request with tag %"PRIi64" and source %d (size %ld)\n", envelope->data_tag, envelope_status.MPI_SOURCE, envelope->size);
+
+	starpu_pthread_mutex_t *early_mutex = EARLY_DATA_MUTEX(envelope_status.MPI_SOURCE);
+	STARPU_PTHREAD_MUTEX_UNLOCK(&progress_mutex);
+	STARPU_PTHREAD_MUTEX_LOCK(early_mutex);
+	STARPU_PTHREAD_MUTEX_LOCK(&progress_mutex);
+	struct _starpu_mpi_req *early_request = _starpu_mpi_early_request_dequeue(envelope->data_tag, envelope_status.MPI_SOURCE, envelope_comm);
+
+	/* Case: a data will arrive before a matching receive is
+	 * posted by the application. Create a temporary handle to
+	 * store the incoming data, submit a starpu_mpi_irecv_detached
+	 * on this handle, and store it as an early_data
+	 */
+	if (early_request == NULL)
+	{
+		if (envelope->sync)
+		{
+			_STARPU_MPI_DEBUG(2000, "-------------------------> adding request for tag %"PRIi64"\n", envelope->data_tag);
+			struct _starpu_mpi_req *new_req;
+#ifdef STARPU_DEVEL
+#warning creating a request is not really useful.
+#endif
+			/* Initialize the request structure */
+			_starpu_mpi_request_init(&new_req);
+			new_req->request_type = RECV_REQ;
+			new_req->data_handle = NULL;
+			new_req->node_tag.node.rank = envelope_status.MPI_SOURCE;
+			new_req->node_tag.data_tag = envelope->data_tag;
+			new_req->node_tag.node.comm = envelope_comm;
+			new_req->detached = 1;
+			new_req->sync = 1;
+			new_req->callback = NULL;
+			new_req->callback_arg = NULL;
+			new_req->func = _starpu_mpi_irecv_size_func;
+			new_req->sequential_consistency = 1;
+			new_req->backend->is_internal_req = 0; // ????
+			new_req->count = envelope->size;
+			_starpu_mpi_sync_data_add(new_req);
+			/* We have queued our sync request, we can let _starpu_mpi_submit_ready_request find it */
+			STARPU_PTHREAD_MUTEX_UNLOCK(early_mutex);
+		}
+		else if (!_starpu_mpi_early_data_reserve(envelope->size, force))
+		{
+			/* Too much data was already received before
+			 * being requested, do not receive more from
+			 * this node until the application posts
+			 * receives for it. */
+			_STARPU_MPI_DEBUG(20, "Deferring envelope with tag %"PRIi64" and source %d\n", envelope->data_tag, envelope_status.MPI_SOURCE);
+			STARPU_PTHREAD_MUTEX_UNLOCK(early_mutex);
+			return 0;
+		}
+		else
+		{
+			/* This will release early_mutex when appropriate */
+			_starpu_mpi_receive_early_data(envelope, envelope_status, envelope_comm);
+		}
+	}
+	/* Case: a matching application request has been found for
+	 * the incoming data, we handle the correct allocation
+	 * of the pointer associated to the data handle, then
+	 * submit the corresponding receive with
+	 * _starpu_mpi_handle_ready_request. */
+	else
+	{
+		/* Got the early request */
+		STARPU_PTHREAD_MUTEX_UNLOCK(early_mutex);
+		_STARPU_MPI_DEBUG(2000, "A matching application request has been found for the incoming data with tag %"PRIi64"\n", envelope->data_tag);
+		_STARPU_MPI_DEBUG(2000, "Request sync %d\n", envelope->sync);
+
+		early_request->sync = envelope->sync;
+		_starpu_mpi_datatype_allocate(early_request->data_handle, early_request);
+		if (early_request->registered_datatype == 1)
+		{
+			early_request->ptr = starpu_data_handle_to_pointer(early_request->data_handle, early_request->node);
+		}
+		else
+		{
+			early_request->count = envelope->size;
+			early_request->ptr = (void *)starpu_malloc_on_node_flags(early_request->node, early_request->count, 0);
+			starpu_memory_allocate(early_request->node, early_request->count, STARPU_MEMORY_OVERFLOW);
+
+			STARPU_MPI_ASSERT_MSG(early_request->ptr, "cannot allocate message of size %ld\n", early_request->count);
+		}
+
+		_STARPU_MPI_DEBUG(3, "Handling new request... \n");
+		/* handling a request is likely to block for a while
+		 * (on a sync_data_with_mem call), we want to let the
+		 * application submit requests in the meantime, so we
+		 * release the lock. */
+		STARPU_PTHREAD_MUTEX_UNLOCK(&progress_mutex);
+		_starpu_mpi_handle_ready_request(early_request);
+		STARPU_PTHREAD_MUTEX_LOCK(&progress_mutex);
+	}
+	return 1;
+}
+
+/* Envelopes whose data could not be received yet as early data. The data
+ * sent by a node has to be received in the order of its envelopes, so the
+ * next envelopes from the same node are deferred too, but the other nodes are
+ * not held back. This is only used by the progression thread. */
+LIST_TYPE(_starpu_mpi_deferred_envelope,
+	struct _starpu_mpi_envelope envelope;
+	MPI_Status status;
+	MPI_Comm comm;
+);
+
+static struct _starpu_mpi_deferred_envelope_list deferred_envelopes;
+
+/* Whether an envelope from source was deferred before until (or at all if until is NULL) */
+static int _starpu_mpi_deferred_envelope_source(struct _starpu_mpi_deferred_envelope *until, int source, MPI_Comm comm)
+{
+	struct _starpu_mpi_deferred_envelope *deferred;
+
+	for (deferred = _starpu_mpi_deferred_envelope_list_begin(&deferred_envelopes);
+	     deferred != _starpu_mpi_deferred_envelope_list_end(&deferred_envelopes) && deferred != until;
+	     deferred = _starpu_mpi_deferred_envelope_list_next(deferred))
+		if (deferred->status.MPI_SOURCE == source && deferred->comm == comm)
+			return 1;
+	return 0;
+}
+
+static void _starpu_mpi_defer_envelope(struct _starpu_mpi_envelope *envelope, MPI_Status status, MPI_Comm comm)
+{
+	struct _starpu_mpi_deferred_envelope *deferred = _starpu_mpi_deferred_envelope_new();
+
+	deferred->envelope = *envelope;
+	deferred->status = status;
+	deferred->comm = comm;
+	_starpu_mpi_deferred_envelope_list_push_back(&deferred_envelopes, deferred);
+}
+
+/* Whether the application already requested the data of this deferred
+ * envelope or of a later one from the same node. The data of the envelopes
+ * before it have to be received first anyway, even beyond
+ * STARPU_MPI_EARLYDATA_MAX_MEM, otherwise the application could wait forever
+ * for its data while the memory is held by data it will only request later. */
+static int _starpu_mpi_deferred_envelope_wanted(struct _starpu_mpi_deferred_envelope *from)
+{
+	int source = from->status.MPI_SOURCE;
+	MPI_Comm comm = from->comm;
+	struct _starpu_mpi_deferred_envelope *deferred;
+
+	for (deferred = from;
+	     deferred != _starpu_mpi_deferred_envelope_list_end(&deferred_envelopes);
+	     deferred = _starpu_mpi_deferred_envelope_list_next(deferred))
+		if (deferred->status.MPI_SOURCE == source && deferred->comm == comm
+		    && _starpu_mpi_early_request_pending(deferred->envelope.data_tag, source, comm))
+			return 1;
+	return 0;
+}
+
+/* Retry the deferred envelopes, in order for each node */
+static void _starpu_mpi_retry_deferred_envelopes(void)
+{
+	struct _starpu_mpi_deferred_envelope *deferred, *next;
+
+	for (deferred = _starpu_mpi_deferred_envelope_list_begin(&deferred_envelopes);
+	     deferred != _starpu_mpi_deferred_envelope_list_end(&deferred_envelopes);
+	     deferred = next)
+	{
+		next = _starpu_mpi_deferred_envelope_list_next(deferred);
+		if (_starpu_mpi_deferred_envelope_source(deferred, deferred->status.MPI_SOURCE, deferred->comm))
+			/* An earlier envelope from the same node is still deferred */
+			continue;
+		if (_starpu_mpi_handle_data_envelope(&deferred->envelope, deferred->status, deferred->comm, _starpu_mpi_deferred_envelope_wanted(deferred)))
+		{
+			_starpu_mpi_deferred_envelope_list_erase(&deferred_envelopes, deferred);
+			_starpu_mpi_deferred_envelope_delete(deferred);
+		}
+	}
+}
+
 static void *_starpu_mpi_progress_thread_func(void *arg)
 {
 	struct _starpu_mpi_argc_argv *argc_argv = (struct _starpu_mpi_argc_argv *) arg;
@@ -1268,6 +1620,7 @@ static void *_starpu_mpi_progress_thread_func(void *arg)
 	if (!_starpu_mpi_nobind && _starpu_mpi_thread_cpuid >= 0)
 		/* In case MPI changed the binding */
 		starpu_bind_thread_on(_starpu_mpi_thread_cpuid, STARPU_THREAD_ACTIVE, "MPI");
+	_starpu_mpi_progress_shards_init();
 #else
 	/* Now that MPI is set up, let the rest of simgrid get initialized */
 	char **argv_cpy;
@@ -1330,6 +1683,7 @@ static void *_starpu_mpi_progress_thread_func(void *arg)
 	STARPU_PTHREAD_COND_SIGNAL(&progress_cond);
 
 	int envelope_request_submitted = 0;
+	_starpu_mpi_deferred_envelope_list_init(&deferred_envelopes);
 	int mpi_driver_loop_counter = 0;
 	int mpi_driver_task_counter = 0;
 	_STARPU_MPI_TRACE_POLLING_BEGIN();
@@ -1340,7 +1694,7 @@ static void *_starpu_mpi_progress_thread_func(void *arg)
 		starpu_pthread_wait_reset(&_starpu_mpi_thread_wait);
 #endif
 		/* shall we block ? */
-		unsigned block = _starpu_mpi_req_list_empty(&ready_recv_requests) && _starpu_mpi_req_prio_list_empty(&ready_send_requests) && _starpu_mpi_early_request_count() == 0 && _starpu_mpi_sync_data_count() == 0 && _starpu_mpi_req_list_empty(&detached_requests);
+		unsigned block = _starpu_mpi_req_list_empty(&ready_recv_requests) && _starpu_mpi_req_prio_list_empty(&ready_send_requests) && _starpu_mpi_early_request_count() == 0 && _starpu_mpi_sync_data_count() == 0 && _starpu_mpi_req_list_empty(&detached_requests) && !deferred_envelopes_retry;
 
 		if (block)
 		{
@@ -1418,7 +1772,11 @@ static void *_starpu_mpi_progress_thread_func(void *arg)
 		}
 
 		/* test whether there are some terminated "detached request" */
-		_starpu_mpi_test_detached_requests();
+		_starpu_mpi_test_detached_requests(&detached_requests, &progress_mutex, &ndetached_send_requests);
+
+		deferred_envelopes_retry = 0;
+		if (!_starpu_mpi_deferred_envelope_list_empty(&deferred_envelopes))
+			_starpu_mpi_retry_deferred_envelopes();
 
 		if (envelope_request_submitted == 1)
 		{
@@ -1445,91 +1803,14 @@ static void *_starpu_mpi_progress_thread_func(void *arg)
 					_starpu_mpi_isend_data_func(_sync_req);
 					STARPU_PTHREAD_MUTEX_LOCK(&progress_mutex);
 				}
-				else
+				else if (!envelope->sync && _starpu_mpi_deferred_envelope_source(NULL, envelope_status.MPI_SOURCE, envelope_comm))
 				{
-					_STARPU_MPI_DEBUG(3, "Searching for application request with tag %"PRIi64" and source %d (size %ld)\n", envelope->data_tag, envelope_status.MPI_SOURCE, envelope->size);
-
-					STARPU_PTHREAD_MUTEX_UNLOCK(&progress_mutex);
-					STARPU_PTHREAD_MUTEX_LOCK(&early_data_mutex);
-					STARPU_PTHREAD_MUTEX_LOCK(&progress_mutex);
-					struct _starpu_mpi_req *early_request = _starpu_mpi_early_request_dequeue(envelope->data_tag, envelope_status.MPI_SOURCE, envelope_comm);
-
-					/* Case: a data will arrive before a matching receive is
-					 * posted by the application. Create a temporary handle to
-					 * store the incoming data, submit a starpu_mpi_irecv_detached
-					 * on this handle, and store it as an early_data
-					 */
-					if (early_request == NULL)
-					{
-						if (envelope->sync)
-						{
-							_STARPU_MPI_DEBUG(2000, "-------------------------> adding request for tag %"PRIi64"\n", envelope->data_tag);
-							struct _starpu_mpi_req *new_req;
-#ifdef STARPU_DEVEL
-#warning creating a request is not really useful.
-#endif
-							/* Initialize the request structure */
-							_starpu_mpi_request_init(&new_req);
-							new_req->request_type = RECV_REQ;
-							new_req->data_handle = NULL;
-							new_req->node_tag.node.rank = envelope_status.MPI_SOURCE;
-							new_req->node_tag.data_tag = envelope->data_tag;
-							new_req->node_tag.node.comm = envelope_comm;
-							new_req->detached = 1;
-							new_req->sync = 1;
-							new_req->callback = NULL;
-							new_req->callback_arg = NULL;
-							new_req->func = _starpu_mpi_irecv_size_func;
-							new_req->sequential_consistency = 1;
-							new_req->backend->is_internal_req = 0; // ????
-							new_req->count = envelope->size;
-							_starpu_mpi_sync_data_add(new_req);
-							/* We have queued our sync request, we can let _starpu_mpi_submit_ready_request find it */
-							STARPU_PTHREAD_MUTEX_UNLOCK(&early_data_mutex);
-						}
-						else
-						{
-							/* This will release early_data_mutex when appropriate */
-							_starpu_mpi_receive_early_data(envelope, envelope_status, envelope_comm);
-						}
-					}
-					/* Case: a matching application request has been found for
-					 * the incoming data, we handle the correct allocation
-					 * of the pointer associated to the data handle, then
-					 * submit the corresponding receive with
-					 * _starpu_mpi_handle_ready_request. */
-					else
-					{
-						/* Got the early request */
-						STARPU_PTHREAD_MUTEX_UNLOCK(&early_data_mutex);
-						_STARPU_MPI_DEBUG(2000, "A matching application request has been found for the incoming data with tag %"PRIi64"\n", envelope->data_tag);
-						_STARPU_MPI_DEBUG(2000, "Request sync %d\n", envelope->sync);
-
-						early_request->sync = envelope->sync;
-						_starpu_mpi_datatype_allocate(early_request->data_handle, early_request);
-						if (early_request->registered_datatype == 1)
-						{
-							early_request->count = 1;
-							early_request->ptr = starpu_data_handle_to_pointer(early_request->data_handle, early_request->node);
-						}
-						else
-						{
-							early_request->count = envelope->size;
-							early_request->ptr = (void *)starpu_malloc_on_node_flags(early_request->node, early_request->count, 0);
-							starpu_memory_allocate(early_request->node, early_request->count, STARPU_MEMORY_OVERFLOW);
-
-							STARPU_MPI_ASSERT_MSG(early_request->ptr, "cannot allocate message of size %ld\n", early_request->count);
-						}
-
-						_STARPU_MPI_DEBUG(3, "Handling new request... \n");
-						/* handling a request is likely to block for a while
-						 * (on a sync_data_with_mem call), we want to let the
-						 * application submit requests in the meantime, so we
-						 * release the lock. */
-						STARPU_PTHREAD_MUTEX_UNLOCK(&progress_mutex);
-						_starpu_mpi_handle_ready_request(early_request);
-						STARPU_PTHREAD_MUTEX_LOCK(&progress_mutex);
-					}
+					/* Keep the order of the data sent by this node */
+					_starpu_mpi_defer_envelope(envelope, envelope_status, envelope_comm);
+				}
+				else if (!_starpu_mpi_handle_data_envelope(envelope, envelope_status, envelope_comm, 0))
+				{
+					_starpu_mpi_defer_envelope(envelope, envelope_status, envelope_comm);
 				}
 				envelope_request_submitted = 0;
 				_STARPU_MPI_TRACE_POLLING_BEGIN();
@@ -1586,6 +1867,12 @@ static void *_starpu_mpi_progress_thread_func(void *arg)
 		envelope_request_submitted = 0;
 	}
 
+#ifndef STARPU_SIMGRID
+	/* The additional threads may need progress_mutex to finish */
+	STARPU_PTHREAD_MUTEX_UNLOCK(&progress_mutex);
+	_starpu_mpi_progress_shards_shutdown();
+	STARPU_PTHREAD_MUTEX_LOCK(&progress_mutex);
+#endif
 
 #ifdef STARPU_SIMGRID
 	STARPU_PTHREAD_MUTEX_LOCK(&wait_counter_mutex);
@@ -1610,6 +1897,8 @@ static void *_starpu_mpi_progress_thread_func(void *arg)
 	_starpu_mpi_early_data_check_termination();
 	_starpu_mpi_sync_data_check_termination();
 	_starpu_mpi_req_prio_list_deinit(&ready_send_requests);
+	/* Cached datatypes have to be freed before MPI_Finalize */
+	_starpu_mpi_datatype_shutdown();
 
 #ifdef STARPU_USE_FXT
 	_starpu_mpi_fxt_shutdown();
@@ -1626,7 +1915,8 @@ static void *_starpu_mpi_progress_thread_func(void *arg)
 	_starpu_mpi_sync_data_shutdown();
 	_starpu_mpi_early_data_shutdown();
 	_starpu_mpi_early_request_shutdown();
-	_starpu_mpi_datatype_shutdown();
+	STARPU_ASSERT_MSG(_starpu_mpi_deferred_envelope_list_empty(&deferred_envelopes), "Some data announced by other nodes were never received");
+	_starpu_mpi_select_node_shutdown();
 	free(argc_argv);
 
 	return NULL;
@@ -1634,8 +1924,11 @@ static void *_starpu_mpi_progress_thread_func(void *arg)
 
 int _starpu_mpi_progress_init(struct _starpu_mpi_argc_argv *argc_argv)
 {
+	unsigned i;
+
 	STARPU_PTHREAD_MUTEX_INIT(&progress_mutex, NULL);
-	STARPU_PTHREAD_MUTEX_INIT(&early_data_mutex, NULL);
+	for (i = 0; i < _STARPU_MPI_EARLY_NSTRIPES; i++)
+		STARPU_PTHREAD_MUTEX_INIT(&early_data_mutex[i], NULL);
 	STARPU_PTHREAD_COND_INIT(&progress_cond, NULL);
 	STARPU_PTHREAD_COND_INIT(&barrier_cond, NULL);
 	_starpu_mpi_req_list_init(&ready_recv_requests);
@@ -1682,6 +1975,8 @@ void _starpu_mpi_wait_for_initialization()
 
 void _starpu_mpi_progress_shutdown(void **value)
 {
+	unsigned i;
+
 	if (!running)
 	{
 		_STARPU_ERROR("The progress thread was not launched. Was StarPU successfully initialized?\n");
@@ -1706,7 +2001,8 @@ void _starpu_mpi_progress_shutdown(void **value)
 
 	STARPU_PTHREAD_MUTEX_DESTROY(&posted_requests_mutex);
 	STARPU_PTHREAD_MUTEX_DESTROY(&progress_mutex);
-	STARPU_PTHREAD_MUTEX_DESTROY(&early_data_mutex);
+	for (i = 0; i < _STARPU_MPI_EARLY_NSTRIPES; i++)
+		STARPU_PTHREAD_MUTEX_DESTROY(&early_data_mutex[i]);
 	STARPU_PTHREAD_COND_DESTROY(&barrier_cond);
 }
 
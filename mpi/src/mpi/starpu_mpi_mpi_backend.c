@@ -52,7 +52,9 @@ void _starpu_mpi_mpi_backend_shutdown(void)
 
 int _starpu_mpi_mpi_backend_reserve_core(void)
 {
-	return (starpu_getenv_number_default("STARPU_MPI_DRIVER_CALL_FREQUENCY", 0) <= 0);
+	if (starpu_getenv_number_default("STARPU_MPI_DRIVER_CALL_FREQUENCY", 0) > 0)
+		return 0;
+	return starpu_getenv_number_default("STARPU_MPI_NPROGRESS_THREADS", 1);
 }
 
 void _starpu_mpi_mpi_backend_request_init(struct _starpu_mpi_req *req)
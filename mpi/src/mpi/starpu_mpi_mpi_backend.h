@@ -34,6 +34,11 @@ extern int _starpu_mpi_tag;
 #define _STARPU_MPI_TAG_DATA      _starpu_mpi_tag+1
 #define _STARPU_MPI_TAG_SYNC_DATA _starpu_mpi_tag+2
 
+/** Number of independently-locked parts of the tables of early data and early
+ * requests, they are selected according to the source of the messages */
+#define _STARPU_MPI_EARLY_NSTRIPES	16
+#define _STARPU_MPI_EARLY_STRIPE(rank)	((unsigned) (rank) % _STARPU_MPI_EARLY_NSTRIPES)
+
 #ifdef STARPU_USE_MPI_FT
 #define _STARPU_MPI_TAG_CP_ACK    _starpu_mpi_tag+3
 #define _STARPU_MPI_TAG_CP_RCVRY  _starpu_mpi_tag+4
@@ -141,7 +141,6 @@ void _starpu_mpi_isend_func(struct _starpu_mpi_req *req)
 
 	if (req->registered_datatype == 1)
 	{
-		req->count = 1;
 		req->ptr = starpu_data_handle_to_pointer(req->data_handle, req->node);
 
 		_starpu_mpi_isend_known_datatype(req);
@@ -190,7 +189,6 @@ void _starpu_mpi_irecv_func(struct _starpu_mpi_req *req)
 	_starpu_mpi_datatype_allocate(req->data_handle, req);
 	if (req->registered_datatype == 1)
 	{
-		req->count = 1;
 		req->ptr = starpu_data_handle_to_pointer(req->data_handle, req->node);
 		_starpu_mpi_irecv_known_datatype(req);
 	}
@@ -612,6 +610,7 @@ static void *_starpu_mpi_progress_thread_func(void *arg)
 	{
 		if (argc_argv->world_size > 2)
 		{
+			_starpu_mpi_coop_sends_calibrate(argc_argv->comm);
 			_starpu_mpi_nmad_coop_init();
 			nmad_mcast_started = 1; // to shutdown mcast
 		}
@@ -685,6 +684,9 @@ static void *_starpu_mpi_progress_thread_func(void *arg)
 		_starpu_mpi_nmad_coop_shutdown();
 	}
 
+	_starpu_mpi_datatype_shutdown();
+	_starpu_mpi_select_node_shutdown();
+
 #ifdef STARPU_USE_FXT
 	_starpu_mpi_fxt_shutdown();
 #endif
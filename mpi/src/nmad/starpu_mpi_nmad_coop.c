@@ -47,6 +47,21 @@ void _starpu_mpi_nmad_coop_init(void)
 	mcast_service = nm_mcast_init(nm_mpi_comm(MPI_COMM_WORLD));
 }
 
+static nm_coll_tree_kind_t _starpu_mpi_nmad_coop_tree_kind(enum _starpu_mpi_coop_sends_tree tree)
+{
+	switch (tree)
+	{
+		case _STARPU_MPI_COOP_SENDS_TREE_FLAT:
+			return NM_COLL_TREE_FLAT;
+		case _STARPU_MPI_COOP_SENDS_TREE_BINOMIAL:
+			return NM_COLL_TREE_BINOMIAL;
+		case _STARPU_MPI_COOP_SENDS_TREE_CHAIN:
+			return NM_COLL_TREE_CHAIN;
+		default:
+			return NM_COLL_TREE_DEFAULT;
+	}
+}
+
 void _starpu_mpi_nmad_end_coop_callback(void* arg)
 {
 	/* Callback called by the root node of the broadcast, when its job is done;
@@ -141,7 +156,6 @@ void _starpu_mpi_submit_coop_sends(struct _starpu_mpi_coop_sends *coop_sends, in
 
 		if (starpu_req->registered_datatype == 1)
 		{
-			starpu_req->count = 1;
 			starpu_req->ptr = starpu_data_handle_to_pointer(starpu_req->data_handle, STARPU_MAIN_RAM);
 			nm_mpi_nmad_data_get(&mcast->data, (void*)starpu_req->ptr, starpu_req->datatype, starpu_req->count);
 		}
@@ -158,7 +172,7 @@ void _starpu_mpi_submit_coop_sends(struct _starpu_mpi_coop_sends *coop_sends, in
 
 		nm_mcast_send_init(mcast_service, &mcast->mcast);
 		nm_mcast_send_set_notifier(&mcast->mcast, _starpu_mpi_nmad_end_coop_callback, mcast);
-		nm_mcast_isend(&mcast->mcast, comm, mcast->dests, mcast->prios, n, starpu_req->node_tag.data_tag, &mcast->data, header_len, NM_COLL_TREE_DEFAULT);
+		nm_mcast_isend(&mcast->mcast, comm, mcast->dests, mcast->prios, n, starpu_req->node_tag.data_tag, &mcast->data, header_len, _starpu_mpi_nmad_coop_tree_kind(coop_sends->tree));
 	}
 
 	_STARPU_MPI_LOG_OUT();
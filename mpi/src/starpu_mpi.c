@@ -50,7 +50,7 @@ int _starpu_mpi_choose_node(starpu_data_handle_t handle, enum starpu_data_access
 		/* Several potential places */
 		unsigned i;
 		if (_starpu_mpi_has_cuda || _starpu_mpi_has_hip)
-			for (i = 0; i < STARPU_MAXNODES; i++)
+			for (i = 0; i < handle->nreplicates; i++)
 			{
 				/* Note: We take as a hint that it's allocated on the GPU as
 				 * a clue that we want to push directly to the GPU */
@@ -68,7 +68,7 @@ int _starpu_mpi_choose_node(starpu_data_handle_t handle, enum starpu_data_access
 					return i;
 			}
 
-		for (i = 0; i < STARPU_MAXNODES; i++)
+		for (i = 0; i < handle->nreplicates; i++)
 		{
 			/* Note: We take as a hint that it's allocated on a NUMA node as
 			 * a clue that we want to push directly to that NUMA node */
@@ -105,7 +105,7 @@ int _starpu_mpi_choose_node(starpu_data_handle_t handle, enum starpu_data_access
 
 		/* Several potential places */
 		unsigned i;
-		for (i = 0; i < STARPU_MAXNODES; i++)
+		for (i = 0; i < handle->nreplicates; i++)
 		{
 			if (handle->per_node[i].state != STARPU_INVALID)
 			{
@@ -119,6 +119,7 @@ void _starpu_mpi_cache_data_clear(starpu_data_handle_t data_handle)
 	}
 
 	free(mpi_data->cache_sent);
+	free(mpi_data->cache_holders);
 }
 
 void _starpu_mpi_cache_data_init(starpu_data_handle_t data_handle)
@@ -134,6 +135,7 @@ void _starpu_mpi_cache_data_init(starpu_data_handle_t data_handle)
 	mpi_data->ft_induced_cache_received = 0;
 	mpi_data->ft_induced_cache_received_count = 0;
 	_STARPU_MALLOC(mpi_data->cache_sent, _starpu_cache_comm_size*sizeof(mpi_data->cache_sent[0]));
+	_STARPU_CALLOC(mpi_data->cache_holders, _starpu_cache_comm_size, sizeof(mpi_data->cache_holders[0]));
 	for(i=0 ; i<_starpu_cache_comm_size ; i++)
 	{
 		mpi_data->cache_sent[i] = 0;
@@ -172,6 +174,48 @@ static void _starpu_mpi_cache_data_remove_nolock(starpu_data_handle_t data_handl
 	}
 }
 
+/**************************************
+ * Holders of cached copies
+ **************************************/
+void _starpu_mpi_cache_holders_set(starpu_data_handle_t data_handle, int node)
+{
+	struct _starpu_mpi_data *mpi_data = data_handle->mpi_data;
+
+	if (_starpu_cache_enabled == 0 || node < 0)
+		return;
+
+	STARPU_MPI_ASSERT_MSG(node < _starpu_cache_comm_size, "Node %d invalid. Max node is %d\n", node, _starpu_cache_comm_size);
+	STARPU_PTHREAD_MUTEX_LOCK(&_cache_mutex);
+	mpi_data->cache_holders[node] = 1;
+	STARPU_PTHREAD_MUTEX_UNLOCK(&_cache_mutex);
+}
+
+void _starpu_mpi_cache_holders_clear(starpu_data_handle_t data_handle)
+{
+	struct _starpu_mpi_data *mpi_data = data_handle->mpi_data;
+
+	if (_starpu_cache_enabled == 0)
+		return;
+
+	STARPU_PTHREAD_MUTEX_LOCK(&_cache_mutex);
+	memset(mpi_data->cache_holders, 0, _starpu_cache_comm_size * sizeof(mpi_data->cache_holders[0]));
+	STARPU_PTHREAD_MUTEX_UNLOCK(&_cache_mutex);
+}
+
+int _starpu_mpi_cache_holders_get(starpu_data_handle_t data_handle, int node)
+{
+	struct _starpu_mpi_data *mpi_data = data_handle->mpi_data;
+	int held;
+
+	if (_starpu_cache_enabled == 0 || node < 0 || node >= _starpu_cache_comm_size)
+		return 0;
+
+	STARPU_PTHREAD_MUTEX_LOCK(&_cache_mutex);
+	held = mpi_data->cache_holders[node];
+	STARPU_PTHREAD_MUTEX_UNLOCK(&_cache_mutex);
+	return held;
+}
+
 /**************************************
  * Received cache
  **************************************/
@@ -376,6 +420,7 @@ static void _starpu_mpi_cache_flush_nolock(starpu_data_handle_t data_handle)
 			_starpu_mpi_cache_stats_dec(i, data_handle);
 		}
 	}
+	memset(mpi_data->cache_holders, 0, _starpu_cache_comm_size * sizeof(mpi_data->cache_holders[0]));
 
 	if (mpi_data->cache_received == 1)
 	{
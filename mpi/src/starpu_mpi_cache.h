@@ -34,6 +34,13 @@ void _starpu_mpi_cache_shutdown();
 void _starpu_mpi_cache_data_init(starpu_data_handle_t data_handle);
 void _starpu_mpi_cache_data_clear(starpu_data_handle_t data_handle);
 
+/** Note that node will hold a cached copy of the data */
+void _starpu_mpi_cache_holders_set(starpu_data_handle_t data_handle, int node);
+/** Note that the cached copies of the data are no longer valid */
+void _starpu_mpi_cache_holders_clear(starpu_data_handle_t data_handle);
+/** Return whether node holds a cached copy of the data */
+int _starpu_mpi_cache_holders_get(starpu_data_handle_t data_handle, int node);
+
 #ifdef __cplusplus
 }
 #endif
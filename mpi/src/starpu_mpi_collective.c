@@ -79,6 +79,8 @@ int _callback_set(int rank, starpu_data_handle_t *data_handles, int count, int r
 		if (!(*callback_arg)->count)
 		{
 			free(*callback_arg);
+			*callback_arg = NULL;
+			*callback_func = NULL;
 			return 1;
 		}
 	}
@@ -86,17 +88,151 @@ int _callback_set(int rank, starpu_data_handle_t *data_handles, int count, int r
 	return 0;
 }
 
-int starpu_mpi_scatter_detached(starpu_data_handle_t *data_handles, int count, int root, MPI_Comm comm, void (*scallback)(void *), void *sarg, void (*rcallback)(void *), void *rarg)
+/*
+ * Tree-shaped collectives: with STARPU_MPI_COLLECTIVE_ARITY set, pieces of
+ * data are forwarded along a k-ary tree rooted at the root of the
+ * collective, instead of being exchanged directly between the root and each
+ * owner. This bounds the number of peers the root has to talk to, at the
+ * expense of relaying through intermediate nodes, which thus need to have
+ * registered the data handles too.
+ *
+ * Nodes are numbered relatively to the root (vrank), the parent of vrank v is
+ * (v-1)/arity.
+ */
+
+static inline int _vrank(int rank, int root, int size)
+{
+	return (rank - root + size) % size;
+}
+
+static inline int _rank(int vrank, int root, int size)
+{
+	return (vrank + root) % size;
+}
+
+/* Whether the collective goes through the tree. All nodes have to take the
+ * same decision, so this only depends on the settings, on the number of
+ * pieces and on the size of the communicator, and all nodes then have to pass
+ * all the handles, to be able to relay them. */
+static int _tree_use(starpu_data_handle_t *data_handles, int count, int size)
 {
-	int rank;
 	int x;
+
+	if (_starpu_mpi_collective_arity < 2 || size <= _starpu_mpi_collective_arity + 1)
+		/* The root talks to everybody anyway */
+		return 0;
+	if (count <= _starpu_mpi_collective_arity)
+		/* The root talks to only a few nodes anyway */
+		return 0;
+
+	for(x = 0; x < count ; x++)
+		STARPU_ASSERT_MSG(data_handles[x], "With STARPU_MPI_COLLECTIVE_ARITY set, all nodes have to pass all the data handles to the collective, even those they do not own, but handle %d is NULL", x);
+	return 1;
+}
+
+/* Whether this piece goes through the tree: large pieces are better sent
+ * directly rather than stored and forwarded. All nodes have the handle when
+ * the tree is used, and thus take the same decision. */
+static int _tree_piece(starpu_data_handle_t data_handle)
+{
+	if (_starpu_mpi_collective_tree_threshold == 0)
+		return 1;
+	return starpu_data_get_size(data_handle) <= (size_t) _starpu_mpi_collective_tree_threshold;
+}
+
+/* If vrank is on the path between the root and vowner, return 1, and set the
+ * previous and next nodes on the path, or -1 */
+static int _tree_path(int vrank, int vowner, int *prev, int *next)
+{
+	int arity = _starpu_mpi_collective_arity;
+	int v = vowner, child = -1;
+
+	while (v > vrank)
+	{
+		child = v;
+		v = (v - 1) / arity;
+	}
+	if (v != vrank)
+		return 0;
+
+	*prev = vrank ? (vrank - 1) / arity : -1;
+	*next = child;
+	return 1;
+}
+
+/* The relay node does not need its copy any more */
+static void _tree_relay_done(starpu_data_handle_t data_handle)
+{
+	if (starpu_data_get_home_node(data_handle) < 0)
+		starpu_data_invalidate_submit(data_handle);
+}
+
+static int _tree_scatter(starpu_data_handle_t data_handle, int rank, int size, int owner, int root, starpu_mpi_tag_t data_tag, MPI_Comm comm, void (*callback_func)(void *), struct _callback_arg *callback_arg)
+{
+	int vrank = _vrank(rank, root, size);
+	int prev, next;
+	int ret;
+
+	if (owner == root || !_tree_path(vrank, _vrank(owner, root, size), &prev, &next))
+		return 0;
+
+	if (vrank == 0)
+		return starpu_mpi_isend_detached(data_handle, _rank(next, root, size), data_tag, comm, callback_func, callback_arg);
+
+	if (next == -1)
+		/* We are the owner */
+		return starpu_mpi_irecv_detached(data_handle, _rank(prev, root, size), data_tag, comm, callback_func, callback_arg);
+
+	ret = starpu_mpi_irecv_detached(data_handle, _rank(prev, root, size), data_tag, comm, NULL, NULL);
+	if (ret)
+		return ret;
+	ret = starpu_mpi_isend_detached(data_handle, _rank(next, root, size), data_tag, comm, NULL, NULL);
+	if (ret)
+		return ret;
+	_tree_relay_done(data_handle);
+	return 0;
+}
+
+static int _tree_gather(starpu_data_handle_t data_handle, int rank, int size, int owner, int root, starpu_mpi_tag_t data_tag, MPI_Comm comm, void (*callback_func)(void *), struct _callback_arg *callback_arg)
+{
+	int vrank = _vrank(rank, root, size);
+	int prev, next;
+	int ret;
+
+	if (owner == root || !_tree_path(vrank, _vrank(owner, root, size), &prev, &next))
+		return 0;
+
+	if (vrank == 0)
+		return starpu_mpi_irecv_detached(data_handle, _rank(next, root, size), data_tag, comm, callback_func, callback_arg);
+
+	if (next == -1)
+		/* We are the owner */
+		return starpu_mpi_isend_detached(data_handle, _rank(prev, root, size), data_tag, comm, callback_func, callback_arg);
+
+	ret = starpu_mpi_irecv_detached(data_handle, _rank(next, root, size), data_tag, comm, NULL, NULL);
+	if (ret)
+		return ret;
+	ret = starpu_mpi_isend_detached(data_handle, _rank(prev, root, size), data_tag, comm, NULL, NULL);
+	if (ret)
+		return ret;
+	_tree_relay_done(data_handle);
+	return 0;
+}
+
+int starpu_mpi_scatter_detached(starpu_data_handle_t *data_handles, int count, int root, MPI_Comm comm, void (*scallback)(void *), void *sarg, void (*rcallback)(void *), void *rarg)
+{
+	int rank, size;
+	int x, tree;
 	struct _callback_arg *callback_arg = NULL;
 	void (*callback_func)(void *) = NULL;
 
 	starpu_mpi_comm_rank(comm, &rank);
+	starpu_mpi_comm_size(comm, &size);
 
+	tree = _tree_use(data_handles, count, size);
 	x = _callback_set(rank, data_handles, count, root, scallback, sarg, rcallback, rarg, &callback_func, &callback_arg);
-	if (x == 1)
+	if (x == 1 && !tree)
+		/* Nothing to do, we are not relaying for others either */
 		return 0;
 
 	for(x = 0; x < count ; x++)
@@ -107,6 +243,13 @@ int starpu_mpi_scatter_detached(starpu_data_handle_t *data_handles, int count, i
 			int owner = starpu_mpi_data_get_rank(data_handles[x]);
 			starpu_mpi_tag_t data_tag = starpu_mpi_data_get_tag(data_handles[x]);
 			STARPU_ASSERT_MSG(data_tag >= 0, "Invalid tag for data handle");
+			if (tree && _tree_piece(data_handles[x]))
+			{
+				ret = _tree_scatter(data_handles[x], rank, size, owner, root, data_tag, comm, callback_func, callback_arg);
+				if (ret)
+					return ret;
+				continue;
+			}
 			if ((rank == root) && (owner != root))
 			{
 				//fprintf(stderr, "[%d] Sending data[%d] to %d\n", rank, x, owner);
@@ -129,15 +272,18 @@ int starpu_mpi_scatter_detached(starpu_data_handle_t *data_handles, int count, i
 
 int starpu_mpi_gather_detached(starpu_data_handle_t *data_handles, int count, int root, MPI_Comm comm, void (*scallback)(void *), void *sarg, void (*rcallback)(void *), void *rarg)
 {
-	int rank;
-	int x;
+	int rank, size;
+	int x, tree;
 	struct _callback_arg *callback_arg = NULL;
 	void (*callback_func)(void *) = NULL;
 
 	starpu_mpi_comm_rank(comm, &rank);
+	starpu_mpi_comm_size(comm, &size);
 
+	tree = _tree_use(data_handles, count, size);
 	x = _callback_set(rank, data_handles, count, root, scallback, sarg, rcallback, rarg, &callback_func, &callback_arg);
-	if (x == 1)
+	if (x == 1 && !tree)
+		/* Nothing to do, we are not relaying for others either */
 		return 0;
 
 	for(x = 0; x < count ; x++)
@@ -148,6 +294,13 @@ int starpu_mpi_gather_detached(starpu_data_handle_t *data_handles, int count, in
 			int owner = starpu_mpi_data_get_rank(data_handles[x]);
 			starpu_mpi_tag_t data_tag = starpu_mpi_data_get_tag(data_handles[x]);
 			STARPU_ASSERT_MSG(data_tag >= 0, "Invalid tag for data handle");
+			if (tree && _tree_piece(data_handles[x]))
+			{
+				ret = _tree_gather(data_handles[x], rank, size, owner, root, data_tag, comm, callback_func, callback_arg);
+				if (ret)
+					return ret;
+				continue;
+			}
 			if ((rank == root) && (owner != root))
 			{
 				//fprintf(stderr, "[%d] Receiving data[%d] from %d\n", rank, x, owner);
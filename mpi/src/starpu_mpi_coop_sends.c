@@ -15,6 +15,7 @@
  * See the GNU Lesser General Public License in COPYING.LGPL for more details.
  */
 
+#include <math.h>
 #include <starpu_mpi.h>
 #include <starpu_mpi_private.h>
 #include <datawizard/coherency.h>
@@ -91,6 +92,131 @@ static int _starpu_mpi_reqs_prio_compare(const void *a, const void *b)
 		return 1;
 }
 
+#ifdef STARPU_USE_MPI_NMAD
+/*
+ * Network model used to choose the shape of diffusion trees: latency in us,
+ * and bandwidth in bytes per us, i.e. MB/s. Only the NewMadeleine backend
+ * builds such trees, the MPI backend always sends from the root.
+ */
+static double _starpu_mpi_coop_latency = 2.;
+static double _starpu_mpi_coop_bandwidth = 10000.;
+
+#define _STARPU_MPI_COOP_CALIBRATE_NITER 10
+#define _STARPU_MPI_COOP_CALIBRATE_SIZE (1<<20)
+/* Do not pipeline with segments smaller than this */
+#define _STARPU_MPI_COOP_MIN_SEGMENT (16*1024)
+
+/* Return the average one-way time of a ping-pong of len bytes between nodes 0 and 1 */
+static double _starpu_mpi_coop_pingpong(char *buffer, int len, int rank, MPI_Comm comm)
+{
+	int peer = 1 - rank;
+	double start;
+	int i;
+
+	start = starpu_timing_now();
+	for (i = 0; i < _STARPU_MPI_COOP_CALIBRATE_NITER; i++)
+	{
+		if (rank == 0)
+		{
+			MPI_Send(buffer, len, MPI_BYTE, peer, 0, comm);
+			MPI_Recv(buffer, len, MPI_BYTE, peer, 0, comm, MPI_STATUS_IGNORE);
+		}
+		else
+		{
+			MPI_Recv(buffer, len, MPI_BYTE, peer, 0, comm, MPI_STATUS_IGNORE);
+			MPI_Send(buffer, len, MPI_BYTE, peer, 0, comm);
+		}
+	}
+	return (starpu_timing_now() - start) / (2 * _STARPU_MPI_COOP_CALIBRATE_NITER);
+}
+
+void _starpu_mpi_coop_sends_calibrate(MPI_Comm comm)
+{
+	double model[2];
+	int rank, size;
+
+	model[0] = starpu_getenv_float_default("STARPU_MPI_COOP_SENDS_LATENCY", -1.);
+	model[1] = starpu_getenv_float_default("STARPU_MPI_COOP_SENDS_BANDWIDTH", -1.);
+
+	if (model[0] < 0. || model[1] <= 0.)
+	{
+		MPI_Comm calibrate_comm;
+
+		MPI_Comm_rank(comm, &rank);
+		MPI_Comm_size(comm, &size);
+		if (size < 2)
+			return;
+
+		/* Do not mix our messages with the application ones */
+		MPI_Comm_dup(comm, &calibrate_comm);
+
+		/* Only nodes 0 and 1 measure, and then tell the others */
+		if (rank <= 1)
+		{
+			char *buffer;
+			double latency, duration;
+
+			_STARPU_MPI_CALLOC(buffer, 1, _STARPU_MPI_COOP_CALIBRATE_SIZE);
+			latency = _starpu_mpi_coop_pingpong(buffer, 1, rank, calibrate_comm);
+			duration = _starpu_mpi_coop_pingpong(buffer, _STARPU_MPI_COOP_CALIBRATE_SIZE, rank, calibrate_comm);
+			free(buffer);
+
+			if (model[0] < 0.)
+				model[0] = latency;
+			if (model[1] <= 0.)
+				model[1] = _STARPU_MPI_COOP_CALIBRATE_SIZE / STARPU_MAX(duration - latency, 1.);
+		}
+		MPI_Bcast(model, 2, MPI_DOUBLE, 0, calibrate_comm);
+		MPI_Comm_free(&calibrate_comm);
+	}
+
+	_starpu_mpi_coop_latency = model[0];
+	_starpu_mpi_coop_bandwidth = model[1];
+	_STARPU_MPI_DEBUG(0, "cooperative sends network model: latency %fus, bandwidth %fMB/s\n", _starpu_mpi_coop_latency, _starpu_mpi_coop_bandwidth);
+}
+
+/* Choose the diffusion tree which minimizes the expected time to send size
+ * bytes to n nodes, according to a latency/bandwidth model */
+static enum _starpu_mpi_coop_sends_tree _starpu_mpi_coop_sends_select_tree(size_t size, unsigned n)
+{
+	double latency = _starpu_mpi_coop_latency;
+	double bandwidth = _starpu_mpi_coop_bandwidth;
+	double msg = latency + size / bandwidth;
+	enum _starpu_mpi_coop_sends_tree tree;
+	double best, cost;
+	unsigned depth;
+
+	/* The root sends the message n times */
+	tree = _STARPU_MPI_COOP_SENDS_TREE_FLAT;
+	best = n * msg;
+
+	/* The number of nodes having the data doubles at each step */
+	for (depth = 0; (1U << depth) < n + 1; depth++)
+		;
+	cost = depth * msg;
+	if (cost < best)
+	{
+		tree = _STARPU_MPI_COOP_SENDS_TREE_BINOMIAL;
+		best = cost;
+	}
+
+	/* The message is cut into segments which flow along the chain, the
+	 * optimal number of segments balances the latency of each of them with
+	 * the time to fill the pipeline */
+	double nsegments = sqrt((n - 1) * size / (latency * bandwidth));
+	nsegments = STARPU_MIN(nsegments, (double) size / _STARPU_MPI_COOP_MIN_SEGMENT);
+	nsegments = STARPU_MAX(floor(nsegments), 1.);
+	cost = (n + nsegments - 1) * (latency + size / (nsegments * bandwidth));
+	if (cost < best)
+	{
+		tree = _STARPU_MPI_COOP_SENDS_TREE_CHAIN;
+		best = cost;
+	}
+
+	return tree;
+}
+#endif
+
 /* Sort the requests by priority and build a diffusion tree. Actually does something only once per coop_sends bag. */
 static void _starpu_mpi_coop_sends_optimize(struct _starpu_mpi_coop_sends *coop_sends)
 {
@@ -116,6 +242,12 @@ static void _starpu_mpi_coop_sends_optimize(struct _starpu_mpi_coop_sends *coop_
 		/* Sort them */
 		qsort(reqs, n, sizeof(*reqs), _starpu_mpi_reqs_prio_compare);
 
+#ifdef STARPU_USE_MPI_NMAD
+		/* Choose the shape of the tree */
+		coop_sends->tree = _starpu_mpi_coop_sends_select_tree(starpu_data_get_size(coop_sends->data_handle), n);
+		_STARPU_MPI_DEBUG(0, "cooperative sends %p uses tree shape %d\n", coop_sends, coop_sends->tree);
+#endif
+
 #if 0
 		/* And build the diffusion tree */
 		_starpu_mpi_coop_sends_build_tree(coop_sends);
@@ -14,6 +14,7 @@
  * See the GNU Lesser General Public License in COPYING.LGPL for more details.
  */
 
+#include <limits.h>
 #include <starpu_mpi_datatype.h>
 #include <common/uthash.h>
 #include <datawizard/coherency.h>
@@ -31,12 +32,76 @@ struct _starpu_mpi_datatype_funcs
 static starpu_pthread_mutex_t _starpu_mpi_datatype_funcs_table_mutex = STARPU_PTHREAD_MUTEX_INITIALIZER;
 static struct _starpu_mpi_datatype_funcs *_starpu_mpi_datatype_funcs_table = NULL;
 
+/*
+ * 	Cache of committed datatypes
+ *
+ * Building and committing a derived datatype is not cheap with most MPI
+ * implementations, and applications typically transfer many pieces of data of
+ * the same shape. We thus keep the datatypes built for the predefined
+ * interfaces, indexed by the shape of the data, and only free the least
+ * recently used ones when there are more than STARPU_MPI_DATATYPE_CACHE_SIZE
+ * of them.
+ */
+
+#define _STARPU_MPI_DATATYPE_MAXDIM 8
+
+struct _starpu_mpi_datatype_key
+{
+	enum starpu_data_interface_id id;
+	unsigned ndim;
+	size_t elemsize;
+	/* Number of elements along each dimension */
+	unsigned nn[_STARPU_MPI_DATATYPE_MAXDIM];
+	/* Stride, in elements, along each dimension, ldn[0] is always 1 */
+	unsigned ldn[_STARPU_MPI_DATATYPE_MAXDIM];
+};
+
+struct _starpu_mpi_datatype_entry
+{
+	struct _starpu_mpi_datatype_key key;
+	MPI_Datatype datatype;
+	/* Number of requests currently using the datatype */
+	unsigned refcount;
+	/* Indexed by key, in least recently used order */
+	UT_hash_handle hh;
+	/* Indexed by datatype, to find the entry back on free */
+	UT_hash_handle hh_datatype;
+};
+
+static starpu_pthread_mutex_t _starpu_mpi_datatype_cache_mutex = STARPU_PTHREAD_MUTEX_INITIALIZER;
+static struct _starpu_mpi_datatype_entry *_starpu_mpi_datatype_cache = NULL;
+static struct _starpu_mpi_datatype_entry *_starpu_mpi_datatype_cache_by_datatype = NULL;
+
 void _starpu_mpi_datatype_init(void)
 {
 }
 
+/* Free unused entries, least recently used first, until the cache fits in its
+ * size. Entries still used by requests are kept, they will be considered again
+ * on their release. _starpu_mpi_datatype_cache_mutex must be held. */
+static void _starpu_mpi_datatype_cache_evict(unsigned size)
+{
+	struct _starpu_mpi_datatype_entry *entry, *tmp;
+	HASH_ITER(hh, _starpu_mpi_datatype_cache, entry, tmp)
+	{
+		if (HASH_CNT(hh, _starpu_mpi_datatype_cache) <= size)
+			break;
+		if (entry->refcount)
+			continue;
+		HASH_DELETE(hh, _starpu_mpi_datatype_cache, entry);
+		HASH_DELETE(hh_datatype, _starpu_mpi_datatype_cache_by_datatype, entry);
+		int ret = MPI_Type_free(&entry->datatype);
+		STARPU_ASSERT_MSG(ret == MPI_SUCCESS, "MPI_Type_free failed");
+		free(entry);
+	}
+}
+
 void _starpu_mpi_datatype_shutdown(void)
 {
+	STARPU_PTHREAD_MUTEX_LOCK(&_starpu_mpi_datatype_cache_mutex);
+	_starpu_mpi_datatype_cache_evict(0);
+	STARPU_ASSERT_MSG(HASH_CNT(hh, _starpu_mpi_datatype_cache) == 0, "Some MPI datatypes are still in use");
+	STARPU_PTHREAD_MUTEX_UNLOCK(&_starpu_mpi_datatype_cache_mutex);
 }
 
 /*
@@ -267,6 +332,157 @@ static starpu_mpi_datatype_node_allocate_func_t handle_to_datatype_funcs[STARPU_
 	[STARPU_MULTIFORMAT_INTERFACE_ID] = NULL,
 };
 
+/* Describe the layout of the data as a set of strided dimensions. Returns 0
+ * if the layout cannot be described that way. */
+static int _starpu_mpi_datatype_get_key(starpu_data_handle_t data_handle, unsigned node, enum starpu_data_interface_id id, struct _starpu_mpi_datatype_key *key)
+{
+	void *data_interface = starpu_data_get_interface_on_node(data_handle, node);
+
+	memset(key, 0, sizeof(*key));
+	key->id = id;
+	key->ldn[0] = 1;
+
+	switch (id)
+	{
+		case STARPU_MATRIX_INTERFACE_ID:
+		{
+			struct starpu_matrix_interface *matrix_interface = data_interface;
+			key->ndim = 2;
+			key->elemsize = STARPU_MATRIX_GET_ELEMSIZE(matrix_interface);
+			key->nn[0] = STARPU_MATRIX_GET_NX(matrix_interface);
+			key->nn[1] = STARPU_MATRIX_GET_NY(matrix_interface);
+			key->ldn[1] = STARPU_MATRIX_GET_LD(matrix_interface);
+			return 1;
+		}
+		case STARPU_BLOCK_INTERFACE_ID:
+		{
+			struct starpu_block_interface *block_interface = data_interface;
+			key->ndim = 3;
+			key->elemsize = STARPU_BLOCK_GET_ELEMSIZE(block_interface);
+			key->nn[0] = STARPU_BLOCK_GET_NX(block_interface);
+			key->nn[1] = STARPU_BLOCK_GET_NY(block_interface);
+			key->nn[2] = STARPU_BLOCK_GET_NZ(block_interface);
+			key->ldn[1] = STARPU_BLOCK_GET_LDY(block_interface);
+			key->ldn[2] = STARPU_BLOCK_GET_LDZ(block_interface);
+			return 1;
+		}
+		case STARPU_TENSOR_INTERFACE_ID:
+		{
+			struct starpu_tensor_interface *tensor_interface = data_interface;
+			key->ndim = 4;
+			key->elemsize = STARPU_TENSOR_GET_ELEMSIZE(tensor_interface);
+			key->nn[0] = STARPU_TENSOR_GET_NX(tensor_interface);
+			key->nn[1] = STARPU_TENSOR_GET_NY(tensor_interface);
+			key->nn[2] = STARPU_TENSOR_GET_NZ(tensor_interface);
+			key->nn[3] = STARPU_TENSOR_GET_NT(tensor_interface);
+			key->ldn[1] = STARPU_TENSOR_GET_LDY(tensor_interface);
+			key->ldn[2] = STARPU_TENSOR_GET_LDZ(tensor_interface);
+			key->ldn[3] = STARPU_TENSOR_GET_LDT(tensor_interface);
+			return 1;
+		}
+		case STARPU_NDIM_INTERFACE_ID:
+		{
+			struct starpu_ndim_interface *ndim_interface = data_interface;
+			size_t ndim = STARPU_NDIM_GET_NDIM(ndim_interface);
+			unsigned *nn = STARPU_NDIM_GET_NN(ndim_interface);
+			unsigned *ldn = STARPU_NDIM_GET_LDN(ndim_interface);
+			unsigned i;
+			if (ndim == 0 || ndim > _STARPU_MPI_DATATYPE_MAXDIM)
+				return 0;
+			key->ndim = ndim;
+			key->elemsize = STARPU_NDIM_GET_ELEMSIZE(ndim_interface);
+			key->nn[0] = nn[0];
+			for (i = 1; i < ndim; i++)
+			{
+				key->nn[i] = nn[i];
+				key->ldn[i] = ldn[i];
+			}
+			return 1;
+		}
+		case STARPU_VECTOR_INTERFACE_ID:
+		{
+			struct starpu_vector_interface *vector_interface = data_interface;
+			key->ndim = 1;
+			key->elemsize = STARPU_VECTOR_GET_ELEMSIZE(vector_interface);
+			key->nn[0] = STARPU_VECTOR_GET_NX(vector_interface);
+			return 1;
+		}
+		case STARPU_VARIABLE_INTERFACE_ID:
+		{
+			struct starpu_variable_interface *variable_interface = data_interface;
+			key->ndim = 1;
+			key->elemsize = STARPU_VARIABLE_GET_ELEMSIZE(variable_interface);
+			key->nn[0] = 1;
+			return 1;
+		}
+		case STARPU_VOID_INTERFACE_ID:
+			return 1;
+		default:
+			return 0;
+	}
+}
+
+/* Returns the size in bytes of the data if it is stored contiguously in
+ * memory, and -1 otherwise */
+static starpu_ssize_t _starpu_mpi_datatype_contiguous_size(const struct _starpu_mpi_datatype_key *key)
+{
+	size_t n = key->ndim ? key->nn[0] : 0;
+	unsigned i;
+
+	for (i = 1; i < key->ndim; i++)
+	{
+		/* The stride does not matter for a single layer */
+		if (key->nn[i] > 1 && key->ldn[i] != n)
+			return -1;
+		n *= key->nn[i];
+	}
+	return n * key->elemsize;
+}
+
+static void _starpu_mpi_datatype_cache_get(const struct _starpu_mpi_datatype_key *key, starpu_mpi_datatype_node_allocate_func_t func, starpu_data_handle_t data_handle, unsigned node, MPI_Datatype *datatype)
+{
+	struct _starpu_mpi_datatype_entry *entry;
+
+	STARPU_PTHREAD_MUTEX_LOCK(&_starpu_mpi_datatype_cache_mutex);
+	HASH_FIND(hh, _starpu_mpi_datatype_cache, key, sizeof(*key), entry);
+	if (entry)
+	{
+		/* Move it to the most recently used end */
+		HASH_DELETE(hh, _starpu_mpi_datatype_cache, entry);
+	}
+	else
+	{
+		_STARPU_MPI_MALLOC(entry, sizeof(*entry));
+		entry->key = *key;
+		entry->refcount = 0;
+		func(data_handle, node, &entry->datatype);
+		HASH_ADD(hh_datatype, _starpu_mpi_datatype_cache_by_datatype, datatype, sizeof(entry->datatype), entry);
+	}
+	HASH_ADD(hh, _starpu_mpi_datatype_cache, key, sizeof(entry->key), entry);
+	entry->refcount++;
+	*datatype = entry->datatype;
+	_starpu_mpi_datatype_cache_evict(_starpu_mpi_datatype_cache_size);
+	STARPU_PTHREAD_MUTEX_UNLOCK(&_starpu_mpi_datatype_cache_mutex);
+}
+
+/* Returns 0 if the datatype does not come from the cache and thus has to be
+ * freed by the caller */
+static int _starpu_mpi_datatype_cache_release(MPI_Datatype datatype)
+{
+	struct _starpu_mpi_datatype_entry *entry;
+
+	STARPU_PTHREAD_MUTEX_LOCK(&_starpu_mpi_datatype_cache_mutex);
+	HASH_FIND(hh_datatype, _starpu_mpi_datatype_cache_by_datatype, &datatype, sizeof(datatype), entry);
+	if (entry)
+	{
+		STARPU_ASSERT(entry->refcount > 0);
+		entry->refcount--;
+		_starpu_mpi_datatype_cache_evict(_starpu_mpi_datatype_cache_size);
+	}
+	STARPU_PTHREAD_MUTEX_UNLOCK(&_starpu_mpi_datatype_cache_mutex);
+	return entry != NULL;
+}
+
 MPI_Datatype _starpu_mpi_datatype_get_user_defined_datatype(starpu_data_handle_t data_handle, unsigned node)
 {
 	enum starpu_data_interface_id id = starpu_data_get_interface_id(data_handle);
@@ -301,7 +517,30 @@ void _starpu_mpi_datatype_allocate(starpu_data_handle_t data_handle, struct _sta
 		starpu_mpi_datatype_node_allocate_func_t func = handle_to_datatype_funcs[id];
 		if (func)
 		{
-			func(data_handle, req->node, &req->datatype);
+			struct _starpu_mpi_datatype_key key;
+			if (_starpu_mpi_datatype_get_key(data_handle, req->node, id, &key))
+			{
+				starpu_ssize_t size = _starpu_mpi_datatype_contiguous_size(&key);
+				if (size >= 0 && size <= INT_MAX)
+				{
+					/* Contiguous data, send it as raw bytes */
+					req->datatype = MPI_BYTE;
+					req->count = size;
+				}
+				else
+				{
+					if (_starpu_mpi_datatype_cache_size > 0)
+						_starpu_mpi_datatype_cache_get(&key, func, data_handle, req->node, &req->datatype);
+					else
+						func(data_handle, req->node, &req->datatype);
+					req->count = 1;
+				}
+			}
+			else
+			{
+				func(data_handle, req->node, &req->datatype);
+				req->count = 1;
+			}
 			req->registered_datatype = 1;
 		}
 		else
@@ -326,7 +565,10 @@ void _starpu_mpi_datatype_allocate(starpu_data_handle_t data_handle, struct _sta
 			else
 				ret = table->allocate_datatype_func(data_handle, &req->datatype);
 			if (ret == 0)
+			{
+				req->count = 1;
 				req->registered_datatype = 1;
+			}
 			else
 			{
 				/* Couldn't register, probably complex data which needs packing. */
@@ -383,7 +625,9 @@ void _starpu_mpi_datatype_free(starpu_data_handle_t data_handle, MPI_Datatype *d
 	if (id < STARPU_MAX_INTERFACE_ID)
 	{
 		starpu_mpi_datatype_free_func_t func = handle_free_datatype_funcs[id];
-		if (func)
+		/* Contiguous data is sent as MPI_BYTE, and cached datatypes are
+		 * only freed on eviction */
+		if (func && *datatype != MPI_BYTE && !_starpu_mpi_datatype_cache_release(*datatype))
 			func(datatype);
 	}
 	else
@@ -95,12 +95,14 @@ void _starpu_mpi_do_initialize(struct _starpu_mpi_argc_argv *argc_argv)
 		hipSetDevice(devid);
 	}
 #endif
+	int thread_support;
 	if (argc_argv->initialize_mpi)
 	{
 		STARPU_ASSERT_MSG(argc_argv->comm == MPI_COMM_WORLD, "It does not make sense to ask StarPU-MPI to initialize MPI while a non-world communicator was given");
-		int thread_support;
 		_STARPU_DEBUG("Calling MPI_Init_thread\n");
-		if (MPI_Init_thread(argc_argv->argc, argc_argv->argv, MPI_THREAD_SERIALIZED, &thread_support) != MPI_SUCCESS)
+		/* Several progression threads make concurrent MPI calls */
+		int required = _starpu_mpi_nprogress_threads > 1 ? MPI_THREAD_MULTIPLE : MPI_THREAD_SERIALIZED;
+		if (MPI_Init_thread(argc_argv->argc, argc_argv->argv, required, &thread_support) != MPI_SUCCESS)
 		{
 			_STARPU_ERROR("MPI_Init_thread failed\n");
 		}
@@ -108,9 +110,14 @@ void _starpu_mpi_do_initialize(struct _starpu_mpi_argc_argv *argc_argv)
 	}
 	else
 	{
-		int provided;
-		MPI_Query_thread(&provided);
-		_starpu_mpi_print_thread_level_support(provided, " has been initialized with");
+		MPI_Query_thread(&thread_support);
+		_starpu_mpi_print_thread_level_support(thread_support, " has been initialized with");
+	}
+
+	if (_starpu_mpi_nprogress_threads > 1 && thread_support < MPI_THREAD_MULTIPLE)
+	{
+		_STARPU_DISP("Warning: MPI does not provide MPI_THREAD_MULTIPLE, STARPU_MPI_NPROGRESS_THREADS is ignored\n");
+		_starpu_mpi_nprogress_threads = 1;
 	}
 
 	// automatically register the given communicator
@@ -360,16 +367,17 @@ int starpu_mpi_init_conf(int *argc, char ***argv, int initialize_mpi, MPI_Comm c
 
 	_mpi_backend._starpu_mpi_backend_init(conf);
 
-	/* Reserve a core only if required by the backend and if STARPU_NCPU isn't provided */
+	/* Reserve cores only if required by the backend and if STARPU_NCPU isn't provided */
 	int mpi_thread_cpuid = starpu_getenv_number_default("STARPU_MPI_THREAD_CPUID", -1);
 	int mpi_thread_coreid = starpu_getenv_number_default("STARPU_MPI_THREAD_COREID", -1);
-	if (mpi_thread_cpuid < 0 && mpi_thread_coreid < 0 && _mpi_backend._starpu_mpi_backend_reserve_core() && conf->ncpus == -1)
+	int reserve_ncpus = _mpi_backend._starpu_mpi_backend_reserve_core();
+	if (mpi_thread_cpuid < 0 && mpi_thread_coreid < 0 && reserve_ncpus > 0 && conf->ncpus == -1)
 	{
-		/* Reserve a core for our progression thread */
+		/* Reserve cores for our progression threads */
 		if (conf->reserve_ncpus == -1)
-			conf->reserve_ncpus = 1;
+			conf->reserve_ncpus = reserve_ncpus;
 		else
-			conf->reserve_ncpus++;
+			conf->reserve_ncpus += reserve_ncpus;
 	}
 
 	conf->will_use_mpi = 1;
@@ -31,6 +31,10 @@ int _starpu_mpi_fake_world_size = -1;
 int _starpu_mpi_fake_world_rank = -1;
 int _starpu_mpi_use_coop_sends = 1;
 int _starpu_mpi_mem_throttle = 0;
+int _starpu_mpi_collective_arity = 0;
+int _starpu_mpi_collective_tree_threshold = 65536;
+int _starpu_mpi_datatype_cache_size = 128;
+int _starpu_mpi_nprogress_threads = 1;
 int _starpu_mpi_recv_wait_finalize = 0;
 
 void _starpu_mpi_set_debug_level_min(int level)
@@ -71,10 +75,20 @@ void _starpu_mpi_env_init(void)
 	_starpu_mpi_use_prio = starpu_getenv_number_default("STARPU_MPI_PRIORITIES", 1);
 	_starpu_mpi_use_coop_sends = starpu_getenv_number_default("STARPU_MPI_COOP_SENDS", 1);
 	_starpu_mpi_mem_throttle = starpu_getenv_number_default("STARPU_MPI_MEM_THROTTLE", 0);
+	_starpu_mpi_collective_arity = starpu_getenv_number_default("STARPU_MPI_COLLECTIVE_ARITY", 0);
+	_starpu_mpi_collective_tree_threshold = starpu_getenv_number_default("STARPU_MPI_COLLECTIVE_TREE_THRESHOLD", 65536);
+	_starpu_mpi_datatype_cache_size = starpu_getenv_number_default("STARPU_MPI_DATATYPE_CACHE_SIZE", 128);
+	_starpu_mpi_nprogress_threads = starpu_getenv_number_default("STARPU_MPI_NPROGRESS_THREADS", 1);
 	_starpu_debug_level_min = starpu_getenv_number_default("STARPU_MPI_DEBUG_LEVEL_MIN", 0);
 	_starpu_debug_level_max = starpu_getenv_number_default("STARPU_MPI_DEBUG_LEVEL_MAX", 0);
 	_starpu_mpi_recv_wait_finalize = starpu_getenv_number_default("STARPU_MPI_RECV_WAIT_FINALIZE", _starpu_mpi_recv_wait_finalize);
 
+	if (_starpu_mpi_nprogress_threads < 1)
+	{
+		_STARPU_DISP("Warning: STARPU_MPI_NPROGRESS_THREADS has to be at least 1, using 1.\n");
+		_starpu_mpi_nprogress_threads = 1;
+	}
+
 	int mpi_thread_coreid = starpu_getenv_number_default("STARPU_MPI_THREAD_COREID", -1);
 	if (_starpu_mpi_thread_cpuid >= 0 && mpi_thread_coreid >= 0)
 	{
@@ -70,6 +70,10 @@ extern int _starpu_mpi_nobind;
 extern int _starpu_mpi_thread_cpuid;
 extern int _starpu_mpi_use_coop_sends;
 extern int _starpu_mpi_mem_throttle;
+extern int _starpu_mpi_collective_arity;
+extern int _starpu_mpi_collective_tree_threshold;
+extern int _starpu_mpi_datatype_cache_size;
+extern int _starpu_mpi_nprogress_threads;
 extern int _starpu_mpi_recv_wait_finalize;
 extern int _starpu_mpi_has_cuda;
 extern int _starpu_mpi_has_hip;
@@ -192,6 +196,18 @@ struct _starpu_mpi_node_tag
 };
 
 MULTILIST_CREATE_TYPE(_starpu_mpi_req, coop_sends)
+
+/** Shape of the diffusion tree of a bag of cooperative sends */
+enum _starpu_mpi_coop_sends_tree
+{
+	/** The root sends to every node */
+	_STARPU_MPI_COOP_SENDS_TREE_FLAT,
+	/** Each node forwards to half of the remaining nodes */
+	_STARPU_MPI_COOP_SENDS_TREE_BINOMIAL,
+	/** Each node forwards to the next one, in a pipelined way */
+	_STARPU_MPI_COOP_SENDS_TREE_CHAIN,
+};
+
 /** One bag of cooperative sends */
 struct _starpu_mpi_coop_sends
 {
@@ -206,6 +222,9 @@ struct _starpu_mpi_coop_sends
 	struct _starpu_mpi_req **reqs_array;
 	unsigned n;
 	unsigned redirects_sent;
+	/** Shape of the diffusion tree, chosen when sorting out the requests,
+	 * only with the NewMadeleine backend */
+	enum _starpu_mpi_coop_sends_tree tree;
 
 	/* Used to trace dependencies */
 	long pre_sync_jobid;
@@ -217,6 +236,12 @@ struct _starpu_mpi_data
 	int magic;
 	struct _starpu_mpi_node_tag node_tag;
 	char *cache_sent;
+	/** Nodes which hold a valid cached copy of the data. Unlike
+	  * cache_sent and cache_received, this is maintained the same way on
+	  * every node by starpu_mpi_task_insert(), so that node selection
+	  * policies can take it into account and still all make the same
+	  * decision. */
+	char *cache_holders;
 	unsigned int cache_received;
 	unsigned int ft_induced_cache_received:1;
 	unsigned int ft_induced_cache_received_count:1;
@@ -312,6 +337,11 @@ void _starpu_mpi_isend_irecv_common(struct _starpu_mpi_req *req, enum starpu_dat
 /** Build a communication tree. Called before _starpu_mpi_coop_send is ever called. coop_sends->lock is held. */
 void _starpu_mpi_coop_sends_build_tree(struct _starpu_mpi_coop_sends *coop_sends);
 #endif
+#ifdef STARPU_USE_MPI_NMAD
+/** Measure the network latency and bandwidth, to be able to choose the shape
+ * of diffusion trees. Collective over \p comm, to be called from the MPI thread. */
+void _starpu_mpi_coop_sends_calibrate(MPI_Comm comm);
+#endif
 /** Try to merge with send request with other send requests */
 void _starpu_mpi_coop_send(starpu_data_handle_t data_handle, struct _starpu_mpi_req *req, enum starpu_data_access_mode mode, int sequential_consistency);
 
@@ -373,6 +403,7 @@ struct _starpu_mpi_backend
 {
 	void (*_starpu_mpi_backend_init)(struct starpu_conf *conf);
 	void (*_starpu_mpi_backend_shutdown)(void);
+	/** Number of cores to reserve for the progression threads */
 	int (*_starpu_mpi_backend_reserve_core)(void);
 	void (*_starpu_mpi_backend_request_init)(struct _starpu_mpi_req *req);
 	void (*_starpu_mpi_backend_request_fill)(struct _starpu_mpi_req *req, int is_internal_req);
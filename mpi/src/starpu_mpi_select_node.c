@@ -22,23 +22,37 @@
 #include <starpu_data.h>
 #include <starpu_mpi_private.h>
 #include <starpu_mpi_select_node.h>
+#include <starpu_mpi_cache.h>
 #include <datawizard/coherency.h>
 
 static int _current_policy = STARPU_MPI_NODE_SELECTION_MOST_R_DATA;
-static int _last_predefined_policy = STARPU_MPI_NODE_SELECTION_MOST_R_DATA;
+static int _last_predefined_policy = STARPU_MPI_NODE_SELECTION_MIN_COMM;
 static starpu_mpi_select_node_policy_func_t _policies[_STARPU_MPI_NODE_SELECTION_MAX_POLICY];
 
+/* Number of tasks given to each node by the min_comm policy */
+static unsigned *_min_comm_ntasks;
+static int _min_comm_nnodes;
+
 int _starpu_mpi_select_node_with_most_data(int me, int nb_nodes, struct starpu_data_descr *descr, int nb_data);
+int _starpu_mpi_select_node_with_min_comm(int me, int nb_nodes, struct starpu_data_descr *descr, int nb_data);
 
 void _starpu_mpi_select_node_init()
 {
 	int i;
 
 	_policies[STARPU_MPI_NODE_SELECTION_MOST_R_DATA] = _starpu_mpi_select_node_with_most_data;
+	_policies[STARPU_MPI_NODE_SELECTION_MIN_COMM] = _starpu_mpi_select_node_with_min_comm;
 	for(i=_last_predefined_policy+1 ; i<_STARPU_MPI_NODE_SELECTION_MAX_POLICY ; i++)
 		_policies[i] = NULL;
 }
 
+void _starpu_mpi_select_node_shutdown()
+{
+	free(_min_comm_ntasks);
+	_min_comm_ntasks = NULL;
+	_min_comm_nnodes = 0;
+}
+
 int starpu_mpi_node_selection_get_current_policy()
 {
 	return _current_policy;
@@ -112,6 +126,61 @@ int _starpu_mpi_select_node_with_most_data(int me, int nb_nodes, struct starpu_d
 	return xrank;
 }
 
+int _starpu_mpi_select_node_with_min_comm(int me, int nb_nodes, struct starpu_data_descr *descr, int nb_data)
+{
+	size_t *comm_on_nodes;
+	int i, node;
+	int xrank = 0;
+
+	(void)me;
+	_STARPU_MPI_CALLOC(comm_on_nodes, nb_nodes, sizeof(size_t));
+
+	if (nb_nodes > _min_comm_nnodes)
+	{
+		_STARPU_MPI_REALLOC(_min_comm_ntasks, nb_nodes * sizeof(_min_comm_ntasks[0]));
+		memset(_min_comm_ntasks + _min_comm_nnodes, 0, (nb_nodes - _min_comm_nnodes) * sizeof(_min_comm_ntasks[0]));
+		_min_comm_nnodes = nb_nodes;
+	}
+
+	for(i= 0 ; i<nb_data ; i++)
+	{
+		starpu_data_handle_t data = descr[i].handle;
+		enum starpu_data_access_mode mode = descr[i].mode;
+		int rank = starpu_data_get_rank(data);
+		size_t size = data->ops->get_size(data);
+
+		if (rank < 0)
+			/* Per-node data, available everywhere */
+			continue;
+
+		for(node=0 ; node<nb_nodes ; node++)
+		{
+			if (node == rank)
+				continue;
+
+			/* The cache is flushed on write, so data in W mode
+			 * cannot be cached anyway */
+			if ((mode & STARPU_R) && !_starpu_mpi_cache_holders_get(data, node))
+				comm_on_nodes[node] += size;
+
+			if (mode & STARPU_W)
+				/* Would have to transfer it back */
+				comm_on_nodes[node] += size;
+		}
+	}
+
+	for(node=1 ; node<nb_nodes ; node++)
+	{
+		if (comm_on_nodes[node] < comm_on_nodes[xrank]
+		    || (comm_on_nodes[node] == comm_on_nodes[xrank] && _min_comm_ntasks[node] < _min_comm_ntasks[xrank]))
+			xrank = node;
+	}
+	_min_comm_ntasks[xrank]++;
+
+	free(comm_on_nodes);
+	return xrank;
+}
+
 int _starpu_mpi_select_node(int me, int nb_nodes, struct starpu_data_descr *descr, int nb_data, int policy)
 {
 	int ppolicy = policy == STARPU_MPI_NODE_SELECTION_CURRENT_POLICY ? _current_policy : policy;
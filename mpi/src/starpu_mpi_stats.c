@@ -31,9 +31,7 @@ static double time_init;
 static MPI_Comm comm_init;
 static int nb_sends = 0;
 static size_t max_sent_size = 0;
-#ifdef STARPU_USE_MPI_NMAD
 static struct _starpu_spinlock stats_lock;
-#endif
 
 void _starpu_mpi_comm_amounts_init(MPI_Comm comm)
 {
@@ -65,9 +63,7 @@ void _starpu_mpi_comm_amounts_init(MPI_Comm comm)
 	nb_coop = 0;
 	_STARPU_MPI_CALLOC(nb_nodes_per_coop, world_size, sizeof(int));
 
-#ifdef STARPU_USE_MPI_NMAD
 	_starpu_spin_init(&stats_lock);
-#endif
 }
 
 void _starpu_mpi_comm_stats_disable()
@@ -93,9 +89,7 @@ void _starpu_mpi_comm_amounts_shutdown()
 		comm_amount = NULL;
 		nb_nodes_per_coop = NULL;
 
-#ifdef STARPU_USE_MPI_NMAD
 		_starpu_spin_destroy(&stats_lock);
-#endif
 	}
 }
 
@@ -113,11 +107,10 @@ void _starpu_mpi_comm_amounts_inc(MPI_Comm comm, unsigned memnode, unsigned dst,
 
 	STARPU_ASSERT(memnode < starpu_memory_nodes_get_count());
 
-#ifdef STARPU_USE_MPI_NMAD
-	/* With NewMadeleine, the send requests are triggered from the workers, so
-	 * this is a critical section. */
+	/* With NewMadeleine, the send requests are triggered from the workers,
+	 * and with STARPU_MPI_NPROGRESS_THREADS from several progression
+	 * threads, so this is a critical section. */
 	_starpu_spin_lock(&stats_lock);
-#endif
 
 	comm_amount[dst] += count*size;
 	comm_amount_memnode[memnode] += count*size;
@@ -129,9 +122,7 @@ void _starpu_mpi_comm_amounts_inc(MPI_Comm comm, unsigned memnode, unsigned dst,
 
 	nb_sends++;
 
-#ifdef STARPU_USE_MPI_NMAD
 	_starpu_spin_unlock(&stats_lock);
-#endif
 }
 
 void _starpu_mpi_nb_coop_inc(int nb_nodes_in_coop)
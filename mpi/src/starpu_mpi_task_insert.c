@@ -128,6 +128,11 @@ int _starpu_mpi_exchange_data_before_execution(starpu_data_handle_t data, enum s
 			_STARPU_ERROR("StarPU needs to be told the MPI rank of this data, using starpu_mpi_data_register\n");
 		}
 
+		if (mpi_rank != STARPU_MPI_PER_NODE && xrank != mpi_rank)
+			/* All nodes note that the executee node will get a
+			 * copy, for node selection policies */
+			_starpu_mpi_cache_holders_set(data, xrank);
+
 		if (do_execute && mpi_rank != STARPU_MPI_PER_NODE && mpi_rank != me)
 		{
 			/* The node is going to execute the codelet, but it does not own the data, it needs to receive the data from the owner node */
@@ -211,6 +216,7 @@ void _starpu_mpi_clear_data_after_execution(starpu_data_handle_t data, enum star
 			/* The data has been modified, it MUST be removed from the cache */
 			starpu_mpi_cached_send_clear(data);
 			starpu_mpi_cached_receive_clear(data);
+			_starpu_mpi_cache_holders_clear(data);
 		}
 	}
 	else
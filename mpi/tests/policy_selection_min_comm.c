@@ -0,0 +1,166 @@
+/* StarPU --- Runtime system for heterogeneous multicore architectures.
+ *
+ * Copyright (C) 2023       Université de Bordeaux, CNRS (LaBRI UMR 5800), Inria
+ *
+ * StarPU is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or (at
+ * your option) any later version.
+ *
+ * StarPU is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU Lesser General Public License in COPYING.LGPL for more details.
+ */
+
+#include <starpu_mpi.h>
+#include "helper.h"
+
+/*
+ * Check that the STARPU_MPI_NODE_SELECTION_MIN_COMM policy takes into account
+ * the size of the data, the data already cached by the nodes, and balances
+ * the tasks between the nodes when they need the same amount of
+ * communications.
+ */
+
+#define NX 1024
+
+void func_cpu(void *descr[], void *_args)
+{
+	(void)descr;
+	(void)_args;
+}
+
+struct starpu_codelet mycodelet =
+{
+	.cpu_funcs = {func_cpu},
+	.nbuffers = 2,
+	.modes = {STARPU_R, STARPU_R},
+	.model = &starpu_perfmodel_nop,
+};
+
+static void check_insert(int rank, int expected, starpu_data_handle_t handle0, starpu_data_handle_t handle1, int execute_on_node)
+{
+	struct starpu_task *task;
+	int ret;
+
+	if (execute_on_node >= 0)
+		task = starpu_mpi_task_build(MPI_COMM_WORLD, &mycodelet,
+					     STARPU_R, handle0, STARPU_R, handle1,
+					     STARPU_EXECUTE_ON_NODE, execute_on_node,
+					     0);
+	else
+		task = starpu_mpi_task_build(MPI_COMM_WORLD, &mycodelet,
+					     STARPU_R, handle0, STARPU_R, handle1,
+					     STARPU_NODE_SELECTION_POLICY, STARPU_MPI_NODE_SELECTION_MIN_COMM,
+					     0);
+	FPRINTF_MPI(stderr, "Task %p\n", task);
+	if (rank == expected)
+	{
+		STARPU_ASSERT_MSG(task, "Task should be executed by rank %d", expected);
+		ret = starpu_task_submit(task);
+		STARPU_CHECK_RETURN_VALUE(ret, "starpu_task_submit");
+	}
+	else
+	{
+		STARPU_ASSERT_MSG(task == NULL, "Task should be executed by rank %d", expected);
+	}
+	if (execute_on_node >= 0)
+		starpu_mpi_task_post_build(MPI_COMM_WORLD, &mycodelet,
+					   STARPU_R, handle0, STARPU_R, handle1,
+					   STARPU_EXECUTE_ON_NODE, execute_on_node,
+					   0);
+	else
+		starpu_mpi_task_post_build(MPI_COMM_WORLD, &mycodelet,
+					   STARPU_R, handle0, STARPU_R, handle1,
+					   STARPU_NODE_SELECTION_POLICY, STARPU_MPI_NODE_SELECTION_MIN_COMM,
+					   0);
+}
+
+int main(int argc, char **argv)
+{
+	int ret;
+	int rank, size;
+	int mpi_init;
+	struct starpu_conf conf;
+	static int big0[NX], big1[NX], medium0[NX/2], small0, small1;
+	starpu_data_handle_t big0_handle, big1_handle, medium0_handle, small0_handle, small1_handle;
+
+	MPI_INIT_THREAD(&argc, &argv, MPI_THREAD_SERIALIZED, &mpi_init);
+
+	starpu_conf_init(&conf);
+	starpu_conf_noworker(&conf);
+	conf.ncpus = -1;
+	conf.nmpi_ms = -1;
+	conf.ntcpip_ms = -1;
+
+	ret = starpu_mpi_init_conf(&argc, &argv, mpi_init, MPI_COMM_WORLD, &conf);
+	STARPU_CHECK_RETURN_VALUE(ret, "starpu_mpi_init_conf");
+
+	starpu_mpi_comm_rank(MPI_COMM_WORLD, &rank);
+	starpu_mpi_comm_size(MPI_COMM_WORLD, &size);
+
+	if (size != 2 || starpu_cpu_worker_get_count() == 0 || !starpu_mpi_cache_is_enabled())
+	{
+		if (rank == 0)
+		{
+			if (size != 2)
+				FPRINTF(stderr, "We need exactly 2 processes.\n");
+			else if (starpu_cpu_worker_get_count() == 0)
+				FPRINTF(stderr, "We need at least 1 CPU worker.\n");
+			else
+				FPRINTF(stderr, "We need the MPI cache.\n");
+		}
+		starpu_mpi_shutdown();
+		if (!mpi_init)
+			MPI_Finalize();
+		return rank == 0 ? STARPU_TEST_SKIPPED : 0;
+	}
+
+	starpu_vector_data_register(&big0_handle, rank == 0 ? STARPU_MAIN_RAM : -1, rank == 0 ? (uintptr_t)big0 : 0, NX, sizeof(big0[0]));
+	starpu_mpi_data_register(big0_handle, 10, 0);
+	starpu_vector_data_register(&big1_handle, rank == 1 ? STARPU_MAIN_RAM : -1, rank == 1 ? (uintptr_t)big1 : 0, NX, sizeof(big1[0]));
+	starpu_mpi_data_register(big1_handle, 11, 1);
+	starpu_vector_data_register(&medium0_handle, rank == 0 ? STARPU_MAIN_RAM : -1, rank == 0 ? (uintptr_t)medium0 : 0, NX/2, sizeof(medium0[0]));
+	starpu_mpi_data_register(medium0_handle, 12, 0);
+	starpu_variable_data_register(&small0_handle, rank == 0 ? STARPU_MAIN_RAM : -1, rank == 0 ? (uintptr_t)&small0 : 0, sizeof(small0));
+	starpu_mpi_data_register(small0_handle, 13, 0);
+	starpu_variable_data_register(&small1_handle, rank == 1 ? STARPU_MAIN_RAM : -1, rank == 1 ? (uintptr_t)&small1 : 0, sizeof(small1));
+	starpu_mpi_data_register(small1_handle, 14, 1);
+
+	// Node 0 owns the biggest data
+	check_insert(rank, 0, big0_handle, small1_handle, -1);
+
+	// Make node 0 get a copy of big1
+	check_insert(rank, 0, big1_handle, small0_handle, 0);
+
+	// big1 is now cached on node 0, so node 0 does not need any
+	// communication while node 1 would need medium0
+	check_insert(rank, 0, big1_handle, medium0_handle, -1);
+
+	// Flush the copy of small1 on node 0. small0 and small1 have the same
+	// size, the policy gave 2 tasks to node 0, so node 1 is selected
+	starpu_mpi_cache_flush(MPI_COMM_WORLD, small1_handle);
+	check_insert(rank, 1, small0_handle, small1_handle, -1);
+	// Flush the copy of small0 on node 1, node 1 still got less tasks
+	starpu_mpi_cache_flush(MPI_COMM_WORLD, small0_handle);
+	check_insert(rank, 1, small0_handle, small1_handle, -1);
+	starpu_mpi_cache_flush(MPI_COMM_WORLD, small0_handle);
+	// Tasks are now balanced, node 0 is selected
+	check_insert(rank, 0, small0_handle, small1_handle, -1);
+
+	starpu_task_wait_for_all();
+
+	starpu_data_unregister(big0_handle);
+	starpu_data_unregister(big1_handle);
+	starpu_data_unregister(medium0_handle);
+	starpu_data_unregister(small0_handle);
+	starpu_data_unregister(small1_handle);
+
+	starpu_mpi_shutdown();
+	if (!mpi_init)
+		MPI_Finalize();
+
+	return 0;
+}
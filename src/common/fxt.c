@@ -27,8 +27,10 @@ unsigned long _starpu_job_cnt = 0;
 
 #ifdef STARPU_USE_FXT
 #include <common/fxt.h>
+#include <common/timing.h>
 #include <starpu_fxt.h>
 #include <sys/stat.h>
+#include <sys/time.h>
 
 #ifdef STARPU_HAVE_WINDOWS
 #include <windows.h>
@@ -54,6 +56,17 @@ unsigned long _starpu_submit_order = 0;
 
 static int _starpu_written = 0;
 
+/* Record task events for only one job out of _starpu_fxt_task_sampling */
+unsigned long _starpu_fxt_task_sampling = 1;
+
+/* Period (in us) of the worker status snapshots, 0 to disable them */
+static unsigned long snapshot_period = 0;
+static starpu_pthread_t snapshot_thread;
+/* Protects snapshot_stop, snapshot_cond wakes the snapshot thread up on stop */
+static starpu_pthread_mutex_t snapshot_mutex;
+static starpu_pthread_cond_t snapshot_cond;
+static int snapshot_stop;
+
 static int _starpu_id;
 
 /* If we use several MPI processes, we can't use STARPU_GENERATE_TRACE=1,
@@ -296,6 +309,9 @@ void _starpu_fxt_init_profiling(uint64_t trace_buffer_size)
 	_starpu_written = 0;
 	_starpu_profile_set_tracefile();
 
+	_starpu_fxt_task_sampling = starpu_getenv_number_default("STARPU_FXT_TASK_SAMPLING", 1);
+	snapshot_period = starpu_getenv_number_default("STARPU_FXT_SNAPSHOT_PERIOD", 0);
+
 	STARPU_HG_DISABLE_CHECKING(fut_active);
 
 #ifdef HAVE_FUT_SET_FILENAME
@@ -328,6 +344,78 @@ void _starpu_fxt_init_profiling(uint64_t trace_buffer_size)
 	return;
 }
 
+/* Periodically record what each worker is doing, so that a coarse view of
+ * the worker activity is available even when only a fraction of the tasks
+ * are recorded */
+static void *snapshot_func(void *arg)
+{
+	(void) arg;
+	starpu_pthread_setname("fxt_snapshot");
+
+	STARPU_PTHREAD_MUTEX_LOCK(&snapshot_mutex);
+	while (!snapshot_stop)
+	{
+		struct timespec abstime;
+#ifdef STARPU_SIMGRID
+		_starpu_clock_gettime(&abstime);
+#else
+		struct timeval now;
+		gettimeofday(&now, NULL);
+		abstime.tv_sec = now.tv_sec;
+		abstime.tv_nsec = now.tv_usec * 1000;
+#endif
+		abstime.tv_sec += snapshot_period / 1000000;
+		abstime.tv_nsec += (snapshot_period % 1000000) * 1000;
+		if (abstime.tv_nsec >= 1000000000)
+		{
+			abstime.tv_sec++;
+			abstime.tv_nsec -= 1000000000;
+		}
+
+		/* Sleep for the period, unless we get stopped in between */
+		while (!snapshot_stop && starpu_pthread_cond_timedwait(&snapshot_cond, &snapshot_mutex, &abstime) != ETIMEDOUT)
+			;
+		if (snapshot_stop)
+			break;
+		STARPU_PTHREAD_MUTEX_UNLOCK(&snapshot_mutex);
+
+		unsigned nworkers = starpu_worker_get_count();
+		unsigned workerid;
+		for (workerid = 0; workerid < nworkers; workerid++)
+			_STARPU_TRACE_WORKER_STATUS_SNAPSHOT(workerid, (unsigned long) _starpu_worker_get_status(workerid));
+
+		STARPU_PTHREAD_MUTEX_LOCK(&snapshot_mutex);
+	}
+	STARPU_PTHREAD_MUTEX_UNLOCK(&snapshot_mutex);
+	return NULL;
+}
+
+void _starpu_fxt_snapshot_init(void)
+{
+	if (!_starpu_fxt_started || !snapshot_period)
+		return;
+
+	STARPU_PTHREAD_MUTEX_INIT(&snapshot_mutex, NULL);
+	STARPU_PTHREAD_COND_INIT(&snapshot_cond, NULL);
+	snapshot_stop = 0;
+	STARPU_PTHREAD_CREATE(&snapshot_thread, NULL, snapshot_func, NULL);
+}
+
+void _starpu_fxt_snapshot_shutdown(void)
+{
+	if (!_starpu_fxt_started || !snapshot_period)
+		return;
+
+	STARPU_PTHREAD_MUTEX_LOCK(&snapshot_mutex);
+	snapshot_stop = 1;
+	STARPU_PTHREAD_COND_SIGNAL(&snapshot_cond);
+	STARPU_PTHREAD_MUTEX_UNLOCK(&snapshot_mutex);
+
+	STARPU_PTHREAD_JOIN(snapshot_thread, NULL);
+	STARPU_PTHREAD_COND_DESTROY(&snapshot_cond);
+	STARPU_PTHREAD_MUTEX_DESTROY(&snapshot_mutex);
+}
+
 int _starpu_generate_paje_trace_read_option(const char *option, struct starpu_fxt_options *options)
 {
 	if (strcmp(option, "-c") == 0)
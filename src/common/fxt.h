@@ -250,6 +250,8 @@
 #define	_STARPU_FUT_START_PARALLEL_SYNC	0x518a
 #define	_STARPU_FUT_END_PARALLEL_SYNC	0x518b
 
+#define _STARPU_FUT_WORKER_STATUS_SNAPSHOT	0x518c
+
 /* Predefined FUT key masks */
 #define _STARPU_FUT_KEYMASK_META           FUT_KEYMASK0
 #define _STARPU_FUT_KEYMASK_USER           FUT_KEYMASK1
@@ -343,6 +345,24 @@ void _starpu_profiling_set_mpi_worldsize(int worldsize) STARPU_ATTRIBUTE_VISIBIL
 /** Generate the trace file. Used when catching signals SIGINT and SIGSEGV */
 void _starpu_fxt_dump_file(void);
 
+/** Start the thread which periodically records the status of each worker,
+ * if STARPU_FXT_SNAPSHOT_PERIOD is set. */
+void _starpu_fxt_snapshot_init(void);
+
+/** Wait for the worker status snapshot thread to terminate. */
+void _starpu_fxt_snapshot_shutdown(void);
+
+/** When STARPU_FXT_TASK_SAMPLING is set to N > 1, only one job out of N
+ * gets its task-related events recorded, dependencies being only recorded
+ * between two recorded jobs. */
+extern unsigned long _starpu_fxt_task_sampling;
+
+#define _STARPU_FXT_JOB_ID_SAMPLED(id) \
+	(STARPU_LIKELY(_starpu_fxt_task_sampling <= 1) || (id) % _starpu_fxt_task_sampling == 0)
+
+#define _STARPU_FXT_JOB_SAMPLED(job) \
+	_STARPU_FXT_JOB_ID_SAMPLED((job)->job_id)
+
 #ifdef FUT_NEEDS_COMMIT
 #define _STARPU_FUT_COMMIT(size) fut_commitstampedbuffer(size)
 #else
@@ -823,7 +843,7 @@ do {									\
 
 #define _STARPU_TRACE_START_CODELET_BODY(job, nimpl, perf_arch, workerid, rank)				\
 do {									\
-    if(STARPU_UNLIKELY((_STARPU_FUT_KEYMASK_TASK|_STARPU_FUT_KEYMASK_TASK_VERBOSE|_STARPU_FUT_KEYMASK_DATA|_STARPU_FUT_KEYMASK_TASK_VERBOSE_EXTRA) & fut_active)) { \
+    if(STARPU_UNLIKELY((_STARPU_FUT_KEYMASK_TASK|_STARPU_FUT_KEYMASK_TASK_VERBOSE|_STARPU_FUT_KEYMASK_DATA|_STARPU_FUT_KEYMASK_TASK_VERBOSE_EXTRA) & fut_active) && _STARPU_FXT_JOB_SAMPLED(job)) { \
 	int mem_node = workerid == -1 ? -1 : (int)starpu_worker_get_memory_node(workerid); \
 	int codelet_null = (job)->task->cl == NULL; \
 	int nowhere = ((job)->task->where == STARPU_NOWHERE) || ((job)->task->cl != NULL && (job)->task->cl->where == STARPU_NOWHERE); \
@@ -868,7 +888,7 @@ do {									\
 
 #define _STARPU_TRACE_END_CODELET_BODY(job, nimpl, perf_arch, workerid, rank)			\
 do {									\
-    if(STARPU_UNLIKELY((_STARPU_FUT_KEYMASK_TASK) & fut_active)) { \
+    if(STARPU_UNLIKELY((_STARPU_FUT_KEYMASK_TASK) & fut_active) && _STARPU_FXT_JOB_SAMPLED(job)) { \
 	    const size_t job_size = (perf_arch == NULL) ? 0 : _starpu_job_get_data_size((job)->task->cl?(job)->task->cl->model:NULL, perf_arch, nimpl, (job)); \
 	    const uint32_t job_hash = (perf_arch == NULL) ? 0 : _starpu_compute_buffers_footprint((job)->task->cl?(job)->task->cl->model:NULL, perf_arch, nimpl, (job)); \
 	    char _archname[32]="";					\
@@ -880,28 +900,54 @@ do {									\
 } while(0)
 
 #define _STARPU_TRACE_START_EXECUTING(job)				\
-	FUT_FULL_PROBE2(_STARPU_FUT_KEYMASK_WORKER_VERBOSE, _STARPU_FUT_START_EXECUTING, _starpu_gettid(), (job)->job_id);
+do {									\
+	if (_STARPU_FXT_JOB_SAMPLED(job))				\
+		FUT_FULL_PROBE2(_STARPU_FUT_KEYMASK_WORKER_VERBOSE, _STARPU_FUT_START_EXECUTING, _starpu_gettid(), (job)->job_id); \
+} while(0)
 
 #define _STARPU_TRACE_END_EXECUTING(job)				\
-	FUT_FULL_PROBE2(_STARPU_FUT_KEYMASK_WORKER_VERBOSE, _STARPU_FUT_END_EXECUTING, _starpu_gettid(), (job)->job_id);
+do {									\
+	if (_STARPU_FXT_JOB_SAMPLED(job))				\
+		FUT_FULL_PROBE2(_STARPU_FUT_KEYMASK_WORKER_VERBOSE, _STARPU_FUT_END_EXECUTING, _starpu_gettid(), (job)->job_id); \
+} while(0)
 
 #define _STARPU_TRACE_START_PARALLEL_SYNC(job)				\
-	FUT_FULL_PROBE2(_STARPU_FUT_KEYMASK_WORKER_VERBOSE, _STARPU_FUT_START_PARALLEL_SYNC, _starpu_gettid(), (job)->job_id);
+do {									\
+	if (_STARPU_FXT_JOB_SAMPLED(job))				\
+		FUT_FULL_PROBE2(_STARPU_FUT_KEYMASK_WORKER_VERBOSE, _STARPU_FUT_START_PARALLEL_SYNC, _starpu_gettid(), (job)->job_id); \
+} while(0)
 
 #define _STARPU_TRACE_END_PARALLEL_SYNC(job)				\
-	FUT_FULL_PROBE2(_STARPU_FUT_KEYMASK_WORKER_VERBOSE, _STARPU_FUT_END_PARALLEL_SYNC, _starpu_gettid(), (job)->job_id);
+do {									\
+	if (_STARPU_FXT_JOB_SAMPLED(job))				\
+		FUT_FULL_PROBE2(_STARPU_FUT_KEYMASK_WORKER_VERBOSE, _STARPU_FUT_END_PARALLEL_SYNC, _starpu_gettid(), (job)->job_id); \
+} while(0)
 
 #define _STARPU_TRACE_START_CALLBACK(job)	\
-	FUT_FULL_PROBE2(_STARPU_FUT_KEYMASK_WORKER_VERBOSE, _STARPU_FUT_START_CALLBACK, job, _starpu_gettid());
+do {									\
+	if (_STARPU_FXT_JOB_SAMPLED(job))				\
+		FUT_FULL_PROBE2(_STARPU_FUT_KEYMASK_WORKER_VERBOSE, _STARPU_FUT_START_CALLBACK, job, _starpu_gettid()); \
+} while(0)
 
 #define _STARPU_TRACE_END_CALLBACK(job)	\
-	FUT_FULL_PROBE2(_STARPU_FUT_KEYMASK_WORKER_VERBOSE, _STARPU_FUT_END_CALLBACK, job, _starpu_gettid());
+do {									\
+	if (_STARPU_FXT_JOB_SAMPLED(job))				\
+		FUT_FULL_PROBE2(_STARPU_FUT_KEYMASK_WORKER_VERBOSE, _STARPU_FUT_END_CALLBACK, job, _starpu_gettid()); \
+} while(0)
 
 #define _STARPU_TRACE_JOB_PUSH(task, prio)	\
-	FUT_FULL_PROBE3(_STARPU_FUT_KEYMASK_SCHED, _STARPU_FUT_JOB_PUSH, _starpu_get_job_associated_to_task(task)->job_id, prio, _starpu_gettid());
+do {									\
+	struct _starpu_job *__job = _starpu_get_job_associated_to_task(task); \
+	if (_STARPU_FXT_JOB_SAMPLED(__job))				\
+		FUT_FULL_PROBE3(_STARPU_FUT_KEYMASK_SCHED, _STARPU_FUT_JOB_PUSH, __job->job_id, prio, _starpu_gettid()); \
+} while(0)
 
 #define _STARPU_TRACE_JOB_POP(task, prio)	\
-	FUT_FULL_PROBE3(_STARPU_FUT_KEYMASK_SCHED, _STARPU_FUT_JOB_POP, _starpu_get_job_associated_to_task(task)->job_id, prio, _starpu_gettid());
+do {									\
+	struct _starpu_job *__job = _starpu_get_job_associated_to_task(task); \
+	if (_STARPU_FXT_JOB_SAMPLED(__job))				\
+		FUT_FULL_PROBE3(_STARPU_FUT_KEYMASK_SCHED, _STARPU_FUT_JOB_POP, __job->job_id, prio, _starpu_gettid()); \
+} while(0)
 
 #define _STARPU_TRACE_UPDATE_TASK_CNT(counter)	\
 	FUT_FULL_PROBE2(_STARPU_FUT_KEYMASK_TASK, _STARPU_FUT_UPDATE_TASK_CNT, counter, _starpu_gettid())
@@ -925,29 +971,45 @@ do {									\
 	FUT_FULL_PROBE2(_STARPU_FUT_KEYMASK_WORKER_VERBOSE, _STARPU_FUT_START_FETCH_INPUT, job, id);
 
 #define _STARPU_TRACE_TAG(tag, job)	\
-	FUT_FULL_PROBE2(_STARPU_FUT_KEYMASK_TASK, _STARPU_FUT_TAG, tag, (job)->job_id)
+do {									\
+	if (_STARPU_FXT_JOB_SAMPLED(job))				\
+		FUT_FULL_PROBE2(_STARPU_FUT_KEYMASK_TASK, _STARPU_FUT_TAG, tag, (job)->job_id); \
+} while(0)
 
 #define _STARPU_TRACE_TAG_DEPS(tag_child, tag_parent)	\
 	FUT_FULL_PROBE2(_STARPU_FUT_KEYMASK_TASK, _STARPU_FUT_TAG_DEPS, tag_child, tag_parent)
 
 #define _STARPU_TRACE_TASK_DEPS(job_prev, job_succ)	\
-	_STARPU_FUT_FULL_PROBE4STR(_STARPU_FUT_KEYMASK_TASK, _STARPU_FUT_TASK_DEPS, (job_prev)->job_id, (job_succ)->job_id, (job_succ)->task->type, 1, "task")
+do {									\
+	if (_STARPU_FXT_JOB_SAMPLED(job_prev) && _STARPU_FXT_JOB_SAMPLED(job_succ)) \
+		_STARPU_FUT_FULL_PROBE4STR(_STARPU_FUT_KEYMASK_TASK, _STARPU_FUT_TASK_DEPS, (job_prev)->job_id, (job_succ)->job_id, (job_succ)->task->type, 1, "task"); \
+} while(0)
 
 #define _STARPU_TRACE_TASK_END_DEP(job_prev, job_succ) \
-	FUT_DO_PROBE2(_STARPU_FUT_TASK_END_DEP, (job_prev)->job_id, (job_succ)->job_id)
+do {									\
+	if (_STARPU_FXT_JOB_SAMPLED(job_prev) && _STARPU_FXT_JOB_SAMPLED(job_succ)) \
+		FUT_DO_PROBE2(_STARPU_FUT_TASK_END_DEP, (job_prev)->job_id, (job_succ)->job_id); \
+} while(0)
 
 #define _STARPU_TRACE_GHOST_TASK_DEPS(ghost_prev_id, job_succ)		\
-	_STARPU_FUT_FULL_PROBE4STR(_STARPU_FUT_KEYMASK_TASK_VERBOSE, _STARPU_FUT_TASK_DEPS, (ghost_prev_id), (job_succ)->job_id, (job_succ)->task->type, 1, "ghost")
+do {									\
+	if (_STARPU_FXT_JOB_ID_SAMPLED(ghost_prev_id) && _STARPU_FXT_JOB_SAMPLED(job_succ)) \
+		_STARPU_FUT_FULL_PROBE4STR(_STARPU_FUT_KEYMASK_TASK_VERBOSE, _STARPU_FUT_TASK_DEPS, (ghost_prev_id), (job_succ)->job_id, (job_succ)->task->type, 1, "ghost"); \
+} while(0)
 
 #ifdef STARPU_RECURSIVE_TASKS
 #define _STARPU_TRACE_RECURSIVE_TASK_DEPS(prev_id, job_succ)		\
-	_STARPU_FUT_FULL_PROBE4STR(_STARPU_FUT_KEYMASK_TASK_VERBOSE, _STARPU_FUT_TASK_DEPS, (prev_id), (job_succ)->job_id, (job_succ)->task->type, 1, "recursive_task")
+do {									\
+	if (_STARPU_FXT_JOB_ID_SAMPLED(prev_id) && _STARPU_FXT_JOB_SAMPLED(job_succ)) \
+		_STARPU_FUT_FULL_PROBE4STR(_STARPU_FUT_KEYMASK_TASK_VERBOSE, _STARPU_FUT_TASK_DEPS, (prev_id), (job_succ)->job_id, (job_succ)->task->type, 1, "recursive_task"); \
+} while(0)
 #endif
 
 #define _STARPU_TRACE_TASK_EXCLUDE_FROM_DAG(job)			\
 	do {								\
 	unsigned exclude_from_dag = (job)->exclude_from_dag;		\
-	FUT_FULL_PROBE2(_STARPU_FUT_KEYMASK_TASK, _STARPU_FUT_TASK_EXCLUDE_FROM_DAG, (job)->job_id, (long unsigned)exclude_from_dag); \
+	if (_STARPU_FXT_JOB_SAMPLED(job))				\
+		FUT_FULL_PROBE2(_STARPU_FUT_KEYMASK_TASK, _STARPU_FUT_TASK_EXCLUDE_FROM_DAG, (job)->job_id, (long unsigned)exclude_from_dag); \
 } while(0)
 
 #define _STARPU_TRACE_TASK_NAME_LINE_COLOR(job)				\
@@ -959,14 +1021,14 @@ do {									\
 
 #define _STARPU_TRACE_TASK_LINE(job)					\
 	do {								\
-		if ((job)->task->file)					\
+		if ((job)->task->file && _STARPU_FXT_JOB_SAMPLED(job))	\
 			_STARPU_FUT_FULL_PROBE2STR(_STARPU_FUT_KEYMASK_TASK, _STARPU_FUT_TASK_LINE, (job)->job_id, (job)->task->line, (job)->task->file); \
 } while(0)
 
 #ifdef STARPU_RECURSIVE_TASKS
 #define _STARPU_TRACE_RECURSIVE_TASK(job)					\
 do {								\
-    if(STARPU_UNLIKELY((_STARPU_FUT_KEYMASK_TASK) & fut_active)) { \
+    if(STARPU_UNLIKELY((_STARPU_FUT_KEYMASK_TASK) & fut_active) && _STARPU_FXT_JOB_SAMPLED(job)) { \
 	unsigned int is_recursive_task=(job)->is_recursive_task;			\
 	unsigned long recursive_task_parent=(job)->task->recursive_task_parent;		\
 	FUT_FULL_PROBE3(_STARPU_FUT_KEYMASK_TASK, _STARPU_FUT_RECURSIVE_TASK, (job)->job_id, is_recursive_task, recursive_task_parent); \
@@ -976,7 +1038,7 @@ do {								\
 
 #define _STARPU_TRACE_TASK_NAME(job)				\
 do {								\
-    if(STARPU_UNLIKELY((_STARPU_FUT_KEYMASK_TASK) & fut_active)) { \
+    if(STARPU_UNLIKELY((_STARPU_FUT_KEYMASK_TASK) & fut_active) && _STARPU_FXT_JOB_SAMPLED(job)) { \
         const char *model_name = _starpu_job_get_model_name((job));		\
 	const char *name = _starpu_job_get_task_name((job));			\
 	if (name)					                        \
@@ -993,7 +1055,7 @@ do {								\
 
 #define _STARPU_TRACE_TASK_COLOR(job)						\
 do { \
-    if(STARPU_UNLIKELY((_STARPU_FUT_KEYMASK_TASK) & fut_active)) { \
+    if(STARPU_UNLIKELY((_STARPU_FUT_KEYMASK_TASK) & fut_active) && _STARPU_FXT_JOB_SAMPLED(job)) { \
 	if ((job)->task->color != 0) \
 		FUT_FULL_PROBE2(_STARPU_FUT_KEYMASK_TASK, _STARPU_FUT_TASK_COLOR, (job)->job_id, (job)->task->color); \
 	else if ((job)->task->cl && (job)->task->cl->color != 0) \
@@ -1002,11 +1064,14 @@ do { \
 } while(0)
 
 #define _STARPU_TRACE_TASK_DONE(job)						\
-	FUT_FULL_PROBE2(_STARPU_FUT_KEYMASK_TASK, _STARPU_FUT_TASK_DONE, (job)->job_id, _starpu_gettid())
+do {										\
+	if (_STARPU_FXT_JOB_SAMPLED(job))					\
+		FUT_FULL_PROBE2(_STARPU_FUT_KEYMASK_TASK, _STARPU_FUT_TASK_DONE, (job)->job_id, _starpu_gettid()); \
+} while(0)
 
 #define _STARPU_TRACE_TAG_DONE(tag)						\
 do {										\
-    if(STARPU_UNLIKELY((_STARPU_FUT_KEYMASK_TASK) & fut_active)) { \
+    if(STARPU_UNLIKELY((_STARPU_FUT_KEYMASK_TASK) & fut_active) && _STARPU_FXT_JOB_SAMPLED((tag)->job)) { \
         struct _starpu_job *job = (tag)->job;                                  \
         const char *model_name = _starpu_job_get_task_name((job));                       \
 	if (model_name)                                                         \
@@ -1081,11 +1146,17 @@ do {										\
 #define _STARPU_TRACE_WORKER_SLEEP_START	\
 	FUT_FULL_PROBE1(_STARPU_FUT_KEYMASK_WORKER, _STARPU_FUT_WORKER_SLEEP_START, _starpu_gettid());
 
+#define _STARPU_TRACE_WORKER_STATUS_SNAPSHOT(workerid, status)	\
+	FUT_FULL_PROBE2(_STARPU_FUT_KEYMASK_WORKER, _STARPU_FUT_WORKER_STATUS_SNAPSHOT, workerid, status);
+
 #define _STARPU_TRACE_WORKER_SLEEP_END	\
 	FUT_FULL_PROBE1(_STARPU_FUT_KEYMASK_WORKER, _STARPU_FUT_WORKER_SLEEP_END, _starpu_gettid());
 
 #define _STARPU_TRACE_TASK_SUBMIT(job, iter, subiter)	\
-	FUT_FULL_PROBE7(_STARPU_FUT_KEYMASK_TASK, _STARPU_FUT_TASK_SUBMIT, (job)->job_id, iter, subiter, (job)->task->no_submitorder?0:_starpu_fxt_get_submit_order(), (job)->task->priority, (job)->task->type, _starpu_gettid());
+do {									\
+	if (_STARPU_FXT_JOB_SAMPLED(job))				\
+		FUT_FULL_PROBE7(_STARPU_FUT_KEYMASK_TASK, _STARPU_FUT_TASK_SUBMIT, (job)->job_id, iter, subiter, (job)->task->no_submitorder?0:_starpu_fxt_get_submit_order(), (job)->task->priority, (job)->task->type, _starpu_gettid()); \
+} while(0)
 
 #define _STARPU_TRACE_TASK_SUBMIT_START()	\
 	FUT_FULL_PROBE1(_STARPU_FUT_KEYMASK_TASK_VERBOSE, _STARPU_FUT_TASK_SUBMIT_START, _starpu_gettid());
@@ -1175,7 +1246,11 @@ do {										\
 	FUT_FULL_PROBE2(_STARPU_FUT_KEYMASK_DSM_VERBOSE, _STARPU_FUT_END_WRITEBACK_ASYNC, memnode, _starpu_gettid());
 
 #define _STARPU_TRACE_PAPI_TASK_EVENT(event_id, task, value)	\
-	FUT_DO_PROBE3(_STARPU_FUT_PAPI_TASK_EVENT_VALUE, event_id, _starpu_get_job_associated_to_task(task)->job_id, value)
+do {									\
+	struct _starpu_job *__job = _starpu_get_job_associated_to_task(task); \
+	if (_STARPU_FXT_JOB_SAMPLED(__job))				\
+		FUT_DO_PROBE3(_STARPU_FUT_PAPI_TASK_EVENT_VALUE, event_id, __job->job_id, value); \
+} while(0)
 
 /* We skip these events because they are called so often that they cause FxT to
  * fail and make the overall trace unreadable anyway. */
@@ -1402,10 +1477,16 @@ do {										\
 	if (STARPU_UNLIKELY(fut_active)) FUT_RAW_ALWAYS_PROBE2(FUT_CODE(_STARPU_FUT_SCHED_COMPONENT_CONNECT,2), parent, child);
 
 #define _STARPU_TRACE_SCHED_COMPONENT_PUSH(from, to, task, prio)		\
-	FUT_FULL_PROBE5(_STARPU_FUT_KEYMASK_SCHED, _STARPU_FUT_SCHED_COMPONENT_PUSH, _starpu_gettid(), from, to, task, prio);
+do {									\
+	if (_STARPU_FXT_JOB_SAMPLED(_starpu_get_job_associated_to_task(task))) \
+		FUT_FULL_PROBE5(_STARPU_FUT_KEYMASK_SCHED, _STARPU_FUT_SCHED_COMPONENT_PUSH, _starpu_gettid(), from, to, task, prio); \
+} while(0)
 
 #define _STARPU_TRACE_SCHED_COMPONENT_PULL(from, to, task)		\
-	FUT_FULL_PROBE5(_STARPU_FUT_KEYMASK_SCHED, _STARPU_FUT_SCHED_COMPONENT_PULL, _starpu_gettid(), from, to, task, (task)->priority);
+do {									\
+	if (_STARPU_FXT_JOB_SAMPLED(_starpu_get_job_associated_to_task(task))) \
+		FUT_FULL_PROBE5(_STARPU_FUT_KEYMASK_SCHED, _STARPU_FUT_SCHED_COMPONENT_PULL, _starpu_gettid(), from, to, task, (task)->priority); \
+} while(0)
 
 #define _STARPU_TRACE_HANDLE_DATA_REGISTER(handle)	do {	\
     if(STARPU_UNLIKELY((_STARPU_FUT_KEYMASK_META) & fut_active)) { \
@@ -1489,6 +1570,7 @@ do {										\
 #define _STARPU_TRACE_WORKER_SCHEDULING_PUSH		do {} while(0)
 #define _STARPU_TRACE_WORKER_SCHEDULING_POP		do {} while(0)
 #define _STARPU_TRACE_WORKER_SLEEP_START		do {} while(0)
+#define _STARPU_TRACE_WORKER_STATUS_SNAPSHOT(workerid, status)	do {(void)(workerid); (void)(status);} while(0)
 #define _STARPU_TRACE_WORKER_SLEEP_END			do {} while(0)
 #define _STARPU_TRACE_TASK_SUBMIT(job, a, b)			do {(void)(job); (void)(a);(void)(b);} while(0)
 #define _STARPU_TRACE_TASK_SUBMIT_START()		do {} while(0)
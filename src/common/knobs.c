@@ -47,6 +47,8 @@ void _starpu_perf_counter_sample_init(struct starpu_perf_counter_sample *sample,
 	sample->scope = scope;
 	sample->listener = NULL;
 	sample->value_array = NULL;
+	sample->next_update_array = NULL;
+	sample->due_array = NULL;
 	_starpu_spin_init(&sample->lock);
 }
 
@@ -59,6 +61,10 @@ void _starpu_perf_counter_sample_exit(struct starpu_perf_counter_sample *sample)
 		free(sample->value_array);
 	}
 	sample->value_array = NULL;
+	free(sample->next_update_array);
+	sample->next_update_array = NULL;
+	free(sample->due_array);
+	sample->due_array = NULL;
 	sample->scope = starpu_perf_counter_scope_undefined;
 	_starpu_spin_destroy(&sample->lock);
 }
@@ -83,6 +89,7 @@ void _starpu_perf_counter_init(struct _starpu_machine_config *pconfig)
 
 	/* call counter registration routines in each modules */
 	_starpu__task_c__register_counters();
+	_starpu__bound_c__register_counters();
 }
 
 void _starpu_perf_counter_exit(void)
@@ -327,6 +334,7 @@ struct starpu_perf_counter_set *starpu_perf_counter_set_alloc(enum starpu_perf_c
 	set->scope = scope;
 	set->size  = counters->size;
 	_STARPU_CALLOC(set->index_array, set->size, sizeof(*set->index_array));
+	_STARPU_CALLOC(set->period_array, set->size, sizeof(*set->period_array));
 	return set;
 }
 
@@ -334,6 +342,7 @@ void starpu_perf_counter_set_free(struct starpu_perf_counter_set *set)
 {
 	memset(set->index_array, 0, set->size*sizeof(*set->index_array));
 	free(set->index_array);
+	free(set->period_array);
 	memset(set, 0, sizeof(*set));
 	free(set);
 }
@@ -354,6 +363,13 @@ void starpu_perf_counter_set_disable_id(struct starpu_perf_counter_set *set, int
 	set->index_array[index] = 0;
 }
 
+void starpu_perf_counter_set_sample_period_id(struct starpu_perf_counter_set *set, int id, unsigned period)
+{
+	const int index = _starpu_perf_counter_id_get_index(id);
+	STARPU_ASSERT(index >= 0 && index < set->size);
+	set->period_array[index] = period;
+}
+
 /* - */
 
 struct starpu_perf_counter_listener *starpu_perf_counter_listener_init(struct starpu_perf_counter_set *set,
@@ -389,6 +405,13 @@ static void set_listener(struct starpu_perf_counter_sample *sample, struct starp
 	/* Assume a single listener, for now, which sets the set of counters to monitor */
 	STARPU_ASSERT(sample->value_array == NULL);
 	_STARPU_CALLOC(sample->value_array, sample->listener->set->size, sizeof(*sample->value_array));
+	STARPU_ASSERT(sample->next_update_array == NULL);
+	_STARPU_CALLOC(sample->next_update_array, sample->listener->set->size, sizeof(*sample->next_update_array));
+	STARPU_ASSERT(sample->due_array == NULL);
+	_STARPU_CALLOC(sample->due_array, sample->listener->set->size, sizeof(*sample->due_array));
+	if (sample->scope != starpu_perf_counter_scope_global)
+		/* Task execution times need to be measured */
+		(void)STARPU_ATOMIC_ADD(&_starpu_config.perf_counter_timed_listeners, 1);
 	_starpu_spin_unlock(&sample->lock);
 }
 
@@ -417,7 +440,21 @@ void starpu_perf_counter_set_all_per_worker_listeners(struct starpu_perf_counter
 void starpu_perf_counter_set_per_codelet_listener(struct starpu_codelet *cl, struct starpu_perf_counter_listener *listener)
 {
 	STARPU_ASSERT(cl->perf_counter_values == NULL);
-	_STARPU_CALLOC(cl->perf_counter_values, 1, sizeof(*cl->perf_counter_values));
+	/* Only allocate shards for the workers which actually exist, aligned
+	 * on cache lines */
+	unsigned nworkers = _starpu_worker_get_count();
+	size_t size = sizeof(*cl->perf_counter_values) + (nworkers + 1) * sizeof(cl->perf_counter_values->shards[0]);
+	void *values;
+#ifdef STARPU_HAVE_POSIX_MEMALIGN
+	if (posix_memalign(&values, STARPU_CACHELINE_SIZE, size))
+		values = NULL;
+#else
+	values = malloc(size);
+#endif
+	STARPU_ASSERT_MSG(values, "Cannot allocate %lu bytes of per-codelet counters\n", (unsigned long) size);
+	memset(values, 0, size);
+	cl->perf_counter_values = values;
+	cl->perf_counter_values->nworkers = nworkers;
 
 	STARPU_ASSERT(cl->perf_counter_sample == NULL);
 	_STARPU_MALLOC(cl->perf_counter_sample, sizeof(*cl->perf_counter_sample));
@@ -435,7 +472,13 @@ static void unset_listener(struct starpu_perf_counter_sample *sample)
 	memset(sample->value_array, 0, sample->listener->set->size * sizeof(*sample->value_array));
 	free(sample->value_array);
 	sample->value_array = NULL;
+	free(sample->next_update_array);
+	sample->next_update_array = NULL;
+	free(sample->due_array);
+	sample->due_array = NULL;
 	sample->listener = NULL;
+	if (sample->scope != starpu_perf_counter_scope_global)
+		(void)STARPU_ATOMIC_ADD(&_starpu_config.perf_counter_timed_listeners, -1);
 	_starpu_spin_unlock(&sample->lock);
 }
 
@@ -486,6 +529,32 @@ void _starpu_perf_counter_register_updater(enum starpu_perf_counter_scope scope,
 
 /* - */
 
+/* Determine which counters of the sample are to be refreshed: all of them,
+ * except those with a sampling period which has not elapsed yet */
+static void compute_due_counters(struct starpu_perf_counter_sample *sample)
+{
+	const struct starpu_perf_counter_set * const set = sample->listener->set;
+	double now = -1.;
+	int index;
+	for (index = 0; index < set->size; index++)
+	{
+		if (set->period_array[index] == 0)
+		{
+			sample->due_array[index] = 1;
+			continue;
+		}
+		if (now < 0.)
+			now = starpu_timing_now();
+		if (now >= sample->next_update_array[index])
+		{
+			sample->due_array[index] = 1;
+			sample->next_update_array[index] = now + set->period_array[index];
+		}
+		else
+			sample->due_array[index] = 0;
+	}
+}
+
 static void update_sample(struct starpu_perf_counter_sample *sample, void *context)
 {
 	if (sample->listener == NULL)
@@ -499,6 +568,8 @@ static void update_sample(struct starpu_perf_counter_sample *sample, void *conte
 	{
 		if (counters->updater_array_size > 0)
 		{
+			compute_due_counters(sample);
+
 			int upd_id;
 			for (upd_id = 0; upd_id < counters->updater_array_size; upd_id++)
 			{
@@ -530,6 +601,30 @@ void _starpu_perf_counter_update_per_codelet_sample(struct starpu_codelet *cl)
 	update_sample(cl->perf_counter_sample, cl);
 }
 
+void _starpu_perf_counter_task_shards_aggregate(const struct _starpu_perf_counter_task_shard *shards, unsigned nworkers, struct _starpu_perf_counter_task_shard *total)
+{
+	memset(total, 0, sizeof(*total));
+	unsigned i;
+	for (i = 0; i <= nworkers; i++)
+	{
+		const struct _starpu_perf_counter_task_shard * const shard = &shards[i];
+		starpu_perf_counter_int64_t total_submitted, total_executed;
+		starpu_perf_counter_double cumul_execution_time;
+#ifdef __ATOMIC_RELAXED
+		__atomic_load(&shard->total_submitted, &total_submitted, __ATOMIC_RELAXED);
+		__atomic_load(&shard->total_executed, &total_executed, __ATOMIC_RELAXED);
+		__atomic_load(&shard->cumul_execution_time, &cumul_execution_time, __ATOMIC_RELAXED);
+#else
+		total_submitted = shard->total_submitted;
+		total_executed = shard->total_executed;
+		cumul_execution_time = shard->cumul_execution_time;
+#endif
+		total->total_submitted += total_submitted;
+		total->total_executed += total_executed;
+		total->cumul_execution_time += cumul_execution_time;
+	}
+}
+
 #define STARPU_PERF_COUNTER_SAMPLE_GET_TYPED_VALUE(STRING, TYPE) \
 TYPE starpu_perf_counter_sample_get_##STRING##_value(struct starpu_perf_counter_sample *sample, const int counter_id) \
 { \
@@ -169,6 +169,9 @@ struct starpu_perf_counter_set
 	enum starpu_perf_counter_scope scope;
 	int size;
 	int *index_array;
+	/** Minimum time between two refreshes of each counter, in µs, 0 when
+	 * the counter is refreshed on each event */
+	unsigned *period_array;
 };
 
 union starpu_perf_counter_value
@@ -192,20 +195,82 @@ struct starpu_perf_counter_sample
 	struct starpu_perf_counter_listener *listener;
 	union starpu_perf_counter_value *value_array;
 	struct _starpu_spinlock lock;
+	/** For the counters with a sampling period, date of their next refresh */
+	double *next_update_array;
+	/** Whether each counter is to be refreshed by the ongoing update */
+	char *due_array;
 };
 
+/** Shard of the task counters which only ever grow. There is one shard per
+ * worker, plus one shared by all non-worker threads, so that the task
+ * submission, push and execution paths only touch a cache line local to the
+ * calling thread. Shards are only summed up when a sample is updated for a
+ * listener. */
+struct _starpu_perf_counter_task_shard
+{
+	starpu_perf_counter_int64_t total_submitted;
+	starpu_perf_counter_int64_t total_executed;
+	starpu_perf_counter_double cumul_execution_time;
+} STARPU_ATTRIBUTE_ALIGNED(STARPU_CACHELINE_SIZE);
+
+/** Numbers of tasks currently submitted and ready. They cannot be sharded,
+ * since their peaks have to be folded in on each update to be exact. */
+struct _starpu_perf_counter_task_current
+{
+	starpu_perf_counter_int64_t current_submitted;
+	starpu_perf_counter_int64_t peak_submitted;
+	starpu_perf_counter_int64_t current_ready;
+	starpu_perf_counter_int64_t peak_ready;
+} STARPU_ATTRIBUTE_ALIGNED(STARPU_CACHELINE_SIZE);
+
+/** The non-worker shard comes after those of the workers */
+#define _STARPU_PERF_COUNTER_NSHARDS (STARPU_NMAXWORKERS+1)
+
+/** Add to a counter of a shard. A worker shard is only ever written by the
+ * thread driving the worker, so a relaxed load and store are enough for the
+ * aggregation not to see torn values. Only the non-worker shard, which is
+ * shared, needs an atomic read-modify-write. */
+#ifdef __ATOMIC_RELAXED
+#define STARPU_PERF_COUNTER_SHARD_ADD(ptr, val, shared) do \
+{ \
+	__typeof__(*(ptr)) __old, __new; \
+	if (shared) \
+		(void)__atomic_fetch_add((ptr), (val), __ATOMIC_RELAXED); \
+	else \
+	{ \
+		__atomic_load((ptr), &__old, __ATOMIC_RELAXED); \
+		__new = __old + (val); \
+		__atomic_store((ptr), &__new, __ATOMIC_RELAXED); \
+	} \
+} while (0)
+/** Only workers accumulate execution times, in their own shards */
+#define STARPU_PERF_COUNTER_SHARD_ACC_DOUBLE(ptr, val) do \
+{ \
+	starpu_perf_counter_double __old, __new; \
+	__atomic_load((ptr), &__old, __ATOMIC_RELAXED); \
+	__new = __old + (val); \
+	__atomic_store((ptr), &__new, __ATOMIC_RELAXED); \
+} while (0)
+#else
+#define STARPU_PERF_COUNTER_SHARD_ADD(ptr, val, shared) ((void)(shared), (void)STARPU_PERF_COUNTER_ADD64((ptr), (val)))
+#define STARPU_PERF_COUNTER_SHARD_ACC_DOUBLE(ptr, val) _starpu_perf_counter_update_acc_double((ptr), (val))
+#endif
+
+/** Add \p val to a current number of tasks, and fold the result in its peak */
+static inline void _starpu_perf_counter_current_add(starpu_perf_counter_int64_t *current, starpu_perf_counter_int64_t *peak, starpu_perf_counter_int64_t val)
+{
+	starpu_perf_counter_int64_t value = STARPU_PERF_COUNTER_ADD64(current, val);
+	if (val > 0)
+		_starpu_perf_counter_update_max_int64(peak, value);
+}
+
 struct starpu_perf_counter_sample_cl_values
 {
-	struct
-	{
-		starpu_perf_counter_int64_t total_submitted;
-		starpu_perf_counter_int64_t peak_submitted;
-		starpu_perf_counter_int64_t current_submitted;
-		starpu_perf_counter_int64_t peak_ready;
-		starpu_perf_counter_int64_t current_ready;
-		starpu_perf_counter_int64_t total_executed;
-		starpu_perf_counter_double cumul_execution_time;
-	} task;
+	struct _starpu_perf_counter_task_current task;
+	/** Number of workers when the listener was set, the non-worker shard
+	 * is the last one */
+	unsigned nworkers;
+	struct _starpu_perf_counter_task_shard shards[];
 };
 
 typedef void (*starpu_perf_counter_sample_updater)(struct starpu_perf_counter_sample *sample, void *context);
@@ -254,7 +319,7 @@ static inline void _starpu_perf_counter_sample_set_##STRING##_value(struct starp
 	const struct starpu_perf_counter_set * const set = sample->listener->set; \
 	const int index =  _starpu_perf_counter_id_get_index(counter_id); \
 	STARPU_ASSERT(index < set->size); \
-	if (set->index_array[index] > 0) \
+	if (set->index_array[index] > 0 && sample->due_array[index]) \
 	{ \
 		sample->value_array[index].STRING##_val = value; \
 	} \
@@ -276,15 +341,28 @@ __STARPU_PERF_COUNTER_SAMPLE_SET_TYPED_VALUE(double, starpu_perf_counter_double)
 		} \
 	while (0)
 
+/** Whether the updater has to refresh the value of \p counter_id in \p
+ * sample: the counter is enabled in the set of the listener, and it is either
+ * not sampled, or its sampling period has elapsed. Updaters use it to avoid
+ * computing values which would not be stored anyway. */
+static inline int _starpu_perf_counter_sample_due(struct starpu_perf_counter_sample *sample, const int counter_id)
+{
+	const int index = _starpu_perf_counter_id_get_index(counter_id);
+	STARPU_ASSERT(index < sample->listener->set->size);
+	return sample->listener->set->index_array[index] > 0 && sample->due_array[index];
+}
+
+/** Sum up the first \p nworkers shards and the non-worker one which follows
+ * them into \p total */
+void _starpu_perf_counter_task_shards_aggregate(const struct _starpu_perf_counter_task_shard *shards, unsigned nworkers, struct _starpu_perf_counter_task_shard *total);
+
 /* global counter variables */
-extern starpu_perf_counter_int64_t _starpu_task__g_total_submitted__value;
-extern starpu_perf_counter_int64_t _starpu_task__g_peak_submitted__value;
-extern starpu_perf_counter_int64_t _starpu_task__g_current_submitted__value;
-extern starpu_perf_counter_int64_t _starpu_task__g_peak_ready__value;
-extern starpu_perf_counter_int64_t _starpu_task__g_current_ready__value;
+extern struct _starpu_perf_counter_task_shard _starpu_task__g_shards[_STARPU_PERF_COUNTER_NSHARDS];
+extern struct _starpu_perf_counter_task_current _starpu_task__g_current;
 
 /* performance counter registration routines per modules */
 void _starpu__task_c__register_counters(void);	/* module: task.c */
+void _starpu__bound_c__register_counters(void);	/* module: bound.c */
 
 
 /* -------------------------------------------------------------------- */
@@ -626,9 +626,9 @@ void _starpu_release_task_enforce_sequential_consistency(struct _starpu_job *j)
 }
 
 
-void _starpu_add_post_sync_tasks(struct starpu_task *post_sync_task, starpu_data_handle_t handle)
+static int _starpu_add_post_sync_link(struct starpu_task *task, unsigned end_dep, starpu_data_handle_t handle)
 {
-	_STARPU_LOG_IN();
+	int added = 0;
 	STARPU_PTHREAD_MUTEX_LOCK(&handle->sequential_consistency_mutex);
 
 	if (handle->sequential_consistency)
@@ -637,15 +637,31 @@ void _starpu_add_post_sync_tasks(struct starpu_task *post_sync_task, starpu_data
 
 		struct _starpu_task_wrapper_list *link;
 		_STARPU_MALLOC(link, sizeof(struct _starpu_task_wrapper_list));
-		link->task = post_sync_task;
+		link->task = task;
+		link->end_dep = end_dep;
 		link->next = handle->post_sync_tasks;
 		handle->post_sync_tasks = link;
+		added = 1;
 	}
 
 	STARPU_PTHREAD_MUTEX_UNLOCK(&handle->sequential_consistency_mutex);
+	return added;
+}
+
+void _starpu_add_post_sync_tasks(struct starpu_task *post_sync_task, starpu_data_handle_t handle)
+{
+	_STARPU_LOG_IN();
+	_starpu_add_post_sync_link(post_sync_task, 0, handle);
 	_STARPU_LOG_OUT();
 }
 
+/* The task was given an end dependency which is to be released when the
+ * application releases handle, instead of submitting a post sync task */
+int _starpu_add_post_sync_end_dep(struct starpu_task *task, starpu_data_handle_t handle)
+{
+	return _starpu_add_post_sync_link(task, 1, handle);
+}
+
 void _starpu_unlock_post_sync_tasks(starpu_data_handle_t handle, enum starpu_data_access_mode mode)
 {
 	struct _starpu_task_wrapper_list *post_sync_tasks = NULL;
@@ -680,11 +696,17 @@ void _starpu_unlock_post_sync_tasks(starpu_data_handle_t handle, enum starpu_dat
 
 		while (link)
 		{
-			/* There is no need to depend on that task now, since it was already unlocked */
-			_starpu_release_data_enforce_sequential_consistency(link->task, &_starpu_get_job_associated_to_task(link->task)->implicit_dep_slot, handle);
+			if (link->end_dep)
+				/* The task holds the implicit dependencies itself */
+				starpu_task_end_dep_release(link->task);
+			else
+			{
+				/* There is no need to depend on that task now, since it was already unlocked */
+				_starpu_release_data_enforce_sequential_consistency(link->task, &_starpu_get_job_associated_to_task(link->task)->implicit_dep_slot, handle);
 
-			int ret = _starpu_task_submit_internally(link->task);
-			STARPU_ASSERT(!ret);
+				int ret = _starpu_task_submit_internally(link->task);
+				STARPU_ASSERT(!ret);
+			}
 			struct _starpu_task_wrapper_list *tmp = link;
 			link = link->next;
 			free(tmp);
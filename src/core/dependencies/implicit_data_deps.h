@@ -32,6 +32,9 @@ void _starpu_release_data_enforce_sequential_consistency(struct starpu_task *tas
 void _starpu_release_task_enforce_sequential_consistency(struct _starpu_job *j);
 
 void _starpu_add_post_sync_tasks(struct starpu_task *post_sync_task, starpu_data_handle_t handle);
+/** Have the release of \p handle release an end dependency of \p task. Return 0 if
+ * \p handle has no sequential consistency, the caller then has to release it */
+int _starpu_add_post_sync_end_dep(struct starpu_task *task, starpu_data_handle_t handle);
 void _starpu_unlock_post_sync_tasks(starpu_data_handle_t handle, enum starpu_data_access_mode mode);
 
 /** Register a hook to be called when a write is submitted */
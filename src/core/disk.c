@@ -15,6 +15,7 @@
  * See the GNU Lesser General Public License in COPYING.LGPL for more details.
  */
 
+#include <errno.h>
 #include <fcntl.h>
 #include <stdbool.h>
 #include <stdio.h>
@@ -24,6 +25,9 @@
 #include <time.h>
 
 #include <common/config.h>
+#ifdef HAVE_UNISTD_H
+#  include <unistd.h>
+#endif
 #include <core/debug.h>
 #include <core/disk.h>
 #include <core/workers.h>
@@ -32,6 +36,7 @@
 #include <datawizard/memory_nodes.h>
 #include <datawizard/memory_manager.h>
 #include <datawizard/memalloc.h>
+#include <datawizard/interfaces/data_interface.h>
 
 #include <drivers/cuda/driver_cuda.h>
 #include <drivers/opencl/driver_opencl.h>
@@ -39,18 +44,46 @@
 #include <profiling/profiling.h>
 #include <common/uthash.h>
 
+/* Persistent store of named data. Its index is itself stored in the disk,
+ * as one "size name" line per data after a header line. It is rewritten in
+ * STORE_INDEX_NEW, which then replaces STORE_INDEX. */
+struct disk_store
+{
+	unsigned nentries;
+	unsigned maxentries;
+	char **names;
+	size_t *sizes;
+};
+
+#define STORE_INDEX ".starpu_store"
+#define STORE_INDEX_NEW ".starpu_store.new"
+#define STORE_HEADER "STARPU_STORE 1\n"
+
 struct disk_register
 {
 	void *base;
 	struct starpu_disk_ops *functions;
 	/* disk condition (1 = all authorizations,  */
 	int flag;
+	/* persistent store, loaded on first use */
+	struct disk_store *store;
 };
 
 static int add_disk_in_list(int devid, struct starpu_disk_ops *func, void *base);
 
 static struct disk_register *disk_register_list[STARPU_NMAXDEVS];
 static int disk_number = 0;
+static starpu_pthread_mutex_t disk_store_mutex = STARPU_PTHREAD_MUTEX_INITIALIZER;
+
+static void store_free(struct disk_store *store)
+{
+	unsigned i;
+	for (i = 0; i < store->nentries; i++)
+		free(store->names[i]);
+	free(store->names);
+	free(store->sizes);
+	free(store);
+}
 
 int starpu_disk_swap_node = -1;
 
@@ -75,6 +108,15 @@ static void add_async_event(struct _starpu_async_channel * channel, void * event
 int starpu_disk_register(struct starpu_disk_ops *func, void *parameter, starpu_ssize_t size)
 {
 	STARPU_ASSERT_MSG(size < 0 || size >= STARPU_DISK_SIZE_MIN, "Minimum disk size is %d Bytes ! (Here %d) \n", (int) STARPU_DISK_SIZE_MIN, (int) size);
+
+	/* The registered data handles only have room for a few more memory nodes */
+	unsigned nreplicates = _starpu_data_get_registered_nreplicates();
+	if (nreplicates && _starpu_memory_nodes_get_count() >= nreplicates)
+	{
+		_STARPU_DISP("Warning: data was already registered with room for only %u memory nodes, cannot register another disk. Register the disks before the data, or increase STARPU_DISK_RESERVED_NODES\n", nreplicates);
+		return -ENOSPC;
+	}
+
 	/* register disk */
 	int disk_device = STARPU_ATOMIC_ADD(&disk_number, 1) - 1;
 	unsigned disk_memnode = _starpu_memory_node_register(STARPU_DISK_RAM, disk_device);
@@ -171,6 +213,9 @@ void _starpu_disk_unregister(void)
 		unsigned node = starpu_memory_devid_find_node(i, STARPU_DISK_RAM);
 		_starpu_free_all_automatically_allocated_buffers(node);
 
+		if (disk_register_list[i]->store)
+			store_free(disk_register_list[i]->store);
+
 		/* don't forget to unplug */
 		disk_register_list[i]->functions->unplug(disk_register_list[i]->base);
 		free(disk_register_list[i]);
@@ -375,6 +420,7 @@ void *starpu_disk_open(unsigned node, void *pos, size_t size)
 {
 	int devid = starpu_memory_node_get_devid(node);
 	STARPU_ASSERT(devid < STARPU_NMAXDEVS);
+	STARPU_ASSERT_MSG(disk_register_list[devid]->functions->open, "This disk backend does not support opening existing data");
 	return disk_register_list[devid]->functions->open(disk_register_list[devid]->base, pos, size);
 }
 
@@ -385,6 +431,292 @@ void starpu_disk_close(unsigned node, void *obj, size_t size)
 	disk_register_list[devid]->functions->close(disk_register_list[devid]->base, obj, size);
 }
 
+static void store_add_entry(struct disk_store *store, const char *name, size_t size)
+{
+	if (store->nentries == store->maxentries)
+	{
+		store->maxentries = store->maxentries ? 2*store->maxentries : 16;
+		_STARPU_REALLOC(store->names, store->maxentries * sizeof(*store->names));
+		_STARPU_REALLOC(store->sizes, store->maxentries * sizeof(*store->sizes));
+	}
+	store->names[store->nentries] = strdup(name);
+	store->sizes[store->nentries] = size;
+	store->nentries++;
+}
+
+/* Names are used as file names by the backends, they must not escape the
+ * directory of the disk, nor clash with the index */
+static int store_valid_name(const char *name)
+{
+	return *name && !strchr(name, '\n') && !strchr(name, '/') && !strstr(name, "..")
+		&& strncmp(name, STORE_INDEX, strlen(STORE_INDEX));
+}
+
+static int store_find_entry(struct disk_store *store, const char *name)
+{
+	unsigned i;
+	for (i = 0; i < store->nentries; i++)
+		if (!strcmp(store->names[i], name))
+			return i;
+	return -1;
+}
+
+/* Parse the index of the store, return -EINVAL if it is corrupted */
+static int store_parse_index(struct disk_store *store, char *index)
+{
+	char *line, *name, *end;
+
+	if (strncmp(index, STORE_HEADER, strlen(STORE_HEADER)))
+		return -EINVAL;
+	line = index + strlen(STORE_HEADER);
+	for ( ; *line; line = end + 1)
+	{
+		unsigned long long entry_size = strtoull(line, &name, 10);
+		end = strchr(name, '\n');
+		if (name == line || *name != ' ' || !end)
+			return -EINVAL;
+		*end = 0;
+		store_add_entry(store, name + 1, entry_size);
+	}
+	return 0;
+}
+
+/* Get the store of the disk, reading its index from the disk on first use.
+ * Return -ENOTSUP if the backend does not support it, and -EINVAL if its
+ * index is corrupted.
+ * Called with disk_store_mutex held */
+static int store_get(struct disk_register *disk, struct disk_store **pstore)
+{
+	struct disk_store *store = disk->store;
+	if (store)
+	{
+		*pstore = store;
+		return 0;
+	}
+
+	if (!disk->functions->create || !disk->functions->open || !disk->functions->rename)
+	{
+		_STARPU_DISP("This disk backend does not support the persistent store\n");
+		return -ENOTSUP;
+	}
+	_STARPU_CALLOC(store, 1, sizeof(*store));
+
+	void *obj = disk->functions->open(disk->base, STORE_INDEX, 0);
+	if (obj)
+	{
+		void *ptr;
+		size_t size;
+		char *index;
+		int ret;
+
+		disk->functions->full_read(disk->base, obj, &ptr, &size, STARPU_MAIN_RAM);
+		disk->functions->close(disk->base, obj, 0);
+		_STARPU_MALLOC(index, size + 1);
+		memcpy(index, ptr, size);
+		index[size] = 0;
+		_starpu_free_flags_on_node(STARPU_MAIN_RAM, ptr, size, 0);
+
+		ret = store_parse_index(store, index);
+		free(index);
+		if (ret)
+		{
+			_STARPU_DISP("Invalid index for the persistent store of the disk\n");
+			store_free(store);
+			return ret;
+		}
+	}
+
+	disk->store = store;
+	*pstore = store;
+	return 0;
+}
+
+/* Write the index of the store to the disk.
+ * Called with disk_store_mutex held */
+static int store_write_index(struct disk_register *disk, struct disk_store *store)
+{
+	size_t size = strlen(STORE_HEADER);
+	unsigned i;
+	char *index, *cur;
+
+	for (i = 0; i < store->nentries; i++)
+		size += 20 + 1 + strlen(store->names[i]) + 1;
+	_STARPU_MALLOC(index, size + 1);
+
+	cur = index + sprintf(index, "%s", STORE_HEADER);
+	for (i = 0; i < store->nentries; i++)
+		cur += sprintf(cur, "%lu %s\n", (unsigned long) store->sizes[i], store->names[i]);
+	size = cur - index;
+
+	void *obj = disk->functions->create(disk->base, STORE_INDEX_NEW, size);
+	if (!obj)
+	{
+		_STARPU_DISP("Could not create the index for the persistent store of the disk\n");
+		free(index);
+		return -EIO;
+	}
+	disk->functions->full_write(disk->base, obj, index, size);
+	disk->functions->close(disk->base, obj, size);
+	free(index);
+
+	/* Only replace the previous index once the new one is complete, the
+	 * rename method flushes it to the disk first */
+	int ret = disk->functions->rename(disk->base, STORE_INDEX_NEW, STORE_INDEX);
+	if (ret)
+		_STARPU_DISP("Could not replace the index for the persistent store of the disk\n");
+	return ret;
+}
+
+void *starpu_disk_store_open(unsigned node, const char *name, size_t *size)
+{
+	int devid = starpu_memory_node_get_devid(node);
+	STARPU_ASSERT(devid < STARPU_NMAXDEVS);
+	struct disk_register *disk = disk_register_list[devid];
+	struct disk_store *store;
+	void *obj = NULL;
+	int ret;
+
+	if (!store_valid_name(name))
+	{
+		errno = EINVAL;
+		return NULL;
+	}
+
+	STARPU_PTHREAD_MUTEX_LOCK(&disk_store_mutex);
+	ret = store_get(disk, &store);
+	if (ret)
+		errno = -ret;
+	else
+	{
+		int i = store_find_entry(store, name);
+		if (i >= 0)
+		{
+			*size = store->sizes[i];
+			obj = disk->functions->open(disk->base, (void *) name, *size);
+		}
+		else
+			errno = ENOENT;
+	}
+	STARPU_PTHREAD_MUTEX_UNLOCK(&disk_store_mutex);
+
+	return obj;
+}
+
+void *starpu_disk_store_create(unsigned node, const char *name, size_t size)
+{
+	int devid = starpu_memory_node_get_devid(node);
+	STARPU_ASSERT(devid < STARPU_NMAXDEVS);
+	struct disk_register *disk = disk_register_list[devid];
+	struct disk_store *store;
+	void *obj = NULL;
+	int ret;
+
+	if (!store_valid_name(name))
+	{
+		_STARPU_DISP("Invalid name '%s' for the persistent store\n", name);
+		errno = EINVAL;
+		return NULL;
+	}
+
+	STARPU_PTHREAD_MUTEX_LOCK(&disk_store_mutex);
+	ret = store_get(disk, &store);
+	if (ret)
+		errno = -ret;
+	else
+	{
+		obj = disk->functions->create(disk->base, (void *) name, size);
+		if (!obj)
+			errno = EIO;
+		else
+		{
+			int i = store_find_entry(store, name);
+			size_t old_size = 0;
+			if (i >= 0)
+			{
+				old_size = store->sizes[i];
+				store->sizes[i] = size;
+			}
+			else
+				store_add_entry(store, name, size);
+
+			ret = store_write_index(disk, store);
+			if (ret)
+			{
+				/* Keep the store as it is on the disk */
+				if (i >= 0)
+				{
+					store->sizes[i] = old_size;
+					disk->functions->close(disk->base, obj, size);
+				}
+				else
+				{
+					store->nentries--;
+					free(store->names[store->nentries]);
+					disk->functions->free(disk->base, obj, size);
+				}
+				obj = NULL;
+				errno = -ret;
+			}
+		}
+	}
+	STARPU_PTHREAD_MUTEX_UNLOCK(&disk_store_mutex);
+
+	return obj;
+}
+
+int starpu_disk_store_remove(unsigned node, const char *name)
+{
+	int devid = starpu_memory_node_get_devid(node);
+	STARPU_ASSERT(devid < STARPU_NMAXDEVS);
+	struct disk_register *disk = disk_register_list[devid];
+	struct disk_store *store;
+	char *entry_name;
+	size_t entry_size;
+	int ret;
+
+	if (!store_valid_name(name))
+		return -EINVAL;
+
+	STARPU_PTHREAD_MUTEX_LOCK(&disk_store_mutex);
+	ret = store_get(disk, &store);
+	if (ret)
+	{
+		STARPU_PTHREAD_MUTEX_UNLOCK(&disk_store_mutex);
+		return ret;
+	}
+
+	int i = store_find_entry(store, name);
+	if (i < 0)
+	{
+		STARPU_PTHREAD_MUTEX_UNLOCK(&disk_store_mutex);
+		return -ENOENT;
+	}
+
+	/* Drop it from the index before deleting the data, so that the index
+	 * never refers to missing data */
+	entry_name = store->names[i];
+	entry_size = store->sizes[i];
+	store->nentries--;
+	store->names[i] = store->names[store->nentries];
+	store->sizes[i] = store->sizes[store->nentries];
+	ret = store_write_index(disk, store);
+	if (ret)
+	{
+		store_add_entry(store, entry_name, entry_size);
+		free(entry_name);
+		STARPU_PTHREAD_MUTEX_UNLOCK(&disk_store_mutex);
+		return ret;
+	}
+	free(entry_name);
+
+	void *obj = disk->functions->open(disk->base, (void *) name, entry_size);
+	if (obj)
+		disk->functions->free(disk->base, obj, entry_size);
+	STARPU_PTHREAD_MUTEX_UNLOCK(&disk_store_mutex);
+
+	return 0;
+}
+
 void starpu_disk_wait_request(struct _starpu_async_channel *async_channel)
 {
 	struct _starpu_disk_event *disk_event = _starpu_disk_get_event(&async_channel->event);
@@ -481,6 +813,7 @@ static int add_disk_in_list(int devid,  struct starpu_disk_ops *func, void *base
 	dr->base = base;
 	dr->flag = STARPU_DISK_ALL;
 	dr->functions = func;
+	dr->store = NULL;
 	disk_register_list[devid] = dr;
 	return devid;
 }
@@ -508,10 +841,115 @@ int _starpu_get_disk_flag(int devid)
 	return disk_register_list[devid]->flag;
 }
 
+void *_starpu_disk_get_base(unsigned node, struct starpu_disk_ops *func)
+{
+	if (starpu_node_get_kind(node) != STARPU_DISK_RAM)
+		return NULL;
+	int devid = starpu_memory_node_get_devid(node);
+	if (disk_register_list[devid] == NULL || disk_register_list[devid]->functions != func)
+		return NULL;
+	return disk_register_list[devid]->base;
+}
+
+int _starpu_disk_can_map(unsigned src_node, unsigned dst_node)
+{
+	if (!starpu_map_enabled())
+		return 0;
+	if (starpu_node_get_kind(src_node) != STARPU_DISK_RAM || starpu_node_get_kind(dst_node) != STARPU_CPU_RAM)
+		return 0;
+	int devid = starpu_memory_node_get_devid(src_node);
+	return disk_register_list[devid]->functions->map != NULL;
+}
+
+void *_starpu_disk_map(int devid, void *obj, off_t offset, size_t size)
+{
+	STARPU_ASSERT(devid < STARPU_NMAXDEVS);
+	if (!disk_register_list[devid]->functions->map)
+		return NULL;
+	return disk_register_list[devid]->functions->map(disk_register_list[devid]->base, obj, offset, size);
+}
+
+int _starpu_disk_sync(int devid, void *obj, void *ptr, off_t offset, size_t size)
+{
+	STARPU_ASSERT(devid < STARPU_NMAXDEVS);
+	if (!disk_register_list[devid]->functions->sync)
+		return 0;
+	return disk_register_list[devid]->functions->sync(disk_register_list[devid]->base, obj, ptr, offset, size);
+}
+
+void _starpu_disk_unmap(int devid, void *obj, void *ptr, off_t offset, size_t size)
+{
+	STARPU_ASSERT(devid < STARPU_NMAXDEVS);
+	disk_register_list[devid]->functions->unmap(disk_register_list[devid]->base, obj, ptr, offset, size);
+}
+
+/* The objects of the underlying backend of a stacked backend are opaque, so
+ * they can not be fsync-ed: flush all file systems instead, so that the
+ * measurement does not only hit the page cache */
+static void _starpu_disk_flush_all(void)
+{
+#ifndef STARPU_HAVE_WINDOWS
+	sync();
+#endif
+}
+
+int _starpu_disk_bandwidth_stacked(unsigned node, struct starpu_disk_ops *func, void *base, const char *name)
+{
+	unsigned iter;
+	double timing_slowness, timing_latency;
+	double start;
+	double end;
+	char *buf;
+	void *mem;
+	int ret;
+
+	/* The node still uses the stacking backend, so directly use the
+	 * underlying backend's methods instead of _starpu_disk_write() */
+	mem = func->alloc(base, STARPU_DISK_SIZE_MIN);
+	/* fail to alloc */
+	if (mem == NULL)
+		return 0;
+
+	srand(time(NULL));
+	starpu_malloc_flags((void **) &buf, STARPU_DISK_SIZE_MIN, 0);
+	STARPU_ASSERT(buf != NULL);
+	memset(buf, 0, STARPU_DISK_SIZE_MIN);
+
+	/* Measure upload slowness */
+	start = starpu_timing_now();
+	for (iter = 0; iter < _starpu_calibration_minimum; ++iter)
+	{
+		ret = func->write(base, mem, buf, 0, STARPU_DISK_SIZE_MIN);
+		STARPU_ASSERT_MSG(ret == 0, "Slowness computation failed");
+		_starpu_disk_flush_all();
+	}
+	end = starpu_timing_now();
+	timing_slowness = end - start;
+
+	/* Measure latency */
+	start = starpu_timing_now();
+	for (iter = 0; iter < _starpu_calibration_minimum; ++iter)
+	{
+		ret = func->write(base, mem, buf, rand() % (STARPU_DISK_SIZE_MIN - 1), 1);
+		STARPU_ASSERT_MSG(ret == 0, "Latency computation failed");
+		_starpu_disk_flush_all();
+	}
+	end = starpu_timing_now();
+	timing_latency = end - start;
+
+	func->free(base, mem, STARPU_DISK_SIZE_MIN);
+	starpu_free_flags(buf, STARPU_DISK_SIZE_MIN, 0);
+
+	_starpu_save_bandwidth_and_latency_disk((_starpu_calibration_minimum/timing_slowness)*STARPU_DISK_SIZE_MIN, (_starpu_calibration_minimum/timing_slowness)*STARPU_DISK_SIZE_MIN,
+						timing_latency/_starpu_calibration_minimum, timing_latency/_starpu_calibration_minimum, node, name);
+	return 1;
+}
+
 void _starpu_swap_init(void)
 {
 	char *backend;
 	char *path;
+	void *parameter;
 	starpu_ssize_t size;
 	struct starpu_disk_ops *ops;
 
@@ -532,6 +970,14 @@ void _starpu_swap_init(void)
 	{
 		ops = &starpu_disk_unistd_ops;
 	}
+	else if (!strcmp(backend, "slab"))
+	{
+		ops = &starpu_disk_slab_ops;
+	}
+	else if (!strcmp(backend, "mmap"))
+	{
+		ops = &starpu_disk_mmap_ops;
+	}
 	else if (!strcmp(backend, "unistd_o_direct"))
 	{
 #ifdef STARPU_LINUX_SYS
@@ -568,7 +1014,19 @@ void _starpu_swap_init(void)
 
 	size = starpu_getenv_number_default("STARPU_DISK_SWAP_SIZE", -1);
 
-	starpu_disk_swap_node = starpu_disk_register(ops, path, ((size_t) size) << 20);
+	parameter = path;
+	if (starpu_getenv_number_default("STARPU_DISK_SWAP_COMPRESS", 0))
+	{
+		/* Only read at plug time */
+		static struct starpu_disk_compress_parameter compress;
+		compress.ops = ops;
+		compress.parameter = path;
+		compress.codec = NULL;
+		ops = &starpu_disk_compress_ops;
+		parameter = &compress;
+	}
+
+	starpu_disk_swap_node = starpu_disk_register(ops, parameter, ((size_t) size) << 20);
 	if (starpu_disk_swap_node < 0)
 	{
 		_STARPU_DISP("Warning: could not enable disk swap %s on %s with size %ld, could not enable disk swap\n", backend, path, (long) size);
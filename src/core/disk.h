@@ -63,6 +63,20 @@ int _starpu_get_disk_flag(int devid);
 /** unregister disk */
 void _starpu_disk_unregister(void);
 
+/** return the base of the disk memory node if it was registered with these functions, NULL otherwise */
+void *_starpu_disk_get_base(unsigned node, struct starpu_disk_ops *func);
+
+/** return whether the data of disk memory node \p src_node can be mapped in memory node \p dst_node */
+int _starpu_disk_can_map(unsigned src_node, unsigned dst_node);
+/** interface to map data of a disk in main memory, the mapping is shared with the disk */
+void *_starpu_disk_map(int devid, void *obj, off_t offset, size_t size);
+/** write back the modifications made through a mapping */
+int _starpu_disk_sync(int devid, void *obj, void *ptr, off_t offset, size_t size);
+void _starpu_disk_unmap(int devid, void *obj, void *ptr, off_t offset, size_t size);
+
+/** measure the bandwidth of the disk memory node by directly calling the methods of the backend \p func on its \p base, for backends stacked over another one */
+int _starpu_disk_bandwidth_stacked(unsigned node, struct starpu_disk_ops *func, void *base, const char *name);
+
 void _starpu_swap_init(void);
 
 static inline struct _starpu_disk_event *_starpu_disk_get_event(union _starpu_async_channel_event *_event)
@@ -0,0 +1,848 @@
+/* StarPU --- Runtime system for heterogeneous multicore architectures.
+ *
+ * Copyright (C) 2023       Université de Bordeaux, CNRS (LaBRI UMR 5800), Inria
+ *
+ * StarPU is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or (at
+ * your option) any later version.
+ *
+ * StarPU is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU Lesser General Public License in COPYING.LGPL for more details.
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <errno.h>
+
+#include <common/config.h>
+#include <starpu.h>
+#include <common/list.h>
+#include <core/disk.h>
+#include <core/workers.h>
+#include <datawizard/malloc.h>
+
+/* Data are compressed by chunks of this size, so that parts of them can be
+ * read or written without processing the whole data, and that chunks can be
+ * processed in parallel */
+#define COMPRESS_CHUNK	(64*1024)
+
+/* ------------------- compress data stored by another backend -------------------  */
+
+/* Chunk i of an object is stored at offset i * COMPRESS_CHUNK of the object
+ * of the underlying backend, so the latter does not need to support variable
+ * sizes. Only the compressed size of each chunk is written, the rest of the
+ * room remains a hole in the file for backends which create sparse files, and
+ * is discarded again when a chunk gets compressed better than before. The
+ * memory accounted for the node is adjusted to the stored size. */
+
+struct starpu_compress_job;
+typedef void (*starpu_compress_func)(struct starpu_compress_job *job, unsigned i);
+
+/* A set of n independent items to be processed by the threads */
+LIST_TYPE(starpu_compress_job,
+	starpu_compress_func func;
+	void *arg;
+	unsigned n;
+	/* Next item to be processed */
+	unsigned next;
+	/* Number of processed items */
+	unsigned ndone;
+	/* Whether it is in the list of jobs of the base */
+	int queued;
+);
+
+struct starpu_compress_base
+{
+	struct starpu_disk_ops *ops;
+	void *base;
+	struct starpu_disk_compress_codec *codec;
+
+	/* Memory node of the disk, -1 until known */
+	int node;
+
+	starpu_pthread_mutex_t mutex;
+	/* Signaled when jobs are queued */
+	starpu_pthread_cond_t cond;
+	/* Signaled when jobs are completed */
+	starpu_pthread_cond_t done_cond;
+	struct starpu_compress_job_list jobs;
+	unsigned nthreads;
+	starpu_pthread_t *threads;
+	int exiting;
+
+	/* Protected by mutex */
+	struct starpu_disk_compress_stats stats;
+};
+
+struct starpu_compress_obj
+{
+	/* Object of the underlying backend */
+	void *obj;
+	/* Size allocated in the underlying backend */
+	size_t capacity;
+	/* Size of the data, for full_read */
+	size_t size;
+	/* Size accounted by StarPU for the object, 0 if it is not accounted */
+	size_t accounted;
+	/* Sum of the stored size of the chunks, protected by the mutex of the base */
+	size_t stored;
+	/* Difference currently applied to the memory accounted for the node,
+	 * protected by the mutex of the base */
+	starpu_ssize_t adjustment;
+	/* Stored size of each chunk. 0 means that the chunk was never
+	 * written, the chunk size means that it is stored uncompressed */
+	uint32_t *lengths;
+};
+
+/* A synchronous or asynchronous read or write */
+struct starpu_compress_request
+{
+	/* Used to process the request asynchronously */
+	struct starpu_compress_job job;
+	struct starpu_compress_base *base;
+	struct starpu_compress_obj *obj;
+	char *buf;
+	off_t offset;
+	size_t size;
+	int write;
+	/* The data after offset + size does not need to be preserved */
+	int truncate;
+};
+
+/* ------------------- built-in codec -------------------  */
+
+/* This is a simple LZ77 variant, in the spirit of LZ4: a sequence of
+ * literals followed by a match is encoded as a token byte holding both
+ * lengths, followed by the literals, a 16bit offset, and the remainder of
+ * the lengths when they do not fit in the token. The last sequence has
+ * literals only. */
+
+#define LZ_HASH_LOG	12
+#define LZ_MIN_MATCH	4
+#define LZ_MAX_OFFSET	65535
+
+static inline uint32_t _starpu_lz_hash(const unsigned char *p)
+{
+	uint32_t seq;
+	memcpy(&seq, p, sizeof(seq));
+	return (seq * 2654435761U) >> (32 - LZ_HASH_LOG);
+}
+
+static unsigned char *_starpu_lz_put_length(unsigned char *op, size_t length)
+{
+	while (length >= 255)
+	{
+		*op++ = 255;
+		length -= 255;
+	}
+	*op++ = length;
+	return op;
+}
+
+/* Emit a sequence, or return NULL if it does not fit */
+static unsigned char *_starpu_lz_put_sequence(unsigned char *op, unsigned char *oend, const unsigned char *literals, size_t nliterals, size_t match, size_t offset, int last)
+{
+	unsigned char *token = op++;
+	size_t needed = 1 + nliterals / 255 + 1 + nliterals + (last ? 0 : 2 + match / 255 + 1);
+
+	if (needed > (size_t) (oend - token))
+		return NULL;
+
+	*token = (STARPU_MIN(nliterals, 15) << 4) | (last ? 0 : STARPU_MIN(match, 15));
+	if (nliterals >= 15)
+		op = _starpu_lz_put_length(op, nliterals - 15);
+	memcpy(op, literals, nliterals);
+	op += nliterals;
+	if (last)
+		return op;
+	*op++ = offset & 0xff;
+	*op++ = offset >> 8;
+	if (match >= 15)
+		op = _starpu_lz_put_length(op, match - 15);
+	return op;
+}
+
+static size_t _starpu_lz_compress(const void *_src, size_t src_size, void *_dst, size_t dst_size)
+{
+	const unsigned char *src = _src;
+	const unsigned char *ip = src, *anchor = src, *end = src + src_size;
+	unsigned char *op = _dst, *oend = op + dst_size;
+	uint32_t table[1 << LZ_HASH_LOG];
+	unsigned misses = 0;
+
+	if (src_size > UINT32_MAX)
+		return 0;
+
+	memset(table, 0, sizeof(table));
+	while (ip + LZ_MIN_MATCH <= end)
+	{
+		uint32_t h = _starpu_lz_hash(ip);
+		const unsigned char *ref = src + table[h];
+		const unsigned char *mp, *rp;
+
+		table[h] = ip - src;
+		if (ref >= ip || ip - ref > LZ_MAX_OFFSET || memcmp(ref, ip, LZ_MIN_MATCH))
+		{
+			/* Skip faster over incompressible data */
+			ip += 1 + (misses++ >> 6);
+			continue;
+		}
+		misses = 0;
+
+		mp = ip + LZ_MIN_MATCH;
+		rp = ref + LZ_MIN_MATCH;
+		while (mp < end && *mp == *rp)
+		{
+			mp++;
+			rp++;
+		}
+
+		op = _starpu_lz_put_sequence(op, oend, anchor, ip - anchor, mp - ip - LZ_MIN_MATCH, ip - ref, 0);
+		if (!op)
+			return 0;
+		ip = anchor = mp;
+	}
+
+	op = _starpu_lz_put_sequence(op, oend, anchor, end - anchor, 0, 0, 1);
+	if (!op)
+		return 0;
+	return op - (unsigned char *) _dst;
+}
+
+static int _starpu_lz_get_length(const unsigned char **ip, const unsigned char *iend, size_t *length)
+{
+	unsigned char c;
+	do
+	{
+		if (*ip >= iend)
+			return -EINVAL;
+		c = *(*ip)++;
+		*length += c;
+	}
+	while (c == 255);
+	return 0;
+}
+
+static int _starpu_lz_decompress(const void *src, size_t src_size, void *dst, size_t dst_size)
+{
+	const unsigned char *ip = src, *iend = ip + src_size;
+	unsigned char *op = dst, *oend = op + dst_size;
+
+	while (ip < iend)
+	{
+		unsigned char token = *ip++;
+		size_t nliterals = token >> 4;
+		size_t match = token & 15;
+		size_t offset;
+		const unsigned char *ref;
+
+		if (nliterals == 15 && _starpu_lz_get_length(&ip, iend, &nliterals))
+			return -EINVAL;
+		if (nliterals > (size_t) (iend - ip) || nliterals > (size_t) (oend - op))
+			return -EINVAL;
+		memcpy(op, ip, nliterals);
+		ip += nliterals;
+		op += nliterals;
+
+		if (ip == iend)
+			/* Last sequence */
+			break;
+
+		if (iend - ip < 2)
+			return -EINVAL;
+		offset = ip[0] | (ip[1] << 8);
+		ip += 2;
+		if (match == 15 && _starpu_lz_get_length(&ip, iend, &match))
+			return -EINVAL;
+		match += LZ_MIN_MATCH;
+		if (offset == 0 || offset > (size_t) (op - (unsigned char *) dst) || match > (size_t) (oend - op))
+			return -EINVAL;
+
+		/* The match may overlap with what it produces */
+		ref = op - offset;
+		while (match--)
+			*op++ = *ref++;
+	}
+
+	return op == oend ? 0 : -EINVAL;
+}
+
+struct starpu_disk_compress_codec starpu_disk_compress_lz_codec =
+{
+	.name = "lz",
+	.compress = _starpu_lz_compress,
+	.decompress = _starpu_lz_decompress,
+};
+
+/* ------------------- threads -------------------  */
+
+/* Get the next item of the job to be processed, with the mutex held */
+static int _starpu_compress_job_get(struct starpu_compress_base *base, struct starpu_compress_job *job, unsigned *i)
+{
+	if (job->next >= job->n)
+		return 0;
+	*i = job->next++;
+	if (job->next == job->n && job->queued)
+	{
+		/* Nothing left for the threads */
+		starpu_compress_job_list_erase(&base->jobs, job);
+		job->queued = 0;
+	}
+	return 1;
+}
+
+/* Process item i of the job, with the mutex held */
+static void _starpu_compress_job_process(struct starpu_compress_base *base, struct starpu_compress_job *job, unsigned i)
+{
+	STARPU_PTHREAD_MUTEX_UNLOCK(&base->mutex);
+	job->func(job, i);
+	STARPU_PTHREAD_MUTEX_LOCK(&base->mutex);
+	if (++job->ndone == job->n)
+		STARPU_PTHREAD_COND_BROADCAST(&base->done_cond);
+}
+
+static void _starpu_compress_job_queue(struct starpu_compress_base *base, struct starpu_compress_job *job)
+{
+	starpu_compress_job_list_push_back(&base->jobs, job);
+	job->queued = 1;
+	STARPU_PTHREAD_COND_BROADCAST(&base->cond);
+}
+
+static void *_starpu_compress_thread(void *arg)
+{
+	struct starpu_compress_base *base = arg;
+	struct starpu_compress_job *job;
+	unsigned i;
+
+	STARPU_PTHREAD_MUTEX_LOCK(&base->mutex);
+	while (1)
+	{
+		while (!base->exiting && starpu_compress_job_list_empty(&base->jobs))
+			STARPU_PTHREAD_COND_WAIT(&base->cond, &base->mutex);
+		if (base->exiting)
+			break;
+
+		job = starpu_compress_job_list_front(&base->jobs);
+		if (_starpu_compress_job_get(base, job, &i))
+			_starpu_compress_job_process(base, job, i);
+	}
+	STARPU_PTHREAD_MUTEX_UNLOCK(&base->mutex);
+
+	return NULL;
+}
+
+/* Process all items of the job, with the help of the threads */
+static void _starpu_compress_job_run(struct starpu_compress_base *base, struct starpu_compress_job *job)
+{
+	unsigned i;
+
+	job->next = 0;
+	job->ndone = 0;
+	job->queued = 0;
+
+	STARPU_PTHREAD_MUTEX_LOCK(&base->mutex);
+	if (job->n > 1 && base->nthreads)
+		_starpu_compress_job_queue(base, job);
+	while (_starpu_compress_job_get(base, job, &i))
+		_starpu_compress_job_process(base, job, i);
+	while (job->ndone < job->n)
+		STARPU_PTHREAD_COND_WAIT(&base->done_cond, &base->mutex);
+	STARPU_PTHREAD_MUTEX_UNLOCK(&base->mutex);
+}
+
+/* ------------------- chunks -------------------  */
+
+/* Make the node account the stored size of the object instead of its
+ * uncompressed size, with the mutex held */
+static void _starpu_compress_account(struct starpu_compress_base *base, struct starpu_compress_obj *obj, starpu_ssize_t adjustment)
+{
+	starpu_ssize_t diff = adjustment - obj->adjustment;
+
+	if (base->node < 0 || !obj->accounted || diff == 0)
+		return;
+
+	if (diff > 0)
+		starpu_memory_allocate(base->node, diff, STARPU_MEMORY_OVERFLOW);
+	else
+		starpu_memory_deallocate(base->node, -diff);
+	obj->adjustment = adjustment;
+}
+
+static size_t _starpu_compress_chunk_size(struct starpu_compress_obj *obj, unsigned i)
+{
+	return STARPU_MIN((size_t) COMPRESS_CHUNK, obj->capacity - (size_t) i * COMPRESS_CHUNK);
+}
+
+/* Get the content of chunk i into buf */
+static void _starpu_compress_load(struct starpu_compress_base *base, struct starpu_compress_obj *obj, unsigned i, void *buf)
+{
+	size_t chunk_size = _starpu_compress_chunk_size(obj, i);
+	uint32_t length = obj->lengths[i];
+	off_t offset = (off_t) i * COMPRESS_CHUNK;
+	double start, end;
+	char *compressed;
+	int ret;
+
+	if (length == 0)
+	{
+		/* Never written */
+		memset(buf, 0, chunk_size);
+		return;
+	}
+
+	if (length == chunk_size)
+	{
+		/* Stored uncompressed */
+		base->ops->read(base->base, obj->obj, buf, offset, chunk_size);
+		start = end = 0.;
+	}
+	else
+	{
+		_STARPU_MALLOC(compressed, length);
+		base->ops->read(base->base, obj->obj, compressed, offset, length);
+		start = starpu_timing_now();
+		ret = base->codec->decompress(compressed, length, buf, chunk_size);
+		end = starpu_timing_now();
+		STARPU_ASSERT_MSG(ret == 0, "Codec %s could not decompress chunk %u of disk data %p", base->codec->name, i, obj);
+		free(compressed);
+	}
+
+	STARPU_PTHREAD_MUTEX_LOCK(&base->mutex);
+	base->stats.read += chunk_size;
+	base->stats.read_stored += length;
+	base->stats.decompress_time += end - start;
+	STARPU_PTHREAD_MUTEX_UNLOCK(&base->mutex);
+}
+
+/* Store chunk i from buf */
+static void _starpu_compress_store(struct starpu_compress_base *base, struct starpu_compress_obj *obj, unsigned i, const void *buf)
+{
+	size_t chunk_size = _starpu_compress_chunk_size(obj, i);
+	off_t offset = (off_t) i * COMPRESS_CHUNK;
+	uint32_t old_length = obj->lengths[i];
+	double start, end;
+	size_t length;
+	char *compressed;
+
+	/* Only keep the compressed version if it is smaller */
+	_STARPU_MALLOC(compressed, chunk_size);
+	start = starpu_timing_now();
+	length = base->codec->compress(buf, chunk_size, compressed, chunk_size - 1);
+	end = starpu_timing_now();
+
+	if (length == 0 || length >= chunk_size)
+	{
+		length = chunk_size;
+		base->ops->write(base->base, obj->obj, buf, offset, length);
+	}
+	else
+		base->ops->write(base->base, obj->obj, compressed, offset, length);
+	free(compressed);
+	obj->lengths[i] = length;
+
+	if (length < old_length && base->ops->discard)
+		/* Release the end of the previous version */
+		base->ops->discard(base->base, obj->obj, offset + length, old_length - length);
+
+	STARPU_PTHREAD_MUTEX_LOCK(&base->mutex);
+	obj->stored += length - old_length;
+	_starpu_compress_account(base, obj, (starpu_ssize_t) obj->stored - (starpu_ssize_t) obj->accounted);
+	base->stats.written += chunk_size;
+	base->stats.written_stored += length;
+	base->stats.compress_time += end - start;
+	if (length == chunk_size)
+		base->stats.nuncompressed++;
+	STARPU_PTHREAD_MUTEX_UNLOCK(&base->mutex);
+}
+
+/* Process the part of the request which falls in its n-th chunk */
+static void _starpu_compress_request_chunk(struct starpu_compress_job *job, unsigned n)
+{
+	struct starpu_compress_request *req = job->arg;
+	unsigned i = req->offset / COMPRESS_CHUNK + n;
+	off_t chunk_start = (off_t) i * COMPRESS_CHUNK;
+	size_t chunk_size = _starpu_compress_chunk_size(req->obj, i);
+	off_t start = STARPU_MAX(req->offset, chunk_start);
+	off_t end = STARPU_MIN(req->offset + (off_t) req->size, chunk_start + (off_t) chunk_size);
+	char *buf = req->buf + (start - req->offset);
+	char *tmp;
+
+	if (start == chunk_start && end == chunk_start + (off_t) chunk_size)
+	{
+		/* Whole chunk, process it in place */
+		if (req->write)
+			_starpu_compress_store(req->base, req->obj, i, buf);
+		else
+			_starpu_compress_load(req->base, req->obj, i, buf);
+		return;
+	}
+
+	_STARPU_MALLOC(tmp, chunk_size);
+	if (req->write)
+	{
+		if (req->truncate && start == chunk_start)
+			memset(tmp + (end - chunk_start), 0, chunk_start + chunk_size - end);
+		else
+			_starpu_compress_load(req->base, req->obj, i, tmp);
+		memcpy(tmp + (start - chunk_start), buf, end - start);
+		_starpu_compress_store(req->base, req->obj, i, tmp);
+	}
+	else
+	{
+		_starpu_compress_load(req->base, req->obj, i, tmp);
+		memcpy(buf, tmp + (start - chunk_start), end - start);
+	}
+	free(tmp);
+}
+
+static void _starpu_compress_request_init(struct starpu_compress_request *req, struct starpu_compress_base *base, struct starpu_compress_obj *obj, void *buf, off_t offset, size_t size, int write, int truncate)
+{
+	STARPU_ASSERT(offset + size <= obj->capacity);
+	req->base = base;
+	req->obj = obj;
+	req->buf = buf;
+	req->offset = offset;
+	req->size = size;
+	req->write = write;
+	req->truncate = truncate;
+}
+
+static void _starpu_compress_request_run(struct starpu_compress_request *req)
+{
+	struct starpu_compress_job job;
+
+	if (!req->size)
+		return;
+
+	job.func = _starpu_compress_request_chunk;
+	job.arg = req;
+	job.n = (req->offset + req->size - 1) / COMPRESS_CHUNK - req->offset / COMPRESS_CHUNK + 1;
+	_starpu_compress_job_run(req->base, &job);
+}
+
+/* ------------------- disk methods -------------------  */
+
+static void _starpu_compress_set_capacity(struct starpu_compress_obj *obj, size_t capacity)
+{
+	unsigned nchunks = (capacity + COMPRESS_CHUNK - 1) / COMPRESS_CHUNK;
+	obj->capacity = capacity;
+	free(obj->lengths);
+	_STARPU_CALLOC(obj->lengths, STARPU_MAX(nchunks, 1), sizeof(*obj->lengths));
+}
+
+/* allocation memory on disk */
+static void *starpu_compress_alloc(void *base, size_t size)
+{
+	struct starpu_compress_base *compressBase = (struct starpu_compress_base *) base;
+	struct starpu_compress_obj *obj;
+	void *sub = compressBase->ops->alloc(compressBase->base, size);
+
+	/* fail */
+	if (!sub)
+		return NULL;
+
+	_STARPU_CALLOC(obj, 1, sizeof(*obj));
+	obj->obj = sub;
+	obj->size = size;
+	/* As done by starpu_malloc_on_node() */
+	if (compressBase->node >= 0 && _starpu_get_node_struct(compressBase->node)->malloc_on_node_default_flags & STARPU_MALLOC_COUNT)
+		obj->accounted = size;
+	_starpu_compress_set_capacity(obj, size);
+
+	/* Nothing is stored yet */
+	STARPU_PTHREAD_MUTEX_LOCK(&compressBase->mutex);
+	_starpu_compress_account(compressBase, obj, -(starpu_ssize_t) size);
+	STARPU_PTHREAD_MUTEX_UNLOCK(&compressBase->mutex);
+	return obj;
+}
+
+/* free memory on disk */
+static void starpu_compress_free(void *base, void *obj, size_t size STARPU_ATTRIBUTE_UNUSED)
+{
+	struct starpu_compress_base *compressBase = (struct starpu_compress_base *) base;
+	struct starpu_compress_obj *tmp = (struct starpu_compress_obj *) obj;
+
+	/* Give back the accounting expected by StarPU */
+	STARPU_PTHREAD_MUTEX_LOCK(&compressBase->mutex);
+	_starpu_compress_account(compressBase, tmp, 0);
+	STARPU_PTHREAD_MUTEX_UNLOCK(&compressBase->mutex);
+
+	compressBase->ops->free(compressBase->base, tmp->obj, tmp->capacity);
+	free(tmp->lengths);
+	free(tmp);
+}
+
+/* read the memory disk */
+static int starpu_compress_read(void *base, void *obj, void *buf, off_t offset, size_t size)
+{
+	struct starpu_compress_request req;
+
+	_starpu_compress_request_init(&req, base, obj, buf, offset, size, 0, 0);
+	_starpu_compress_request_run(&req);
+	return 0;
+}
+
+/* write on the memory disk */
+static int starpu_compress_write(void *base, void *obj, const void *buf, off_t offset, size_t size)
+{
+	struct starpu_compress_request req;
+
+	_starpu_compress_request_init(&req, base, obj, (void *) buf, offset, size, 1, 0);
+	_starpu_compress_request_run(&req);
+	return 0;
+}
+
+static int starpu_compress_full_read(void *base, void *obj, void **ptr, size_t *size, unsigned dst_node)
+{
+	struct starpu_compress_obj *tmp = (struct starpu_compress_obj *) obj;
+
+	*size = tmp->size;
+	_starpu_malloc_flags_on_node(dst_node, ptr, *size, 0);
+	return starpu_compress_read(base, obj, *ptr, 0, *size);
+}
+
+/* Make room for size bytes of data, before a full write */
+static void _starpu_compress_prepare_full_write(struct starpu_compress_base *base, struct starpu_compress_obj *obj, size_t size)
+{
+	if (size > obj->capacity)
+	{
+		/* Does not fit any more, get a bigger object */
+		void *sub = base->ops->alloc(base->base, size);
+		STARPU_ASSERT_MSG(sub, "Could not allocate %lu bytes on the underlying disk", (unsigned long) size);
+		base->ops->free(base->base, obj->obj, obj->capacity);
+		obj->obj = sub;
+		_starpu_compress_set_capacity(obj, size);
+
+		STARPU_PTHREAD_MUTEX_LOCK(&base->mutex);
+		obj->stored = 0;
+		_starpu_compress_account(base, obj, -(starpu_ssize_t) obj->accounted);
+		STARPU_PTHREAD_MUTEX_UNLOCK(&base->mutex);
+	}
+
+	/* update size to realise the next good full_read */
+	obj->size = size;
+}
+
+static int starpu_compress_full_write(void *base, void *obj, void *ptr, size_t size)
+{
+	struct starpu_compress_request req;
+
+	_starpu_compress_prepare_full_write(base, obj, size);
+	_starpu_compress_request_init(&req, base, obj, ptr, 0, size, 1, 1);
+	_starpu_compress_request_run(&req);
+	return 0;
+}
+
+static void _starpu_compress_async_job(struct starpu_compress_job *job, unsigned i STARPU_ATTRIBUTE_UNUSED)
+{
+	_starpu_compress_request_run(job->arg);
+}
+
+/* Let a thread process the request, return NULL if there are no threads */
+static void *_starpu_compress_async(struct starpu_compress_base *base, struct starpu_compress_obj *obj, void *buf, off_t offset, size_t size, int write, int truncate)
+{
+	struct starpu_compress_request *req;
+
+	if (!base->nthreads)
+		return NULL;
+
+	_STARPU_MALLOC(req, sizeof(*req));
+	_starpu_compress_request_init(req, base, obj, buf, offset, size, write, truncate);
+	req->job.func = _starpu_compress_async_job;
+	req->job.arg = req;
+	req->job.n = 1;
+	req->job.next = 0;
+	req->job.ndone = 0;
+
+	STARPU_PTHREAD_MUTEX_LOCK(&base->mutex);
+	_starpu_compress_job_queue(base, &req->job);
+	STARPU_PTHREAD_MUTEX_UNLOCK(&base->mutex);
+
+	return req;
+}
+
+static void *starpu_compress_async_read(void *base, void *obj, void *buf, off_t offset, size_t size)
+{
+	return _starpu_compress_async(base, obj, buf, offset, size, 0, 0);
+}
+
+static void *starpu_compress_async_write(void *base, void *obj, void *buf, off_t offset, size_t size)
+{
+	return _starpu_compress_async(base, obj, buf, offset, size, 1, 0);
+}
+
+static void *starpu_compress_async_full_read(void *base, void *obj, void **ptr, size_t *size, unsigned dst_node)
+{
+	struct starpu_compress_base *compressBase = (struct starpu_compress_base *) base;
+	struct starpu_compress_obj *tmp = (struct starpu_compress_obj *) obj;
+
+	if (!compressBase->nthreads)
+		return NULL;
+
+	*size = tmp->size;
+	_starpu_malloc_flags_on_node(dst_node, ptr, *size, 0);
+	return _starpu_compress_async(base, obj, *ptr, 0, *size, 0, 0);
+}
+
+static void *starpu_compress_async_full_write(void *base, void *obj, void *ptr, size_t size)
+{
+	struct starpu_compress_base *compressBase = (struct starpu_compress_base *) base;
+
+	if (!compressBase->nthreads)
+		return NULL;
+
+	_starpu_compress_prepare_full_write(base, obj, size);
+	return _starpu_compress_async(base, obj, ptr, 0, size, 1, 1);
+}
+
+static void starpu_compress_wait_request(void *async_channel)
+{
+	struct starpu_compress_request *req = async_channel;
+	struct starpu_compress_base *base = req->base;
+
+	STARPU_PTHREAD_MUTEX_LOCK(&base->mutex);
+	while (req->job.ndone < req->job.n)
+		STARPU_PTHREAD_COND_WAIT(&base->done_cond, &base->mutex);
+	STARPU_PTHREAD_MUTEX_UNLOCK(&base->mutex);
+}
+
+static int starpu_compress_test_request(void *async_channel)
+{
+	struct starpu_compress_request *req = async_channel;
+	struct starpu_compress_base *base = req->base;
+	int done;
+
+	STARPU_PTHREAD_MUTEX_LOCK(&base->mutex);
+	done = req->job.ndone == req->job.n;
+	STARPU_PTHREAD_MUTEX_UNLOCK(&base->mutex);
+	return done;
+}
+
+static void starpu_compress_free_request(void *async_channel)
+{
+	free(async_channel);
+}
+
+static void *starpu_compress_plug(void *parameter, starpu_ssize_t size)
+{
+	struct starpu_disk_compress_parameter *param = (struct starpu_disk_compress_parameter *) parameter;
+	struct starpu_compress_base *base;
+	unsigned i;
+
+	STARPU_ASSERT_MSG(param && param->ops, "The parameter of the compress disk backend must be a struct starpu_disk_compress_parameter giving the underlying disk backend");
+	STARPU_ASSERT_MSG(param->ops != &starpu_disk_compress_ops, "The compress disk backend cannot be stacked on itself");
+
+	_STARPU_CALLOC(base, 1, sizeof(*base));
+	base->node = -1;
+	base->ops = param->ops;
+	base->codec = param->codec ? param->codec : &starpu_disk_compress_lz_codec;
+	base->base = base->ops->plug(param->parameter, size);
+	if (!base->base)
+	{
+		free(base);
+		return NULL;
+	}
+
+	STARPU_PTHREAD_MUTEX_INIT(&base->mutex, NULL);
+	STARPU_PTHREAD_COND_INIT(&base->cond, NULL);
+	STARPU_PTHREAD_COND_INIT(&base->done_cond, NULL);
+	starpu_compress_job_list_init(&base->jobs);
+
+	base->nthreads = starpu_getenv_number_default("STARPU_DISK_COMPRESS_NTHREADS", 2);
+	if (base->nthreads)
+	{
+		_STARPU_MALLOC(base->threads, base->nthreads * sizeof(*base->threads));
+		for (i = 0; i < base->nthreads; i++)
+			STARPU_PTHREAD_CREATE(&base->threads[i], NULL, _starpu_compress_thread, base);
+	}
+
+	return (void *) base;
+}
+
+/* free memory allocated for the base */
+static void starpu_compress_unplug(void *base)
+{
+	struct starpu_compress_base *compressBase = (struct starpu_compress_base *) base;
+	struct starpu_disk_compress_stats *stats = &compressBase->stats;
+	unsigned i;
+
+	STARPU_PTHREAD_MUTEX_LOCK(&compressBase->mutex);
+	compressBase->exiting = 1;
+	STARPU_PTHREAD_COND_BROADCAST(&compressBase->cond);
+	STARPU_PTHREAD_MUTEX_UNLOCK(&compressBase->mutex);
+	for (i = 0; i < compressBase->nthreads; i++)
+		STARPU_PTHREAD_JOIN(compressBase->threads[i], NULL);
+	free(compressBase->threads);
+
+	if (starpu_getenv_number_default("STARPU_DISK_COMPRESS_STATS", 0))
+	{
+		_STARPU_MSG("Disk compression with codec %s: wrote %lu bytes as %lu bytes (ratio %.2f, %.2f MB/s), read %lu bytes from %lu bytes (ratio %.2f, %.2f MB/s), %lu chunks stored uncompressed\n",
+			    compressBase->codec->name,
+			    (unsigned long) stats->written, (unsigned long) stats->written_stored,
+			    stats->written_stored ? (double) stats->written / stats->written_stored : 0.,
+			    stats->compress_time > 0. ? stats->written / stats->compress_time : 0.,
+			    (unsigned long) stats->read, (unsigned long) stats->read_stored,
+			    stats->read_stored ? (double) stats->read / stats->read_stored : 0.,
+			    stats->decompress_time > 0. ? stats->read / stats->decompress_time : 0.,
+			    stats->nuncompressed);
+	}
+
+	compressBase->ops->unplug(compressBase->base);
+	STARPU_PTHREAD_COND_DESTROY(&compressBase->done_cond);
+	STARPU_PTHREAD_COND_DESTROY(&compressBase->cond);
+	STARPU_PTHREAD_MUTEX_DESTROY(&compressBase->mutex);
+	free(compressBase);
+}
+
+static int get_compress_bandwidth_between_disk_and_main_ram(unsigned node, void *base)
+{
+	struct starpu_compress_base *compressBase = (struct starpu_compress_base *) base;
+
+	/* This is called when registering the disk, before any allocation */
+	compressBase->node = node;
+
+	/* Compression only makes the transfers smaller, take the
+	 * performance of the underlying backend */
+	return _starpu_disk_bandwidth_stacked(node, compressBase->ops, compressBase->base, "compress");
+}
+
+int starpu_disk_compress_get_stats(unsigned node, struct starpu_disk_compress_stats *stats)
+{
+	struct starpu_compress_base *compressBase = _starpu_disk_get_base(node, &starpu_disk_compress_ops);
+
+	if (!compressBase)
+		return -EINVAL;
+
+	STARPU_PTHREAD_MUTEX_LOCK(&compressBase->mutex);
+	*stats = compressBase->stats;
+	STARPU_PTHREAD_MUTEX_UNLOCK(&compressBase->mutex);
+
+	return 0;
+}
+
+struct starpu_disk_ops starpu_disk_compress_ops =
+{
+	.alloc = starpu_compress_alloc,
+	.free = starpu_compress_free,
+	.open = NULL,
+	.close = NULL,
+	.read = starpu_compress_read,
+	.write = starpu_compress_write,
+	.plug = starpu_compress_plug,
+	.unplug = starpu_compress_unplug,
+	.copy = NULL,
+	.bandwidth = get_compress_bandwidth_between_disk_and_main_ram,
+	.full_read = starpu_compress_full_read,
+	.full_write = starpu_compress_full_write,
+	.async_write = starpu_compress_async_write,
+	.async_read = starpu_compress_async_read,
+	.async_full_read = starpu_compress_async_full_read,
+	.async_full_write = starpu_compress_async_full_write,
+	.wait_request = starpu_compress_wait_request,
+	.test_request = starpu_compress_test_request,
+	.free_request = starpu_compress_free_request,
+};
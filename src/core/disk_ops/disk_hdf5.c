@@ -32,14 +32,17 @@
 #endif
 
 #define NITER	_starpu_calibration_minimum
-#define STARPU_CHUNK_DIM 4096
+
+/* HDF5 chunks have to be smaller than 4GiB */
+#define HDF5_MAX_CHUNK	((hsize_t) 1 << 31)
 
 /* ------------------- use HDF5 to write on disk -------------------  */
 
 #ifndef H5_HAVE_THREADSAFE
 static int nb_disk_open = 0;
 static volatile int init_finished = 0;
-static starpu_pthread_t global_thread;        /* This thread will perform each write/read because we don't have asynchronous functions */
+static unsigned global_nthreads;
+static starpu_pthread_t *global_threads;      /* These threads will perform each write/read because we don't have asynchronous functions */
 static volatile int global_run;                        /* Ask to the thread if he can continue */
 static starpu_pthread_mutex_t global_mutex;   /* Mutex is used to protect work_list and if HDF5 library is not safe */
 static starpu_pthread_cond_t global_cond;
@@ -48,7 +51,8 @@ static struct _starpu_hdf5_work_list global_work_list;        /* This list conta
 
 #ifdef H5_HAVE_THREADSAFE
 
-#define HDF5_VAR_THREAD fileBase->thread
+#define HDF5_VAR_NTHREADS fileBase->nthreads
+#define HDF5_VAR_THREADS fileBase->threads
 #define HDF5_VAR_RUN fileBase->run
 #define HDF5_VAR_MUTEX fileBase->mutex
 #define HDF5_VAR_COND fileBase->cond
@@ -56,7 +60,8 @@ static struct _starpu_hdf5_work_list global_work_list;        /* This list conta
 
 #else
 
-#define HDF5_VAR_THREAD global_thread
+#define HDF5_VAR_NTHREADS global_nthreads
+#define HDF5_VAR_THREADS global_threads
 #define HDF5_VAR_RUN global_run
 #define HDF5_VAR_MUTEX global_mutex
 #define HDF5_VAR_COND global_cond
@@ -87,9 +92,12 @@ struct starpu_hdf5_base
 	hid_t fileID;
 	char * path;
 	unsigned created;	/* StarPU creates the HDF5 file */
+	int fd;			/* Used to read/write datasets directly */
+	hid_t dapl;		/* Access properties of the datasets, without chunk cache */
 	unsigned next_dataset_id;
-	starpu_pthread_t thread;	/* This thread will perform each write/read because we don't have asynchronous functions */
-	int run;			/* Ask to the thread if he can continue */
+	unsigned nthreads;
+	starpu_pthread_t *threads;	/* These threads will perform each write/read because we don't have asynchronous functions */
+	int run;			/* Ask to the threads if they can continue */
 	starpu_pthread_mutex_t mutex;	/* Mutex is used to protect work_list and if HDF5 library is not safe */
 	starpu_pthread_cond_t cond;
 	struct _starpu_hdf5_work_list work_list;	/* This list contains the work for the hdf5 thread */
@@ -100,6 +108,9 @@ struct starpu_hdf5_obj
 	hid_t dataset;		/* describe this object in HDF5 file */
 	char * path;		/* path where data are stored in HDF5 file */
 	size_t size;
+	haddr_t offset;		/* offset in the file of the beginning of the data, if it can be accessed directly, HADDR_UNDEF otherwise */
+	size_t direct_size;	/* size of the data at offset, which can be accessed directly */
+	starpu_pthread_rwlock_t lock;	/* Taken in write mode when the dataset may be resized or recreated */
 };
 
 static inline void _starpu_hdf5_protect_start(void * base STARPU_ATTRIBUTE_UNUSED)
@@ -118,6 +129,191 @@ static inline void _starpu_hdf5_protect_stop(void * base STARPU_ATTRIBUTE_UNUSED
 #endif
 }
 
+/* Contiguous datasets and the first chunk of unfiltered chunked datasets,
+ * once allocated in the file, can be read and written without going through
+ * the HDF5 library, which serializes all calls even when it is thread-safe.
+ * This allows the internal threads to perform these transfers concurrently.
+ * To be called whenever the dataset is created or resized. */
+static void _starpu_hdf5_update_offset(struct starpu_hdf5_obj * obj)
+{
+	hid_t prop = H5Dget_create_plist(obj->dataset);
+	STARPU_ASSERT_MSG(prop >= 0, "Can not get the properties of this HDF5 dataset (%s)\n", obj->path);
+	H5D_layout_t layout = H5Pget_layout(prop);
+
+	obj->offset = HADDR_UNDEF;
+	obj->direct_size = 0;
+
+	if (layout == H5D_CONTIGUOUS)
+	{
+		obj->offset = H5Dget_offset(obj->dataset);
+		obj->direct_size = obj->size;
+	}
+#if H5_VERSION_GE(1,10,5)
+	else if (layout == H5D_CHUNKED && H5Pget_nfilters(prop) == 0)
+	{
+		hsize_t chunk[1];
+		hsize_t coord[1] = {0};
+		unsigned filter_mask;
+		haddr_t addr;
+		hsize_t chunk_size;
+
+		if (H5Pget_chunk(prop, 1, chunk) == 1
+		    && obj->size > 0
+		    && H5Dget_chunk_info_by_coord(obj->dataset, coord, &filter_mask, &addr, &chunk_size) >= 0
+		    && addr != HADDR_UNDEF)
+		{
+			hid_t datatype = H5Dget_type(obj->dataset);
+			obj->offset = addr;
+			obj->direct_size = STARPU_MIN((size_t) (chunk[0] * H5Tget_size(datatype)), obj->size);
+			H5Tclose(datatype);
+		}
+	}
+#endif
+
+	H5Pclose(prop);
+}
+
+/* Whether size bytes at offset of obj can be accessed directly */
+static int _starpu_hdf5_is_direct(struct starpu_hdf5_obj * obj, off_t offset, size_t size)
+{
+	return obj->offset != HADDR_UNDEF && offset + size <= obj->direct_size;
+}
+
+static void starpu_hdf5_direct_read(struct starpu_hdf5_base * fileBase, struct starpu_hdf5_obj * obj, void * buf, off_t offset, size_t size)
+{
+	off_t pos = obj->offset + offset;
+
+	while (size > 0)
+	{
+		starpu_ssize_t nb = pread(fileBase->fd, buf, size, pos);
+		STARPU_ASSERT_MSG(nb > 0, "Can not read data associed to this dataset (%s), pread failed with error '%s'\n", obj->path, strerror(errno));
+		size -= nb;
+		buf = (char *) buf + nb;
+		pos += nb;
+	}
+}
+
+static void starpu_hdf5_direct_write(struct starpu_hdf5_base * fileBase, struct starpu_hdf5_obj * obj, const void * buf, off_t offset, size_t size)
+{
+	off_t pos = obj->offset + offset;
+
+	while (size > 0)
+	{
+		starpu_ssize_t nb = pwrite(fileBase->fd, buf, size, pos);
+		STARPU_ASSERT_MSG(nb > 0, "Can not write data to this dataset (%s), pwrite failed with error '%s'\n", obj->path, strerror(errno));
+		size -= nb;
+		buf = (const char *) buf + nb;
+		pos += nb;
+	}
+}
+
+/* Datasets created by StarPU are made of one chunk of the size of the data,
+ * allocated right away, so that they can be accessed directly, and writing
+ * them does not need to update any metadata. They can still be extended
+ * when writing past their end */
+static hid_t _starpu_hdf5_dataset_create(struct starpu_hdf5_base * fileBase, char * name, size_t size, hid_t datatype)
+{
+	size_t sizeDatatype = H5Tget_size(datatype);
+	STARPU_ASSERT_MSG(sizeDatatype > 0 && size % sizeDatatype == 0, "Can not create a HDF5 dataset of %lu bytes with elements of %lu bytes\n", (unsigned long) size, (unsigned long) sizeDatatype);
+	size /= sizeDatatype;
+
+	/* create a dataspace with one dimension of size elements */
+	hsize_t dim[1] = {size};
+	hsize_t maxdim[1] = {H5S_UNLIMITED};
+	hid_t dataspace = H5Screate_simple(1, dim, maxdim);
+
+	if (dataspace < 0)
+		return dataspace;
+
+	hsize_t chunk[1] = {STARPU_MAX(STARPU_MIN((hsize_t) size, HDF5_MAX_CHUNK), 1)};
+	hid_t prop = H5Pcreate (H5P_DATASET_CREATE);
+	herr_t status = H5Pset_chunk (prop, 1, chunk);
+	STARPU_ASSERT_MSG(status >= 0, "Error when setting HDF5 property \n");
+	status = H5Pset_alloc_time (prop, H5D_ALLOC_TIME_EARLY);
+	STARPU_ASSERT_MSG(status >= 0, "Error when setting HDF5 property \n");
+	status = H5Pset_fill_time (prop, H5D_FILL_TIME_NEVER);
+	STARPU_ASSERT_MSG(status >= 0, "Error when setting HDF5 property \n");
+
+	/* create a dataset at location name, with data described by the dataspace */
+	hid_t dataset = H5Dcreate2(fileBase->fileID, name, datatype, dataspace, H5P_DEFAULT, prop, fileBase->dapl);
+
+	H5Sclose(dataspace);
+	H5Pclose(prop);
+
+	return dataset;
+}
+
+static int _starpu_hdf5_is_contiguous(struct starpu_hdf5_obj * obj)
+{
+	hid_t prop = H5Dget_create_plist(obj->dataset);
+	STARPU_ASSERT_MSG(prop >= 0, "Can not get the properties of this HDF5 dataset (%s)\n", obj->path);
+	H5D_layout_t layout = H5Pget_layout(prop);
+	H5Pclose(prop);
+
+	return layout == H5D_CONTIGUOUS;
+}
+
+static void starpu_hdf5_read_internal(struct _starpu_hdf5_work * work);
+static void starpu_hdf5_write_internal(struct _starpu_hdf5_work * work);
+
+/* Resize the dataset to size bytes, keeping the first keep bytes of data */
+static void _starpu_hdf5_data_resize(struct starpu_hdf5_base * fileBase, struct starpu_hdf5_obj * obj, size_t size, size_t keep)
+{
+	herr_t status;
+
+	if (!_starpu_hdf5_is_contiguous(obj))
+	{
+		/* Get official datatype */
+		hid_t datatype = H5Dget_type(obj->dataset);
+		hsize_t sizeDatatype = H5Tget_size(datatype);
+		H5Tclose(datatype);
+
+		/* Count in number of elements */
+		hsize_t extendsdim[1] = {size/sizeDatatype};
+		status = H5Dset_extent (obj->dataset, extendsdim);
+		STARPU_ASSERT_MSG(status >= 0, "Error when extending HDF5 dataspace !\n");
+		obj->size = size;
+		_starpu_hdf5_update_offset(obj);
+		return;
+	}
+
+	/* Contiguous datasets can not be resized, create a new one */
+	struct _starpu_hdf5_work work = { .base_src = fileBase, .obj_src = obj, .base_dst = fileBase, .obj_dst = obj };
+	void * ptr = NULL;
+
+	keep = STARPU_MIN(keep, STARPU_MIN(size, obj->size));
+	if (keep)
+	{
+		int ret = _starpu_malloc_flags_on_node(STARPU_MAIN_RAM, &ptr, keep, 0);
+		STARPU_ASSERT_MSG(ret == 0, "Cannot allocate %lu bytes to resize HDF5 dataset (%s)", (unsigned long) keep, obj->path);
+		work.ptr = ptr;
+		work.size = keep;
+		starpu_hdf5_read_internal(&work);
+	}
+
+	/* Keep the datatype of the application */
+	hid_t datatype = H5Dget_type(obj->dataset);
+	status = H5Dclose(obj->dataset);
+	STARPU_ASSERT_MSG(status >= 0, "Can not close this HDF5 dataset (%s)\n", obj->path);
+	status = H5Ldelete(fileBase->fileID, obj->path, H5P_DEFAULT);
+	STARPU_ASSERT_MSG(status >= 0, "Can not delete the link associed to this dataset (%s)\n", obj->path);
+
+	obj->dataset = _starpu_hdf5_dataset_create(fileBase, obj->path, size, datatype);
+	H5Tclose(datatype);
+	STARPU_ASSERT_MSG(obj->dataset >= 0, "Can not resize this HDF5 dataset (%s)\n", obj->path);
+	obj->size = size;
+	_starpu_hdf5_update_offset(obj);
+
+	if (keep)
+	{
+		work.ptr = ptr;
+		work.size = keep;
+		work.offset_dst = 0;
+		starpu_hdf5_write_internal(&work);
+		_starpu_free_flags_on_node(STARPU_MAIN_RAM, ptr, keep, 0);
+	}
+}
+
 /* ------------------ Functions for internal thread -------------------- */
 
 /* TODO : Dataspace may not be NATIVE_CHAR for opened data */
@@ -125,6 +321,12 @@ static void starpu_hdf5_full_read_internal(struct _starpu_hdf5_work * work)
 {
 	herr_t status;
 
+	if (_starpu_hdf5_is_direct(work->obj_src, 0, work->size))
+	{
+		starpu_hdf5_direct_read(work->base_src, work->obj_src, work->ptr, 0, work->size);
+		return;
+	}
+
 	status = H5Dread(work->obj_src->dataset, H5T_NATIVE_CHAR, H5S_ALL, H5S_ALL, H5P_DEFAULT, work->ptr);
 	STARPU_ASSERT_MSG(status >= 0, "Can not read data associed to this dataset (%s)\n", work->obj_src->path);
 }
@@ -134,18 +336,14 @@ static void starpu_hdf5_full_write_internal(struct _starpu_hdf5_work * work)
 {
 	herr_t status;
 
-	/* Update size of dataspace */
-	if (work->size > work->obj_dst->size)
-	{
-		/* Get official datatype */
-		hid_t datatype = H5Dget_type(work->obj_dst->dataset);
-		hsize_t sizeDatatype = H5Tget_size(datatype);
+	/* The whole data is replaced */
+	if (work->size != work->obj_dst->size)
+		_starpu_hdf5_data_resize(work->base_dst, work->obj_dst, work->size, 0);
 
-		/* Count in number of elements */
-		hsize_t extendsdim[1] = {work->size/sizeDatatype};
-		status = H5Dset_extent (work->obj_dst->dataset, extendsdim);
-		STARPU_ASSERT_MSG(status >= 0, "Error when extending HDF5 dataspace !\n");
-		work->obj_dst->size = work->size;
+	if (_starpu_hdf5_is_direct(work->obj_dst, 0, work->size))
+	{
+		starpu_hdf5_direct_write(work->base_dst, work->obj_dst, work->ptr, 0, work->size);
+		return;
 	}
 
 	/* Write ALL the dataspace */
@@ -157,6 +355,12 @@ static void starpu_hdf5_read_internal(struct _starpu_hdf5_work * work)
 {
 	herr_t status;
 
+	if (_starpu_hdf5_is_direct(work->obj_src, work->offset_src, work->size))
+	{
+		starpu_hdf5_direct_read(work->base_src, work->obj_src, work->ptr, work->offset_src, work->size);
+		return;
+	}
+
 	/* Get official datatype */
 	hid_t datatype = H5Dget_type(work->obj_src->dataset);
 	hsize_t sizeDatatype = H5Tget_size(datatype);
@@ -201,20 +405,20 @@ static void starpu_hdf5_write_internal(struct _starpu_hdf5_work * work)
 {
 	herr_t status;
 
-	/* Get official datatype */
-	hid_t datatype = H5Dget_type(work->obj_dst->dataset);
-	hsize_t sizeDatatype = H5Tget_size(datatype);
-
-	/* Update size of dataspace */
+	/* Update size of dataspace, keeping the data before */
 	if (work->size + work->offset_dst > work->obj_dst->size)
+		_starpu_hdf5_data_resize(work->base_dst, work->obj_dst, work->offset_dst + work->size, work->offset_dst);
+
+	if (_starpu_hdf5_is_direct(work->obj_dst, work->offset_dst, work->size))
 	{
-		/* Count in number of elements */
-		hsize_t extendsdim[1] = {(work->offset_dst + work->size)/sizeDatatype};
-		status = H5Dset_extent (work->obj_dst->dataset, extendsdim);
-		STARPU_ASSERT_MSG(status >= 0, "Error when extending HDF5 dataspace !\n");
-		work->obj_dst->size = work->offset_dst + work->size;
+		starpu_hdf5_direct_write(work->base_dst, work->obj_dst, work->ptr, work->offset_dst, work->size);
+		return;
 	}
 
+	/* Get official datatype */
+	hid_t datatype = H5Dget_type(work->obj_dst->dataset);
+	hsize_t sizeDatatype = H5Tget_size(datatype);
+
 	/* count in element, not in byte */
 	work->offset_dst /= sizeDatatype;
 	work->size /= sizeDatatype;
@@ -266,7 +470,8 @@ static void starpu_hdf5_copy_internal(struct _starpu_hdf5_work * work)
 		status = H5Ocopy(work->base_src->fileID, work->obj_src->path, work->base_dst->fileID, work->obj_dst->path, H5P_DEFAULT, H5P_DEFAULT);
 		STARPU_ASSERT_MSG(status >= 0, "Can not copy data (%s) associed to this disk (%s) to the data (%s) on this disk (%s)\n", work->obj_src->path, work->base_src->path, work->obj_dst->path, work->base_dst->path);
 
-		work->obj_dst->dataset = H5Dopen2(work->base_dst->fileID, work->obj_dst->path, H5P_DEFAULT);
+		work->obj_dst->dataset = H5Dopen2(work->base_dst->fileID, work->obj_dst->path, work->base_dst->dapl);
+		_starpu_hdf5_update_offset(work->obj_dst);
 	}
 	else
 	{
@@ -290,25 +495,167 @@ static void starpu_hdf5_copy_internal(struct _starpu_hdf5_work * work)
 	}
 }
 
+/* Whether the work can be performed without calling the HDF5 library */
+static int _starpu_hdf5_work_is_direct(struct _starpu_hdf5_work * work)
+{
+	switch(work->type)
+	{
+		case READ:
+		case FULL_READ:
+			return _starpu_hdf5_is_direct(work->obj_src, work->offset_src, work->size);
+
+		case WRITE:
+			return _starpu_hdf5_is_direct(work->obj_dst, work->offset_dst, work->size);
+
+		case FULL_WRITE:
+			return work->size == work->obj_dst->size && _starpu_hdf5_is_direct(work->obj_dst, 0, work->size);
+
+		default:
+			return 0;
+	}
+}
+
+static void _starpu_hdf5_perform_work(struct _starpu_hdf5_work * work)
+{
+	switch(work->type)
+	{
+		case READ:
+			starpu_hdf5_read_internal(work);
+			break;
+
+		case WRITE:
+			starpu_hdf5_write_internal(work);
+			break;
+
+		case FULL_READ:
+			starpu_hdf5_full_read_internal(work);
+			break;
+
+		case FULL_WRITE:
+			starpu_hdf5_full_write_internal(work);
+			break;
+
+		case COPY:
+			starpu_hdf5_copy_internal(work);
+			break;
+
+		default:
+			STARPU_ABORT();
+	}
+}
+
+/* Whether the work may resize or recreate the dataset it writes to */
+static int _starpu_hdf5_work_resizes(struct _starpu_hdf5_work * work)
+{
+	switch(work->type)
+	{
+		case WRITE:
+			return work->offset_dst + work->size > work->obj_dst->size;
+
+		case FULL_WRITE:
+			return work->size != work->obj_dst->size;
+
+		case COPY:
+			return 1;
+
+		default:
+			return 0;
+	}
+}
+
+/* Direct accesses are performed concurrently, make sure that the dataset
+ * does not move meanwhile */
+static void _starpu_hdf5_work_lock(struct _starpu_hdf5_work * work)
+{
+	switch(work->type)
+	{
+		case READ:
+		case FULL_READ:
+			STARPU_PTHREAD_RWLOCK_RDLOCK(&work->obj_src->lock);
+			break;
+
+		case WRITE:
+		case FULL_WRITE:
+			STARPU_PTHREAD_RWLOCK_RDLOCK(&work->obj_dst->lock);
+			if (_starpu_hdf5_work_resizes(work))
+			{
+				STARPU_PTHREAD_RWLOCK_UNLOCK(&work->obj_dst->lock);
+				STARPU_PTHREAD_RWLOCK_WRLOCK(&work->obj_dst->lock);
+			}
+			break;
+
+		case COPY:
+			if (work->obj_src == work->obj_dst)
+				STARPU_PTHREAD_RWLOCK_WRLOCK(&work->obj_dst->lock);
+			else if (work->obj_src < work->obj_dst)
+			{
+				STARPU_PTHREAD_RWLOCK_RDLOCK(&work->obj_src->lock);
+				STARPU_PTHREAD_RWLOCK_WRLOCK(&work->obj_dst->lock);
+			}
+			else
+			{
+				STARPU_PTHREAD_RWLOCK_WRLOCK(&work->obj_dst->lock);
+				STARPU_PTHREAD_RWLOCK_RDLOCK(&work->obj_src->lock);
+			}
+			break;
+
+		default:
+			STARPU_ABORT();
+	}
+}
+
+static void _starpu_hdf5_work_unlock(struct _starpu_hdf5_work * work)
+{
+	switch(work->type)
+	{
+		case READ:
+		case FULL_READ:
+			STARPU_PTHREAD_RWLOCK_UNLOCK(&work->obj_src->lock);
+			break;
+
+		case WRITE:
+		case FULL_WRITE:
+			STARPU_PTHREAD_RWLOCK_UNLOCK(&work->obj_dst->lock);
+			break;
+
+		case COPY:
+			STARPU_PTHREAD_RWLOCK_UNLOCK(&work->obj_dst->lock);
+			if (work->obj_src != work->obj_dst)
+				STARPU_PTHREAD_RWLOCK_UNLOCK(&work->obj_src->lock);
+			break;
+
+		default:
+			STARPU_ABORT();
+	}
+}
+
 static void * _starpu_hdf5_internal_thread(void * arg)
 {
 #ifdef H5_HAVE_THREADSAFE
 	struct starpu_hdf5_base * fileBase = (struct starpu_hdf5_base *) arg;
 #endif
+	STARPU_PTHREAD_MUTEX_LOCK(&HDF5_VAR_MUTEX);
 	while (HDF5_VAR_RUN || !_starpu_hdf5_work_list_empty(&HDF5_VAR_WORK_LIST))
 	{
-		STARPU_PTHREAD_MUTEX_LOCK(&HDF5_VAR_MUTEX);
-		if (_starpu_hdf5_work_list_empty(&HDF5_VAR_WORK_LIST) && HDF5_VAR_RUN)
+		if (_starpu_hdf5_work_list_empty(&HDF5_VAR_WORK_LIST))
+		{
 			STARPU_PTHREAD_COND_WAIT(&HDF5_VAR_COND, &HDF5_VAR_MUTEX);
+			continue;
+		}
+
+		struct _starpu_hdf5_work * work = _starpu_hdf5_work_list_pop_back(&HDF5_VAR_WORK_LIST);
 		STARPU_PTHREAD_MUTEX_UNLOCK(&HDF5_VAR_MUTEX);
 
-		/* We are the only consumer here, don't need to protect here */
-		if (!_starpu_hdf5_work_list_empty(&HDF5_VAR_WORK_LIST))
-		{
-			STARPU_PTHREAD_MUTEX_LOCK(&HDF5_VAR_MUTEX);
-			struct _starpu_hdf5_work * work = _starpu_hdf5_work_list_pop_back(&HDF5_VAR_WORK_LIST);
-			STARPU_PTHREAD_MUTEX_UNLOCK(&HDF5_VAR_MUTEX);
+		_starpu_hdf5_work_lock(work);
 
+		if (_starpu_hdf5_work_is_direct(work))
+		{
+			/* No need to protect the HDF5 library, this can
+			 * proceed concurrently with the other threads */
+			_starpu_hdf5_perform_work(work);
+		}
+		else
+		{
 			if (work->base_src < work->base_dst)
 			{
 				_starpu_hdf5_protect_start(work->base_src);
@@ -325,31 +672,7 @@ static void * _starpu_hdf5_internal_thread(void * arg)
 #endif
 			}
 
-			switch(work->type)
-			{
-				case READ:
-					starpu_hdf5_read_internal(work);
-					break;
-
-				case WRITE:
-					starpu_hdf5_write_internal(work);
-					break;
-
-				case FULL_READ:
-					starpu_hdf5_full_read_internal(work);
-					break;
-
-				case FULL_WRITE:
-					starpu_hdf5_full_write_internal(work);
-					break;
-
-				case COPY:
-					starpu_hdf5_copy_internal(work);
-					break;
-
-				default:
-					STARPU_ABORT();
-			}
+			_starpu_hdf5_perform_work(work);
 
 			if (work->base_src < work->base_dst)
 			{
@@ -366,24 +689,36 @@ static void * _starpu_hdf5_internal_thread(void * arg)
 					_starpu_hdf5_protect_stop(work->base_src);
 #endif
 			}
+		}
 
-			/* Update event to tell it's finished */
-			starpu_sem_post((starpu_sem_t *) work->event);
+		_starpu_hdf5_work_unlock(work);
 
-			free(work);
-		}
+		/* Update event to tell it's finished */
+		starpu_sem_post((starpu_sem_t *) work->event);
+
+		free(work);
+
+		STARPU_PTHREAD_MUTEX_LOCK(&HDF5_VAR_MUTEX);
 	}
+	STARPU_PTHREAD_MUTEX_UNLOCK(&HDF5_VAR_MUTEX);
 
 	return NULL;
 }
 
 static void _starpu_hdf5_create_thread(struct starpu_hdf5_base * fileBase)
 {
+	unsigned i;
+
 	_starpu_hdf5_work_list_init(&HDF5_VAR_WORK_LIST);
 	HDF5_VAR_RUN = 1;
 
+	HDF5_VAR_NTHREADS = starpu_getenv_number_default("STARPU_HDF5_NTHREADS", 2);
+	STARPU_ASSERT_MSG(HDF5_VAR_NTHREADS >= 1, "STARPU_HDF5_NTHREADS must be at least 1");
+	_STARPU_MALLOC(HDF5_VAR_THREADS, HDF5_VAR_NTHREADS * sizeof(*HDF5_VAR_THREADS));
+
 	STARPU_PTHREAD_COND_INIT(&HDF5_VAR_COND, NULL);
-	STARPU_PTHREAD_CREATE(&HDF5_VAR_THREAD, NULL, _starpu_hdf5_internal_thread, (void *) fileBase);
+	for (i = 0; i < HDF5_VAR_NTHREADS; i++)
+		STARPU_PTHREAD_CREATE(&HDF5_VAR_THREADS[i], NULL, _starpu_hdf5_internal_thread, (void *) fileBase);
 }
 
 /* returns the size in BYTES */
@@ -456,45 +791,27 @@ static struct starpu_hdf5_obj * _starpu_hdf5_data_alloc(struct starpu_hdf5_base
 
 	_starpu_hdf5_protect_start((void *) fileBase);
 
-	/* create a dataspace with one dimension of size elements */
-	hsize_t dim[1] = {size};
-	hsize_t maxdim[1] = {H5S_UNLIMITED};
-	hid_t dataspace = H5Screate_simple(1, dim, maxdim);
-
-	if (dataspace < 0)
-	{
-		free(obj);
-		return NULL;
-	}
-
-	hsize_t chunkdim[1] = {STARPU_CHUNK_DIM};
-	hid_t prop = H5Pcreate (H5P_DATASET_CREATE);
-	herr_t status = H5Pset_chunk (prop, 1, chunkdim);
-	STARPU_ASSERT_MSG(status >= 0, "Error when setting HDF5 property \n");
-
-	/* create a dataset at location name, with data described by the dataspace.
-	 * Each element are like char in C (expected one byte)
-	 */
-	obj->dataset = H5Dcreate2(fileBase->fileID, name, H5T_NATIVE_CHAR, dataspace, H5P_DEFAULT, prop, H5P_DEFAULT);
-
-	H5Sclose(dataspace);
-	H5Pclose(prop);
+	/* Each element are like char in C (expected one byte) */
+	obj->dataset = _starpu_hdf5_dataset_create(fileBase, name, size, H5T_NATIVE_CHAR);
 
 	if (obj->dataset < 0)
 	{
+		_starpu_hdf5_protect_stop((void *) fileBase);
 		free(obj);
 		return NULL;
 	}
 
 	obj->path = name;
 	obj->size = size;
+	_starpu_hdf5_update_offset(obj);
+	STARPU_PTHREAD_RWLOCK_INIT(&obj->lock, NULL);
 
 	_starpu_hdf5_protect_stop((void *) fileBase);
 
 	return obj;
 }
 
-static struct starpu_hdf5_obj * _starpu_hdf5_data_open(struct starpu_hdf5_base * fileBase,  char * name, size_t size)
+static struct starpu_hdf5_obj * _starpu_hdf5_data_open(struct starpu_hdf5_base * fileBase,  char * name, size_t size STARPU_ATTRIBUTE_UNUSED)
 {
 	struct starpu_hdf5_obj * obj;
 	_STARPU_MALLOC(obj, sizeof(*obj));
@@ -504,18 +821,23 @@ static struct starpu_hdf5_obj * _starpu_hdf5_data_open(struct starpu_hdf5_base *
 	/* create a dataset at location name, with data described by the dataspace.
 	 * Each element are like char in C (expected one byte)
 	 */
-	obj->dataset = H5Dopen2(fileBase->fileID, name, H5P_DEFAULT);
-
-	_starpu_hdf5_protect_stop((void *) fileBase);
+	obj->dataset = H5Dopen2(fileBase->fileID, name, fileBase->dapl);
 
 	if (obj->dataset < 0)
 	{
+		_starpu_hdf5_protect_stop((void *) fileBase);
 		free(obj);
 		return NULL;
 	}
 
 	obj->path = name;
-	obj->size = size;
+	/* The dataset may be smaller than the data, it will be extended when
+	 * writing past its end */
+	obj->size = _starpu_get_size_obj(obj);
+	_starpu_hdf5_update_offset(obj);
+	STARPU_PTHREAD_RWLOCK_INIT(&obj->lock, NULL);
+
+	_starpu_hdf5_protect_stop((void *) fileBase);
 
 	return obj;
 }
@@ -560,7 +882,13 @@ static void *starpu_hdf5_plug(void *parameter, starpu_ssize_t size STARPU_ATTRIB
 		close(id);
 
 		/* Truncate it */
-		fileBase->fileID = H5Fcreate((char *)fileBase->path, H5F_ACC_TRUNC, H5P_DEFAULT, H5P_DEFAULT);
+		hid_t prop = H5Pcreate(H5P_FILE_CREATE);
+#if H5_VERS_MAJOR > 1 || (H5_VERS_MAJOR == 1 && H5_VERS_MINOR > 10) || (H5_VERS_MAJOR == 1 && H5_VERS_MINOR == 10 && H5_VERS_RELEASE > 0)
+		/* Reuse the space of the freed datasets */
+		H5Pset_file_space_strategy(prop, H5F_FSPACE_STRATEGY_FSM_AGGR, 0, 0);
+#endif
+		fileBase->fileID = H5Fcreate((char *)fileBase->path, H5F_ACC_TRUNC, prop, H5P_DEFAULT);
+		H5Pclose(prop);
 		if (fileBase->fileID < 0)
 		{
 			free(fileBase);
@@ -587,6 +915,13 @@ static void *starpu_hdf5_plug(void *parameter, starpu_ssize_t size STARPU_ATTRIB
 		fileBase->path = path;
 	}
 
+	/* The data is accessed by whole tiles, the chunk cache would only
+	 * duplicate it in memory */
+	fileBase->dapl = H5Pcreate(H5P_DATASET_ACCESS);
+	STARPU_ASSERT_MSG(fileBase->dapl >= 0, "Error when creating HDF5 property \n");
+	herr_t status = H5Pset_chunk_cache(fileBase->dapl, 0, 0, H5D_CHUNK_CACHE_W0_DEFAULT);
+	STARPU_ASSERT_MSG(status >= 0, "Error when setting HDF5 property \n");
+
 #ifndef H5_HAVE_THREADSAFE
 	if (actual_nb_disk == 1)
 	{
@@ -597,12 +932,11 @@ static void *starpu_hdf5_plug(void *parameter, starpu_ssize_t size STARPU_ATTRIB
 	}
 #endif
 
-#if H5_VERS_MAJOR > 1 || (H5_VERS_MAJOR == 1 && H5_VERS_MINOR > 10) || (H5_VERS_MAJOR == 1 && H5_VERS_MINOR == 10 && H5_VERS_RELEASE > 0)
-	H5Pset_file_space_strategy(fileBase->fileID, H5F_FSPACE_STRATEGY_FSM_AGGR, 0, 0);
-#endif
-
 	_starpu_hdf5_protect_stop(fileBase);
 
+	fileBase->fd = open(fileBase->path, O_RDWR | O_BINARY);
+	STARPU_ASSERT_MSG(fileBase->fd >= 0, "Can not open the HDF5 file (%s): %s", fileBase->path, strerror(errno));
+
 	fileBase->next_dataset_id = 0;
 
 	return (void *) fileBase;
@@ -627,7 +961,10 @@ static void starpu_hdf5_unplug(void *base)
 		HDF5_VAR_RUN = 0;
 		STARPU_PTHREAD_COND_BROADCAST(&HDF5_VAR_COND);
 		STARPU_PTHREAD_MUTEX_UNLOCK(&HDF5_VAR_MUTEX);
-		STARPU_PTHREAD_JOIN(HDF5_VAR_THREAD, NULL);
+		unsigned i;
+		for (i = 0; i < HDF5_VAR_NTHREADS; i++)
+			STARPU_PTHREAD_JOIN(HDF5_VAR_THREADS[i], NULL);
+		free(HDF5_VAR_THREADS);
 		STARPU_PTHREAD_MUTEX_LOCK(&HDF5_VAR_MUTEX);
 		STARPU_PTHREAD_COND_DESTROY(&HDF5_VAR_COND);
 		STARPU_ASSERT(_starpu_hdf5_work_list_empty(&HDF5_VAR_WORK_LIST));
@@ -636,7 +973,9 @@ static void starpu_hdf5_unplug(void *base)
 	}
 #endif
 
+	H5Pclose(fileBase->dapl);
 	status = H5Fclose(fileBase->fileID);
+	close(fileBase->fd);
 
 	STARPU_PTHREAD_MUTEX_UNLOCK(&HDF5_VAR_MUTEX);
 
@@ -710,6 +1049,7 @@ static void starpu_hdf5_free(void *base, void *obj, size_t size STARPU_ATTRIBUTE
 
 	_starpu_hdf5_protect_stop(base);
 
+	STARPU_PTHREAD_RWLOCK_DESTROY(&dataObj->lock);
 	free(dataObj->path);
 	free(dataObj);
 }
@@ -745,6 +1085,7 @@ static void starpu_hdf5_close(void *base, void *obj, size_t size STARPU_ATTRIBUT
 
 	_starpu_hdf5_protect_stop(base);
 
+	STARPU_PTHREAD_RWLOCK_DESTROY(&dataObj->lock);
 	free(dataObj->path);
 	free(dataObj);
 }
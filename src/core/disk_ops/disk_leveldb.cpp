@@ -364,6 +364,11 @@ struct starpu_disk_ops starpu_disk_leveldb_ops =
 	NULL,
 	NULL,
 	NULL,
+	NULL,
+	NULL,
+	NULL,
+	NULL,
+	NULL,
 	NULL
 };
 #endif
@@ -0,0 +1,154 @@
+/* StarPU --- Runtime system for heterogeneous multicore architectures.
+ *
+ * Copyright (C) 2023       Université de Bordeaux, CNRS (LaBRI UMR 5800), Inria
+ *
+ * StarPU is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or (at
+ * your option) any later version.
+ *
+ * StarPU is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU Lesser General Public License in COPYING.LGPL for more details.
+ */
+
+#include <fcntl.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+#include <stdint.h>
+#include <errno.h>
+
+#include <common/config.h>
+#ifdef HAVE_UNISTD_H
+#include <unistd.h>
+#endif
+#ifdef HAVE_MMAP
+#include <sys/mman.h>
+#endif
+#include <starpu.h>
+#include <core/disk.h>
+#include <core/perfmodel/perfmodel.h>
+#include <core/disk_ops/unistd/disk_unistd_global.h>
+
+/* ------------------- use UNISTD to write on disk, and mmap to map in memory -------------------  */
+
+/* allocation memory on disk */
+static void *starpu_mmap_alloc(void *base, size_t size)
+{
+	struct starpu_unistd_global_obj *obj;
+	_STARPU_MALLOC(obj, sizeof(struct starpu_unistd_global_obj));
+	obj->flags = O_RDWR | O_BINARY;
+	return starpu_unistd_global_alloc(obj, base, size);
+}
+
+/* open an existing memory on disk */
+static void *starpu_mmap_open(void *base, void *pos, size_t size)
+{
+	struct starpu_unistd_global_obj *obj;
+	_STARPU_MALLOC(obj, sizeof(struct starpu_unistd_global_obj));
+	obj->flags = O_RDWR | O_BINARY;
+	return starpu_unistd_global_open(obj, base, pos, size);
+}
+
+/* create a named memory on disk */
+static void *starpu_mmap_create(void *base, void *pos, size_t size)
+{
+	struct starpu_unistd_global_obj *obj;
+	_STARPU_MALLOC(obj, sizeof(struct starpu_unistd_global_obj));
+	obj->flags = O_RDWR | O_BINARY;
+	return starpu_unistd_global_create(obj, base, pos, size);
+}
+
+#ifdef HAVE_MMAP
+/* mmap needs offsets aligned on pages */
+static off_t starpu_mmap_shift(off_t offset)
+{
+	return offset % getpagesize();
+}
+
+static void *starpu_mmap_map(void *base STARPU_ATTRIBUTE_UNUSED, void *obj, off_t offset, size_t size)
+{
+	struct starpu_unistd_global_obj *tmp = (struct starpu_unistd_global_obj *) obj;
+	off_t shift = starpu_mmap_shift(offset);
+	void *ptr;
+	int fd;
+
+	/* The mapping remains valid after closing the file */
+	fd = open(tmp->path, tmp->flags);
+	if (fd < 0)
+	{
+		_STARPU_DISP("Could not open file %s to map it, open failed with error '%s'\n", tmp->path, strerror(errno));
+		return NULL;
+	}
+	ptr = mmap(NULL, size + shift, PROT_READ | PROT_WRITE, MAP_SHARED, fd, offset - shift);
+	close(fd);
+	if (ptr == MAP_FAILED)
+	{
+		_STARPU_DISP("Could not map file %s, mmap failed with error '%s'\n", tmp->path, strerror(errno));
+		return NULL;
+	}
+
+#ifdef MADV_WILLNEED
+	/* We are mapping because a task will need the data, most often while
+	 * prefetching it, so let the kernel start reading it */
+	madvise(ptr, size + shift, MADV_WILLNEED);
+#endif
+
+	return (char *) ptr + shift;
+}
+
+static int starpu_mmap_sync(void *base STARPU_ATTRIBUTE_UNUSED, void *obj STARPU_ATTRIBUTE_UNUSED, void *ptr, off_t offset, size_t size)
+{
+	off_t shift = starpu_mmap_shift(offset);
+
+	return msync((char *) ptr - shift, size + shift, MS_ASYNC);
+}
+
+static void starpu_mmap_unmap(void *base STARPU_ATTRIBUTE_UNUSED, void *obj STARPU_ATTRIBUTE_UNUSED, void *ptr, off_t offset, size_t size)
+{
+	off_t shift = starpu_mmap_shift(offset);
+
+	/* Dirty pages remain in the page cache, to be written back by the kernel */
+	int res = munmap((char *) ptr - shift, size + shift);
+	STARPU_ASSERT_MSG(res == 0, "Could not unmap data, munmap failed with error '%s'\n", strerror(errno));
+}
+#endif
+
+struct starpu_disk_ops starpu_disk_mmap_ops =
+{
+	.alloc = starpu_mmap_alloc,
+	.free = starpu_unistd_global_free,
+	.open = starpu_mmap_open,
+	.create = starpu_mmap_create,
+	.rename = starpu_unistd_global_rename,
+	.close = starpu_unistd_global_close,
+	.read = starpu_unistd_global_read,
+	.write = starpu_unistd_global_write,
+	.discard = starpu_unistd_global_discard,
+	.plug = starpu_unistd_global_plug,
+	.unplug = starpu_unistd_global_unplug,
+#ifdef STARPU_UNISTD_USE_COPY
+	.copy = starpu_unistd_global_copy,
+#else
+	.copy = NULL,
+#endif
+	.bandwidth = _starpu_get_unistd_global_bandwidth_between_disk_and_main_ram,
+#ifdef HAVE_AIO_H
+	.async_read = starpu_unistd_global_async_read,
+	.async_write = starpu_unistd_global_async_write,
+	.async_full_read = starpu_unistd_global_async_full_read,
+	.async_full_write = starpu_unistd_global_async_full_write,
+	.wait_request = starpu_unistd_global_wait_request,
+	.test_request = starpu_unistd_global_test_request,
+	.free_request = starpu_unistd_global_free_request,
+#endif
+	.full_read = starpu_unistd_global_full_read,
+	.full_write = starpu_unistd_global_full_write,
+#ifdef HAVE_MMAP
+	.map = starpu_mmap_map,
+	.sync = starpu_mmap_sync,
+	.unmap = starpu_mmap_unmap,
+#endif
+};
@@ -0,0 +1,554 @@
+/* StarPU --- Runtime system for heterogeneous multicore architectures.
+ *
+ * Copyright (C) 2023       Université de Bordeaux, CNRS (LaBRI UMR 5800), Inria
+ *
+ * StarPU is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or (at
+ * your option) any later version.
+ *
+ * StarPU is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU Lesser General Public License in COPYING.LGPL for more details.
+ */
+
+#include <fcntl.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+#include <errno.h>
+#include <time.h>
+
+#include <common/config.h>
+#ifdef HAVE_UNISTD_H
+#include <unistd.h>
+#endif
+#include <starpu.h>
+#include <common/list.h>
+#include <common/uthash.h>
+#include <core/disk.h>
+#include <core/perfmodel/perfmodel.h>
+#include <datawizard/copy_driver.h>
+#include <datawizard/memory_manager.h>
+#include <datawizard/memory_nodes.h>
+
+#ifdef STARPU_HAVE_WINDOWS
+#  include <io.h>
+#endif
+
+#define NITER	_starpu_calibration_minimum
+
+#ifndef O_BINARY
+#define O_BINARY 0
+#endif
+
+/* Granularity of the allocations in the file */
+#define SLAB_ALIGN	4096
+/* Free extents are sorted in size classes by the log2 of their number of
+ * SLAB_ALIGN blocks */
+#define SLAB_NCLASSES	32
+/* Minimum amount by which the file is grown when it is full */
+#define SLAB_GROW	(64*1024*1024)
+
+/* ------------------- use one single file to write on disk -------------------  */
+
+/* A free range of the file */
+LIST_TYPE(starpu_slab_extent,
+	off_t offset;
+	off_t end;
+	size_t size;
+	UT_hash_handle hh_offset;
+	UT_hash_handle hh_end;
+);
+
+struct starpu_slab_obj
+{
+	off_t offset;
+	/* Size reserved in the file */
+	size_t capacity;
+	/* Size of the data, for full_read */
+	size_t size;
+};
+
+struct starpu_slab_base
+{
+	char *path;
+	int created;
+	char *file_path;
+	int descriptor;
+	starpu_pthread_mutex_t mutex;
+
+	/* Size of the file */
+	off_t file_size;
+	/* Everything after this is free */
+	off_t end;
+
+	/* Free extents before end, by size class, and indexed by their
+	 * boundaries to coalesce them */
+	struct starpu_slab_extent_list classes[SLAB_NCLASSES];
+	struct starpu_slab_extent *by_offset;
+	struct starpu_slab_extent *by_end;
+
+	/* Statistics */
+	size_t used;
+	size_t free;
+	unsigned nobjects;
+	unsigned nfree_extents;
+	unsigned long ncoalesced;
+};
+
+static unsigned _starpu_slab_class(size_t size)
+{
+	size_t nblocks = size / SLAB_ALIGN;
+	unsigned class = 0;
+
+	while (nblocks > 1 && class < SLAB_NCLASSES - 1)
+	{
+		nblocks >>= 1;
+		class++;
+	}
+	return class;
+}
+
+static void _starpu_slab_extent_insert(struct starpu_slab_base *base, struct starpu_slab_extent *extent)
+{
+	starpu_slab_extent_list_push_front(&base->classes[_starpu_slab_class(extent->size)], extent);
+	HASH_ADD(hh_offset, base->by_offset, offset, sizeof(extent->offset), extent);
+	HASH_ADD(hh_end, base->by_end, end, sizeof(extent->end), extent);
+	base->nfree_extents++;
+	base->free += extent->size;
+}
+
+static void _starpu_slab_extent_remove(struct starpu_slab_base *base, struct starpu_slab_extent *extent)
+{
+	starpu_slab_extent_list_erase(&base->classes[_starpu_slab_class(extent->size)], extent);
+	HASH_DELETE(hh_offset, base->by_offset, extent);
+	HASH_DELETE(hh_end, base->by_end, extent);
+	base->nfree_extents--;
+	base->free -= extent->size;
+}
+
+/* Find room for size bytes, return the offset, or -1 */
+static off_t _starpu_slab_reserve(struct starpu_slab_base *base, size_t size)
+{
+	unsigned class;
+	off_t offset;
+
+	/* Look for the smallest size class with a big enough extent */
+	for (class = _starpu_slab_class(size); class < SLAB_NCLASSES; class++)
+	{
+		struct starpu_slab_extent *extent;
+		for (extent = starpu_slab_extent_list_begin(&base->classes[class]);
+		     extent != starpu_slab_extent_list_end(&base->classes[class]);
+		     extent = starpu_slab_extent_list_next(extent))
+		{
+			if (extent->size < size)
+				continue;
+
+			_starpu_slab_extent_remove(base, extent);
+			offset = extent->offset;
+			if (extent->size > size)
+			{
+				/* Put back the remainder */
+				extent->offset += size;
+				extent->size -= size;
+				_starpu_slab_extent_insert(base, extent);
+			}
+			else
+				starpu_slab_extent_delete(extent);
+			return offset;
+		}
+	}
+
+	/* No free extent, take from the end of the file */
+	offset = base->end;
+	if (offset + (off_t) size > base->file_size)
+	{
+		off_t new_size = base->file_size + SLAB_GROW;
+		if (new_size < offset + (off_t) size)
+			new_size = offset + size;
+		if (_starpu_ftruncate(base->descriptor, new_size) < 0)
+		{
+			_STARPU_DISP("Could not extend file %s, ftruncate failed with error '%s'\n", base->file_path, strerror(errno));
+			return -1;
+		}
+		base->file_size = new_size;
+	}
+	base->end = offset + size;
+	return offset;
+}
+
+/* Give back the room at offset, merging with the neighbour free extents */
+static void _starpu_slab_release(struct starpu_slab_base *base, off_t offset, size_t size)
+{
+	struct starpu_slab_extent *prev, *next;
+	off_t end = offset + size;
+
+	HASH_FIND(hh_end, base->by_end, &offset, sizeof(offset), prev);
+	if (prev)
+	{
+		_starpu_slab_extent_remove(base, prev);
+		offset = prev->offset;
+		starpu_slab_extent_delete(prev);
+		base->ncoalesced++;
+	}
+
+	HASH_FIND(hh_offset, base->by_offset, &end, sizeof(end), next);
+	if (next)
+	{
+		_starpu_slab_extent_remove(base, next);
+		end = next->end;
+		starpu_slab_extent_delete(next);
+		base->ncoalesced++;
+	}
+
+	if (end == base->end)
+	{
+		/* Just give back to the end of the file */
+		base->end = offset;
+		return;
+	}
+
+	struct starpu_slab_extent *extent = starpu_slab_extent_new();
+	extent->offset = offset;
+	extent->end = end;
+	extent->size = end - offset;
+	_starpu_slab_extent_insert(base, extent);
+}
+
+/* allocation memory on disk */
+static void *starpu_slab_alloc(void *base, size_t size)
+{
+	struct starpu_slab_base *fileBase = (struct starpu_slab_base *) base;
+	struct starpu_slab_obj *obj;
+	size_t capacity = (STARPU_MAX(size, 1) + SLAB_ALIGN - 1) / SLAB_ALIGN * SLAB_ALIGN;
+	off_t offset;
+
+	STARPU_PTHREAD_MUTEX_LOCK(&fileBase->mutex);
+	offset = _starpu_slab_reserve(fileBase, capacity);
+	if (offset >= 0)
+	{
+		fileBase->used += capacity;
+		fileBase->nobjects++;
+	}
+	STARPU_PTHREAD_MUTEX_UNLOCK(&fileBase->mutex);
+
+	/* fail */
+	if (offset < 0)
+		return NULL;
+
+	_STARPU_MALLOC(obj, sizeof(*obj));
+	obj->offset = offset;
+	obj->capacity = capacity;
+	obj->size = size;
+	return obj;
+}
+
+/* free memory on disk */
+static void starpu_slab_free(void *base, void *obj, size_t size STARPU_ATTRIBUTE_UNUSED)
+{
+	struct starpu_slab_base *fileBase = (struct starpu_slab_base *) base;
+	struct starpu_slab_obj *tmp = (struct starpu_slab_obj *) obj;
+
+	STARPU_PTHREAD_MUTEX_LOCK(&fileBase->mutex);
+	_starpu_slab_release(fileBase, tmp->offset, tmp->capacity);
+	fileBase->used -= tmp->capacity;
+	fileBase->nobjects--;
+	STARPU_PTHREAD_MUTEX_UNLOCK(&fileBase->mutex);
+
+	free(tmp);
+}
+
+/* read the memory disk */
+static int starpu_slab_read(void *base, void *obj, void *buf, off_t offset, size_t size)
+{
+	struct starpu_slab_base *fileBase = (struct starpu_slab_base *) base;
+	struct starpu_slab_obj *tmp = (struct starpu_slab_obj *) obj;
+	starpu_ssize_t nb;
+	starpu_ssize_t bytes_to_read = size;
+
+	STARPU_ASSERT(offset + size <= tmp->capacity);
+	offset += tmp->offset;
+
+#ifdef HAVE_PREAD
+	while (bytes_to_read > 0)
+	{
+		nb = pread(fileBase->descriptor, buf, bytes_to_read, offset);
+		STARPU_ASSERT_MSG(nb >= 0, "Starpu Disk slab pread failed: size %lu got errno %d", (unsigned long) size, errno);
+		bytes_to_read -= nb;
+		buf = (char*) buf + nb;
+		offset += nb;
+	}
+#else
+	STARPU_PTHREAD_MUTEX_LOCK(&fileBase->mutex);
+	int res = lseek(fileBase->descriptor, offset, SEEK_SET);
+	STARPU_ASSERT_MSG(res >= 0, "Starpu Disk slab lseek for read failed: offset %lu got errno %d", (unsigned long) offset, errno);
+	while (bytes_to_read > 0)
+	{
+		nb = read(fileBase->descriptor, buf, bytes_to_read);
+		STARPU_ASSERT_MSG(nb >= 0, "Starpu Disk slab read failed: offset %lu got errno %d", (unsigned long) offset, errno);
+		bytes_to_read -= nb;
+		buf = (char*) buf + nb;
+	}
+	STARPU_PTHREAD_MUTEX_UNLOCK(&fileBase->mutex);
+#endif
+
+	return 0;
+}
+
+/* write on the memory disk */
+static int starpu_slab_write(void *base, void *obj, const void *buf, off_t offset, size_t size)
+{
+	struct starpu_slab_base *fileBase = (struct starpu_slab_base *) base;
+	struct starpu_slab_obj *tmp = (struct starpu_slab_obj *) obj;
+	starpu_ssize_t nb;
+	starpu_ssize_t bytes_to_write = size;
+
+	STARPU_ASSERT(offset + size <= tmp->capacity);
+	offset += tmp->offset;
+
+#ifdef HAVE_PWRITE
+	while (bytes_to_write > 0)
+	{
+		nb = pwrite(fileBase->descriptor, buf, bytes_to_write, offset);
+		STARPU_ASSERT_MSG(nb >= 0, "Starpu Disk slab pwrite failed: size %lu got errno %d", (unsigned long) size, errno);
+		bytes_to_write -= nb;
+		buf = (const char*) buf + nb;
+		offset += nb;
+	}
+#else
+	STARPU_PTHREAD_MUTEX_LOCK(&fileBase->mutex);
+	int res = lseek(fileBase->descriptor, offset, SEEK_SET);
+	STARPU_ASSERT_MSG(res >= 0, "Starpu Disk slab lseek for write failed: offset %lu got errno %d", (unsigned long) offset, errno);
+	while (bytes_to_write > 0)
+	{
+		nb = write(fileBase->descriptor, buf, bytes_to_write);
+		STARPU_ASSERT_MSG(nb >= 0, "Starpu Disk slab write failed: offset %lu got errno %d", (unsigned long) offset, errno);
+		bytes_to_write -= nb;
+		buf = (const char*) buf + nb;
+	}
+	STARPU_PTHREAD_MUTEX_UNLOCK(&fileBase->mutex);
+#endif
+
+	return 0;
+}
+
+static int starpu_slab_full_read(void *base, void *obj, void **ptr, size_t *size, unsigned dst_node)
+{
+	struct starpu_slab_obj *tmp = (struct starpu_slab_obj *) obj;
+
+	*size = tmp->size;
+	/* Alloc aligned buffer */
+	_starpu_malloc_flags_on_node(dst_node, ptr, *size, 0);
+	return starpu_slab_read(base, obj, *ptr, 0, *size);
+}
+
+static int starpu_slab_full_write(void *base, void *obj, void *ptr, size_t size)
+{
+	struct starpu_slab_base *fileBase = (struct starpu_slab_base *) base;
+	struct starpu_slab_obj *tmp = (struct starpu_slab_obj *) obj;
+
+	if (size > tmp->capacity)
+	{
+		/* Does not fit any more, move it */
+		size_t capacity = (size + SLAB_ALIGN - 1) / SLAB_ALIGN * SLAB_ALIGN;
+		off_t offset;
+
+		STARPU_PTHREAD_MUTEX_LOCK(&fileBase->mutex);
+		offset = _starpu_slab_reserve(fileBase, capacity);
+		STARPU_ASSERT_MSG(offset >= 0, "Could not allocate %lu bytes in %s", (unsigned long) capacity, fileBase->file_path);
+		_starpu_slab_release(fileBase, tmp->offset, tmp->capacity);
+		fileBase->used += capacity - tmp->capacity;
+		STARPU_PTHREAD_MUTEX_UNLOCK(&fileBase->mutex);
+
+		tmp->offset = offset;
+		tmp->capacity = capacity;
+	}
+
+	/* update size to realise the next good full_read */
+	tmp->size = size;
+
+	return starpu_slab_write(base, obj, ptr, 0, size);
+}
+
+static void *starpu_slab_plug(void *parameter, starpu_ssize_t size)
+{
+	struct starpu_slab_base * base;
+	struct stat buf;
+	unsigned i;
+
+	_STARPU_CALLOC(base, 1, sizeof(*base));
+	base->created = 0;
+	base->path = strdup((char *) parameter);
+	STARPU_ASSERT(base->path);
+
+	if (!(stat(base->path, &buf) == 0 && S_ISDIR(buf.st_mode)))
+	{
+		_starpu_mkpath(base->path, S_IRWXU);
+		base->created = 1;
+	}
+
+	base->file_path = _starpu_mktemp(base->path, O_RDWR | O_BINARY, &base->descriptor);
+	if (!base->file_path)
+	{
+		if (base->created)
+			rmdir(base->path);
+		free(base->path);
+		free(base);
+		return NULL;
+	}
+
+	/* Reserve the whole size at once, it will be grown if really needed */
+	if (size > 0)
+	{
+		if (_starpu_ftruncate(base->descriptor, size) < 0)
+			_STARPU_DISP("Could not truncate file %s, ftruncate failed with error '%s'\n", base->file_path, strerror(errno));
+		else
+			base->file_size = size;
+	}
+
+	STARPU_PTHREAD_MUTEX_INIT(&base->mutex, NULL);
+	for (i = 0; i < SLAB_NCLASSES; i++)
+		starpu_slab_extent_list_init(&base->classes[i]);
+
+	return (void *) base;
+}
+
+/* free memory allocated for the base */
+static void starpu_slab_unplug(void *base)
+{
+	struct starpu_slab_base * fileBase = (struct starpu_slab_base *) base;
+	struct starpu_slab_extent *extent, *tmp;
+
+	HASH_ITER(hh_offset, fileBase->by_offset, extent, tmp)
+	{
+		_starpu_slab_extent_remove(fileBase, extent);
+		starpu_slab_extent_delete(extent);
+	}
+	STARPU_PTHREAD_MUTEX_DESTROY(&fileBase->mutex);
+
+	close(fileBase->descriptor);
+	unlink(fileBase->file_path);
+	free(fileBase->file_path);
+	if (fileBase->created)
+		rmdir(fileBase->path);
+	free(fileBase->path);
+	free(fileBase);
+}
+
+static int get_slab_bandwidth_between_disk_and_main_ram(unsigned node, void *base)
+{
+	unsigned iter;
+	double timing_slowness, timing_latency;
+	double start;
+	double end;
+	char *buf;
+	struct starpu_slab_base * fileBase = (struct starpu_slab_base *) base;
+
+	srand(time(NULL));
+	starpu_malloc_flags((void **) &buf, STARPU_DISK_SIZE_MIN, 0);
+	STARPU_ASSERT(buf != NULL);
+
+	/* allocate memory */
+	int devid = starpu_memory_node_get_devid(node);
+	void *mem = _starpu_disk_alloc(devid, STARPU_DISK_SIZE_MIN);
+	/* fail to alloc */
+	if (mem == NULL)
+	{
+		starpu_free_flags(buf, STARPU_DISK_SIZE_MIN, 0);
+		return 0;
+	}
+
+	memset(buf, 0, STARPU_DISK_SIZE_MIN);
+
+	/* Measure upload slowness */
+	start = starpu_timing_now();
+	for (iter = 0; iter < NITER; ++iter)
+	{
+		_starpu_disk_write(0, devid, mem, buf, 0, STARPU_DISK_SIZE_MIN, NULL);
+
+		/* clean cache memory */
+#ifdef STARPU_HAVE_WINDOWS
+		int res = _commit(fileBase->descriptor);
+#else
+		int res = fsync(fileBase->descriptor);
+#endif
+		STARPU_ASSERT_MSG(res == 0, "Slowness computation failed \n");
+	}
+	end = starpu_timing_now();
+	timing_slowness = end - start;
+
+	/* free memory */
+	starpu_free_flags(buf, STARPU_DISK_SIZE_MIN, 0);
+
+	starpu_malloc_flags((void**) &buf, sizeof(char), 0);
+	STARPU_ASSERT(buf != NULL);
+
+	*buf = 0;
+
+	/* Measure latency */
+	start = starpu_timing_now();
+	for (iter = 0; iter < NITER; ++iter)
+	{
+		_starpu_disk_write(0, devid, mem, buf, rand() % (STARPU_DISK_SIZE_MIN -1) , 1, NULL);
+
+#ifdef STARPU_HAVE_WINDOWS
+		int res = _commit(fileBase->descriptor);
+#else
+		int res = fsync(fileBase->descriptor);
+#endif
+		STARPU_ASSERT_MSG(res == 0, "Latency computation failed");
+	}
+	end = starpu_timing_now();
+	timing_latency = end - start;
+
+	_starpu_disk_free(devid, mem, STARPU_DISK_SIZE_MIN);
+	starpu_free_flags(buf, sizeof(char), 0);
+
+	_starpu_save_bandwidth_and_latency_disk((NITER/timing_slowness)*STARPU_DISK_SIZE_MIN, (NITER/timing_slowness)*STARPU_DISK_SIZE_MIN,
+			timing_latency/NITER, timing_latency/NITER, node, fileBase->path);
+	return 1;
+}
+
+int starpu_disk_slab_get_stats(unsigned node, struct starpu_disk_slab_stats *stats)
+{
+	struct starpu_slab_base *fileBase = _starpu_disk_get_base(node, &starpu_disk_slab_ops);
+	struct starpu_slab_extent *extent, *tmp;
+
+	if (!fileBase)
+		return -EINVAL;
+
+	STARPU_PTHREAD_MUTEX_LOCK(&fileBase->mutex);
+	stats->file_size = fileBase->file_size;
+	stats->used = fileBase->used;
+	stats->free = fileBase->free;
+	stats->largest_free = 0;
+	HASH_ITER(hh_offset, fileBase->by_offset, extent, tmp)
+	{
+		if (extent->size > stats->largest_free)
+			stats->largest_free = extent->size;
+	}
+	stats->nobjects = fileBase->nobjects;
+	stats->nfree_extents = fileBase->nfree_extents;
+	stats->ncoalesced = fileBase->ncoalesced;
+	STARPU_PTHREAD_MUTEX_UNLOCK(&fileBase->mutex);
+
+	return 0;
+}
+
+struct starpu_disk_ops starpu_disk_slab_ops =
+{
+	.alloc = starpu_slab_alloc,
+	.free = starpu_slab_free,
+	.open = NULL,
+	.close = NULL,
+	.read = starpu_slab_read,
+	.write = starpu_slab_write,
+	.plug = starpu_slab_plug,
+	.unplug = starpu_slab_unplug,
+	.copy = NULL,
+	.bandwidth = get_slab_bandwidth_between_disk_and_main_ram,
+	.full_read = starpu_slab_full_read,
+	.full_write = starpu_slab_full_write
+};
@@ -198,6 +198,92 @@ static void *starpu_stdio_open(void *base, void *pos, size_t size)
 	return obj;
 }
 
+/* create a named memory on disk, which is kept after closing it */
+static void *starpu_stdio_create(void *base, void *pos, size_t size)
+{
+	struct starpu_stdio_base * fileBase = (struct starpu_stdio_base *) base;
+	struct starpu_stdio_obj *obj;
+	/* create template */
+	char *baseCpy;
+	_STARPU_MALLOC(baseCpy, strlen(fileBase->path)+1+strlen(pos)+1);
+
+	snprintf(baseCpy, strlen(fileBase->path)+1+strlen(pos)+1, "%s/%s", fileBase->path, (char *)pos);
+
+	int id = open(baseCpy, O_RDWR | O_BINARY | O_CREAT, 0666);
+	if (id < 0)
+	{
+		_STARPU_DISP("Could not create file %s, open failed with error '%s'\n", baseCpy, strerror(errno));
+		free(baseCpy);
+		return NULL;
+	}
+
+	int val = _starpu_ftruncate(id,size);
+	/* fail */
+	if (val < 0)
+	{
+		_STARPU_DISP("Could not truncate file, ftruncate failed with error '%s'\n", strerror(errno));
+		close(id);
+		unlink(baseCpy);
+		free(baseCpy);
+		return NULL;
+	}
+
+	obj = _starpu_stdio_init(id, baseCpy, size);
+	if (!obj)
+	{
+		close(id);
+		free(baseCpy);
+	}
+	return obj;
+}
+
+/* rename a named memory on disk */
+static int starpu_stdio_rename(void *base, void *pos, void *new_pos)
+{
+	struct starpu_stdio_base * fileBase = (struct starpu_stdio_base *) base;
+	char *oldpath, *newpath;
+	int ret;
+
+	_STARPU_MALLOC(oldpath, strlen(fileBase->path)+1+strlen(pos)+1);
+	snprintf(oldpath, strlen(fileBase->path)+1+strlen(pos)+1, "%s/%s", fileBase->path, (char *)pos);
+	_STARPU_MALLOC(newpath, strlen(fileBase->path)+1+strlen(new_pos)+1);
+	snprintf(newpath, strlen(fileBase->path)+1+strlen(new_pos)+1, "%s/%s", fileBase->path, (char *)new_pos);
+
+	/* Make sure that the content is on the disk before it replaces new_pos */
+	int fd = open(oldpath, O_RDWR | O_BINARY);
+	if (fd < 0)
+	{
+		ret = -errno;
+		_STARPU_DISP("Could not open file %s, open failed with error '%s'\n", oldpath, strerror(errno));
+		goto out;
+	}
+#ifdef STARPU_HAVE_WINDOWS
+	ret = _commit(fd);
+#else
+	ret = fsync(fd);
+#endif
+	if (ret < 0)
+		ret = -errno;
+	close(fd);
+	if (ret < 0)
+	{
+		_STARPU_DISP("Could not flush file %s, fsync failed with error '%s'\n", oldpath, strerror(-ret));
+		goto out;
+	}
+
+	ret = rename(oldpath, newpath);
+	if (ret < 0)
+	{
+		ret = -errno;
+		_STARPU_DISP("Could not rename file %s to %s, rename failed with error '%s'\n", oldpath, newpath, strerror(errno));
+	}
+
+out:
+	free(oldpath);
+	free(newpath);
+	return ret;
+}
+
 /* free memory without delete it */
 static void starpu_stdio_close(void *base STARPU_ATTRIBUTE_UNUSED, void *obj, size_t size STARPU_ATTRIBUTE_UNUSED)
 {
@@ -450,6 +536,8 @@ struct starpu_disk_ops starpu_disk_stdio_ops =
 	.alloc = starpu_stdio_alloc,
 	.free = starpu_stdio_free,
 	.open = starpu_stdio_open,
+	.create = starpu_stdio_create,
+	.rename = starpu_stdio_rename,
 	.close = starpu_stdio_close,
 	.read = starpu_stdio_read,
 	.write = starpu_stdio_write,
@@ -51,14 +51,27 @@ static void *starpu_unistd_open(void *base, void *pos, size_t size)
 	return starpu_unistd_global_open(obj, base, pos, size);
 }
 
+/* create a named memory on disk */
+static void *starpu_unistd_create(void *base, void *pos, size_t size)
+{
+	struct starpu_unistd_global_obj *obj;
+	_STARPU_MALLOC(obj, sizeof(struct starpu_unistd_global_obj));
+	/* only flags change between unistd and unistd_o_direct */
+	obj->flags = O_RDWR | O_BINARY;
+	return starpu_unistd_global_create(obj, base, pos, size);
+}
+
 struct starpu_disk_ops starpu_disk_unistd_ops =
 {
 	.alloc = starpu_unistd_alloc,
 	.free = starpu_unistd_global_free,
 	.open = starpu_unistd_open,
+	.create = starpu_unistd_create,
+	.rename = starpu_unistd_global_rename,
 	.close = starpu_unistd_global_close,
 	.read = starpu_unistd_global_read,
 	.write = starpu_unistd_global_write,
+	.discard = starpu_unistd_global_discard,
 	.plug = starpu_unistd_global_plug,
 	.unplug = starpu_unistd_global_unplug,
 #ifdef STARPU_UNISTD_USE_COPY
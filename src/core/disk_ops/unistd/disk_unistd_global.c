@@ -269,6 +269,89 @@ void *starpu_unistd_global_open(struct starpu_unistd_global_obj *obj, void *base
 	return obj;
 }
 
+/* create a named memory on disk, which is kept after closing it */
+void *starpu_unistd_global_create(struct starpu_unistd_global_obj *obj, void *base, void *pos, size_t size)
+{
+	struct starpu_unistd_base *fileBase = (struct starpu_unistd_base *) base;
+	/* create template */
+	char *baseCpy;
+	_STARPU_MALLOC(baseCpy, strlen(fileBase->path)+1+strlen(pos)+1);
+
+	snprintf(baseCpy, strlen(fileBase->path)+1+strlen(pos)+1, "%s/%s", fileBase->path, (char *)pos);
+
+	int id = open(baseCpy, obj->flags | O_CREAT, 0666);
+	if (id < 0)
+	{
+		_STARPU_DISP("Could not create file %s, open failed with error '%s'\n", baseCpy, strerror(errno));
+		free(obj);
+		free(baseCpy);
+		return NULL;
+	}
+
+	int val = _starpu_ftruncate(id,size);
+	/* fail */
+	if (val < 0)
+	{
+		_STARPU_DISP("Could not truncate file, ftruncate failed with error '%s'\n", strerror(errno));
+		close(id);
+		unlink(baseCpy);
+		free(baseCpy);
+		free(obj);
+		return NULL;
+	}
+
+	_starpu_unistd_init(obj, id, baseCpy, size);
+
+	return obj;
+}
+
+/* rename a named memory on disk */
+int starpu_unistd_global_rename(void *base, void *pos, void *new_pos)
+{
+	struct starpu_unistd_base *fileBase = (struct starpu_unistd_base *) base;
+	char *oldpath, *newpath;
+	int ret;
+
+	_STARPU_MALLOC(oldpath, strlen(fileBase->path)+1+strlen(pos)+1);
+	snprintf(oldpath, strlen(fileBase->path)+1+strlen(pos)+1, "%s/%s", fileBase->path, (char *)pos);
+	_STARPU_MALLOC(newpath, strlen(fileBase->path)+1+strlen(new_pos)+1);
+	snprintf(newpath, strlen(fileBase->path)+1+strlen(new_pos)+1, "%s/%s", fileBase->path, (char *)new_pos);
+
+	/* Make sure that the content is on the disk before it replaces new_pos */
+	int fd = open(oldpath, O_RDWR | O_BINARY);
+	if (fd < 0)
+	{
+		ret = -errno;
+		_STARPU_DISP("Could not open file %s, open failed with error '%s'\n", oldpath, strerror(errno));
+		goto out;
+	}
+#ifdef STARPU_HAVE_WINDOWS
+	ret = _commit(fd);
+#else
+	ret = fsync(fd);
+#endif
+	if (ret < 0)
+		ret = -errno;
+	close(fd);
+	if (ret < 0)
+	{
+		_STARPU_DISP("Could not flush file %s, fsync failed with error '%s'\n", oldpath, strerror(-ret));
+		goto out;
+	}
+
+	ret = rename(oldpath, newpath);
+	if (ret < 0)
+	{
+		ret = -errno;
+		_STARPU_DISP("Could not rename file %s to %s, rename failed with error '%s'\n", oldpath, newpath, strerror(errno));
+	}
+
+out:
+	free(oldpath);
+	free(newpath);
+	return ret;
+}
+
 /* free memory without delete it */
 void starpu_unistd_global_close(void *base STARPU_ATTRIBUTE_UNUSED, void *obj, size_t size STARPU_ATTRIBUTE_UNUSED)
 {
@@ -473,6 +556,30 @@ int starpu_unistd_global_write(void *base STARPU_ATTRIBUTE_UNUSED, void *obj, co
 	return 0;
 }
 
+/* punch a hole in the file */
+int starpu_unistd_global_discard(void *base STARPU_ATTRIBUTE_UNUSED, void *obj STARPU_ATTRIBUTE_UNUSED, off_t offset STARPU_ATTRIBUTE_UNUSED, size_t size STARPU_ATTRIBUTE_UNUSED)
+{
+#if defined(STARPU_LINUX_SYS) && defined(FALLOC_FL_PUNCH_HOLE)
+	struct starpu_unistd_global_obj *tmp = (struct starpu_unistd_global_obj *) obj;
+	int fd = tmp->descriptor;
+	int res;
+
+	if (fd < 0)
+		fd = _starpu_unistd_reopen(obj);
+
+	res = fallocate(fd, FALLOC_FL_PUNCH_HOLE | FALLOC_FL_KEEP_SIZE, offset, size);
+	if (res < 0)
+		res = -errno;
+
+	if (tmp->descriptor < 0)
+		_starpu_unistd_reclose(fd);
+
+	return res;
+#else
+	return -ENOSYS;
+#endif
+}
+
 #if defined(HAVE_LIBAIO_H)
 void *starpu_unistd_global_async_write(void *base, void *obj, void *buf, off_t offset, size_t size)
 {
@@ -54,9 +54,12 @@ struct starpu_unistd_global_obj
 void * starpu_unistd_global_alloc (struct starpu_unistd_global_obj * obj, void *base, size_t size);
 void starpu_unistd_global_free (void *base, void *obj, size_t size);
 void * starpu_unistd_global_open (struct starpu_unistd_global_obj * obj, void *base, void *pos, size_t size);
+void * starpu_unistd_global_create (struct starpu_unistd_global_obj * obj, void *base, void *pos, size_t size);
+int starpu_unistd_global_rename (void *base, void *pos, void *new_pos);
 void starpu_unistd_global_close (void *base, void *obj, size_t size);
 int starpu_unistd_global_read (void *base, void *obj, void *buf, off_t offset, size_t size);
 int starpu_unistd_global_write (void *base, void *obj, const void *buf, off_t offset, size_t size);
+int starpu_unistd_global_discard (void *base, void *obj, off_t offset, size_t size);
 void * starpu_unistd_global_plug (void *parameter, starpu_ssize_t size);
 void starpu_unistd_global_unplug (void *base);
 int _starpu_get_unistd_global_bandwidth_between_disk_and_main_ram(unsigned node, void *base);
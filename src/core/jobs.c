@@ -371,6 +371,9 @@ void _starpu_handle_job_termination(struct _starpu_job *j)
 #endif
 		;
 
+	if (!continuation)
+		_starpu_bound_job_terminated(j);
+
 	if (!continuation)
 	{
 		void (*epilogue_callback)(void *) = task->epilogue_callback_func;
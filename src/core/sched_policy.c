@@ -604,16 +604,14 @@ int _starpu_repush_task(struct _starpu_job *j)
 		;
 	if (!_starpu_perf_counter_paused() && !j->internal && !continuation)
 	{
-		(void) STARPU_PERF_COUNTER_ADD64(& _starpu_task__g_current_submitted__value, -1);
-		int64_t value = STARPU_PERF_COUNTER_ADD64(& _starpu_task__g_current_ready__value, 1);
-		_starpu_perf_counter_update_max_int64(&_starpu_task__g_peak_ready__value, value);
+		_starpu_perf_counter_current_add(&_starpu_task__g_current.current_submitted, &_starpu_task__g_current.peak_submitted, -1);
+		_starpu_perf_counter_current_add(&_starpu_task__g_current.current_ready, &_starpu_task__g_current.peak_ready, 1);
 		if (task->cl && task->cl->perf_counter_values)
 		{
 			struct starpu_perf_counter_sample_cl_values * const pcv = task->cl->perf_counter_values;
 
-			(void)STARPU_PERF_COUNTER_ADD64(&pcv->task.current_submitted, -1);
-			value = STARPU_PERF_COUNTER_ADD64(&pcv->task.current_ready, 1);
-			_starpu_perf_counter_update_max_int64(&pcv->task.peak_ready, value);
+			_starpu_perf_counter_current_add(&pcv->task.current_submitted, &pcv->task.peak_submitted, -1);
+			_starpu_perf_counter_current_add(&pcv->task.current_ready, &pcv->task.peak_ready, 1);
 		}
 	}
 	STARPU_AYU_ADDTOTASKQUEUE(j->job_id, -1);
@@ -653,11 +651,11 @@ int _starpu_repush_task(struct _starpu_job *j)
 		_STARPU_TRACE_TASK_NAME_LINE_COLOR(j);
 		if (!_starpu_perf_counter_paused() && !j->internal)
 		{
-			(void)STARPU_PERF_COUNTER_ADD64(& _starpu_task__g_current_ready__value, -1);
+			_starpu_perf_counter_current_add(&_starpu_task__g_current.current_ready, &_starpu_task__g_current.peak_ready, -1);
 			if (task->cl && task->cl->perf_counter_values)
 			{
 				struct starpu_perf_counter_sample_cl_values * const pcv = task->cl->perf_counter_values;
-				(void)STARPU_PERF_COUNTER_ADD64(&pcv->task.current_ready, -1);
+				_starpu_perf_counter_current_add(&pcv->task.current_ready, &pcv->task.peak_ready, -1);
 			}
 		}
 		task->status = STARPU_TASK_RUNNING;
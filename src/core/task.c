@@ -50,11 +50,8 @@ static int __g_peak_submitted;
 static int __g_peak_ready;
 
 /* global counter variables */
-starpu_perf_counter_int64_t _starpu_task__g_total_submitted__value;
-starpu_perf_counter_int64_t _starpu_task__g_peak_submitted__value;
-starpu_perf_counter_int64_t _starpu_task__g_current_submitted__value;
-starpu_perf_counter_int64_t _starpu_task__g_peak_ready__value;
-starpu_perf_counter_int64_t _starpu_task__g_current_ready__value;
+struct _starpu_perf_counter_task_shard _starpu_task__g_shards[_STARPU_PERF_COUNTER_NSHARDS];
+struct _starpu_perf_counter_task_current _starpu_task__g_current;
 
 /* per-worker counters */
 static int __w_total_executed;
@@ -86,9 +83,14 @@ static void global_sample_updater(struct starpu_perf_counter_sample *sample, voi
 	STARPU_ASSERT(context == NULL); /* no context for the global updater */
 	(void)context;
 
-	_starpu_perf_counter_sample_set_int64_value(sample, __g_total_submitted, _starpu_task__g_total_submitted__value);
-	_starpu_perf_counter_sample_set_int64_value(sample, __g_peak_submitted, _starpu_task__g_peak_submitted__value);
-	_starpu_perf_counter_sample_set_int64_value(sample, __g_peak_ready, _starpu_task__g_peak_ready__value);
+	if (_starpu_perf_counter_sample_due(sample, __g_total_submitted))
+	{
+		struct _starpu_perf_counter_task_shard total;
+		_starpu_perf_counter_task_shards_aggregate(_starpu_task__g_shards, _starpu_worker_get_count(), &total);
+		_starpu_perf_counter_sample_set_int64_value(sample, __g_total_submitted, total.total_submitted);
+	}
+	_starpu_perf_counter_sample_set_int64_value(sample, __g_peak_submitted, _starpu_task__g_current.peak_submitted);
+	_starpu_perf_counter_sample_set_int64_value(sample, __g_peak_ready, _starpu_task__g_current.peak_ready);
 }
 
 static void per_worker_sample_updater(struct starpu_perf_counter_sample *sample, void *context)
@@ -107,12 +109,20 @@ static void per_codelet_sample_updater(struct starpu_perf_counter_sample *sample
 	STARPU_ASSERT(set->scope == starpu_perf_counter_scope_per_codelet);
 	STARPU_ASSERT(context != NULL);
 	struct starpu_codelet *cl = context;
+	struct starpu_perf_counter_sample_cl_values * const pcv = cl->perf_counter_values;
 
-	_starpu_perf_counter_sample_set_int64_value(sample, __c_total_submitted, cl->perf_counter_values->task.total_submitted);
-	_starpu_perf_counter_sample_set_int64_value(sample, __c_peak_submitted, cl->perf_counter_values->task.peak_submitted);
-	_starpu_perf_counter_sample_set_int64_value(sample, __c_peak_ready, cl->perf_counter_values->task.peak_ready);
-	_starpu_perf_counter_sample_set_int64_value(sample, __c_total_executed, cl->perf_counter_values->task.total_executed);
-	_starpu_perf_counter_sample_set_double_value(sample, __c_cumul_execution_time, cl->perf_counter_values->task.cumul_execution_time);
+	if (_starpu_perf_counter_sample_due(sample, __c_total_submitted)
+	    || _starpu_perf_counter_sample_due(sample, __c_total_executed)
+	    || _starpu_perf_counter_sample_due(sample, __c_cumul_execution_time))
+	{
+		struct _starpu_perf_counter_task_shard total;
+		_starpu_perf_counter_task_shards_aggregate(pcv->shards, pcv->nworkers, &total);
+		_starpu_perf_counter_sample_set_int64_value(sample, __c_total_submitted, total.total_submitted);
+		_starpu_perf_counter_sample_set_int64_value(sample, __c_total_executed, total.total_executed);
+		_starpu_perf_counter_sample_set_double_value(sample, __c_cumul_execution_time, total.cumul_execution_time);
+	}
+	_starpu_perf_counter_sample_set_int64_value(sample, __c_peak_submitted, pcv->task.peak_submitted);
+	_starpu_perf_counter_sample_set_int64_value(sample, __c_peak_ready, pcv->task.peak_ready);
 }
 
 void _starpu__task_c__register_counters(void)
@@ -129,7 +139,7 @@ void _starpu__task_c__register_counters(void)
 	{
 		const enum starpu_perf_counter_scope scope = starpu_perf_counter_scope_per_worker;
 		__STARPU_PERF_COUNTER_REG("starpu.task", scope, w_total_executed, int64, "number of tasks executed on this worker (since StarPU initialization)");
-		__STARPU_PERF_COUNTER_REG("starpu.task", scope, w_cumul_execution_time, double, "cumulated execution time of tasks executed on this worker (microseconds, since StarPU initialization)");
+		__STARPU_PERF_COUNTER_REG("starpu.task", scope, w_cumul_execution_time, double, "cumulated execution time of tasks executed on this worker (microseconds, measured while a per_worker or per_codelet listener is set)");
 
 		_starpu_perf_counter_register_updater(scope, per_worker_sample_updater);
 	}
@@ -994,18 +1004,18 @@ int _starpu_task_submit(struct starpu_task *task, int nodeps)
 		;
 	if (!_starpu_perf_counter_paused() && !j->internal && !continuation)
 	{
-		(void) STARPU_PERF_COUNTER_ADD64(&_starpu_task__g_total_submitted__value, 1);
-		int64_t value = STARPU_PERF_COUNTER_ADD64(&_starpu_task__g_current_submitted__value, 1);
-		_starpu_perf_counter_update_max_int64(&_starpu_task__g_peak_submitted__value, value);
+		const int workerid = _starpu_worker_get_id();
+		const unsigned nworkers = _starpu_worker_get_count();
+		STARPU_PERF_COUNTER_SHARD_ADD(&_starpu_task__g_shards[workerid < 0 ? nworkers : (unsigned) workerid].total_submitted, 1, workerid < 0);
+		_starpu_perf_counter_current_add(&_starpu_task__g_current.current_submitted, &_starpu_task__g_current.peak_submitted, 1);
 		_starpu_perf_counter_update_global_sample();
 
 		if (task->cl && task->cl->perf_counter_values)
 		{
 			struct starpu_perf_counter_sample_cl_values * const pcv = task->cl->perf_counter_values;
 
-			(void) STARPU_PERF_COUNTER_ADD64(&pcv->task.total_submitted, 1);
-			value = STARPU_PERF_COUNTER_ADD64(&pcv->task.current_submitted, 1);
-			_starpu_perf_counter_update_max_int64(&pcv->task.peak_submitted, value);
+			STARPU_PERF_COUNTER_SHARD_ADD(&pcv->shards[workerid < 0 ? pcv->nworkers : (unsigned) workerid].total_submitted, 1, workerid < 0);
+			_starpu_perf_counter_current_add(&pcv->task.current_submitted, &pcv->task.peak_submitted, 1);
 			_starpu_perf_counter_update_per_codelet_sample(task->cl);
 		}
 	}
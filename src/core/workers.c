@@ -1823,6 +1823,7 @@ int starpu_initialize(struct starpu_conf *user_conf, int *argc, char ***argv)
 	_starpu_open_debug_logfile();
 
 	_starpu_data_interface_init();
+	_starpu_init_reduction();
 
 	_starpu_timing_init();
 
@@ -1911,6 +1912,9 @@ int starpu_initialize(struct starpu_conf *user_conf, int *argc, char ***argv)
 	}
 
 	_starpu_watchdog_init();
+#ifdef STARPU_USE_FXT
+	_starpu_fxt_snapshot_init();
+#endif
 
 	_starpu_profiling_start();
 
@@ -2188,6 +2192,9 @@ void starpu_shutdown(void)
 	_starpu_deinitialize_registered_performance_models();
 
 	_starpu_watchdog_shutdown();
+#ifdef STARPU_USE_FXT
+	_starpu_fxt_snapshot_shutdown();
+#endif
 
 	/* wait for their termination */
 	_starpu_terminate_workers(&_starpu_config);
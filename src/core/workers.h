@@ -87,6 +87,8 @@ struct _starpu_node
 	 * mc_list plus the non-automatically allocated elements (which are thus always
 	 * considered as clean) */
 	unsigned mc_nb, mc_clean_nb;
+	/** Amount of memory used by the elements of mc_list which are not clean */
+	starpu_ssize_t mc_dirty_size;
 
 	struct mc_cache_entry *mc_cache;
 	int mc_cache_nb;
@@ -105,6 +107,11 @@ struct _starpu_node
 	/** Whether this memory node can evict data to another node */
 	unsigned evictable;
 
+	/** Percentage of used memory above which dirty data gets written back
+	 * in the background, and percentage of memory that dirty data is then
+	 * brought down to */
+	unsigned writeback_high_p, writeback_low_p;
+
 	/*
 	 * used by data_request.c
 	 */
@@ -226,6 +233,7 @@ LIST_TYPE(_starpu_worker,
 	struct timespec cl_start; /**< Codelet start time of the task currently running */
 	struct timespec cl_expend; /**< Codelet expected end time of the task currently running */
 	struct timespec cl_end; /**< Codelet end time of the last task running */
+	unsigned cl_timed; /**< Whether the task currently running is timed for the performance counters */
 	unsigned char first_task; /**< Index of first task in the pipeline */
 	unsigned char ntasks; /**< number of tasks in the pipeline */
 	unsigned char pipeline_length; /**< number of tasks to be put in the pipeline */
@@ -514,6 +522,10 @@ struct _starpu_machine_config
 
 	/** When >0, StarPU should stop performance counters collection. */
 	int perf_counter_pause_depth;
+
+	/** Number of per-worker and per-codelet listeners, which have counters
+	 * of task execution times */
+	int perf_counter_timed_listeners;
 };
 
 struct _starpu_machine_topology;
@@ -1327,6 +1339,14 @@ static inline int _starpu_perf_counter_paused(void)
 	return STARPU_UNLIKELY(_starpu_config.perf_counter_pause_depth > 0);
 }
 
+/** Whether task execution times have to be measured for the performance
+ * counters. Measuring them costs two clock readings per task, so it is only
+ * done while some listener may get them. */
+static inline int _starpu_perf_counter_timed(void)
+{
+	return !_starpu_perf_counter_paused() && STARPU_UNLIKELY(_starpu_config.perf_counter_timed_listeners > 0);
+}
+
 void _starpu_crash_add_hook(void (*hook_func)(void));
 void _starpu_crash_call_hooks();
 
@@ -317,7 +317,10 @@ int _starpu_determine_request_path(starpu_data_handle_t handle,
 		struct _starpu_data_replicate *src_replicate = &handle->per_node[src_node];
 		struct _starpu_data_replicate *dst_replicate = &handle->per_node[dst_node];
 
-		if (src_replicate->mapped != STARPU_UNMAPPED)
+		/* Main memory mapping a disk can be used as usual, only
+		 * devices mapping main memory need to go through it */
+		if (src_replicate->mapped != STARPU_UNMAPPED
+			&& starpu_node_get_kind(src_node) != STARPU_CPU_RAM)
 		{
 			/* Device -> map */
 			STARPU_ASSERT(max_len >= 1);
@@ -335,7 +338,8 @@ int _starpu_determine_request_path(starpu_data_handle_t handle,
 
 			return consumed + 1;
 		}
-		else if (dst_replicate->mapped != STARPU_UNMAPPED)
+		else if (dst_replicate->mapped != STARPU_UNMAPPED
+			&& starpu_node_get_kind(dst_node) != STARPU_CPU_RAM)
 		{
 			/* Device -> map */
 			int consumed = _starpu_determine_request_path(handle,
@@ -461,7 +465,7 @@ static struct _starpu_data_request *_starpu_search_existing_data_request(struct
 	/* Make sure we don't have anything else than R/W */
 	STARPU_ASSERT(mode != STARPU_UNMAP);
 
-	for (r = replicate->request[node]; r; r = r->next_same_req)
+	for (r = _starpu_data_replicate_get_request(replicate, node); r; r = r->next_same_req)
 	{
 		_starpu_spin_checklocked(&r->handle->header_lock);
 
@@ -561,7 +565,7 @@ struct _starpu_data_request *_starpu_create_request_to_fetch_data(starpu_data_ha
 			for (j = 0; j < nnodes; j++)
 			{
 				struct _starpu_data_request *r;
-				for (r = handle->per_node[i].request[j]; r; r = r->next_same_req)
+				for (r = _starpu_data_replicate_get_request(&handle->per_node[i], j); r; r = r->next_same_req)
 					nwait++;
 			}
 		/* If the request is not detached (i.e. the caller really wants
@@ -609,7 +613,7 @@ struct _starpu_data_request *_starpu_create_request_to_fetch_data(starpu_data_ha
 				struct _starpu_data_request *r2;
 				for (j = 0; j < nnodes; j++)
 				{
-					for (r2 = dst_replicate->request[j]; r2; r2 = r2->next_same_req)
+					for (r2 = _starpu_data_replicate_get_request(dst_replicate, j); r2; r2 = r2->next_same_req)
 					{
 						if (r2->task && r2->task == task)
 						{
@@ -796,7 +800,7 @@ struct _starpu_data_request *_starpu_create_request_to_fetch_data(starpu_data_ha
 			for (j = 0; j < nnodes; j++)
 			{
 				struct _starpu_data_request *r2;
-				for (r2 = handle->per_node[i].request[j]; r2; r2 = r2->next_same_req)
+				for (r2 = _starpu_data_replicate_get_request(&handle->per_node[i], j); r2; r2 = r2->next_same_req)
 				{
 					_starpu_spin_lock(&r2->lock);
 					if (is_prefetch < r2->prefetch)
@@ -870,7 +874,7 @@ int _starpu_fetch_data_on_node(starpu_data_handle_t handle, int node, struct _st
 		else if (node == STARPU_ACQUIRE_NO_NODE_LOCK_ALL)
 		{
 			int i;
-			for (i = 0; i < STARPU_MAXNODES; i++)
+			for (i = 0; i < (int) handle->nreplicates; i++)
 				handle->per_node[i].refcnt++;
 		}
 		handle->busy_count++;
@@ -1545,7 +1549,7 @@ unsigned starpu_data_is_on_node(starpu_data_handle_t handle, unsigned node)
 
 		for (i = 0; i < nnodes; i++)
 		{
-			if (handle->per_node[node].request[i])
+			if (_starpu_data_replicate_get_request(&handle->per_node[node], i))
 			{
 				ret = 1;
 				break;
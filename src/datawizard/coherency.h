@@ -42,6 +42,17 @@ enum _starpu_cache_state
 	STARPU_INVALID
 };
 
+/** Requests pending towards a given replicate. This is only allocated on the
+ * first request, since it is large and most replicates never get any, and
+ * then kept until the handle is destroyed. */
+struct _starpu_data_replicate_requests
+{
+	/** This tracks the list of requests to provide the value */
+	struct _starpu_data_request *request[STARPU_MAXNODES];
+	/** This points to the last entry of request, to easily append to the list */
+	struct _starpu_data_request *last_request[STARPU_MAXNODES];
+};
+
 /** this should contain the information relative to a given data replicate  */
 struct _starpu_data_replicate
 {
@@ -95,10 +106,8 @@ struct _starpu_data_replicate
 	 */
 	uint32_t requested;
 
-	/** This tracks the list of requests to provide the value */
-	struct _starpu_data_request *request[STARPU_MAXNODES];
-	/** This points to the last entry of request, to easily append to the list */
-	struct _starpu_data_request *last_request[STARPU_MAXNODES];
+	/** Requests pending towards this replicate, NULL until the first one */
+	struct _starpu_data_replicate_requests *requests;
 
 	/* Which request is loading data here */
 	struct _starpu_data_request *load_request;
@@ -125,6 +134,8 @@ struct _starpu_jobid_list
 struct _starpu_task_wrapper_list
 {
 	struct starpu_task *task;
+	/** Whether to release an end dependency of \p task instead of submitting it */
+	unsigned end_dep;
 	struct _starpu_task_wrapper_list *next;
 };
 
@@ -140,6 +151,8 @@ extern int _starpu_has_not_important_data;
 
 typedef void (*_starpu_data_handle_unregister_hook)(starpu_data_handle_t);
 
+struct _starpu_data_handle_slab;
+
 /** This is initialized in both _starpu_register_new_data and _starpu_data_partition */
 struct _starpu_data_state
 {
@@ -181,6 +194,8 @@ struct _starpu_data_state
 	starpu_data_handle_t *siblings;
 	unsigned sibling_index; /** indicate which child this node is from the parent's perspective (if any) */
 	unsigned depth; /** what's the depth of the tree ? */
+	/** The slab this handle was allocated from by starpu_data_partition_plan, if any */
+	struct _starpu_data_handle_slab *slab;
 
 #ifdef STARPU_RECURSIVE_TASKS
 	starpu_pthread_mutex_t unpartition_mutex;
@@ -210,8 +225,15 @@ struct _starpu_data_state
 	unsigned active_ro:1;
 
 	/** describe the state of the data in term of coherency
-	 * This is execution-time state. */
-	struct _starpu_data_replicate per_node[STARPU_MAXNODES];
+	 * This is execution-time state. This is only allocated for the
+	 * nreplicates first memory nodes, see _starpu_data_handle_init */
+	struct _starpu_data_replicate *per_node;
+	/** Number of entries of per_node, at least the number of memory nodes
+	 * which can exist while the handle is registered */
+	unsigned nreplicates;
+	/** Interface returned by starpu_data_get_interface_on_node for the
+	 * nodes beyond nreplicates, which can never be used */
+	void *unused_interface;
 	struct _starpu_data_replicate *per_worker;
 
 	struct starpu_data_interface_ops *ops;
@@ -370,6 +392,23 @@ void _starpu_update_data_state(starpu_data_handle_t handle,
 
 uint32_t _starpu_get_data_refcnt(struct _starpu_data_state *state, unsigned node);
 
+/** Handles allocated at once by starpu_data_partition_plan. The slab is freed
+ * when the last of them gets unregistered. */
+struct _starpu_data_handle_slab
+{
+	int refcnt;
+	struct _starpu_data_state handles[];
+};
+
+/** Return the first request pending from \p node towards \p replicate.
+ * This may be called without the header lock: the lists are published once
+ * initialized, and only freed along with the handle */
+static inline struct _starpu_data_request *_starpu_data_replicate_get_request(struct _starpu_data_replicate *replicate, unsigned node)
+{
+	struct _starpu_data_replicate_requests *requests = *(struct _starpu_data_replicate_requests * volatile *) &replicate->requests;
+	return requests ? requests->request[node] : NULL;
+}
+
 size_t _starpu_data_get_size(starpu_data_handle_t handle);
 size_t _starpu_data_get_alloc_size(starpu_data_handle_t handle);
 starpu_ssize_t _starpu_data_get_max_size(starpu_data_handle_t handle);
@@ -407,6 +446,7 @@ struct _starpu_data_request *_starpu_create_request_to_fetch_data(starpu_data_ha
 								  unsigned async,
 								  void (*callback_func)(void *), void *callback_arg, int prio, const char *origin);
 
+void _starpu_init_reduction(void);
 void _starpu_init_data_replicate(starpu_data_handle_t handle, struct _starpu_data_replicate *replicate, int workerid);
 void _starpu_data_start_reduction_mode(starpu_data_handle_t handle);
 void _starpu_data_end_reduction_mode(starpu_data_handle_t handle, int priority);
@@ -19,6 +19,7 @@
 #include <common/config.h>
 #include <common/utils.h>
 #include <core/sched_policy.h>
+#include <core/disk.h>
 #include <datawizard/datastats.h>
 #include <datawizard/memory_nodes.h>
 #include <drivers/disk/driver_disk.h>
@@ -252,9 +253,11 @@ int STARPU_ATTRIBUTE_WARN_UNUSED_RESULT _starpu_driver_copy_data_1_to_1(starpu_d
 
 	if (!dst_replicate->allocated && dst_replicate->mapped == STARPU_UNMAPPED && dst_node != src_node
 			&& handle->ops->map_data
-			&& (_starpu_memory_node_get_mapped(dst_replicate->memory_node) /* || handle wants it */))
+			&& (_starpu_memory_node_get_mapped(dst_replicate->memory_node)
+				|| _starpu_disk_can_map(src_node, dst_node) /* || handle wants it */))
 	{
-		/* Memory node which can just map the main memory, try to map.  */
+		/* Memory node which can just map the main memory, or main
+		 * memory which can just map the disk, try to map.  */
 		if (!handle->ops->map_data(
 				src_replicate->data_interface, src_replicate->memory_node,
 				dst_replicate->data_interface, dst_replicate->memory_node))
@@ -307,7 +310,9 @@ int STARPU_ATTRIBUTE_WARN_UNUSED_RESULT _starpu_driver_copy_data_1_to_1(starpu_d
 	 *   updated.
 	 * All in all, any data change will actually trigger both.
 	 */
-	if (!donotread && dst_replicate->mapped != STARPU_UNMAPPED)
+	if (!donotread && dst_replicate->mapped != STARPU_UNMAPPED
+		/* Main memory mapping a disk can be copied to as usual from other nodes */
+		&& (starpu_node_get_kind(dst_node) != STARPU_CPU_RAM || dst_replicate->mapped == (int) src_node))
 	{
 		STARPU_ASSERT(src_replicate->memory_node == dst_replicate->mapped);
 		if (_starpu_node_needs_map_update(dst_node))
@@ -323,7 +328,9 @@ int STARPU_ATTRIBUTE_WARN_UNUSED_RESULT _starpu_driver_copy_data_1_to_1(starpu_d
 		dst_replicate->initialized = 1;
 	}
 
-	else if (!donotread && src_replicate->mapped != STARPU_UNMAPPED)
+	else if (!donotread && src_replicate->mapped != STARPU_UNMAPPED
+		/* Main memory mapping a disk can be copied from as usual to other nodes */
+		&& (starpu_node_get_kind(src_node) != STARPU_CPU_RAM || src_replicate->mapped == (int) dst_node))
 	{
 		STARPU_ASSERT(dst_replicate->memory_node == src_replicate->mapped);
 		if (_starpu_node_needs_map_update(src_node))
@@ -96,6 +96,7 @@ static void _starpu_data_request_unlink(struct _starpu_data_request *r)
 	else
 	{
 		unsigned node;
+		struct _starpu_data_replicate_requests *requests = r->dst_replicate->requests;
 		struct _starpu_data_request **prevp, *prev;
 
 		if (r->mode & STARPU_R)
@@ -108,7 +109,7 @@ static void _starpu_data_request_unlink(struct _starpu_data_request *r)
 			node = r->dst_replicate->memory_node;
 
 		/* Look for ourself in the list, we should be not very far. */
-		for (prevp = &r->dst_replicate->request[node], prev = NULL;
+		for (prevp = &requests->request[node], prev = NULL;
 		     *prevp && *prevp != r;
 		     prev = *prevp, prevp = &prev->next_same_req)
 			;
@@ -119,15 +120,33 @@ static void _starpu_data_request_unlink(struct _starpu_data_request *r)
 		if (!r->next_same_req)
 		{
 			/* I was last */
-			STARPU_ASSERT(r->dst_replicate->last_request[node] == r);
+			STARPU_ASSERT(requests->last_request[node] == r);
 			if (prev)
-				r->dst_replicate->last_request[node] = prev;
+				requests->last_request[node] = prev;
 			else
-				r->dst_replicate->last_request[node] = NULL;
+				requests->last_request[node] = NULL;
 		}
 	}
 }
 
+void _starpu_data_free_request_lists(starpu_data_handle_t handle, unsigned nworkers)
+{
+	unsigned node, worker;
+
+	for (node = 0; node < handle->nreplicates; node++)
+	{
+		free(handle->per_node[node].requests);
+		handle->per_node[node].requests = NULL;
+	}
+
+	if (handle->per_worker)
+		for (worker = 0; worker < nworkers; worker++)
+		{
+			free(handle->per_worker[worker].requests);
+			handle->per_worker[worker].requests = NULL;
+		}
+}
+
 static void _starpu_data_request_destroy(struct _starpu_data_request *r)
 {
 	//fprintf(stderr, "DESTROY REQ %p (%d) refcnt %d\n", r, node, r->refcnt);
@@ -221,17 +240,29 @@ struct _starpu_data_request *_starpu_create_data_request(starpu_data_handle_t ha
 	else
 	{
 		unsigned node;
+		struct _starpu_data_replicate_requests *requests;
 
 		if (mode & STARPU_R)
 			node = src_replicate->memory_node;
 		else
 			node = dst_replicate->memory_node;
 
-		if (!dst_replicate->request[node])
-			dst_replicate->request[node] = r;
+		requests = dst_replicate->requests;
+		if (!requests)
+		{
+			/* First request towards this replicate, the lists are
+			 * then kept until the handle is destroyed, since
+			 * they may be read without the header lock */
+			_STARPU_CALLOC(requests, 1, sizeof(*requests));
+			STARPU_WMB();
+			dst_replicate->requests = requests;
+		}
+
+		if (!requests->request[node])
+			requests->request[node] = r;
 		else
-			dst_replicate->last_request[node]->next_same_req = r;
-		dst_replicate->last_request[node] = r;
+			requests->last_request[node]->next_same_req = r;
+		requests->last_request[node] = r;
 
 		if (mode & STARPU_R)
 		{
@@ -157,6 +157,8 @@ PRIO_LIST_TYPE(_starpu_data_requester, prio)
 void _starpu_init_data_request_lists(void);
 void _starpu_deinit_data_request_lists(void);
 void _starpu_post_data_request(struct _starpu_data_request *r);
+/** Free the request lists of the replicates of \p handle, which is being destroyed */
+void _starpu_data_free_request_lists(starpu_data_handle_t handle, unsigned nworkers);
 /** returns 0 if we have pushed all requests, -EBUSY or -ENOMEM otherwise */
 int _starpu_handle_node_data_requests(unsigned handling_node, unsigned peer_node, enum _starpu_data_request_inout inout, enum _starpu_may_alloc may_alloc, unsigned *pushed);
 int _starpu_handle_node_prefetch_requests(unsigned handling_node, unsigned peer_node, enum _starpu_data_request_inout inout, enum _starpu_may_alloc may_alloc, unsigned *pushed);
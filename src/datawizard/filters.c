@@ -175,58 +175,14 @@ static unsigned _starpu_data_partition_nparts(starpu_data_handle_t initial_handl
 
 }
 
-static void _starpu_data_partition(starpu_data_handle_t initial_handle, starpu_data_handle_t *childrenp, unsigned nparts, struct starpu_data_filter *f, int inherit_state)
+/* Initialize children first to last-1 of the partitioning of initial_handle.
+ * This can be called from several threads at the same time on different ranges */
+static void _starpu_data_partition_children(starpu_data_handle_t initial_handle, starpu_data_handle_t *childrenp, unsigned first, unsigned last, unsigned nparts, struct starpu_data_filter *f, int inherit_state)
 {
 	unsigned i;
 	unsigned node;
-	unsigned found = STARPU_MAXNODES;
-
-	for (node = 0; node < STARPU_MAXNODES; node++)
-		_starpu_data_unmap(initial_handle, node);
 
-	/* first take care to properly lock the data header */
-	_starpu_spin_lock(&initial_handle->header_lock);
-
-	initial_handle->nplans++;
-
-	STARPU_ASSERT_MSG(nparts > 0, "Partitioning data %p in 0 piece does not make sense", initial_handle);
-
-	/* allocate the children */
-	if (inherit_state)
-	{
-		_STARPU_CALLOC(initial_handle->children, nparts, sizeof(struct _starpu_data_state));
-
-		/* this handle now has children */
-		initial_handle->nchildren = nparts;
-	}
-
-	for (node = 0; node < STARPU_MAXNODES; node++)
-	{
-		if (initial_handle->per_node[node].state != STARPU_INVALID)
-			found = node;
-		STARPU_ASSERT(initial_handle->per_node[node].mapped == STARPU_UNMAPPED);
-	}
-	if (found == STARPU_MAXNODES)
-	{
-		/* This is lazy allocation, allocate it now in main RAM, so as
-		 * to have somewhere to gather pieces later */
-		/* FIXME: mark as unevictable! */
-		int home_node = initial_handle->home_node;
-		if (home_node < 0 || (starpu_node_get_kind(home_node) != STARPU_CPU_RAM))
-			home_node = STARPU_MAIN_RAM;
-		int ret = _starpu_allocate_memory_on_node(initial_handle, &initial_handle->per_node[home_node], STARPU_FETCH, 0);
-#ifdef STARPU_DEVEL
-#warning we should reclaim memory if allocation failed
-#endif
-		STARPU_ASSERT(!ret);
-	}
-
-	if (nparts && !inherit_state)
-	{
-		STARPU_ASSERT_MSG(childrenp, "Passing NULL pointer for parameter childrenp while parameter inherit_state is 0");
-	}
-
-	for (i = 0; i < nparts; i++)
+	for (i = first; i < last; i++)
 	{
 		starpu_data_handle_t child;
 
@@ -284,7 +240,7 @@ static void _starpu_data_partition(starpu_data_handle_t initial_handle, starpu_d
 		child->redux_cl = initial_handle->redux_cl;
 		child->init_cl = initial_handle->init_cl;
 
-		for (node = 0; node < STARPU_MAXNODES; node++)
+		for (node = 0; node < child->nreplicates; node++)
 		{
 			struct _starpu_data_replicate *initial_replicate;
 			struct _starpu_data_replicate *child_replicate;
@@ -330,6 +286,112 @@ static void _starpu_data_partition(starpu_data_handle_t initial_handle, starpu_d
 
 		_STARPU_TRACE_HANDLE_DATA_REGISTER(child);
 	}
+}
+
+#ifndef STARPU_SIMGRID
+struct _starpu_data_partition_children_arg
+{
+	starpu_data_handle_t initial_handle;
+	starpu_data_handle_t *childrenp;
+	unsigned first, last, nparts;
+	struct starpu_data_filter *f;
+	int inherit_state;
+};
+
+static void *_starpu_data_partition_children_thread(void *_arg)
+{
+	struct _starpu_data_partition_children_arg *arg = _arg;
+	_starpu_data_partition_children(arg->initial_handle, arg->childrenp, arg->first, arg->last, arg->nparts, arg->f, arg->inherit_state);
+	return NULL;
+}
+#endif
+
+static void _starpu_data_partition(starpu_data_handle_t initial_handle, starpu_data_handle_t *childrenp, unsigned nparts, struct starpu_data_filter *f, int inherit_state)
+{
+	unsigned node;
+	unsigned found = STARPU_MAXNODES;
+
+	for (node = 0; node < initial_handle->nreplicates; node++)
+		_starpu_data_unmap(initial_handle, node);
+
+	/* first take care to properly lock the data header */
+	_starpu_spin_lock(&initial_handle->header_lock);
+
+	initial_handle->nplans++;
+
+	STARPU_ASSERT_MSG(nparts > 0, "Partitioning data %p in 0 piece does not make sense", initial_handle);
+
+	/* allocate the children */
+	if (inherit_state)
+	{
+		_STARPU_CALLOC(initial_handle->children, nparts, sizeof(struct _starpu_data_state));
+
+		/* this handle now has children */
+		initial_handle->nchildren = nparts;
+	}
+
+	for (node = 0; node < initial_handle->nreplicates; node++)
+	{
+		if (initial_handle->per_node[node].state != STARPU_INVALID)
+			found = node;
+		STARPU_ASSERT(initial_handle->per_node[node].mapped == STARPU_UNMAPPED);
+	}
+	if (found == STARPU_MAXNODES)
+	{
+		/* This is lazy allocation, allocate it now in main RAM, so as
+		 * to have somewhere to gather pieces later */
+		/* FIXME: mark as unevictable! */
+		int home_node = initial_handle->home_node;
+		if (home_node < 0 || (starpu_node_get_kind(home_node) != STARPU_CPU_RAM))
+			home_node = STARPU_MAIN_RAM;
+		int ret = _starpu_allocate_memory_on_node(initial_handle, &initial_handle->per_node[home_node], STARPU_FETCH, 0);
+#ifdef STARPU_DEVEL
+#warning we should reclaim memory if allocation failed
+#endif
+		STARPU_ASSERT(!ret);
+	}
+
+	if (nparts && !inherit_state)
+	{
+		STARPU_ASSERT_MSG(childrenp, "Passing NULL pointer for parameter childrenp while parameter inherit_state is 0");
+	}
+
+	unsigned nthreads = 1;
+#ifndef STARPU_SIMGRID
+	/* Only worth it for many children */
+	if (nparts >= 1024)
+		nthreads = starpu_getenv_number_default("STARPU_PARTITION_NTHREADS", 1);
+	if (nthreads > nparts / 256)
+		nthreads = nparts / 256;
+#endif
+	if (nthreads <= 1)
+		_starpu_data_partition_children(initial_handle, childrenp, 0, nparts, nparts, f, inherit_state);
+#ifndef STARPU_SIMGRID
+	else
+	{
+		starpu_pthread_t threads[nthreads];
+		struct _starpu_data_partition_children_arg args[nthreads];
+		unsigned thread;
+
+		for (thread = 0; thread < nthreads; thread++)
+		{
+			args[thread].initial_handle = initial_handle;
+			args[thread].childrenp = childrenp;
+			args[thread].first = (uint64_t) nparts * thread / nthreads;
+			args[thread].last = (uint64_t) nparts * (thread + 1) / nthreads;
+			args[thread].nparts = nparts;
+			args[thread].f = f;
+			args[thread].inherit_state = inherit_state;
+			/* The current thread takes the first range */
+			if (thread > 0)
+				STARPU_PTHREAD_CREATE(&threads[thread], NULL, _starpu_data_partition_children_thread, &args[thread]);
+		}
+		_starpu_data_partition_children_thread(&args[0]);
+		for (thread = 1; thread < nthreads; thread++)
+			STARPU_PTHREAD_JOIN(threads[thread], NULL);
+	}
+#endif
+
 	/* now let the header */
 	_starpu_spin_unlock(&initial_handle->header_lock);
 }
@@ -402,7 +464,7 @@ void starpu_data_unpartition(starpu_data_handle_t root_handle, unsigned gatherin
 		_starpu_spin_unlock(&child_handle->header_lock);
 
 		/* Make sure it is not mapped */
-		for (node = 0; node < STARPU_MAXNODES; node++)
+		for (node = 0; node < child_handle->nreplicates; node++)
 			_starpu_data_unmap(child_handle, node);
 
 		/* Wait for all requests to finish (notably WT and UNMAP requests) */
@@ -442,6 +504,7 @@ void starpu_data_unpartition(starpu_data_handle_t root_handle, unsigned gatherin
 		}
 
 		_starpu_memory_stats_free(child_handle);
+		_starpu_data_free_request_lists(child_handle, nworkers);
 	}
 
 	/* the gathering_node should now have a valid copy of all the children.
@@ -459,7 +522,7 @@ void starpu_data_unpartition(starpu_data_handle_t root_handle, unsigned gatherin
 	unsigned nvalids = 0;
 
 	/* still valid ? */
-	for (node = 0; node < STARPU_MAXNODES; node++)
+	for (node = 0; node < root_handle->nreplicates; node++)
 	{
 		struct _starpu_data_replicate *local;
 		/* until an issue is found the data is assumed to be valid */
@@ -503,7 +566,7 @@ void starpu_data_unpartition(starpu_data_handle_t root_handle, unsigned gatherin
 
 	enum _starpu_cache_state newstate = (nvalids == 1)?STARPU_OWNER:STARPU_SHARED;
 
-	for (node = 0; node < STARPU_MAXNODES; node++)
+	for (node = 0; node < root_handle->nreplicates; node++)
 	{
 		root_handle->per_node[node].state = still_valid[node]?newstate:STARPU_INVALID;
 	}
@@ -526,7 +589,7 @@ void starpu_data_unpartition(starpu_data_handle_t root_handle, unsigned gatherin
 	}
 	if (root_handle->initialized)
 	{
-		for (node = 0; node < STARPU_MAXNODES; node++)
+		for (node = 0; node < root_handle->nreplicates; node++)
 		{
 			struct _starpu_data_replicate *root_replicate;
 
@@ -610,13 +673,21 @@ void starpu_data_partition_plan(starpu_data_handle_t initial_handle, struct star
 		 */
 		home_node = STARPU_MAIN_RAM;
 
+	/* Allocate all children at once, each of them releases its part of
+	 * the slab when unregistered */
+	struct _starpu_data_handle_slab *slab;
+	_STARPU_MALLOC(slab, sizeof(*slab) + nparts * sizeof(struct _starpu_data_state));
+	slab->refcnt = nparts;
+
 	_STARPU_MALLOC(children, nparts * sizeof(*children));
 	for (i = 0; i < nparts; i++)
 	{
-		_STARPU_CALLOC(children[i], 1, sizeof(struct _starpu_data_state));
+		children[i] = &slab->handles[i];
 		childrenp[i] = children[i];
 	}
 	_starpu_data_partition(initial_handle, children, nparts, f, 0);
+	for (i = 0; i < nparts; i++)
+		children[i]->slab = slab;
 
 	if (!cl)
 	{
@@ -651,10 +722,9 @@ void starpu_data_partition_clean_node(starpu_data_handle_t root_handle, unsigned
 	free(children[0]->siblings);
 
 	for (i = 0; i < nparts; i++)
-	{
 		children[i]->siblings = NULL;
-		starpu_data_unregister_submit(children[i]);
-	}
+	/* Wait for the tasks on all children at once */
+	starpu_data_unregister_submit_array(nparts, children);
 
 	_starpu_spin_lock(&root_handle->header_lock);
 	root_handle->nplans--;
@@ -38,6 +38,10 @@ static int32_t nregistered, maxnregistered;
 static int _data_interface_number = STARPU_MAX_INTERFACE_ID;
 starpu_arbiter_t _starpu_global_arbiter;
 static int max_memory_use;
+/* Number of replicates of the handles, fixed when the first handle gets
+ * registered, see _starpu_data_get_nreplicates */
+static unsigned data_nreplicates;
+static int disk_reserved_nodes;
 
 static void _starpu_data_unregister(starpu_data_handle_t handle, unsigned coherent, unsigned nowait);
 
@@ -46,6 +50,9 @@ void _starpu_data_interface_fini(void);
 void _starpu_data_interface_init(void)
 {
 	max_memory_use = starpu_getenv_number_default("STARPU_MAX_MEMORY_USE", 0);
+	disk_reserved_nodes = starpu_getenv_number_default("STARPU_DISK_RESERVED_NODES", 2);
+	if (disk_reserved_nodes < 0)
+		disk_reserved_nodes = 0;
 
 	/* Just for testing purpose */
 	if (starpu_getenv_number_default("STARPU_GLOBAL_ARBITER", 0) > 0)
@@ -57,7 +64,7 @@ void _starpu_data_interface_init(void)
 void _starpu_data_interface_fini(void)
 {
 	if (max_memory_use)
-		_STARPU_DISP("Memory used for %d data handles: %lu MiB\n", maxnregistered, (unsigned long) (maxnregistered * sizeof(struct _starpu_data_state)) >> 20);
+		_STARPU_DISP("Memory used for %d data handles: %lu MiB\n", maxnregistered, (unsigned long) (maxnregistered * (sizeof(struct _starpu_data_state) + data_nreplicates * sizeof(struct _starpu_data_replicate))) >> 20);
 }
 
 void _starpu_data_interface_shutdown()
@@ -67,6 +74,7 @@ void _starpu_data_interface_shutdown()
 	_id_to_ops_array_size = 0;
 
 	_starpu_data_interface_fini();
+	data_nreplicates = 0;
 }
 
 struct starpu_data_interface_ops *_starpu_data_interface_get_ops(unsigned interface_id)
@@ -165,7 +173,7 @@ static void _starpu_register_new_data(starpu_data_handle_t handle, int home_node
 	/* that new data is invalid from all nodes perpective except for the
 	 * home node */
 	unsigned node;
-	for (node = 0; node < STARPU_MAXNODES; node++)
+	for (node = 0; node < handle->nreplicates; node++)
 	{
 		struct _starpu_data_replicate *replicate;
 		replicate = &handle->per_node[node];
@@ -223,11 +231,7 @@ void _starpu_data_initialize_per_worker(starpu_data_handle_t handle)
 		replicate->handle = handle;
 		//replicate->nb_tasks_prefetch = 0;
 
-		//for (node = 0; node < STARPU_MAXNODES; node++)
-		//{
-		//	replicate->request[node] = NULL;
-		//	replicate->last_request[node] = NULL;
-		//}
+		//replicate->requests = NULL;
 		//replicate->load_request = NULL;
 
 		/* Assuming being used for SCRATCH for now, patched when entering REDUX mode */
@@ -253,6 +257,26 @@ void starpu_data_ptr_register(starpu_data_handle_t handle, unsigned node)
 	_starpu_spin_unlock(&handle->header_lock);
 }
 
+unsigned _starpu_data_get_nreplicates(void)
+{
+	unsigned nreplicates = data_nreplicates;
+	if (STARPU_UNLIKELY(!nreplicates))
+	{
+		/* Leave room for the disks which may be registered later on */
+		nreplicates = _starpu_memory_nodes_get_count() + disk_reserved_nodes;
+		if (nreplicates > STARPU_MAXNODES)
+			nreplicates = STARPU_MAXNODES;
+		if (!STARPU_BOOL_COMPARE_AND_SWAP(&data_nreplicates, 0, nreplicates))
+			nreplicates = data_nreplicates;
+	}
+	return nreplicates;
+}
+
+unsigned _starpu_data_get_registered_nreplicates(void)
+{
+	return data_nreplicates;
+}
+
 int _starpu_data_handle_init(starpu_data_handle_t handle, struct starpu_data_interface_ops *interface_ops, unsigned int mf_node)
 {
 	unsigned node;
@@ -307,8 +331,21 @@ int _starpu_data_handle_init(starpu_data_handle_t handle, struct starpu_data_int
 
 	handle->ops = interface_ops;
 	size_t interfacesize = interface_ops->interface_size;
-
-	for (node = 0; node < STARPU_MAXNODES; node++)
+	/* Allocate the replicates and the interfaces of the memory nodes which
+	 * can exist at once, keeping each of them aligned like malloc would,
+	 * plus the interface for the other nodes. They are freed along
+	 * per_node, see _starpu_data_free_interfaces */
+	unsigned nreplicates = _starpu_data_get_nreplicates();
+	size_t replicatessize = (nreplicates * sizeof(struct _starpu_data_replicate) + 15) & ~(size_t) 15;
+	size_t interfacestride = (interfacesize + 15) & ~(size_t) 15;
+	char *interfaces;
+	_STARPU_CALLOC(handle->per_node, 1, replicatessize + (nreplicates + 1) * interfacestride);
+	handle->nreplicates = nreplicates;
+	interfaces = (char *) handle->per_node + replicatessize;
+	handle->unused_interface = interfaces + nreplicates * interfacestride;
+	if (handle->ops->init) handle->ops->init(handle->unused_interface);
+
+	for (node = 0; node < nreplicates; node++)
 	{
 		_starpu_memory_stats_init_per_node(handle, node);
 
@@ -318,7 +355,7 @@ int _starpu_data_handle_init(starpu_data_handle_t handle, struct starpu_data_int
 
 		replicate->handle = handle;
 
-		_STARPU_CALLOC(replicate->data_interface, 1, interfacesize);
+		replicate->data_interface = interfaces + node * interfacestride;
 		if (handle->ops->init) handle->ops->init(replicate->data_interface);
 	}
 
@@ -460,6 +497,109 @@ void starpu_data_register(starpu_data_handle_t *handleptr, int home_node, void *
 	_STARPU_TRACE_HANDLE_DATA_REGISTER(handle);
 }
 
+struct _starpu_data_register_array_arg
+{
+	starpu_data_handle_t *handleptrs;
+	unsigned first, last;
+	int home_node;
+	char *data_interfaces;
+	struct starpu_data_interface_ops *ops;
+};
+
+/* Initialize and register handles first to last-1 of the slab. This can be
+ * called from several threads at the same time on different ranges */
+static void *_starpu_data_register_array_range(void *_arg)
+{
+	struct _starpu_data_register_array_arg *arg = _arg;
+	struct starpu_data_interface_ops *ops = arg->ops;
+	unsigned i;
+
+	for (i = arg->first; i < arg->last; i++)
+	{
+		starpu_data_handle_t handle = arg->handleptrs[i];
+
+		_starpu_data_handle_init(handle, ops, arg->home_node);
+		ops->register_data_handle(handle, arg->home_node, arg->data_interfaces + i * ops->interface_size);
+		_starpu_register_new_data(handle, arg->home_node, 0);
+		_STARPU_TRACE_HANDLE_DATA_REGISTER(handle);
+	}
+	return NULL;
+}
+
+void starpu_data_register_array(unsigned nhandles, starpu_data_handle_t *handleptrs, int home_node, void *data_interfaces, struct starpu_data_interface_ops *ops)
+{
+	struct _starpu_data_handle_slab *slab;
+	unsigned i;
+
+	STARPU_ASSERT_MSG(home_node >= -1 && home_node < (int)starpu_memory_nodes_get_count(), "Invalid memory node number");
+	STARPU_ASSERT(handleptrs);
+	STARPU_ASSERT(ops->register_data_handle);
+	if (!nhandles)
+		return;
+
+	if (ops->interfaceid == STARPU_UNKNOWN_INTERFACE_ID)
+	{
+		ops->interfaceid = starpu_data_interface_get_next_id();
+	}
+	_starpu_data_register_ops(ops);
+
+	/* Allocate all handles at once, each of them releases its part of the
+	 * slab when unregistered */
+	_STARPU_CALLOC(slab, 1, sizeof(*slab) + nhandles * sizeof(struct _starpu_data_state));
+	slab->refcnt = nhandles;
+	for (i = 0; i < nhandles; i++)
+	{
+		handleptrs[i] = &slab->handles[i];
+		handleptrs[i]->slab = slab;
+	}
+
+	unsigned nthreads = 1;
+#ifndef STARPU_SIMGRID
+	/* Only worth it for many handles */
+	if (nhandles >= 1024)
+		nthreads = starpu_getenv_number_default("STARPU_PARTITION_NTHREADS", 1);
+	if (nthreads > nhandles / 256)
+		nthreads = nhandles / 256;
+#endif
+	if (nthreads <= 1)
+	{
+		struct _starpu_data_register_array_arg arg =
+		{
+			.handleptrs = handleptrs,
+			.first = 0,
+			.last = nhandles,
+			.home_node = home_node,
+			.data_interfaces = data_interfaces,
+			.ops = ops,
+		};
+		_starpu_data_register_array_range(&arg);
+	}
+#ifndef STARPU_SIMGRID
+	else
+	{
+		starpu_pthread_t threads[nthreads];
+		struct _starpu_data_register_array_arg args[nthreads];
+		unsigned thread;
+
+		for (thread = 0; thread < nthreads; thread++)
+		{
+			args[thread].handleptrs = handleptrs;
+			args[thread].first = (uint64_t) nhandles * thread / nthreads;
+			args[thread].last = (uint64_t) nhandles * (thread + 1) / nthreads;
+			args[thread].home_node = home_node;
+			args[thread].data_interfaces = data_interfaces;
+			args[thread].ops = ops;
+			/* The current thread takes the first range */
+			if (thread > 0)
+				STARPU_PTHREAD_CREATE(&threads[thread], NULL, _starpu_data_register_array_range, &args[thread]);
+		}
+		_starpu_data_register_array_range(&args[0]);
+		for (thread = 1; thread < nthreads; thread++)
+			STARPU_PTHREAD_JOIN(threads[thread], NULL);
+	}
+#endif
+}
+
 void starpu_data_register_same(starpu_data_handle_t *handledst, starpu_data_handle_t handlesrc)
 {
 	void *local_interface = starpu_data_get_interface_on_node(handlesrc, STARPU_MAIN_RAM);
@@ -498,14 +638,16 @@ struct starpu_data_interface_ops* starpu_data_get_interface_ops(starpu_data_hand
 
 void _starpu_data_free_interfaces(starpu_data_handle_t handle)
 {
-	unsigned node;
 	unsigned nworkers = starpu_worker_get_count();
 
 	if (handle->ops->unregister_data_handle)
 		handle->ops->unregister_data_handle(handle);
 
-	for (node = 0; node < STARPU_MAXNODES; node++)
-		free(handle->per_node[node].data_interface);
+	_starpu_data_free_request_lists(handle, nworkers);
+
+	/* This also holds the interfaces of all nodes, see _starpu_data_handle_init */
+	free(handle->per_node);
+	handle->per_node = NULL;
 
 	if (handle->per_worker)
 	{
@@ -791,7 +933,7 @@ static void _starpu_data_unregister(starpu_data_handle_t handle, unsigned cohere
 
 	/* Request unmapping of any mapped data */
 	unsigned node;
-	for (node = 0; node < STARPU_MAXNODES; node++)
+	for (node = 0; node < handle->nreplicates; node++)
 		_starpu_data_unmap(handle, node);
 
 retry_busy:
@@ -830,7 +972,7 @@ retry_busy:
 	size_t size = _starpu_data_get_alloc_size(handle);
 
 	/* Destroy the data now */
-	for (node = 0; node < STARPU_MAXNODES; node++)
+	for (node = 0; node < handle->nreplicates; node++)
 	{
 		struct _starpu_data_replicate *local = &handle->per_node[node];
 		STARPU_ASSERT(!local->refcnt);
@@ -884,7 +1026,15 @@ retry_busy:
 		free(handle->switch_cl);
 	}
 	_STARPU_TRACE_HANDLE_DATA_UNREGISTER(handle);
-	free(handle);
+	if (handle->slab)
+	{
+		/* Siblings allocated together are freed together */
+		struct _starpu_data_handle_slab *slab = handle->slab;
+		if (STARPU_ATOMIC_ADD(&slab->refcnt, -1) == 0)
+			free(slab);
+	}
+	else
+		free(handle);
 	(void)STARPU_ATOMIC_ADD(&nregistered, -1);
 }
 
@@ -930,6 +1080,56 @@ void starpu_data_unregister_submit(starpu_data_handle_t handle)
 	starpu_data_acquire_on_node_cb(handle, STARPU_ACQUIRE_NO_NODE_LOCK_ALL, handle->initialized?STARPU_RW:STARPU_W, _starpu_data_unregister_submit_cb, handle);
 }
 
+struct _starpu_data_unregister_array_arg
+{
+	unsigned nhandles;
+	starpu_data_handle_t handles[];
+};
+
+static void _starpu_data_unregister_submit_array_cb(void *_arg)
+{
+	struct _starpu_data_unregister_array_arg *arg = _arg;
+	unsigned i;
+
+	for (i = 0; i < arg->nhandles; i++)
+	{
+		starpu_data_handle_t handle = arg->handles[i];
+
+		_starpu_spin_lock(&handle->header_lock);
+		handle->lazy_unregister = 1;
+		/* Destroyed by _starpu_data_check_not_busy on release, as in
+		 * _starpu_data_unregister_submit_cb */
+		STARPU_ASSERT(handle->busy_count);
+		_starpu_spin_unlock(&handle->header_lock);
+
+		starpu_data_release_on_node(handle, STARPU_ACQUIRE_NO_NODE_LOCK_ALL);
+	}
+	free(arg);
+}
+
+void starpu_data_unregister_submit_array(unsigned nhandles, starpu_data_handle_t *handles)
+{
+	struct _starpu_data_unregister_array_arg *arg;
+	unsigned i;
+
+	_STARPU_MALLOC(arg, sizeof(*arg) + nhandles * sizeof(arg->handles[0]));
+	arg->nhandles = 0;
+	for (i = 0; i < nhandles; i++)
+	{
+		starpu_data_handle_t handle = handles[i];
+		STARPU_ASSERT_MSG(handle->magic == 42, "data %p is invalid (was it already registered?)", handle);
+		STARPU_ASSERT_MSG(!handle->lazy_unregister, "data %p can not be unregistered twice", handle);
+
+		if (_starpu_ro_data_detach(handle))
+			arg->handles[arg->nhandles++] = handle;
+	}
+
+	/* Wait for all task dependencies on these handles at once before
+	 * putting them for free. Write mode catches the same dependencies as
+	 * read-write mode, without requiring the handles to be initialized */
+	starpu_data_acquire_on_node_array_cb(arg->nhandles, arg->handles, STARPU_ACQUIRE_NO_NODE_LOCK_ALL, STARPU_W, _starpu_data_unregister_submit_array_cb, arg);
+}
+
 static void __starpu_data_deinitialize(starpu_data_handle_t handle)
 {
 #ifdef STARPU_DEBUG
@@ -938,13 +1138,13 @@ static void __starpu_data_deinitialize(starpu_data_handle_t handle)
 		unsigned i, j, nnodes = starpu_memory_nodes_get_count();
 		for (i = 0; i < nnodes; i++)
 			for (j = 0; j < nnodes; j++)
-				STARPU_ASSERT_MSG(!handle->per_node[i].request[j], "request for handle %p pending from %u to %u while invalidating data!", handle, j, i);
+				STARPU_ASSERT_MSG(!_starpu_data_replicate_get_request(&handle->per_node[i], j), "request for handle %p pending from %u to %u while invalidating data!", handle, j, i);
 	}
 #endif
 
 	unsigned node;
 
-	for (node = 0; node < STARPU_MAXNODES; node++)
+	for (node = 0; node < handle->nreplicates; node++)
 	{
 		struct _starpu_data_replicate *local = &handle->per_node[node];
 
@@ -981,18 +1181,18 @@ static void _starpu_data_invalidate(void *data)
 
 	unsigned node;
 
-	for (node = 0; node < STARPU_MAXNODES; node++)
+	for (node = 0; node < handle->nreplicates; node++)
 	{
 		struct _starpu_data_replicate *local = &handle->per_node[node];
 
 		if (local->mc && local->allocated && local->automatically_allocated)
 		{
 			unsigned mapping;
-			for (mapping = 0; mapping < STARPU_MAXNODES; mapping++)
+			for (mapping = 0; mapping < handle->nreplicates; mapping++)
 				if (handle->per_node[mapping].mapped == (int) node)
 					break;
 
-			if (mapping == STARPU_MAXNODES)
+			if (mapping == handle->nreplicates)
 			{
 				/* free the data copy in a lazy fashion */
 				_starpu_request_mem_chunk_removal(handle, local, node, size);
@@ -1031,7 +1231,7 @@ static void _starpu_data_deinitialize(void *data)
 
 	unsigned node;
 
-	for (node = 0; node < STARPU_MAXNODES; node++)
+	for (node = 0; node < handle->nreplicates; node++)
 	{
 		struct _starpu_data_replicate *local = &handle->per_node[node];
 
@@ -1124,6 +1324,10 @@ enum starpu_data_interface_id starpu_data_get_interface_id(starpu_data_handle_t
 
 void *starpu_data_get_interface_on_node(starpu_data_handle_t handle, unsigned memory_node)
 {
+	if (memory_node >= handle->nreplicates)
+		/* This node can not exist while the handle is registered,
+		 * just let interfaces loop over all nodes */
+		return handle->unused_interface;
 	return handle->per_node[memory_node].data_interface;
 }
 
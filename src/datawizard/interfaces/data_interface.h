@@ -49,6 +49,13 @@ extern struct starpu_data_interface_ops starpu_interface_multiformat_ops;
 
 void _starpu_data_free_interfaces(starpu_data_handle_t handle);
 
+/** Return the number of replicates of the handles, i.e. the number of memory
+ * nodes which may exist while they are registered */
+unsigned _starpu_data_get_nreplicates(void);
+/** Same as _starpu_data_get_nreplicates, but return 0 if no handle was
+ * registered yet, so that any number of memory nodes can still be added */
+unsigned _starpu_data_get_registered_nreplicates(void);
+
 extern int _starpu_data_handle_init(starpu_data_handle_t handle, struct starpu_data_interface_ops *interface_ops, unsigned int mf_node);
 void _starpu_data_initialize_per_worker(starpu_data_handle_t handle);
 
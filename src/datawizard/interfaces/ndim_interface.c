@@ -17,6 +17,7 @@
 #include <starpu.h>
 #ifdef BUILDING_STARPU
 #include <datawizard/memory_nodes.h>
+#include <datawizard/interfaces/data_interface.h>
 #endif
 #include <common/utils.h>
 
@@ -96,8 +97,15 @@ static void register_ndim_handle(starpu_data_handle_t handle, int home_node, voi
 
 	size_t ndim = ndim_interface->ndim;
 
+#ifdef BUILDING_STARPU
+	/* The other nodes can not exist while the handle is registered, don't
+	 * allocate arrays for them */
+	int nnodes = _starpu_data_get_nreplicates();
+#else
+	int nnodes = STARPU_MAXNODES;
+#endif
 	int node;
-	for (node = 0; node < STARPU_MAXNODES; node++)
+	for (node = 0; node < nnodes; node++)
 	{
 		struct starpu_ndim_interface *local_interface = (struct starpu_ndim_interface *)
 			starpu_data_get_interface_on_node(handle, node);
@@ -140,8 +148,13 @@ static void register_ndim_handle(starpu_data_handle_t handle, int home_node, voi
 static void unregister_ndim_handle(starpu_data_handle_t handle)
 {
 	unsigned home_node = starpu_data_get_home_node(handle);
+#ifdef BUILDING_STARPU
+	unsigned nnodes = _starpu_data_get_nreplicates();
+#else
+	unsigned nnodes = STARPU_MAXNODES;
+#endif
 	unsigned node;
-	for (node = 0; node < STARPU_MAXNODES; node++)
+	for (node = 0; node < nnodes; node++)
 	{
 		struct starpu_ndim_interface *local_interface = (struct starpu_ndim_interface *) starpu_data_get_interface_on_node(handle, node);
 
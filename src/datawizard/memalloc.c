@@ -43,9 +43,13 @@ static int limit_cpu_mem;
 	if ((mc)->clean || (mc)->home)					 \
 		/* This is clean */					 \
 		node_struct->mc_clean_nb++;				 \
-	else if (!node_struct->mc_dirty_head)				 \
-		/* This is the only dirty element for now */		 \
-		node_struct->mc_dirty_head = mc;			 \
+	else								 \
+	{								 \
+		if (!node_struct->mc_dirty_head)			 \
+			/* This is the only dirty element for now */	 \
+			node_struct->mc_dirty_head = mc;		 \
+		node_struct->mc_dirty_size += (mc)->size;		 \
+	}								 \
 	node_struct->mc_nb++;						 \
 } while(0)
 
@@ -63,6 +67,8 @@ static int limit_cpu_mem;
 #define MC_LIST_ERASE(node_struct, mc) do {				 \
 	if ((mc)->clean || (mc)->home)					 \
 		node_struct->mc_clean_nb--; /* One clean element less */	 \
+	else								 \
+		node_struct->mc_dirty_size -= (mc)->size;		 \
 	if ((mc) == node_struct->mc_dirty_head)				 \
 		/* This was the dirty head */				 \
 		node_struct->mc_dirty_head = _starpu_mem_chunk_list_next((mc)); \
@@ -160,6 +166,7 @@ void _starpu_init_mem_chunk_lists(void)
 		STARPU_HG_DISABLE_CHECKING(node->mc_cache_size);
 		STARPU_HG_DISABLE_CHECKING(node->mc_nb);
 		STARPU_HG_DISABLE_CHECKING(node->mc_clean_nb);
+		STARPU_HG_DISABLE_CHECKING(node->mc_dirty_size);
 		STARPU_HG_DISABLE_CHECKING(node->prefetch_out_of_memory);
 	}
 	/* We do not enable forcing available memory by default, since
@@ -171,6 +178,22 @@ void _starpu_init_mem_chunk_lists(void)
 	minimum_clean_p = starpu_getenv_number_default("STARPU_MINIMUM_CLEAN_BUFFERS", 5);
 	target_clean_p = starpu_getenv_number_default("STARPU_TARGET_CLEAN_BUFFERS", 10);
 	limit_cpu_mem = starpu_getenv_number("STARPU_LIMIT_CPU_MEM");
+
+	/* Background write-back of dirty data is disabled by default, the
+	 * clean buffers thresholds above are usually enough */
+	unsigned writeback_high_p = starpu_getenv_number_default("STARPU_WRITEBACK_HIGH_MEM", 0);
+	unsigned writeback_low_p = starpu_getenv_number_default("STARPU_WRITEBACK_LOW_MEM", writeback_high_p / 2);
+	for (i = 0; i < STARPU_MAXNODES; i++)
+	{
+		struct _starpu_node *node = _starpu_get_node_struct(i);
+		char name[64];
+
+		snprintf(name, sizeof(name), "STARPU_WRITEBACK_NODE_%u_HIGH_MEM", i);
+		node->writeback_high_p = starpu_getenv_number_default(name, writeback_high_p);
+		snprintf(name, sizeof(name), "STARPU_WRITEBACK_NODE_%u_LOW_MEM", i);
+		node->writeback_low_p = starpu_getenv_number_default(name, node->writeback_high_p == writeback_high_p ? writeback_low_p : node->writeback_high_p / 2);
+		STARPU_ASSERT_MSG(node->writeback_low_p <= node->writeback_high_p, "The low write-back watermark of memory node %u (%u%%) must not be higher than its high watermark (%u%%)", i, node->writeback_low_p, node->writeback_high_p);
+	}
 }
 
 void _starpu_deinit_mem_chunk_lists(void)
@@ -182,6 +205,7 @@ void _starpu_deinit_mem_chunk_lists(void)
 		struct mc_cache_entry *entry=NULL, *tmp=NULL;
 		STARPU_ASSERT(node->mc_nb == 0);
 		STARPU_ASSERT(node->mc_clean_nb == 0);
+		STARPU_ASSERT(node->mc_dirty_size == 0);
 		STARPU_ASSERT(node->mc_dirty_head == NULL);
 		HASH_ITER(hh, node->mc_cache, entry, tmp)
 		{
@@ -255,7 +279,7 @@ static unsigned may_free_handle(starpu_data_handle_t handle, unsigned node)
 			/* Some request is invalidating it anyway */
 			return 0;
 		unsigned n;
-		for (n = 0; n < STARPU_MAXNODES; n++)
+		for (n = 0; n < handle->nreplicates; n++)
 			if (_starpu_get_data_refcnt(handle, n))
 				/* Some task is writing to the handle somewhere */
 				return 0;
@@ -339,7 +363,7 @@ static int STARPU_ATTRIBUTE_WARN_UNUSED_RESULT transfer_subtree_to_node(starpu_d
 			src_replicate->state = STARPU_INVALID;
 
 			/* count the number of copies */
-			for (i = 0; i < STARPU_MAXNODES; i++)
+			for (i = 0; i < handle->nreplicates; i++)
 			{
 				if (handle->per_node[i].state == STARPU_SHARED)
 				{
@@ -452,6 +476,10 @@ static size_t do_free_mem_chunk(struct _starpu_mem_chunk *mc, unsigned node)
 	size_t size;
 	starpu_data_handle_t handle = mc->data;
 
+	/* remove the mem_chunk from the list, before updating its size which
+	 * was accounted for while in the list */
+	MC_LIST_ERASE(_starpu_get_node_struct(node), mc);
+
 	if (handle)
 	{
 		_starpu_spin_checklocked(&handle->header_lock);
@@ -463,9 +491,6 @@ static size_t do_free_mem_chunk(struct _starpu_mem_chunk *mc, unsigned node)
 	/* free the actual buffer */
 	size = free_memory_on_node(mc, node);
 
-	/* remove the mem_chunk from the list */
-	MC_LIST_ERASE(_starpu_get_node_struct(node), mc);
-
 	_starpu_mem_chunk_delete(mc);
 
 #ifdef STARPU_SIMGRID
@@ -539,7 +564,7 @@ int starpu_data_can_evict(starpu_data_handle_t handle, unsigned node, enum starp
 		return 0;
 
 	unsigned mapnode;
-	for (mapnode = 0; mapnode < STARPU_MAXNODES; mapnode++)
+	for (mapnode = 0; mapnode < handle->nreplicates; mapnode++)
 		if (handle->per_node[mapnode].mapped == (int) node)
 			/* This is mapped, we can't evict it */
 			/* TODO: rather check if that can be evicted as well, and if so unmap it before evicting this */
@@ -1219,8 +1244,29 @@ void starpu_memchunk_tidy(unsigned node)
 	if (!can_evict(node))
 		return;
 
+	/* Whether too few buffers are clean */
+	int writeback_buffers = node_struct->mc_clean_nb < (node_struct->mc_nb * minimum_clean_p) / 100;
+	/* Whether memory use crossed the high watermark, in which case we
+	 * write back dirty data until it gets below the low watermark, so
+	 * that allocations can then just drop clean data instead of waiting
+	 * for it to be written */
+	int writeback_mem = 0;
+	starpu_ssize_t writeback_target = 0;
+
+	if (node_struct->writeback_high_p)
+	{
+		total = starpu_memory_get_total(node);
+		if (total > 0)
+		{
+			available = starpu_memory_get_available(node) + node_struct->mc_cache_size;
+			writeback_target = (total * node_struct->writeback_low_p) / 100;
+			writeback_mem = total - available >= (total * node_struct->writeback_high_p) / 100
+				&& node_struct->mc_dirty_size > writeback_target;
+		}
+	}
+
 	// TODO: ideally we would use the Belady order here as well.
-	if (node_struct->mc_clean_nb < (node_struct->mc_nb * minimum_clean_p) / 100)
+	if (writeback_buffers || writeback_mem)
 	{
 		struct _starpu_mem_chunk *mc, *orig_next_mc, *next_mc;
 		int skipped = 0;	/* Whether we skipped a dirty MC, and we should thus stop updating mc_dirty_head. */
@@ -1231,7 +1277,8 @@ void starpu_memchunk_tidy(unsigned node)
 		_starpu_spin_lock(&node_struct->mc_lock);
 
 		for (mc = node_struct->mc_dirty_head;
-			mc && node_struct->mc_clean_nb < (node_struct->mc_nb * target_clean_p) / 100;
+			mc && ((writeback_buffers && node_struct->mc_clean_nb < (node_struct->mc_nb * target_clean_p) / 100)
+				|| (writeback_mem && node_struct->mc_dirty_size > writeback_target));
 			mc = next_mc, mc && skipped ? 0 : (node_struct->mc_dirty_head = mc))
 		{
 			starpu_data_handle_t handle;
@@ -1279,10 +1326,10 @@ void starpu_memchunk_tidy(unsigned node)
 				}
 
 				unsigned n;
-				for (n = 0; n < STARPU_MAXNODES; n++)
+				for (n = 0; n < handle->nreplicates; n++)
 					if (_starpu_get_data_refcnt(handle, n))
 						break;
-				if (n < STARPU_MAXNODES)
+				if (n < handle->nreplicates)
 				{
 					/* Some task is writing to the handle somewhere */
 					_starpu_spin_unlock(&handle->header_lock);
@@ -1313,6 +1360,7 @@ void starpu_memchunk_tidy(unsigned node)
 				/* It's available in the home node, this should have been marked as clean already */
 				mc->clean = 1;
 				node_struct->mc_clean_nb++;
+				node_struct->mc_dirty_size -= mc->size;
 				_starpu_spin_unlock(&handle->header_lock);
 				continue;
 			}
@@ -1337,6 +1385,7 @@ void starpu_memchunk_tidy(unsigned node)
 			/* MC will be clean, consider it as such */
 			mc->clean = 1;
 			node_struct->mc_clean_nb++;
+			node_struct->mc_dirty_size -= mc->size;
 
 			orig_next_mc = next_mc;
 			if (next_mc)
@@ -1438,6 +1487,7 @@ static struct _starpu_mem_chunk *_starpu_memchunk_init(struct _starpu_data_repli
 	mc->replicate->mc = mc;
 	mc->chunk_interface = NULL;
 	mc->size_interface = interface_size;
+	mc->size = _starpu_data_get_alloc_size(handle);
 	mc->remove_notify = NULL;
 	mc->wontuse = 0;
 
@@ -1476,11 +1526,6 @@ void _starpu_request_mem_chunk_removal(starpu_data_handle_t handle, struct _star
 	_starpu_spin_checklocked(&handle->header_lock);
 	STARPU_ASSERT(node < STARPU_MAXNODES);
 
-	/* Record the allocated size, so that later in memory
-	 * reclaiming we can estimate how much memory we free
-	 * by freeing this.  */
-	mc->size = size;
-
 	/* This memchunk doesn't have to do with the data any more. */
 	replicate->mc = NULL;
 	mc->replicate = NULL;
@@ -1496,6 +1541,11 @@ void _starpu_request_mem_chunk_removal(starpu_data_handle_t handle, struct _star
 
 	_starpu_spin_unlock(&node_struct->mc_lock);
 
+	/* Record the allocated size, so that later in memory
+	 * reclaiming we can estimate how much memory we free
+	 * by freeing this.  */
+	mc->size = size;
+
 	/*
 	 * Unless we have a memory limitation, we would fill
 	 * memory with cached data and then eventually swap.
@@ -1777,7 +1827,7 @@ unsigned starpu_data_test_if_allocated_on_node(starpu_data_handle_t handle, unsi
 unsigned starpu_data_test_if_mapped_on_node(starpu_data_handle_t handle, unsigned memory_node)
 {
 	STARPU_ASSERT(memory_node < STARPU_MAXNODES);
-	return handle->per_node[memory_node].allocated;
+	return handle->per_node[memory_node].mapped != STARPU_UNMAPPED;
 }
 
 /* This memchunk has been recently used, put it last on the mc_list, so we will
@@ -1842,6 +1892,7 @@ void _starpu_memchunk_clean(struct _starpu_mem_chunk *mc, unsigned node)
 	if (!mc->clean)
 	{
 		node_struct->mc_clean_nb++;
+		node_struct->mc_dirty_size -= mc->size;
 		mc->clean = 1;
 	}
 	_starpu_spin_unlock(&node_struct->mc_lock);
@@ -1868,6 +1919,7 @@ void _starpu_memchunk_dirty(struct _starpu_mem_chunk *mc, unsigned node)
 		if (!mc->clean)
 		{
 			node_struct->mc_clean_nb++;
+			node_struct->mc_dirty_size -= mc->size;
 			mc->clean = 1;
 		}
 	}
@@ -1876,6 +1928,7 @@ void _starpu_memchunk_dirty(struct _starpu_mem_chunk *mc, unsigned node)
 		if (mc->clean)
 		{
 			node_struct->mc_clean_nb--;
+			node_struct->mc_dirty_size += mc->size;
 			mc->clean = 0;
 		}
 	}
@@ -23,6 +23,16 @@
 #include <drivers/mp_common/source_common.h>
 #include <datawizard/memory_nodes.h>
 
+/* Number of replicates reduced together by each reduction task */
+static unsigned redux_arity;
+
+void _starpu_init_reduction(void)
+{
+	redux_arity = starpu_getenv_number_default("STARPU_REDUX_ARITY", 2);
+	if (redux_arity < 2)
+		redux_arity = 2;
+}
+
 void starpu_data_set_reduction_methods(starpu_data_handle_t handle, struct starpu_codelet *redux_cl, struct starpu_codelet *init_cl)
 {
 	starpu_data_set_reduction_methods_with_args(handle, redux_cl, NULL, init_cl, NULL);
@@ -201,6 +211,89 @@ void _starpu_data_start_reduction_mode(starpu_data_handle_t handle)
 
 //#define NO_TREE_REDUCTION
 
+#ifndef NO_TREE_REDUCTION
+/* Reduction of replicate src into replicate dst */
+struct _starpu_redux_step
+{
+	unsigned dst;
+	unsigned src;
+};
+
+/* Append to steps the reduction of replicates idx[0..n) into idx[0] along a
+ * tree of the given arity: first 1-by-1, then arity-by-arity, etc. */
+static unsigned _starpu_redux_plan_tree(struct _starpu_redux_step *steps, unsigned nsteps, const unsigned *idx, unsigned n, unsigned arity)
+{
+	unsigned step, i, c;
+
+	for (step = 1; step < n; step *= arity)
+		for (i = 0; i < n; i += arity*step)
+			for (c = 1; c < arity && i + c*step < n; c++)
+			{
+				steps[nsteps].dst = idx[i];
+				steps[nsteps].src = idx[i + c*step];
+				nsteps++;
+			}
+
+	return nsteps;
+}
+
+/* Plan the reduction of all replicates into replicate_array[root]: first
+ * within each memory node, then between memory nodes, the nodes which are the
+ * cheapest to reach from target_node being reduced first together. Returns
+ * the number of steps. */
+static unsigned _starpu_redux_plan(starpu_data_handle_t handle, struct _starpu_redux_step *steps, const unsigned *replicate_node, unsigned replicate_count, unsigned target_node, unsigned *root)
+{
+	unsigned arity = redux_arity;
+	unsigned leaders[STARPU_MAXNODES];
+	unsigned nleaders = 0;
+	unsigned members[replicate_count];
+	unsigned nsteps = 0;
+	unsigned node, i, j;
+
+	for (node = 0; node < STARPU_MAXNODES; node++)
+	{
+		unsigned nmembers = 0;
+		for (i = 0; i < replicate_count; i++)
+			if (replicate_node[i] == node)
+				members[nmembers++] = i;
+		if (!nmembers)
+			continue;
+
+		nsteps = _starpu_redux_plan_tree(steps, nsteps, members, nmembers, arity);
+		if (node == target_node)
+		{
+			/* This one will get the result */
+			memmove(&leaders[1], &leaders[0], nleaders * sizeof(leaders[0]));
+			leaders[0] = members[0];
+		}
+		else
+			leaders[nleaders] = members[0];
+		nleaders++;
+	}
+
+	/* Sort the other nodes by transfer time to the target */
+	size_t size = _starpu_data_get_size(handle);
+	double cost[STARPU_MAXNODES];
+	for (i = 1; i < nleaders; i++)
+	{
+		unsigned leader = leaders[i];
+		double leader_cost = starpu_transfer_predict(replicate_node[leader], replicate_node[leaders[0]], size);
+		for (j = i; j > 1 && cost[j-1] > leader_cost; j--)
+		{
+			leaders[j] = leaders[j-1];
+			cost[j] = cost[j-1];
+		}
+		leaders[j] = leader;
+		cost[j] = leader_cost;
+	}
+
+	nsteps = _starpu_redux_plan_tree(steps, nsteps, leaders, nleaders, arity);
+	*root = leaders[0];
+
+	return nsteps;
+}
+#endif
+
 /* Force reduction. The lock should already have been taken.  */
 void _starpu_data_end_reduction_mode(starpu_data_handle_t handle, int priority)
 {
@@ -211,20 +304,38 @@ void _starpu_data_end_reduction_mode(starpu_data_handle_t handle, int priority)
 	/* Put every valid replicate in the same array */
 	unsigned replicate_count = 0;
 	starpu_data_handle_t replicate_array[1 + STARPU_NMAXWORKERS];
+#ifndef NO_TREE_REDUCTION
+	/* and record where they are */
+	unsigned replicate_node[1 + STARPU_NMAXWORKERS];
+	unsigned target_node;
+#endif
 
 	_starpu_spin_checklocked(&handle->header_lock);
 
-	for (node = 0; node < STARPU_MAXNODES; node++)
+	/* Every further access to the handle is waiting for the reduction */
+	priority = STARPU_MAX(priority, starpu_sched_get_max_priority());
+
+	for (node = 0; node < handle->nreplicates; node++)
 	{
 		if (handle->per_node[node].state != STARPU_INVALID)
 			break;
 	}
-	empty = node == STARPU_MAXNODES;
+	empty = node == handle->nreplicates;
 
 #ifndef NO_TREE_REDUCTION
+	if (handle->home_node >= 0 && (empty || handle->per_node[handle->home_node].state != STARPU_INVALID))
+		target_node = handle->home_node;
+	else if (!empty)
+		target_node = node;
+	else
+		target_node = STARPU_MAIN_RAM;
+
 	if (!empty)
+	{
 		/* Include the initial value into the reduction tree */
+		replicate_node[replicate_count] = target_node;
 		replicate_array[replicate_count++] = handle;
+	}
 #endif
 
 	/* Register all valid per-worker replicates */
@@ -244,6 +355,9 @@ void _starpu_data_end_reduction_mode(starpu_data_handle_t handle, int priority)
 
 			starpu_data_set_sequential_consistency_flag(handle->reduction_tmp_handles[worker], 0);
 
+#ifndef NO_TREE_REDUCTION
+			replicate_node[replicate_count] = home_node;
+#endif
 			replicate_array[replicate_count++] = handle->reduction_tmp_handles[worker];
 		}
 		else
@@ -253,6 +367,13 @@ void _starpu_data_end_reduction_mode(starpu_data_handle_t handle, int priority)
 	}
 
 #ifndef NO_TREE_REDUCTION
+	struct _starpu_redux_step steps[replicate_count ? replicate_count : 1];
+	unsigned nsteps = 0;
+	unsigned root = 0;
+
+	if (replicate_count)
+		nsteps = _starpu_redux_plan(handle, steps, replicate_node, replicate_count, target_node, &root);
+
 	if (empty)
 	{
 		/* Only the final copy will touch the actual handle */
@@ -260,14 +381,13 @@ void _starpu_data_end_reduction_mode(starpu_data_handle_t handle, int priority)
 	}
 	else
 	{
-		unsigned step = 1;
+		unsigned i;
+		STARPU_ASSERT(root == 0);
 		handle->reduction_refcnt = 0;
-		while (step < replicate_count)
-		{
-			/* Each stage will touch the actual handle */
-			handle->reduction_refcnt++;
-			step *= 2;
-		}
+		for (i = 0; i < nsteps; i++)
+			/* This step will touch the actual handle */
+			if (steps[i].dst == 0)
+				handle->reduction_refcnt++;
 	}
 #else
 	/* We know that in this reduction algorithm there is exactly one task per valid replicate. */
@@ -294,84 +414,79 @@ void _starpu_data_end_reduction_mode(starpu_data_handle_t handle, int priority)
 		memset(last_replicate_deps, 0, replicate_count*sizeof(struct starpu_task *));
 		struct starpu_task *redux_tasks[replicate_count];
 
-		/* Redux step-by-step for step from 1 to replicate_count/2, i.e.
-		 * 1-by-1, then 2-by-2, then 4-by-4, etc. */
-		unsigned step;
-		unsigned redux_task_idx = 0;
-		for (step = 1; step < replicate_count; step *=2)
+		/* Follow the plan, tasks reducing into the same replicate are
+		 * chained */
+		unsigned redux_task_idx;
+		for (redux_task_idx = 0; redux_task_idx < nsteps; redux_task_idx++)
 		{
-			unsigned i;
-			for (i = 0; i < replicate_count; i+=2*step)
+			unsigned dst = steps[redux_task_idx].dst;
+			unsigned src = steps[redux_task_idx].src;
+
+			/* Perform the reduction between replicates dst
+			 * and src and put the result in replicate dst */
+			struct starpu_task *redux_task = starpu_task_create();
+			redux_task->name = "redux_task_between_replicates";
+			redux_task->priority = priority;
+
+			/* Mark these tasks so that StarPU does not block them
+			 * when they try to access the handle (normal tasks are
+			 * data requests to that handle are frozen until the
+			 * data is coherent again). */
+			struct _starpu_job *j = _starpu_get_job_associated_to_task(redux_task);
+			j->reduction_task = 1;
+
+			redux_task->cl = handle->redux_cl;
+			redux_task->cl_arg = handle->redux_cl_arg;
+			STARPU_ASSERT(redux_task->cl);
+			if (!(STARPU_CODELET_GET_MODE(redux_task->cl, 0)))
+				STARPU_CODELET_SET_MODE(redux_task->cl, STARPU_RW|STARPU_COMMUTE, 0);
+			if (!(STARPU_CODELET_GET_MODE(redux_task->cl, 1)))
+				STARPU_CODELET_SET_MODE(redux_task->cl, STARPU_R, 1);
+
+			if (!(STARPU_CODELET_GET_MODE(redux_task->cl, 0) & STARPU_COMMUTE))
 			{
-				if (i + step < replicate_count)
+				static int warned;
+				STARPU_HG_DISABLE_CHECKING(warned);
+				if (!warned)
 				{
-					/* Perform the reduction between replicates i
-					 * and i+step and put the result in replicate i */
-					struct starpu_task *redux_task = starpu_task_create();
-					redux_task->name = "redux_task_between_replicates";
-					redux_task->priority = priority;
-
-					/* Mark these tasks so that StarPU does not block them
-					 * when they try to access the handle (normal tasks are
-					 * data requests to that handle are frozen until the
-					 * data is coherent again). */
-					struct _starpu_job *j = _starpu_get_job_associated_to_task(redux_task);
-					j->reduction_task = 1;
-
-					redux_task->cl = handle->redux_cl;
-					redux_task->cl_arg = handle->redux_cl_arg;
-					STARPU_ASSERT(redux_task->cl);
-					if (!(STARPU_CODELET_GET_MODE(redux_task->cl, 0)))
-						STARPU_CODELET_SET_MODE(redux_task->cl, STARPU_RW|STARPU_COMMUTE, 0);
-					if (!(STARPU_CODELET_GET_MODE(redux_task->cl, 1)))
-						STARPU_CODELET_SET_MODE(redux_task->cl, STARPU_R, 1);
-
-					if (!(STARPU_CODELET_GET_MODE(redux_task->cl, 0) & STARPU_COMMUTE))
-					{
-						static int warned;
-						STARPU_HG_DISABLE_CHECKING(warned);
-						if (!warned)
-						{
-							warned = 1;
-							_STARPU_DISP("Warning: for reductions, codelet %p should have STARPU_COMMUTE along STARPU_RW\n", redux_task->cl);
-						}
-					}
-
-					STARPU_TASK_SET_HANDLE(redux_task, replicate_array[i], 0);
-					STARPU_TASK_SET_HANDLE(redux_task, replicate_array[i+step], 1);
-
-					int ndeps = 0;
-					struct starpu_task *task_deps[2];
-
-					if (last_replicate_deps[i])
-						task_deps[ndeps++] = last_replicate_deps[i];
-
-					if (last_replicate_deps[i+step])
-						task_deps[ndeps++] = last_replicate_deps[i+step];
-
-					/* i depends on this task */
-					last_replicate_deps[i] = redux_task;
-
-					/* we don't perform the reduction until both replicates are ready */
-					starpu_task_declare_deps_array(redux_task, ndeps, task_deps);
-
-					/* We cannot submit tasks here : we do
-					 * not want to depend on tasks that have
-					 * been completed, so we juste store
-					 * this task : it will be submitted
-					 * later. */
-					redux_tasks[redux_task_idx++] = redux_task;
+					warned = 1;
+					_STARPU_DISP("Warning: for reductions, codelet %p should have STARPU_COMMUTE along STARPU_RW\n", redux_task->cl);
 				}
 			}
+
+			STARPU_TASK_SET_HANDLE(redux_task, replicate_array[dst], 0);
+			STARPU_TASK_SET_HANDLE(redux_task, replicate_array[src], 1);
+
+			int ndeps = 0;
+			struct starpu_task *task_deps[2];
+
+			if (last_replicate_deps[dst])
+				task_deps[ndeps++] = last_replicate_deps[dst];
+
+			if (last_replicate_deps[src])
+				task_deps[ndeps++] = last_replicate_deps[src];
+
+			/* dst depends on this task */
+			last_replicate_deps[dst] = redux_task;
+
+			/* we don't perform the reduction until both replicates are ready */
+			starpu_task_declare_deps_array(redux_task, ndeps, task_deps);
+
+			/* We cannot submit tasks here : we do
+			 * not want to depend on tasks that have
+			 * been completed, so we juste store
+			 * this task : it will be submitted
+			 * later. */
+			redux_tasks[redux_task_idx] = redux_task;
 		}
 
 		if (empty)
 			/* The handle was empty, we just need to copy the reduced value. */
-			_starpu_data_cpy(handle, replicate_array[0], 1, NULL, 0, 1, last_replicate_deps[0], priority);
+			_starpu_data_cpy(handle, replicate_array[root], 1, NULL, 0, 1, last_replicate_deps[root], priority);
 
 		/* Let's submit all the reduction tasks. */
 		unsigned i;
-		for (i = 0; i < redux_task_idx; i++)
+		for (i = 0; i < nsteps; i++)
 		{
 			int ret = _starpu_task_submit_internally(redux_tasks[i]);
 			STARPU_ASSERT(ret == 0);
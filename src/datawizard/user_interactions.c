@@ -188,34 +188,15 @@ static void starpu_data_acquire_cb_pre_sync_callback(void *arg)
 	}
 }
 
-/* The data must be released by calling starpu_data_release later on */
-int starpu_data_acquire_on_node_cb_sequential_consistency_sync_jobids(starpu_data_handle_t handle, int node,
-							  enum starpu_data_access_mode mode,
-							  void (*callback_acquired)(void *arg, int *node, enum starpu_data_access_mode mode),
-							  void (*callback)(void *arg),
-							  void *arg,
-							  int sequential_consistency, int quick,
-							  long *pre_sync_jobid, long *post_sync_jobid, int prio)
+/* Submit the implicit dependencies of an asynchronous acquisition, and
+ * launch it if it does not have to wait for anything */
+static void _starpu_data_acquire_cb_submit(struct user_interaction_wrapper *wrapper,
+					   int sequential_consistency, int quick,
+					   long *pre_sync_jobid, long *post_sync_jobid)
 {
-	STARPU_ASSERT(handle);
-	STARPU_ASSERT_MSG(handle->nchildren == 0, "Acquiring a partitioned data (%p) is not possible", handle);
-	_STARPU_LOG_IN();
-
-	/* Check that previous tasks have set a value if needed */
-	_starpu_data_check_initialized(handle, mode);
-
-	struct user_interaction_wrapper *wrapper;
-	_STARPU_MALLOC(wrapper, sizeof(struct user_interaction_wrapper));
-
-	_starpu_data_acquire_wrapper_init(wrapper, handle, node, mode);
-	wrapper->async = 1;
-
-	wrapper->callback_acquired = callback_acquired;
-	wrapper->callback = callback;
-	wrapper->callback_arg = arg;
-	wrapper->pre_sync_task = NULL;
-	wrapper->post_sync_task = NULL;
-	wrapper->prio = prio;
+	starpu_data_handle_t handle = wrapper->handle;
+	enum starpu_data_access_mode mode = wrapper->mode;
+	int prio = wrapper->prio;
 
 	STARPU_PTHREAD_MUTEX_LOCK(&handle->sequential_consistency_mutex);
 	int handle_sequential_consistency = handle->sequential_consistency;
@@ -278,6 +259,36 @@ int starpu_data_acquire_on_node_cb_sequential_consistency_sync_jobids(starpu_dat
 
 		starpu_data_acquire_cb_pre_sync_callback(wrapper);
 	}
+}
+
+/* The data must be released by calling starpu_data_release later on */
+int starpu_data_acquire_on_node_cb_sequential_consistency_sync_jobids(starpu_data_handle_t handle, int node,
+							  enum starpu_data_access_mode mode,
+							  void (*callback_acquired)(void *arg, int *node, enum starpu_data_access_mode mode),
+							  void (*callback)(void *arg),
+							  void *arg,
+							  int sequential_consistency, int quick,
+							  long *pre_sync_jobid, long *post_sync_jobid, int prio)
+{
+	STARPU_ASSERT(handle);
+	STARPU_ASSERT_MSG(handle->nchildren == 0, "Acquiring a partitioned data (%p) is not possible", handle);
+	_STARPU_LOG_IN();
+
+	/* Check that previous tasks have set a value if needed */
+	_starpu_data_check_initialized(handle, mode);
+
+	struct user_interaction_wrapper *wrapper;
+	_STARPU_MALLOC(wrapper, sizeof(struct user_interaction_wrapper));
+
+	_starpu_data_acquire_wrapper_init(wrapper, handle, node, mode);
+	wrapper->async = 1;
+
+	wrapper->callback_acquired = callback_acquired;
+	wrapper->callback = callback;
+	wrapper->callback_arg = arg;
+	wrapper->prio = prio;
+
+	_starpu_data_acquire_cb_submit(wrapper, sequential_consistency, quick, pre_sync_jobid, post_sync_jobid);
 
 	_STARPU_LOG_OUT();
 	return 0;
@@ -322,6 +333,202 @@ int starpu_data_acquire_cb_sequential_consistency(starpu_data_handle_t handle,
 }
 
 
+struct user_interaction_array_wrapper;
+
+struct user_interaction_array_entry
+{
+	struct user_interaction_array_wrapper *array;
+	starpu_data_handle_t handle;
+	double transfer_time;
+};
+
+/* Tracks the acquisition of a set of handles, so as to call the application
+ * callback only once all of them are available. A single sync task takes the
+ * implicit dependencies of all of them, and terminates only once all of them
+ * are released. */
+struct user_interaction_array_wrapper
+{
+	int remaining;
+	int node;
+	enum starpu_data_access_mode mode;
+	struct starpu_task *sync_task;
+	void (*callback)(void *);
+	void *callback_arg;
+	unsigned nhandles;
+	struct user_interaction_array_entry entries[];
+};
+
+/* Expected time for fetching the handle, if it already has a value at all: it
+ * may still be only about to be produced by a submitted task */
+static double _starpu_data_acquire_array_transfer_time(starpu_data_handle_t handle, unsigned node, enum starpu_data_access_mode mode)
+{
+	unsigned nnodes = starpu_memory_nodes_get_count();
+	unsigned i;
+
+	for (i = 0; i < nnodes; i++)
+		if (handle->per_node[i].state != STARPU_INVALID)
+			return starpu_data_expected_transfer_time(handle, node, mode);
+	return 0.;
+}
+
+static int _starpu_data_acquire_array_cmp_handle(const void *a, const void *b)
+{
+	const struct user_interaction_array_entry *ea = a;
+	const struct user_interaction_array_entry *eb = b;
+
+	if ((uintptr_t) ea->handle < (uintptr_t) eb->handle)
+		return -1;
+	if ((uintptr_t) ea->handle > (uintptr_t) eb->handle)
+		return 1;
+	return 0;
+}
+
+static int _starpu_data_acquire_array_cmp(const void *a, const void *b)
+{
+	const struct user_interaction_array_entry *ea = a;
+	const struct user_interaction_array_entry *eb = b;
+
+	/* Longest transfers first */
+	if (ea->transfer_time > eb->transfer_time)
+		return -1;
+	if (ea->transfer_time < eb->transfer_time)
+		return 1;
+	return 0;
+}
+
+/* Called when the fetch of a handle of the set is done */
+static void _starpu_data_acquire_array_fetch_data_callback(void *arg)
+{
+	struct user_interaction_array_entry *entry = arg;
+	struct user_interaction_array_wrapper *array = entry->array;
+
+	/* Have starpu_data_release release our part of the sync task */
+	if (!_starpu_add_post_sync_end_dep(array->sync_task, entry->handle))
+		starpu_task_end_dep_release(array->sync_task);
+
+	if (STARPU_ATOMIC_ADD(&array->remaining, -1) > 0)
+		/* Still waiting for other handles of the set */
+		return;
+
+	array->callback(array->callback_arg);
+	free(array);
+}
+
+/* Called when the data acquisition of a handle of the set is done, launch the
+ * fetch into target memory */
+static void _starpu_data_acquire_array_continuation(void *arg)
+{
+	struct user_interaction_array_entry *entry = arg;
+	struct user_interaction_array_wrapper *array = entry->array;
+	starpu_data_handle_t handle = entry->handle;
+	int node = array->node;
+	struct _starpu_data_replicate *replicate = node >= 0 ? &handle->per_node[node] : NULL;
+
+	int ret = _starpu_fetch_data_on_node(handle, node, replicate, array->mode, 0, NULL, STARPU_FETCH, 1, _starpu_data_acquire_array_fetch_data_callback, entry, STARPU_DEFAULT_PRIO, "_starpu_data_acquire_array_continuation");
+	STARPU_ASSERT(!ret);
+}
+
+/* Called when the implicit data dependencies of the whole set are done,
+ * launch the data acquisitions */
+static void _starpu_data_acquire_array_prologue(void *arg)
+{
+	struct user_interaction_array_wrapper *array = arg;
+	unsigned nhandles = array->nhandles;
+	enum starpu_data_access_mode mode = array->mode;
+	unsigned i;
+
+	/* Note: the array may get freed as soon as the last acquisition is
+	 * launched, do not access it any more after that. */
+	for (i = 0; i < nhandles; i++)
+	{
+		struct user_interaction_array_entry *entry = &array->entries[i];
+
+		/* The sync task still holds the data, the request will thus
+		 * proceed once it is done with it */
+		if (!_starpu_attempt_to_submit_data_request_from_apps(entry->handle, mode,
+				_starpu_data_acquire_array_continuation, entry))
+			_starpu_data_acquire_array_continuation(entry);
+	}
+}
+
+/* The data must be released by calling starpu_data_release_on_node_array later on */
+int starpu_data_acquire_on_node_array_cb(unsigned nhandles, starpu_data_handle_t *handles, int node,
+					 enum starpu_data_access_mode mode, void (*callback)(void *), void *arg)
+{
+	struct user_interaction_array_wrapper *array;
+	struct starpu_task *task;
+	unsigned i;
+	int ret;
+
+	_STARPU_LOG_IN();
+
+	if (nhandles == 0)
+	{
+		callback(arg);
+		_STARPU_LOG_OUT();
+		return 0;
+	}
+
+	_STARPU_MALLOC(array, sizeof(*array) + nhandles * sizeof(array->entries[0]));
+	array->remaining = nhandles;
+	array->node = node;
+	array->mode = mode;
+	array->callback = callback;
+	array->callback_arg = arg;
+	array->nhandles = nhandles;
+
+	for (i = 0; i < nhandles; i++)
+	{
+		starpu_data_handle_t handle = handles[i];
+		STARPU_ASSERT(handle);
+		STARPU_ASSERT_MSG(handle->nchildren == 0, "Acquiring a partitioned data (%p) is not possible", handle);
+
+		/* Check that previous tasks have set a value if needed */
+		_starpu_data_check_initialized(handle, mode);
+
+		array->entries[i].array = array;
+		array->entries[i].handle = handle;
+		array->entries[i].transfer_time = node >= 0 ? _starpu_data_acquire_array_transfer_time(handle, node, mode) : 0.;
+	}
+
+	/* Acquiring the same handle twice would wait for itself */
+	qsort(array->entries, nhandles, sizeof(array->entries[0]), _starpu_data_acquire_array_cmp_handle);
+	for (i = 1; i < nhandles; i++)
+		STARPU_ASSERT_MSG(array->entries[i].handle != array->entries[i-1].handle, "handle %p appears several times in the array given to starpu_data_acquire_on_node_array_cb", array->entries[i].handle);
+
+	/* Start the longest transfers first, so that the shorter ones
+	 * overlap with them instead of delaying them */
+	if (node >= 0)
+		qsort(array->entries, nhandles, sizeof(array->entries[0]), _starpu_data_acquire_array_cmp);
+
+	task = starpu_task_create_sync(array->entries[0].handle, mode);
+	task->name = "_starpu_data_acquire_array";
+	task->type = STARPU_TASK_TYPE_DATA_ACQUIRE;
+	task->nbuffers = nhandles;
+	if (nhandles > STARPU_NMAXBUFS)
+	{
+		_STARPU_MALLOC(task->dyn_handles, nhandles * sizeof(*task->dyn_handles));
+		_STARPU_MALLOC(task->dyn_modes, nhandles * sizeof(*task->dyn_modes));
+	}
+	for (i = 0; i < nhandles; i++)
+	{
+		STARPU_TASK_SET_HANDLE(task, array->entries[i].handle, i);
+		STARPU_TASK_SET_MODE(task, mode, i);
+	}
+	task->prologue_callback_func = _starpu_data_acquire_array_prologue;
+	task->prologue_callback_arg = array;
+	/* Only terminate once all handles are released */
+	starpu_task_end_dep_add(task, nhandles);
+	array->sync_task = task;
+
+	ret = _starpu_task_submit_internally(task);
+	STARPU_ASSERT(!ret);
+
+	_STARPU_LOG_OUT();
+	return 0;
+}
+
+
 /*
  *	Blocking data request from application
  */
@@ -523,7 +730,7 @@ void starpu_data_release_to_on_node(starpu_data_handle_t handle, enum starpu_dat
 		if (node == STARPU_ACQUIRE_NO_NODE_LOCK_ALL)
 		{
 			int i;
-			for (i = 0; i < STARPU_MAXNODES; i++)
+			for (i = 0; i < (int) handle->nreplicates; i++)
 				handle->per_node[i].refcnt--;
 		}
 		handle->busy_count--;
@@ -550,6 +757,14 @@ void starpu_data_release(starpu_data_handle_t handle)
 	starpu_data_release_to(handle, STARPU_NONE);
 }
 
+void starpu_data_release_on_node_array(unsigned nhandles, starpu_data_handle_t *handles, int node)
+{
+	unsigned i;
+
+	for (i = 0; i < nhandles; i++)
+		starpu_data_release_on_node(handles[i], node);
+}
+
 static void _prefetch_data_on_node(void *arg)
 {
 	struct user_interaction_wrapper *wrapper = (struct user_interaction_wrapper *) arg;
@@ -659,7 +874,7 @@ static void _starpu_data_wont_use(void *data)
 	_STARPU_TRACE_DATA_DOING_WONT_USE(handle);
 
 	_starpu_spin_lock(&handle->header_lock);
-	for (node = 0; node < STARPU_MAXNODES; node++)
+	for (node = 0; node < handle->nreplicates; node++)
 	{
 		struct _starpu_data_replicate *local = &handle->per_node[node];
 		if (local->allocated && local->automatically_allocated)
@@ -832,7 +1047,7 @@ void starpu_data_query_status2(starpu_data_handle_t handle, int memory_node, int
 		unsigned node;
 		for (node = 0; node < STARPU_MAXNODES; node++)
 		{
-			if (handle->per_node[memory_node].request[node])
+			if (_starpu_data_replicate_get_request(&handle->per_node[memory_node], node))
 			{
 				requested = 1;
 				break;
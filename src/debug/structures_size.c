@@ -18,6 +18,7 @@
 #include <core/jobs.h>
 #include <core/workers.h>
 #include <datawizard/coherency.h>
+#include <datawizard/interfaces/data_interface.h>
 #include <profiling/bound.h>
 #include <debug/starpu_debug_helpers.h>
 
@@ -29,6 +30,21 @@ void _starpu_debug_display_structures_size(FILE *stream)
 			(unsigned) sizeof(struct _starpu_job), (unsigned) sizeof(struct _starpu_job));
 	fprintf(stream, "struct _starpu_data_state\t%u bytes\t(%x)\n",
 			(unsigned) sizeof(struct _starpu_data_state), (unsigned) sizeof(struct _starpu_data_state));
+	fprintf(stream, "struct _starpu_data_replicate\t%u bytes\t(%x)\n",
+			(unsigned) sizeof(struct _starpu_data_replicate), (unsigned) sizeof(struct _starpu_data_replicate));
+	fprintf(stream, "struct _starpu_data_replicate_requests\t%u bytes\t(%x)\n",
+			(unsigned) sizeof(struct _starpu_data_replicate_requests), (unsigned) sizeof(struct _starpu_data_replicate_requests));
+	/* Request lists are only allocated for replicates which get requests,
+	 * they used to be embedded in each replicate, and replicates are only
+	 * allocated for the memory nodes which can be present */
+	unsigned nnodes = _starpu_data_get_registered_nreplicates();
+	if (!nnodes)
+		nnodes = starpu_memory_nodes_get_count();
+	fprintf(stream, "bytes per data handle\t\t%u bytes for %u memory nodes (%u bytes with embedded request lists and %d memory nodes)\n",
+			(unsigned) (sizeof(struct _starpu_data_state) + nnodes * sizeof(struct _starpu_data_replicate)),
+			nnodes,
+			(unsigned) (sizeof(struct _starpu_data_state) + STARPU_MAXNODES * (sizeof(struct _starpu_data_replicate) + 2 * STARPU_MAXNODES * sizeof(struct _starpu_data_request *) - sizeof(struct _starpu_data_replicate_requests *))),
+			STARPU_MAXNODES);
 	fprintf(stream, "struct _starpu_tag\t\t%u bytes\t(%x)\n",
 			(unsigned) sizeof(struct _starpu_tag), (unsigned) sizeof(struct _starpu_tag));
 	fprintf(stream, "struct _starpu_cg\t\t%u bytes\t(%x)\n",
@@ -21,6 +21,7 @@
 #include <common/config.h>
 #include <common/uthash.h>
 #include <datawizard/copy_driver.h>
+#include <core/errorcheck.h>
 #include <string.h>
 #include <math.h>
 
@@ -3555,6 +3556,38 @@ static void handle_thread_event(struct fxt_ev_64 *ev, struct starpu_fxt_options
 	}
 }
 
+static void handle_worker_status_snapshot(struct fxt_ev_64 *ev, struct starpu_fxt_options *options)
+{
+	if (out_paje_file)
+	{
+		unsigned long workerid = ev->param[0];
+		unsigned long status = ev->param[1];
+		char snapshot[64];
+
+		if (status == STATUS_UNKNOWN)
+			snprintf(snapshot, sizeof(snapshot), "Overhead");
+		else
+			snprintf(snapshot, sizeof(snapshot), "%s%s%s%s%s%s",
+				 status & STATUS_INITIALIZING ? "Initializing " : "",
+				 status & STATUS_EXECUTING ? "Executing " : "",
+				 status & STATUS_CALLBACK ? "Callback " : "",
+				 status & STATUS_WAITING ? "Transferring " : "",
+				 status & STATUS_SLEEPING ? "Sleeping " : "",
+				 status & STATUS_SCHEDULING ? "Scheduling " : "");
+		size_t len = strlen(snapshot);
+		if (len && snapshot[len-1] == ' ')
+			snapshot[len-1] = 0;
+
+#ifdef STARPU_HAVE_POTI
+		char container[STARPU_POTI_STR_LEN];
+		worker_container_alias(container, STARPU_POTI_STR_LEN, options->file_prefix, workerid);
+		poti_NewEvent(get_event_time_stamp(ev, options), container, "worker_snapshot", snapshot);
+#else
+		fprintf(out_paje_file, "9	%.9f	worker_snapshot	%sw%lu	\"%s\"\n", get_event_time_stamp(ev, options), options->file_prefix, workerid, snapshot);
+#endif
+	}
+}
+
 static
 void _starpu_fxt_process_bandwidth(struct starpu_fxt_options *options)
 {
@@ -3863,6 +3896,10 @@ void _starpu_fxt_parse_new_file(char *filename_in, struct starpu_fxt_options *op
 				handle_worker_sleep_end(&ev, options);
 				break;
 
+			case _STARPU_FUT_WORKER_STATUS_SNAPSHOT:
+				handle_worker_status_snapshot(&ev, options);
+				break;
+
 			case _STARPU_FUT_TAG:
 				handle_tag(&ev, options);
 				break;
@@ -326,6 +326,7 @@ void _starpu_fxt_write_paje_header(FILE *file STARPU_ATTRIBUTE_UNUSED, struct st
 	/* Types for the Worker of the Memory Node */
 	poti_DefineEventType("user_event", "P", "user event type");
 	poti_DefineEventType("thread_event", "T", "thread event type");
+	poti_DefineEventType("worker_snapshot", "W", "worker status snapshot");
 	poti_DefineVariableType("gf", "W", "GFlop/s", "0 0 0");
 	poti_DefineStateType("S", "T", "Thread State");
 	poti_DefineEntityValue("I", "S", "Idle", ".9 .1 0");
@@ -462,6 +463,7 @@ void _starpu_fxt_write_paje_header(FILE *file STARPU_ATTRIBUTE_UNUSED, struct st
 2       unregister     P       \"data unregistration\"	\"1.0 1.0 1.0\" 			\n\
 2       user_event   P       \"user event type\"		\"1.0 1.0 1.0\" 		\n\
 2       thread_event   T       \"thread event type\"	\"1.0 1.0 1.0\" 			\n\
+2       worker_snapshot   W       \"worker status snapshot\"	\"1.0 1.0 1.0\" 			\n\
 2       user_user_event   UT       \"user event type\"		\"1.0 1.0 1.0\" 		\n\
 2       user_thread_event   UT       \"thread event type\"	\"1.0 1.0 1.0\" 			\n\
 2       MPIev   MPICt    \"MPI event type\"		\"1.0 1.0 1.0\" 	\n\
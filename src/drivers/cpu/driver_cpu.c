@@ -63,6 +63,10 @@
 #endif
 
 static unsigned already_busy_cpus;
+/* Maximum number of tasks of a STARPU_CODELET_COARSEN codelet executed in a row */
+static unsigned coarsen_max;
+/* Bound for coarsen_max, the tasks are kept on the stack */
+#define COARSEN_MAX_LIMIT 64
 
 static struct _starpu_driver_info driver_info =
 {
@@ -93,6 +97,15 @@ void _starpu_cpu_preinit(void)
 	_starpu_driver_info_register(STARPU_CPU_WORKER, &driver_info);
 	_starpu_memory_driver_info_register(STARPU_CPU_RAM, &memory_driver_info);
 	already_busy_cpus = 0;
+	int max = starpu_getenv_number_default("STARPU_CPU_COARSEN_MAX", 8);
+	if (max < 0)
+		max = 0;
+	if (max > COARSEN_MAX_LIMIT)
+	{
+		_STARPU_DISP("Warning: STARPU_CPU_COARSEN_MAX is limited to %d\n", COARSEN_MAX_LIMIT);
+		max = COARSEN_MAX_LIMIT;
+	}
+	coarsen_max = max;
 }
 
 void _starpu_cpu_busy_cpu(unsigned num)
@@ -568,6 +581,99 @@ static int _starpu_cpu_driver_execute_task(struct _starpu_worker *cpu_worker, st
 	return 0;
 }
 
+/* Whether TASK can be executed by CPU_WORKER in a row with other tasks of the
+ * codelet CL: it has to be a sequential task of this codelet, whose data are
+ * already available on the memory node of the worker, so that executing it
+ * never waits for a transfer */
+static int _starpu_cpu_driver_may_coarsen(struct _starpu_worker *cpu_worker, struct starpu_task *task, struct _starpu_job *j, struct starpu_codelet *cl)
+{
+	unsigned nbuffers, i;
+
+	if (task->cl != cl || j->task_size > 1 || !_STARPU_MAY_PERFORM(j, CPU))
+		return 0;
+#ifdef STARPU_OPENMP
+	if (j->discontinuous)
+		return 0;
+#endif
+
+	nbuffers = STARPU_TASK_GET_NBUFFERS(task);
+	for (i = 0; i < nbuffers; i++)
+	{
+		enum starpu_data_access_mode mode = STARPU_TASK_GET_MODE(task, i);
+		int node = _starpu_task_data_get_node_on_worker(task, i, cpu_worker->workerid);
+
+		/* These use per-worker replicates, keep it simple */
+		if (mode & (STARPU_SCRATCH|STARPU_REDUX))
+			return 0;
+		if (node >= 0 && (mode & STARPU_R) && !starpu_data_is_on_node_excluding_prefetch(STARPU_TASK_GET_HANDLE(task, i), node))
+			return 0;
+	}
+	return 1;
+}
+
+/* Execute TASK along the following ready tasks of the same codelet, up to
+ * coarsen_max of them: they are popped in only one scheduling operation, their
+ * data are fetched in one pass, and they are executed back to back without
+ * going through the driver loop in between. The first task which can not be
+ * coarsened has already been popped, it is returned in *NEXT_TASK so that the
+ * caller executes it as usual. */
+static int _starpu_cpu_driver_execute_coarsened(struct _starpu_worker *cpu_worker, struct starpu_task *task, struct _starpu_job *j, struct starpu_task **next_taskp)
+{
+	struct starpu_task *tasks[COARSEN_MAX_LIMIT];
+	struct _starpu_job *jobs[COARSEN_MAX_LIMIT];
+	unsigned ntasks = 1, i;
+	int res;
+
+	STARPU_ASSERT(coarsen_max <= COARSEN_MAX_LIMIT);
+	tasks[0] = task;
+	jobs[0] = j;
+	*next_taskp = NULL;
+
+	STARPU_PTHREAD_MUTEX_LOCK_SCHED(&cpu_worker->sched_mutex);
+	_starpu_worker_enter_sched_op(cpu_worker);
+	STARPU_PTHREAD_MUTEX_UNLOCK_SCHED(&cpu_worker->sched_mutex);
+	while (ntasks < coarsen_max)
+	{
+		struct starpu_task *next_task = _starpu_pop_task(cpu_worker);
+		if (!next_task)
+			break;
+
+		struct _starpu_job *next_j = _starpu_get_job_associated_to_task(next_task);
+		STARPU_AYU_PRERUNTASK(next_j->job_id, cpu_worker->workerid);
+		if (!_starpu_cpu_driver_may_coarsen(cpu_worker, next_task, next_j, task->cl))
+		{
+			/* The pop hooks were already called for it, let the
+			 * caller execute it rather than pushing it again */
+			*next_taskp = next_task;
+			break;
+		}
+
+		tasks[ntasks] = next_task;
+		jobs[ntasks] = next_j;
+		ntasks++;
+	}
+	STARPU_PTHREAD_MUTEX_LOCK_SCHED(&cpu_worker->sched_mutex);
+	_starpu_worker_leave_sched_op(cpu_worker);
+	STARPU_PTHREAD_COND_BROADCAST(&cpu_worker->sched_cond);
+	STARPU_PTHREAD_MUTEX_UNLOCK_SCHED(&cpu_worker->sched_mutex);
+
+	/* The data are already there, so this does not wait for transfers */
+	for (i = 0; i < ntasks; i++)
+	{
+		res = _starpu_fetch_task_input(tasks[i], jobs[i], 0);
+		STARPU_ASSERT(res == 0);
+	}
+
+	for (i = 0; i < ntasks; i++)
+	{
+		cpu_worker->current_rank = 0;
+		res = _starpu_cpu_driver_execute_task(cpu_worker, tasks[i], jobs[i]);
+		STARPU_ASSERT(res == 0);
+	}
+
+	return 0;
+}
+
 /* One iteration of the main driver loop */
 int _starpu_cpu_driver_run_once(struct _starpu_worker *cpu_worker)
 {
@@ -665,6 +771,7 @@ int _starpu_cpu_driver_run_once(struct _starpu_worker *cpu_worker)
 	starpu_prof_tool_callbacks.starpu_prof_tool_event_end_transfer(&pi, NULL, NULL);
 #endif
 	_STARPU_TRACE_END_PROGRESS(memnode);
+execute:
 	/* Get the rank in case it is a parallel task */
 	if (j->task_size > 1)
 	{
@@ -685,7 +792,28 @@ int _starpu_cpu_driver_run_once(struct _starpu_worker *cpu_worker)
 #else
 	const unsigned continuation_wake_up = 0;
 #endif
-	if (rank == 0 && !continuation_wake_up)
+	if (rank == 0 && !continuation_wake_up && coarsen_max > 1
+		&& (task->cl->flags & STARPU_CODELET_COARSEN)
+		/* Keep executing ordered tasks one at a time */
+		&& !cpu_worker->local_ordered_tasks_size
+		&& _starpu_cpu_driver_may_coarsen(cpu_worker, task, j, task->cl))
+	{
+		struct starpu_task *next_task;
+		int ret = _starpu_cpu_driver_execute_coarsened(cpu_worker, task, j, &next_task);
+		if (next_task)
+		{
+			/* It was popped but could not be coarsened, proceed with it
+			 * in this iteration */
+			task = next_task;
+			j = _starpu_get_job_associated_to_task(task);
+			if (_STARPU_MAY_PERFORM(j, CPU))
+				goto execute;
+			_starpu_push_task_to_workers(task);
+		}
+		_STARPU_TRACE_START_PROGRESS(memnode);
+		return ret;
+	}
+	else if (rank == 0 && !continuation_wake_up)
 	{
 		res = _starpu_fetch_task_input(task, j, 1);
 		STARPU_ASSERT(res == 0);
@@ -784,4 +912,8 @@ struct _starpu_node_ops _starpu_driver_cpu_node_ops =
 	.map[STARPU_CPU_RAM] = _starpu_cpu_map,
 	.unmap[STARPU_CPU_RAM] = _starpu_cpu_unmap,
 	.update_map[STARPU_CPU_RAM] = _starpu_cpu_update_map,
+
+	.map[STARPU_DISK_RAM] = _starpu_disk_map_cpu,
+	.unmap[STARPU_DISK_RAM] = _starpu_disk_unmap_cpu,
+	.update_map[STARPU_DISK_RAM] = _starpu_disk_update_map_cpu,
 };
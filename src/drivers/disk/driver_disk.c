@@ -238,6 +238,32 @@ int _starpu_disk_copy_data_from_cpu_to_disk(uintptr_t src, size_t src_offset, in
 					     size, async_channel);
 }
 
+uintptr_t _starpu_disk_map_cpu(uintptr_t src, size_t src_offset, unsigned src_node, unsigned dst_node, size_t size, int *ret)
+{
+	(void) dst_node;
+
+	void *ptr = _starpu_disk_map(starpu_memory_node_get_devid(src_node), (void *) src, src_offset, size);
+	*ret = ptr ? 0 : -EIO;
+	return (uintptr_t) ptr;
+}
+
+int _starpu_disk_unmap_cpu(uintptr_t src, size_t src_offset, unsigned src_node, uintptr_t dst, unsigned dst_node, size_t size)
+{
+	(void) dst_node;
+
+	_starpu_disk_unmap(starpu_memory_node_get_devid(src_node), (void *) src, (void *) dst, src_offset, size);
+	return 0;
+}
+
+int _starpu_disk_update_map_cpu(uintptr_t src, size_t src_offset, unsigned src_node, uintptr_t dst, size_t dst_offset, unsigned dst_node, size_t size)
+{
+	/* The mapping is shared with the disk, this only needs to write back dirty pages */
+	if (starpu_node_get_kind(src_node) == STARPU_DISK_RAM)
+		return _starpu_disk_sync(starpu_memory_node_get_devid(src_node), (void *) src, (void *) dst, src_offset, size);
+	else
+		return _starpu_disk_sync(starpu_memory_node_get_devid(dst_node), (void *) dst, (void *) src, dst_offset, size);
+}
+
 int _starpu_disk_is_direct_access_supported(unsigned node, unsigned handling_node)
 {
 	/* Each worker can manage disks but disk <-> disk is not always allowed */
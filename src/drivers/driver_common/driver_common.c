@@ -69,7 +69,9 @@ void _starpu_driver_start_job(struct _starpu_worker *worker, struct _starpu_job
 	struct timespec start;
 
 	struct starpu_profiling_task_info *profiling_info = task->profiling_info;
-	if ((profiling && profiling_info) || (rank == 0 && (calibrate_model || !_starpu_perf_counter_paused())))
+	if (rank == 0)
+		worker->cl_timed = _starpu_perf_counter_timed();
+	if ((profiling && profiling_info) || (rank == 0 && (calibrate_model || worker->cl_timed)))
 		_starpu_clock_gettime(&start);
 	_starpu_add_worker_status(worker, STATUS_INDEX_EXECUTING, &start);
 
@@ -78,11 +80,11 @@ void _starpu_driver_start_job(struct _starpu_worker *worker, struct _starpu_job
 		STARPU_ASSERT(task->status == STARPU_TASK_READY);
 		if (!_starpu_perf_counter_paused() && !j->internal)
 		{
-			(void)STARPU_PERF_COUNTER_ADD64(& _starpu_task__g_current_ready__value, -1);
+			_starpu_perf_counter_current_add(&_starpu_task__g_current.current_ready, &_starpu_task__g_current.peak_ready, -1);
 			if (task->cl && task->cl->perf_counter_values)
 			{
 				struct starpu_perf_counter_sample_cl_values * const pcv = task->cl->perf_counter_values;
-				(void)STARPU_PERF_COUNTER_ADD64(&pcv->task.current_ready, -1);
+				_starpu_perf_counter_current_add(&pcv->task.current_ready, &pcv->task.peak_ready, -1);
 			}
 		}
 		task->status = STARPU_TASK_RUNNING;
@@ -91,7 +93,7 @@ void _starpu_driver_start_job(struct _starpu_worker *worker, struct _starpu_job
 		if (_starpu_codelet_profiling)
 			cl->per_worker_stats[workerid]++;
 
-		if ((profiling && profiling_info) || calibrate_model || !_starpu_perf_counter_paused())
+		if ((profiling && profiling_info) || calibrate_model || worker->cl_timed)
 		{
 			worker->cl_start = start;
 			if (profiling && profiling_info)
@@ -188,13 +190,13 @@ void _starpu_driver_end_job(struct _starpu_worker *worker, struct _starpu_job *j
 
 	struct timespec end;
 	struct starpu_profiling_task_info *profiling_info = task->profiling_info;
-	if ((profiling && profiling_info) || (rank == 0 && (calibrate_model || !_starpu_perf_counter_paused())))
+	if ((profiling && profiling_info) || (rank == 0 && (calibrate_model || worker->cl_timed)))
 		_starpu_clock_gettime(&end);
 	_starpu_clear_worker_status(worker, STATUS_INDEX_EXECUTING, &end);
 
 	if (rank == 0)
 	{
-		if ((profiling && profiling_info) || calibrate_model || !_starpu_perf_counter_paused())
+		if ((profiling && profiling_info) || calibrate_model || worker->cl_timed)
 			worker->cl_end = end;
 		STARPU_AYU_POSTRUNTASK(j->job_id);
 	}
@@ -239,25 +241,19 @@ void _starpu_driver_update_job_feedback(struct _starpu_job *j, struct _starpu_wo
 		calibrate_model = 1;
 #endif
 
-	if ((profiling && profiling_info) || calibrate_model || !_starpu_perf_counter_paused())
+	if ((profiling && profiling_info) || calibrate_model || worker->cl_timed)
 	{
 		starpu_timespec_sub(&worker->cl_end, &worker->cl_start, &measured_ts);
 		double measured = starpu_timing_timespec_to_us(&measured_ts);
 
 		STARPU_ASSERT_MSG(measured >= 0, "measured=%lf\n", measured);
 
-		if (!_starpu_perf_counter_paused())
+		if (worker->cl_timed)
 		{
-			worker->__w_total_executed__value++;
 			worker->__w_cumul_execution_time__value += measured;
-			_starpu_perf_counter_update_per_worker_sample(worker->workerid);
 			if (cl->perf_counter_values)
-			{
-				struct starpu_perf_counter_sample_cl_values * const pcv = cl->perf_counter_values;
-				(void)STARPU_PERF_COUNTER_ADD64(&pcv->task.total_executed, 1);
-				_starpu_perf_counter_update_acc_double(&pcv->task.cumul_execution_time, measured);
-				_starpu_perf_counter_update_per_codelet_sample(cl);
-			}
+				/* Only the executing worker updates its own shard */
+				STARPU_PERF_COUNTER_SHARD_ACC_DOUBLE(&cl->perf_counter_values->shards[workerid].cumul_execution_time, measured);
 		}
 
 		if (profiling && profiling_info)
@@ -312,6 +308,18 @@ void _starpu_driver_update_job_feedback(struct _starpu_job *j, struct _starpu_wo
 		}
 	}
 
+	if (!_starpu_perf_counter_paused())
+	{
+		worker->__w_total_executed__value++;
+		_starpu_perf_counter_update_per_worker_sample(workerid);
+		if (cl->perf_counter_values)
+		{
+			/* Only the executing worker updates its own shard */
+			STARPU_PERF_COUNTER_SHARD_ADD(&cl->perf_counter_values->shards[workerid].total_executed, 1, 0);
+			_starpu_perf_counter_update_per_codelet_sample(cl);
+		}
+	}
+
 	if (!updated)
 		_starpu_worker_update_profiling_info_executing(workerid, 1, 0, 0, 0, 0);
 
@@ -741,20 +749,20 @@ struct map_allocate_info
 };
 
 /* the cmp_fn arg for rb_tree_insert() */
-static unsigned int map_addr_cmp_insert(struct starpu_rbtree_node * left_elm, struct starpu_rbtree_node * right_elm)
+static int map_addr_cmp_insert(struct starpu_rbtree_node * left_elm, struct starpu_rbtree_node * right_elm)
 {
-	unsigned int addr_left = (uintptr_t)((struct map_allocate_info *) left_elm)->map_addr;
-	unsigned int addr_right = (uintptr_t)((struct map_allocate_info *) right_elm)->map_addr;
+	uintptr_t addr_left = (uintptr_t)((struct map_allocate_info *) left_elm)->map_addr;
+	uintptr_t addr_right = (uintptr_t)((struct map_allocate_info *) right_elm)->map_addr;
 
-	return addr_left - addr_right;
+	return addr_left < addr_right ? -1 : addr_left > addr_right ? 1 : 0;
 }
 
 /* the cmp_fn arg for starpu_rbtree_lookup() */
-static unsigned int map_addr_cmp_lookup(uintptr_t addr_left, struct starpu_rbtree_node * right_elm)
+static int map_addr_cmp_lookup(uintptr_t addr_left, struct starpu_rbtree_node * right_elm)
 {
-	unsigned int addr_right = (uintptr_t)((struct map_allocate_info *) right_elm)->map_addr;
+	uintptr_t addr_right = (uintptr_t)((struct map_allocate_info *) right_elm)->map_addr;
 
-	return addr_left - addr_right;
+	return addr_left < addr_right ? -1 : addr_left > addr_right ? 1 : 0;
 }
 
 void *_starpu_map_allocate(size_t length, unsigned node)
@@ -786,13 +794,29 @@ void *_starpu_map_allocate(size_t length, unsigned node)
 	{
 		perror("fail to allocate room for mapping");
 		close(fd);
+		shm_unlink(fd_name);
+		return NULL;
+	}
+#ifdef HAVE_POSIX_FALLOCATE
+	/* ftruncate does not reserve anything on tmpfs, accessing the mapping
+	 * would then get a SIGBUS when /dev/shm gets full, rather make the
+	 * allocation fail now */
+	ret = posix_fallocate(fd, 0, length);
+	if (ret != 0)
+	{
+		errno = ret;
+		perror("fail to reserve room for mapping");
+		close(fd);
+		shm_unlink(fd_name);
 		return NULL;
 	}
+#endif
 	void* map_addr = mmap(NULL, length, PROT_READ|PROT_WRITE, MAP_SHARED, fd, 0);
 	close(fd);
 	if (map_addr == MAP_FAILED)
 	{
 		perror("fail to map");
+		shm_unlink(fd_name);
 		return NULL;
 	}
 
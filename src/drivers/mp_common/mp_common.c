@@ -41,6 +41,8 @@ const char *_starpu_mp_common_command_to_string(const enum _starpu_mp_command co
 			return "EXECUTE";
 		case STARPU_MP_COMMAND_EXECUTE_DETACHED:
 			return "EXECUTE_DETACHED";
+		case STARPU_MP_COMMAND_EXECUTE_BATCH:
+			return "EXECUTE_BATCH";
 		case STARPU_MP_COMMAND_SINK_NBCORES:
 			return "SINK_NBCORES";
 		case STARPU_MP_COMMAND_LOOKUP:
@@ -55,6 +57,10 @@ const char *_starpu_mp_common_command_to_string(const enum _starpu_mp_command co
 			return "UNMAP";
 		case STARPU_MP_COMMAND_SYNC_WORKERS:
 			return "SYNC_WORKERS";
+		case STARPU_MP_COMMAND_ALLOCATE_SHARED:
+			return "ALLOCATE_SHARED";
+		case STARPU_MP_COMMAND_FREE_SHARED:
+			return "FREE_SHARED";
 
 		/* Note: synchronous send */
 		case STARPU_MP_COMMAND_RECV_FROM_HOST:
@@ -89,6 +95,8 @@ const char *_starpu_mp_common_command_to_string(const enum _starpu_mp_command co
 			return "ANSWER_ALLOCATE";
 		case STARPU_MP_COMMAND_ERROR_ALLOCATE:
 			return "ERROR_ALLOCATE";
+		case STARPU_MP_COMMAND_ANSWER_ALLOCATE_SHARED:
+			return "ANSWER_ALLOCATE_SHARED";
 		case STARPU_MP_COMMAND_ANSWER_MAP:
 			return "ANSWER_MAP";
 		case STARPU_MP_COMMAND_ERROR_MAP:
@@ -154,6 +162,10 @@ _starpu_mp_common_node_create(enum _starpu_mp_node_kind node_kind,
 
 	node->peer_id = peer_id;
 
+	node->shared_memory = 0;
+	starpu_rbtree_init(&node->shared_tree);
+	STARPU_PTHREAD_MUTEX_INIT(&node->shared_mutex, NULL);
+
 	switch(node->kind)
 	{
 #ifdef STARPU_USE_MPI_MASTER_SLAVE
@@ -174,12 +186,14 @@ _starpu_mp_common_node_create(enum _starpu_mp_node_kind node_kind,
 			node->mp_recv_is_ready = _starpu_mpi_common_recv_is_ready;
 			node->mp_send = _starpu_mpi_common_mp_send;
 			node->mp_recv = _starpu_mpi_common_mp_recv;
+			node->mp_sendv = NULL;
 			node->nt_recv_is_ready = _starpu_mpi_common_notif_recv_is_ready;
 			node->nt_send_is_ready = _starpu_mpi_common_notif_send_is_ready;
 			node->mp_wait = NULL;
 			node->mp_signal = NULL;
 			node->nt_send = _starpu_mpi_common_nt_send;
 			node->nt_recv = _starpu_mpi_common_nt_recv;
+			node->nt_sendv = NULL;
 			node->dt_send = _starpu_mpi_common_send;
 			node->dt_recv = _starpu_mpi_common_recv;
 			node->dt_send_to_device = _starpu_mpi_common_send_to_device;
@@ -212,12 +226,14 @@ _starpu_mp_common_node_create(enum _starpu_mp_node_kind node_kind,
 			node->mp_recv_is_ready = _starpu_mpi_common_recv_is_ready;
 			node->mp_send = _starpu_mpi_common_mp_send;
 			node->mp_recv = _starpu_mpi_common_mp_recv;
+			node->mp_sendv = NULL;
 			node->nt_recv_is_ready = _starpu_mpi_common_notif_recv_is_ready;
 			node->nt_send_is_ready = _starpu_mpi_common_notif_send_is_ready;
 			node->mp_wait = NULL;
 			node->mp_signal = NULL;
 			node->nt_send = _starpu_mpi_common_nt_send;
 			node->nt_recv = _starpu_mpi_common_nt_recv;
+			node->nt_sendv = NULL;
 			node->dt_send = _starpu_mpi_common_send;
 			node->dt_recv = _starpu_mpi_common_recv;
 			node->dt_send_to_device = _starpu_mpi_common_send_to_device;
@@ -256,12 +272,14 @@ _starpu_mp_common_node_create(enum _starpu_mp_node_kind node_kind,
 			node->mp_recv_is_ready = _starpu_tcpip_common_recv_is_ready;
 			node->mp_send = _starpu_tcpip_common_mp_send;
 			node->mp_recv = _starpu_tcpip_common_mp_recv;
+			node->mp_sendv = _starpu_tcpip_common_mp_sendv;
 			node->nt_recv_is_ready = _starpu_tcpip_common_notif_recv_is_ready;
 			node->nt_send_is_ready = _starpu_tcpip_common_notif_send_is_ready;
 			node->mp_wait = _starpu_tcpip_common_wait;
 			node->mp_signal = _starpu_tcpip_common_signal;
 			node->nt_send = _starpu_tcpip_common_nt_send;
 			node->nt_recv = _starpu_tcpip_common_nt_recv;
+			node->nt_sendv = _starpu_tcpip_common_nt_sendv;
 			node->dt_send = _starpu_tcpip_common_send;
 			node->dt_recv = _starpu_tcpip_common_recv;
 			node->dt_send_to_device = _starpu_tcpip_common_send_to_device;
@@ -294,12 +312,14 @@ _starpu_mp_common_node_create(enum _starpu_mp_node_kind node_kind,
 			node->mp_recv_is_ready = _starpu_tcpip_common_recv_is_ready;
 			node->mp_send = _starpu_tcpip_common_mp_send;
 			node->mp_recv = _starpu_tcpip_common_mp_recv;
+			node->mp_sendv = _starpu_tcpip_common_mp_sendv;
 			node->nt_recv_is_ready = _starpu_tcpip_common_notif_recv_is_ready;
 			node->nt_send_is_ready = _starpu_tcpip_common_notif_send_is_ready;
 			node->mp_wait = _starpu_tcpip_common_wait;
 			node->mp_signal = _starpu_tcpip_common_signal;
 			node->nt_send = _starpu_tcpip_common_nt_send;
 			node->nt_recv = _starpu_tcpip_common_nt_recv;
+			node->nt_sendv = _starpu_tcpip_common_nt_sendv;
 			node->dt_send = _starpu_tcpip_common_send;
 			node->dt_recv = _starpu_tcpip_common_recv;
 			node->dt_send_to_device = _starpu_tcpip_common_send_to_device;
@@ -344,13 +364,14 @@ _starpu_mp_common_node_create(enum _starpu_mp_node_kind node_kind,
 		int i;
 		STARPU_HG_DISABLE_CHECKING(node->is_running);
 		node->is_running = 1;
-		_STARPU_MALLOC(node->run_table, sizeof(struct mp_task *)*node->nb_cores);
+		_STARPU_CALLOC(node->run_table, node->nb_cores*STARPU_MAX_PIPELINE, sizeof(struct mp_task *));
+		_STARPU_CALLOC(node->run_table_first, node->nb_cores, sizeof(unsigned));
+		_STARPU_CALLOC(node->run_table_last, node->nb_cores, sizeof(unsigned));
 		_STARPU_MALLOC(node->run_table_detached, sizeof(struct mp_task *)*node->nb_cores);
 		_STARPU_MALLOC(node->sem_run_table, sizeof(sem_t)*node->nb_cores);
 
 		for(i=0; i<node->nb_cores; i++)
 		{
-			node->run_table[i] = NULL;
 			node->run_table_detached[i] = NULL;
 			sem_init(&node->sem_run_table[i],0,0);
 		}
@@ -372,6 +393,12 @@ void _starpu_mp_common_node_destroy(struct _starpu_mp_node *node)
 
 	STARPU_PTHREAD_MUTEX_DESTROY(&node->message_queue_mutex);
 
+	/* The host may not have freed all the data allocated on the sink */
+	if (node->kind == STARPU_NODE_MPI_SOURCE || node->kind == STARPU_NODE_TCPIP_SOURCE)
+		_starpu_src_common_release_shared(node);
+	STARPU_ASSERT(starpu_rbtree_empty(&node->shared_tree));
+	STARPU_PTHREAD_MUTEX_DESTROY(&node->shared_mutex);
+
 	/* If the node is a sink then we must destroy some field */
 	if(node->kind == STARPU_NODE_MPI_SINK || node->kind == STARPU_NODE_TCPIP_SINK)
 	{
@@ -382,6 +409,8 @@ void _starpu_mp_common_node_destroy(struct _starpu_mp_node *node)
 		}
 
 		free(node->run_table);
+		free(node->run_table_first);
+		free(node->run_table_last);
 		free(node->run_table_detached);
 		free(node->sem_run_table);
 
@@ -408,6 +437,22 @@ static void __starpu_mp_common_send_command(const struct _starpu_mp_node *node,
 	memcpy(node->buffer, &command, command_size);
 	memcpy((void*) ((uintptr_t)node->buffer + command_size), &arg_size, arg_size_size);
 
+	if (arg_size && (notif ? node->nt_sendv : node->mp_sendv))
+	{
+		/* Send the command along its argument at once */
+		struct iovec iov[2] =
+		{
+			{ .iov_base = node->buffer, .iov_len = command_size + arg_size_size },
+			{ .iov_base = arg, .iov_len = arg_size },
+		};
+
+		if (!notif)
+			node->mp_sendv(node, iov, 2);
+		else
+			node->nt_sendv(node, iov, 2);
+		return;
+	}
+
 	if (!notif)
 		node->mp_send(node, node->buffer, command_size + arg_size_size);
 	else
@@ -21,10 +21,12 @@
 /** @file */
 
 #include <semaphore.h>
+#include <sys/uio.h>
 
 #include <starpu.h>
 #include <common/config.h>
 #include <common/list.h>
+#include <common/rbtree.h>
 #include <common/barrier.h>
 #include <common/thread.h>
 #include <datawizard/interfaces/data_interface.h>
@@ -48,6 +50,7 @@ enum _starpu_mp_command
 	STARPU_MP_COMMAND_EXIT,
 	STARPU_MP_COMMAND_EXECUTE,
 	STARPU_MP_COMMAND_EXECUTE_DETACHED,
+	STARPU_MP_COMMAND_EXECUTE_BATCH,
 	STARPU_MP_COMMAND_SINK_NBCORES,
 	STARPU_MP_COMMAND_LOOKUP,
 	STARPU_MP_COMMAND_ALLOCATE,
@@ -55,6 +58,8 @@ enum _starpu_mp_command
 	STARPU_MP_COMMAND_MAP,
 	STARPU_MP_COMMAND_UNMAP,
 	STARPU_MP_COMMAND_SYNC_WORKERS,
+	STARPU_MP_COMMAND_ALLOCATE_SHARED,
+	STARPU_MP_COMMAND_FREE_SHARED,
 
 	/* Note: synchronous send */
 	STARPU_MP_COMMAND_RECV_FROM_HOST,
@@ -75,6 +80,7 @@ enum _starpu_mp_command
 	STARPU_MP_COMMAND_ERROR_LOOKUP,
 	STARPU_MP_COMMAND_ANSWER_ALLOCATE,
 	STARPU_MP_COMMAND_ERROR_ALLOCATE,
+	STARPU_MP_COMMAND_ANSWER_ALLOCATE_SHARED,
 	STARPU_MP_COMMAND_ANSWER_MAP,
 	STARPU_MP_COMMAND_ERROR_MAP,
 	STARPU_MP_COMMAND_ANSWER_TRANSFER_COMPLETE,
@@ -147,6 +153,14 @@ struct _starpu_mp_transfer_unmap_command
 	size_t size;
 };
 
+/** Answer to STARPU_MP_COMMAND_ALLOCATE_SHARED: the address of the allocation
+ * on the sink, and the name of the shared memory segment holding it */
+struct _starpu_mp_transfer_allocate_shared_answer
+{
+	uintptr_t addr;
+	char fd_name[];
+};
+
 LIST_TYPE(mp_barrier,
 		int id;
 		starpu_pthread_barrier_t before_work_barrier;
@@ -209,6 +223,15 @@ struct _starpu_mp_node
 	 */
 	int peer_id;
 
+	/** For host : whether the sink runs on the same machine. Its
+	 * allocations are then made in shared memory segments which the host
+	 * maps too, so that data transfers boil down to memcpy */
+	int shared_memory;
+	/** For host : the sink allocations mapped by the host, sorted by
+	 * their address on the sink */
+	struct starpu_rbtree shared_tree;
+	starpu_pthread_mutex_t shared_mutex;
+
 	/** Connection used for command passing between the host thread and the
 	 * sink it controls */
 	union _starpu_mp_connection mp_connection;
@@ -240,7 +263,12 @@ struct _starpu_mp_node
 	starpu_pthread_mutex_t barrier_mutex;
 
 	/*table where worker comme pick task*/
+	/** For each core, a ring of up to STARPU_MAX_PIPELINE tasks queued by the
+	 * source: the main thread adds them at run_table_last, and the thread of the
+	 * core executes them from run_table_first */
 	struct mp_task ** run_table;
+	unsigned * run_table_first;
+	unsigned * run_table_last;
 	struct mp_task ** run_table_detached;
 	sem_t * sem_run_table;
 
@@ -254,12 +282,17 @@ struct _starpu_mp_node
 	int (*mp_recv_is_ready) (const struct _starpu_mp_node *);
 	void (*mp_send)		(const struct _starpu_mp_node *, void *, int);
 	void (*mp_recv)		(const struct _starpu_mp_node *, void *, int);
+	/** Optional, send several buffers at once, which the peer can receive
+	 * with separate mp_recv calls */
+	void (*mp_sendv)	(const struct _starpu_mp_node *, struct iovec *, int);
 
 	/** Notifications */
 	int (*nt_recv_is_ready) (const struct _starpu_mp_node *);
 	int (*nt_send_is_ready) (const struct _starpu_mp_node *);
 	void (*nt_send)		(const struct _starpu_mp_node *, void *, int);
 	void (*nt_recv)		(const struct _starpu_mp_node *, void *, int);
+	/** Optional, same as mp_sendv for notifications */
+	void (*nt_sendv)	(const struct _starpu_mp_node *, struct iovec *, int);
 
 	/*signal*/
 	void (*mp_wait)		   (struct _starpu_mp_node *);
@@ -111,6 +111,55 @@ void _starpu_sink_common_free(const struct _starpu_mp_node *mp_node STARPU_ATTRI
 	free(*(void **)(arg));
 }
 
+/* Allocate a memory space in a shared memory segment, which the host can map
+ * when it is running on the same machine, and send its address and the name of
+ * the segment to the host.
+ */
+static void _starpu_sink_common_allocate_shared(const struct _starpu_mp_node *mp_node, void *arg, int arg_size)
+{
+	STARPU_ASSERT(arg_size == sizeof(size_t));
+
+#ifdef HAVE_MMAP
+	size_t size = *(size_t *)(arg);
+	void *addr = _starpu_map_allocate(size, STARPU_MAIN_RAM);
+
+	if (addr)
+	{
+		size_t offset;
+		char *fd_name = _starpu_get_fdname_from_mapaddr((uintptr_t) addr, &offset, size);
+		STARPU_ASSERT(fd_name && offset == 0);
+
+		int answer_size = sizeof(struct _starpu_mp_transfer_allocate_shared_answer)+strlen(fd_name)+1;
+		struct _starpu_mp_transfer_allocate_shared_answer *answer;
+		_STARPU_MALLOC(answer, answer_size);
+		answer->addr = (uintptr_t) addr;
+		memcpy(answer->fd_name, fd_name, strlen(fd_name)+1);
+		free(fd_name);
+
+		_starpu_mp_common_send_command(mp_node, STARPU_MP_COMMAND_ANSWER_ALLOCATE_SHARED, answer, answer_size);
+		free(answer);
+		return;
+	}
+#endif
+
+	/* We could not get a shared memory segment, fall back to a normal allocation */
+	mp_node->allocate(mp_node, arg, arg_size);
+}
+
+static void _starpu_sink_common_free_shared(const struct _starpu_mp_node *mp_node STARPU_ATTRIBUTE_UNUSED, void *arg, int arg_size)
+{
+	STARPU_ASSERT(arg_size == sizeof(struct _starpu_mp_transfer_unmap_command));
+
+#ifdef HAVE_MMAP
+	struct _starpu_mp_transfer_unmap_command *free_cmd = (struct _starpu_mp_transfer_unmap_command *)arg;
+
+	_starpu_map_deallocate((void *) free_cmd->addr, free_cmd->size);
+#else
+	(void) arg;
+	STARPU_ABORT();
+#endif
+}
+
 /* Map a memory space and send the address of this space to the host
  */
 void _starpu_sink_common_map(const struct _starpu_mp_node *mp_node, void *arg, int arg_size)
@@ -353,6 +402,8 @@ static void _starpu_sink_common_recv_workers(struct _starpu_mp_node * node, void
 	STARPU_PTHREAD_BARRIER_WAIT(&node->init_completed_barrier);
 }
 
+static void _starpu_sink_common_execute_batch(struct _starpu_mp_node *node, void *arg, int arg_size);
+
 /* Function looping on the sink, waiting for tasks to execute.
  * If the caller is the host, don't do anything.
  */
@@ -393,6 +444,9 @@ void _starpu_sink_common_worker(void)
 				case STARPU_MP_COMMAND_EXECUTE:
 					node->execute(node, arg, arg_size);
 					break;
+				case STARPU_MP_COMMAND_EXECUTE_BATCH:
+					_starpu_sink_common_execute_batch(node, arg, arg_size);
+					break;
 				case STARPU_MP_COMMAND_SINK_NBCORES:
 					_starpu_sink_common_get_nb_cores(node);
 					break;
@@ -408,6 +462,14 @@ void _starpu_sink_common_worker(void)
 					node->free(node, arg, arg_size);
 					break;
 
+				case STARPU_MP_COMMAND_ALLOCATE_SHARED:
+					_starpu_sink_common_allocate_shared(node, arg, arg_size);
+					break;
+
+				case STARPU_MP_COMMAND_FREE_SHARED:
+					_starpu_sink_common_free_shared(node, arg, arg_size);
+					break;
+
 				case STARPU_MP_COMMAND_MAP:
 					node->map(node, arg, arg_size);
 					break;
@@ -663,7 +725,7 @@ static void _starpu_sink_common_execute_kernel(struct _starpu_mp_node *node, int
 	if (detached)
 		task = node->run_table_detached[coreid];
 	else
-		task = node->run_table[coreid];
+		task = node->run_table[coreid*STARPU_MAX_PIPELINE + node->run_table_first[coreid]];
 
 	/* If it's a parallel task */
 	if(task->is_parallel_task)
@@ -744,7 +806,10 @@ static void _starpu_sink_common_execute_kernel(struct _starpu_mp_node *node, int
 	if (detached)
 		node->run_table_detached[coreid] = NULL;
 	else
-		node->run_table[coreid] = NULL;
+	{
+		node->run_table[coreid*STARPU_MAX_PIPELINE + node->run_table_first[coreid]] = NULL;
+		node->run_table_first[coreid] = (node->run_table_first[coreid] + 1) % STARPU_MAX_PIPELINE;
+	}
 
 	/* tell the sink that the execution is completed */
 	_starpu_sink_common_execution_completed_message(node,task);
@@ -794,11 +859,13 @@ void* _starpu_sink_thread(void * thread_arg)
 		/*Wait there is a task available */
 		sem_wait(&node->sem_run_table[coreid]);
 
-		STARPU_ASSERT((node->run_table_detached[coreid]!=NULL) || (node->run_table[coreid]!=NULL) || node->is_running==0);
+		struct mp_task *next_task = node->run_table[coreid*STARPU_MAX_PIPELINE + node->run_table_first[coreid]];
+
+		STARPU_ASSERT((node->run_table_detached[coreid]!=NULL) || (next_task!=NULL) || node->is_running==0);
 
 		if (node->run_table_detached[coreid] != NULL)
 			_starpu_sink_common_execute_kernel(node, coreid, worker, 1);
-		else if (node->run_table[coreid] != NULL)
+		else if (next_task != NULL)
 			_starpu_sink_common_execute_kernel(node, coreid, worker, 0);
 		else
 			STARPU_ASSERT(!node->is_running);
@@ -820,8 +887,11 @@ static void _starpu_sink_common_execute_thread(struct _starpu_mp_node *node, str
 	}
 	else
 	{
-		STARPU_ASSERT(!node->run_table[task->coreid]);
-		node->run_table[task->coreid] = task;
+		/* The source does not send more tasks than the pipeline can hold */
+		struct mp_task **slot = &node->run_table[task->coreid*STARPU_MAX_PIPELINE + node->run_table_last[task->coreid]];
+		STARPU_ASSERT(!*slot);
+		*slot = task;
+		node->run_table_last[task->coreid] = (node->run_table_last[task->coreid] + 1) % STARPU_MAX_PIPELINE;
 	}
 	/* Unlock the mutex to wake up the thread which will execute the task */
 	sem_post(&node->sem_run_table[task->coreid]);
@@ -834,7 +904,7 @@ static void _starpu_sink_common_execute_thread(struct _starpu_mp_node *node, str
  * addresses of the received interfaces
  */
 
-void _starpu_sink_common_execute(struct _starpu_mp_node *node, void *arg, int arg_size)
+static struct mp_task *_starpu_sink_common_unpack_task(struct _starpu_mp_node *node, void *arg, int arg_size)
 {
 	unsigned i;
 
@@ -913,6 +983,13 @@ void _starpu_sink_common_execute(struct _starpu_mp_node *node, void *arg, int ar
 	else
 		task->cl_arg = NULL;
 
+	return task;
+}
+
+void _starpu_sink_common_execute(struct _starpu_mp_node *node, void *arg, int arg_size)
+{
+	struct mp_task *task = _starpu_sink_common_unpack_task(node, arg, arg_size);
+
 	//_STARPU_DEBUG("telling host that we have submitted the task %p.\n", task->kernel);
 	if (task->detached)
 		_starpu_mp_common_send_command(node, STARPU_MP_COMMAND_ANSWER_EXECUTION_DETACHED_SUBMITTED, NULL, 0);
@@ -922,3 +999,33 @@ void _starpu_sink_common_execute(struct _starpu_mp_node *node, void *arg, int ar
 	//_STARPU_DEBUG("executing the task %p\n", task->kernel);
 	_starpu_sink_common_execute_thread(node, task);
 }
+
+/* Receive a batch of tasks from _starpu_src_common_execute_jobs in the form
+ * below :
+ * [number of tasks, (size, task)*]
+ * where each task is in the form received by _starpu_sink_common_execute
+ */
+static void _starpu_sink_common_execute_batch(struct _starpu_mp_node *node, void *arg, int arg_size)
+{
+	uintptr_t arg_ptr = (uintptr_t) arg;
+	unsigned ntasks, i;
+
+	ntasks = *(unsigned *) arg_ptr;
+	arg_ptr += sizeof(ntasks);
+
+	struct mp_task *tasks[ntasks];
+	for (i = 0; i < ntasks; i++)
+	{
+		int size = *(int *) arg_ptr;
+		arg_ptr += sizeof(size);
+		tasks[i] = _starpu_sink_common_unpack_task(node, (void *) arg_ptr, size);
+		STARPU_ASSERT(!tasks[i]->detached);
+		arg_ptr += size;
+	}
+	STARPU_ASSERT(arg_ptr - (uintptr_t) arg == (uintptr_t) arg_size);
+
+	_starpu_mp_common_send_command(node, STARPU_MP_COMMAND_ANSWER_EXECUTION_SUBMITTED, NULL, 0);
+
+	for (i = 0; i < ntasks; i++)
+		_starpu_sink_common_execute_thread(node, tasks[i]);
+}
@@ -89,13 +89,25 @@ void _starpu_src_common_deinit(void)
 	}
 }
 
+/* Return the task which the sink is executing or is about to execute for the
+ * worker, i.e. the first of its pipeline */
+static struct starpu_task *_starpu_src_common_worker_first_task(struct _starpu_worker *worker)
+{
+	if (worker->pipeline_length)
+		return worker->current_tasks[worker->first_task];
+	else
+		return worker->current_task;
+}
+
 /* Finalize the execution of a task by a worker*/
 static int _starpu_src_common_finalize_job(struct _starpu_job *j, struct _starpu_worker *worker)
 {
 	int profiling = starpu_profiling_status_get();
 	_starpu_driver_end_job(worker, j, &worker->perf_arch, 0, profiling);
 
-	int count = worker->current_rank;
+	/* The rank of the worker only matters for parallel tasks, and then
+	 * the count of the combined worker is used */
+	int count = 0;
 
 	/* If it's a combined worker, we check if it's the last one of his combined */
 	if(j->task_size > 1)
@@ -133,7 +145,8 @@ static int _starpu_src_common_process_completed_job(struct _starpu_mp_node *node
 	arg_ptr += sizeof(coreid);
 
 	struct _starpu_worker *worker = &workerset->workers[coreid];
-	struct _starpu_job *j = _starpu_get_job_associated_to_task(worker->current_task);
+	/* Tasks complete in the order of the pipeline */
+	struct _starpu_job *j = _starpu_get_job_associated_to_task(_starpu_src_common_worker_first_task(worker));
 
 	struct starpu_task *task = j->task;
 	STARPU_ASSERT(task);
@@ -156,11 +169,31 @@ static int _starpu_src_common_process_completed_job(struct _starpu_mp_node *node
 	if (!stored)
 		STARPU_PTHREAD_MUTEX_UNLOCK(&node->connection_mutex);
 
+	/* The job may be freed by its termination */
+	int is_parallel_task = j->task_size > 1;
+
 	_starpu_set_local_worker_key(worker);
 	_starpu_src_common_finalize_job(j, worker);
-	_starpu_set_local_worker_key(old_worker);
 
-	worker->current_task = NULL;
+	if (worker->pipeline_length)
+		worker->current_tasks[worker->first_task] = NULL;
+	else
+		worker->current_task = NULL;
+	worker->first_task = (worker->first_task + 1) % STARPU_MAX_PIPELINE;
+	worker->ntasks--;
+
+	if (is_parallel_task)
+		/* The parallel task is over, we can fill the pipeline again */
+		worker->pipeline_stuck = 0;
+	else if (worker->pipeline_length && worker->ntasks && worker->current_tasks[worker->first_task] != worker->task_transferring)
+	{
+		/* The next task of the pipeline was already sent, it now
+		 * starts on the sink */
+		struct _starpu_job *next_j = _starpu_get_job_associated_to_task(worker->current_tasks[worker->first_task]);
+		_starpu_driver_start_job(worker, next_j, &worker->perf_arch, 0, starpu_profiling_status_get());
+	}
+
+	_starpu_set_local_worker_key(old_worker);
 
 	return 0;
 }
@@ -181,7 +214,7 @@ static void _starpu_src_common_pre_exec(struct _starpu_mp_node *node, void * arg
 	{
 		struct _starpu_worker * worker = _starpu_get_worker_struct(combined_worker->combined_workerid[i]);
 		_starpu_set_local_worker_key(worker);
-		_starpu_sched_pre_exec_hook(worker->current_task);
+		_starpu_sched_pre_exec_hook(_starpu_src_common_worker_first_task(worker));
 	}
 }
 
@@ -436,23 +469,24 @@ int _starpu_src_common_lookup(struct _starpu_mp_node *node, void (**func_ptr)(vo
  * [Function pointer on sink, number of interfaces, interfaces
  * (union _starpu_interface), cl_arg]
  */
-/* Launch the execution of the function KERNEL points to on the sink linked
- * to NODE. Returns 0 in case of success, -EINVAL if kernel is an invalid
- * pointer.
+/* Pack in a newly-allocated buffer the description of the execution of the
+ * function KERNEL points to on the sink linked to NODE, and return it along
+ * its size in *BUFFER_SIZE_P.
  * Data interfaces in task are send to the sink.
  */
-int _starpu_src_common_execute_kernel(struct _starpu_mp_node *node,
-				      void (*kernel)(void), unsigned coreid,
-				      enum starpu_codelet_type type,
-				      int is_parallel_task, int cb_workerid,
-				      starpu_data_handle_t *handles,
-				      void **interfaces,
-				      unsigned nb_interfaces,
-				      void *cl_arg, size_t cl_arg_size, int detached)
+static void *_starpu_src_common_pack_kernel(struct _starpu_mp_node *node,
+					    void (*kernel)(void), unsigned coreid,
+					    enum starpu_codelet_type type,
+					    int is_parallel_task, int cb_workerid,
+					    starpu_data_handle_t *handles,
+					    void **interfaces,
+					    unsigned nb_interfaces,
+					    void *cl_arg, size_t cl_arg_size, int detached,
+					    int *buffer_size_p)
 {
-	void *buffer, *arg =NULL;
+	void *buffer;
 	uintptr_t buffer_ptr;
-	int buffer_size = 0, arg_size =0;
+	int buffer_size = 0;
 	unsigned i;
 	starpu_ssize_t interface_size[nb_interfaces ? nb_interfaces : 1];
 	void *interface_ptr[nb_interfaces ? nb_interfaces : 1];
@@ -564,6 +598,30 @@ int _starpu_src_common_execute_kernel(struct _starpu_mp_node *node,
 	if (cl_arg)
 		memcpy((void*) buffer_ptr, cl_arg, cl_arg_size);
 
+	*buffer_size_p = buffer_size;
+	return buffer;
+}
+
+/* Launch the execution of the function KERNEL points to on the sink linked
+ * to NODE. Returns 0 in case of success, -EINVAL if kernel is an invalid
+ * pointer.
+ * Data interfaces in task are send to the sink.
+ */
+int _starpu_src_common_execute_kernel(struct _starpu_mp_node *node,
+				      void (*kernel)(void), unsigned coreid,
+				      enum starpu_codelet_type type,
+				      int is_parallel_task, int cb_workerid,
+				      starpu_data_handle_t *handles,
+				      void **interfaces,
+				      unsigned nb_interfaces,
+				      void *cl_arg, size_t cl_arg_size, int detached)
+{
+	void *buffer, *arg = NULL;
+	int buffer_size, arg_size = 0;
+
+	buffer = _starpu_src_common_pack_kernel(node, kernel, coreid, type, is_parallel_task, cb_workerid,
+						handles, interfaces, nb_interfaces, cl_arg, cl_arg_size, detached, &buffer_size);
+
 	STARPU_PTHREAD_MUTEX_LOCK(&node->connection_mutex);
 
 	if (detached)
@@ -576,6 +634,7 @@ int _starpu_src_common_execute_kernel(struct _starpu_mp_node *node,
 	if (answer == STARPU_MP_COMMAND_ERROR_EXECUTE_DETACHED)
 	{
 		STARPU_PTHREAD_MUTEX_UNLOCK(&node->connection_mutex);
+		free(buffer);
 		return -EINVAL;
 	}
 
@@ -591,8 +650,9 @@ int _starpu_src_common_execute_kernel(struct _starpu_mp_node *node,
 	return 0;
 }
 
-/* Get the information and call the function to send to the sink a message to execute the task*/
-static int _starpu_src_common_execute(struct _starpu_job *j, struct _starpu_worker *worker, struct _starpu_mp_node * node)
+/* Get the information to send to the sink a message to execute the task, and
+ * return it packed in a newly-allocated buffer */
+static void *_starpu_src_common_pack_job(struct _starpu_job *j, struct _starpu_worker *worker, struct _starpu_mp_node * node, int *buffer_size)
 {
 	STARPU_ASSERT(j);
 	struct starpu_task *task = j->task;
@@ -603,16 +663,71 @@ static int _starpu_src_common_execute(struct _starpu_job *j, struct _starpu_work
 
 	void (*kernel)(void)  = node->get_kernel_from_job(node,j);
 
-	_starpu_driver_start_job(worker, j, &worker->perf_arch, 0, profiling);
+	/* If previous tasks are still in the pipeline, the task will
+	 * actually start on the sink only when they are over */
+	if (worker->ntasks == 1)
+		_starpu_driver_start_job(worker, j, &worker->perf_arch, 0, profiling);
 
 	//_STARPU_DEBUG("\nworkerid:%d, subworkerid:%d, rank:%d, type:%d, cb_workerid:%d, task_size:%d\n\n",worker->devid, worker->subworkerid, worker->current_rank,task->cl->type,j->combined_workerid,j->task_size);
 
-	_starpu_src_common_execute_kernel(node, kernel, worker->subworkerid, task->cl->type,
-					  (j->task_size > 1),
-					  j->combined_workerid, STARPU_TASK_GET_HANDLES(task),
-					  _STARPU_TASK_GET_INTERFACES(task), STARPU_TASK_GET_NBUFFERS(task),
-					  task->cl_arg, task->cl_arg_size, 0);
-	return 0;
+	return _starpu_src_common_pack_kernel(node, kernel, worker->subworkerid, task->cl->type,
+					      (j->task_size > 1),
+					      j->combined_workerid, STARPU_TASK_GET_HANDLES(task),
+					      _STARPU_TASK_GET_INTERFACES(task), STARPU_TASK_GET_NBUFFERS(task),
+					      task->cl_arg, task->cl_arg_size, 0, buffer_size);
+}
+
+/* Send to the sink the NJOBS execution messages packed in BUFFERS, in only
+ * one message if there are several of them */
+static void _starpu_src_common_execute_jobs(struct _starpu_mp_node *node, void **buffers, int *buffer_sizes, unsigned njobs)
+{
+	void *arg, *buffer;
+	int arg_size, buffer_size;
+	enum _starpu_mp_command command;
+	unsigned i;
+
+	if (njobs == 1)
+	{
+		command = STARPU_MP_COMMAND_EXECUTE;
+		buffer = buffers[0];
+		buffer_size = buffer_sizes[0];
+	}
+	else
+	{
+		/* [number of jobs, (size, job)*] */
+		uintptr_t buffer_ptr;
+
+		command = STARPU_MP_COMMAND_EXECUTE_BATCH;
+		buffer_size = sizeof(njobs);
+		for (i = 0; i < njobs; i++)
+			buffer_size += sizeof(buffer_sizes[i]) + buffer_sizes[i];
+
+		_STARPU_MALLOC(buffer, buffer_size);
+		buffer_ptr = (uintptr_t) buffer;
+
+		*(unsigned *) buffer_ptr = njobs;
+		buffer_ptr += sizeof(njobs);
+
+		for (i = 0; i < njobs; i++)
+		{
+			*(int *) buffer_ptr = buffer_sizes[i];
+			buffer_ptr += sizeof(buffer_sizes[i]);
+			memcpy((void *) buffer_ptr, buffers[i], buffer_sizes[i]);
+			buffer_ptr += buffer_sizes[i];
+			free(buffers[i]);
+		}
+	}
+
+	STARPU_PTHREAD_MUTEX_LOCK(&node->connection_mutex);
+
+	_starpu_mp_common_send_command(node, command, buffer, buffer_size);
+
+	enum _starpu_mp_command answer = _starpu_src_common_wait_command_sync(node, &arg, &arg_size);
+	STARPU_ASSERT(answer == STARPU_MP_COMMAND_ANSWER_EXECUTION_SUBMITTED);
+
+	STARPU_PTHREAD_MUTEX_UNLOCK(&node->connection_mutex);
+
+	free(buffer);
 }
 
 static struct _starpu_sink_kernel *starpu_src_common_register_kernel(const char *func_name)
@@ -716,8 +831,59 @@ struct _starpu_mp_node *_starpu_src_common_get_mp_node_from_memory_node(int memo
 			starpu_memory_node_get_devid(memory_node));
 }
 
+/* A sink allocation made in a shared memory segment, and its mapping on the
+ * host */
+struct _starpu_src_shared_allocation
+{
+	struct starpu_rbtree_node node;
+	uintptr_t sink_addr;
+	size_t size;
+	/* NULL if the host could not map the segment */
+	void *local_addr;
+};
+
+static int _starpu_src_shared_cmp_insert(struct starpu_rbtree_node *left_elm, struct starpu_rbtree_node *right_elm)
+{
+	uintptr_t addr_left = ((struct _starpu_src_shared_allocation *) left_elm)->sink_addr;
+	uintptr_t addr_right = ((struct _starpu_src_shared_allocation *) right_elm)->sink_addr;
+
+	return addr_left < addr_right ? -1 : addr_left > addr_right ? 1 : 0;
+}
+
+static int _starpu_src_shared_cmp_lookup(uintptr_t addr_left, struct starpu_rbtree_node *right_elm)
+{
+	uintptr_t addr_right = ((struct _starpu_src_shared_allocation *) right_elm)->sink_addr;
+
+	return addr_left < addr_right ? -1 : addr_left > addr_right ? 1 : 0;
+}
+
+/* If the SIZE bytes at ADDR on the sink linked to MP_NODE are mapped on the
+ * host, return the host address where to access them, else NULL.
+ */
+static void *_starpu_src_common_shared_ptr(struct _starpu_mp_node *mp_node, uintptr_t addr, size_t size)
+{
+	void *ptr = NULL;
+
+	if (!mp_node->shared_memory)
+		return NULL;
+
+	STARPU_PTHREAD_MUTEX_LOCK(&mp_node->shared_mutex);
+	struct starpu_rbtree_node *node = starpu_rbtree_lookup_nearest(&mp_node->shared_tree, addr, _starpu_src_shared_cmp_lookup, STARPU_RBTREE_LEFT);
+	if (node)
+	{
+		struct _starpu_src_shared_allocation *shared = (struct _starpu_src_shared_allocation *) node;
+		if (shared->local_addr && addr >= shared->sink_addr && addr + size <= shared->sink_addr + shared->size)
+			ptr = (char *) shared->local_addr + (addr - shared->sink_addr);
+	}
+	STARPU_PTHREAD_MUTEX_UNLOCK(&mp_node->shared_mutex);
+
+	return ptr;
+}
+
 /* Send a request to the sink linked to the MP_NODE to allocate SIZE bytes on
  * the sink.
+ * When the sink runs on the same machine, it allocates them in a shared memory
+ * segment which we map, so that transfers can be achieved with a mere memcpy.
  * In case of success, it returns 0 and *ADDR contains the address of the
  * allocated area ;
  * else it returns 1 if the allocation fail.
@@ -733,7 +899,7 @@ uintptr_t _starpu_src_common_allocate(enum starpu_worker_archtype archtype, int
 
 	STARPU_PTHREAD_MUTEX_LOCK(&mp_node->connection_mutex);
 
-	_starpu_mp_common_send_command(mp_node, STARPU_MP_COMMAND_ALLOCATE, &size,
+	_starpu_mp_common_send_command(mp_node, mp_node->shared_memory ? STARPU_MP_COMMAND_ALLOCATE_SHARED : STARPU_MP_COMMAND_ALLOCATE, &size,
 			sizeof(size));
 
 	answer = _starpu_src_common_wait_command_sync(mp_node, &arg, &arg_size);
@@ -744,6 +910,29 @@ uintptr_t _starpu_src_common_allocate(enum starpu_worker_archtype archtype, int
 		return 0;
 	}
 
+	if (answer == STARPU_MP_COMMAND_ANSWER_ALLOCATE_SHARED)
+	{
+		struct _starpu_mp_transfer_allocate_shared_answer *shared_answer = arg;
+		STARPU_ASSERT((unsigned) arg_size > sizeof(*shared_answer));
+
+		struct _starpu_src_shared_allocation *shared;
+		_STARPU_MALLOC(shared, sizeof(*shared));
+		shared->sink_addr = shared_answer->addr;
+		shared->size = size;
+		/* If we can not map it, the sink will still be able to use it, and
+		 * transfers will go through the connection as usual */
+		shared->local_addr = _starpu_sink_map(shared_answer->fd_name, 0, size);
+		starpu_rbtree_node_init(&shared->node);
+
+		STARPU_PTHREAD_MUTEX_UNLOCK(&mp_node->connection_mutex);
+
+		STARPU_PTHREAD_MUTEX_LOCK(&mp_node->shared_mutex);
+		starpu_rbtree_insert(&mp_node->shared_tree, &shared->node, _starpu_src_shared_cmp_insert);
+		STARPU_PTHREAD_MUTEX_UNLOCK(&mp_node->shared_mutex);
+
+		return shared->sink_addr;
+	}
+
 	STARPU_ASSERT(answer == STARPU_MP_COMMAND_ANSWER_ALLOCATE && arg_size == sizeof(addr));
 
 	memcpy(&addr, arg, arg_size);
@@ -761,11 +950,55 @@ void _starpu_src_common_free(enum starpu_worker_archtype archtype, int devid, ui
 	(void) flags;
 	(void) size;
 	struct _starpu_mp_node *mp_node = _starpu_src_common_get_mp_node_from_devid(archtype, devid);
+	struct _starpu_src_shared_allocation *shared = NULL;
+
+	if (mp_node->shared_memory)
+	{
+		STARPU_PTHREAD_MUTEX_LOCK(&mp_node->shared_mutex);
+		shared = (struct _starpu_src_shared_allocation *) starpu_rbtree_lookup(&mp_node->shared_tree, addr, _starpu_src_shared_cmp_lookup);
+		if (shared)
+			starpu_rbtree_remove(&mp_node->shared_tree, &shared->node);
+		STARPU_PTHREAD_MUTEX_UNLOCK(&mp_node->shared_mutex);
+	}
+
+	if (shared)
+	{
+		struct _starpu_mp_transfer_unmap_command free_cmd = {.addr = addr, .size = shared->size};
+
+		if (shared->local_addr)
+			_starpu_sink_unmap((uintptr_t) shared->local_addr, shared->size);
+		free(shared);
+
+		STARPU_PTHREAD_MUTEX_LOCK(&mp_node->connection_mutex);
+		_starpu_mp_common_send_command(mp_node, STARPU_MP_COMMAND_FREE_SHARED, &free_cmd, sizeof(free_cmd));
+		STARPU_PTHREAD_MUTEX_UNLOCK(&mp_node->connection_mutex);
+		return;
+	}
+
 	STARPU_PTHREAD_MUTEX_LOCK(&mp_node->connection_mutex);
 	_starpu_mp_common_send_command(mp_node, STARPU_MP_COMMAND_FREE, &addr, sizeof(addr));
 	STARPU_PTHREAD_MUTEX_UNLOCK(&mp_node->connection_mutex);
 }
 
+/* Unmap and forget the shared memory segments which are still known for the
+ * sink linked to MP_NODE, when it is getting destroyed.
+ */
+void _starpu_src_common_release_shared(struct _starpu_mp_node *mp_node)
+{
+	struct starpu_rbtree_node *node, *tmp;
+
+	STARPU_PTHREAD_MUTEX_LOCK(&mp_node->shared_mutex);
+	starpu_rbtree_for_each_remove(&mp_node->shared_tree, node, tmp)
+	{
+		struct _starpu_src_shared_allocation *shared = (struct _starpu_src_shared_allocation *) node;
+		if (shared->local_addr)
+			_starpu_sink_unmap((uintptr_t) shared->local_addr, shared->size);
+		free(shared);
+	}
+	starpu_rbtree_init(&mp_node->shared_tree);
+	STARPU_PTHREAD_MUTEX_UNLOCK(&mp_node->shared_mutex);
+}
+
 /* Send a request to the sink linked to the MP_NODE to map SIZE bytes on ADDR as mapped area
  * on the sink.
  * In case of success, it returns map_addr contains the address of the
@@ -882,6 +1115,13 @@ int _starpu_src_common_copy_data_host_to_sink(uintptr_t src, size_t src_offset,
 {
 	(void) src_devid;
 	struct _starpu_mp_node *mp_node = _starpu_src_common_get_mp_node_from_devid(dst_archtype, dst_devid);
+	void *shared_dst = _starpu_src_common_shared_ptr(mp_node, dst + dst_offset, size);
+
+	if (shared_dst)
+	{
+		memcpy(shared_dst, (void*) (src + src_offset), size);
+		return 0;
+	}
 
 	if (async_channel)
 		return _starpu_src_common_copy_host_to_sink_async(mp_node,
@@ -950,6 +1190,13 @@ int _starpu_src_common_copy_data_sink_to_host(uintptr_t src, size_t src_offset,
 {
 	(void) dst_devid;
 	struct _starpu_mp_node *mp_node = _starpu_src_common_get_mp_node_from_devid(src_archtype, src_devid);
+	void *shared_src = _starpu_src_common_shared_ptr(mp_node, src + src_offset, size);
+
+	if (shared_src)
+	{
+		memcpy((void*) (dst + dst_offset), shared_src, size);
+		return 0;
+	}
 
 	if (async_channel)
 		return _starpu_src_common_copy_sink_to_host_async(mp_node,
@@ -1062,17 +1309,24 @@ int _starpu_src_common_copy_data_sink_to_sink(uintptr_t src, size_t src_offset,
 					      uintptr_t dst, size_t dst_offset, enum starpu_worker_archtype dst_archtype, int dst_devid,
 					      size_t size, struct _starpu_async_channel *async_channel)
 {
+	struct _starpu_mp_node *src_node = _starpu_src_common_get_mp_node_from_devid(src_archtype, src_devid);
+	struct _starpu_mp_node *dst_node = _starpu_src_common_get_mp_node_from_devid(dst_archtype, dst_devid);
+	void *shared_src = _starpu_src_common_shared_ptr(src_node, src + src_offset, size);
+	void *shared_dst = shared_src ? _starpu_src_common_shared_ptr(dst_node, dst + dst_offset, size) : NULL;
+
+	if (shared_dst)
+	{
+		memcpy(shared_dst, shared_src, size);
+		return 0;
+	}
+
 	if (async_channel)
-		return _starpu_src_common_copy_sink_to_sink_async(
-						_starpu_src_common_get_mp_node_from_devid(src_archtype, src_devid),
-						_starpu_src_common_get_mp_node_from_devid(dst_archtype, dst_devid),
+		return _starpu_src_common_copy_sink_to_sink_async(src_node, dst_node,
 						(void*) (src + src_offset),
 						(void*) (dst + dst_offset),
 						size, async_channel);
 	else
-		return _starpu_src_common_copy_sink_to_sink_sync(
-						_starpu_src_common_get_mp_node_from_devid(src_archtype, src_devid),
-						_starpu_src_common_get_mp_node_from_devid(dst_archtype, dst_devid),
+		return _starpu_src_common_copy_sink_to_sink_sync(src_node, dst_node,
 						(void*) (src + src_offset),
 						(void*) (dst + dst_offset),
 						size);
@@ -1148,44 +1402,57 @@ static void _starpu_src_common_worker_internal_work(struct _starpu_worker_set *
 	starpu_pthread_wait_reset(&worker_set->workers[0].wait);
 #endif
 
+	void *buffers[worker_set->nworkers];
+	int buffer_sizes[worker_set->nworkers];
+	unsigned njobs = 0;
+
 	/* Test if async transfers are completed */
 	for (i = 0; i < worker_set->nworkers; i++)
 	{
-		struct starpu_task *task = worker_set->workers[i].task_transferring;
+		struct _starpu_worker *worker = &worker_set->workers[i];
+		struct starpu_task *task = worker->task_transferring;
 		/* We send all buffers to execute the task */
-		if (task != NULL && worker_set->workers[i].nb_buffers_transferred == worker_set->workers[i].nb_buffers_totransfer)
+		if (task != NULL && worker->nb_buffers_transferred == worker->nb_buffers_totransfer)
 		{
 			STARPU_RMB();
 			struct _starpu_job * j = _starpu_get_job_associated_to_task(task);
 
-			_STARPU_TRACE_END_PROGRESS(memnode);
-			_starpu_set_local_worker_key(&worker_set->workers[i]);
-			_starpu_fetch_task_input_tail(task, j, &worker_set->workers[i]);
-			/* Reset it */
-			worker_set->workers[i].task_transferring = NULL;
-			j->workerid = worker_set->workers[i].workerid;
+			if (!worker->pipeline_stuck)
+			{
+				_STARPU_TRACE_END_PROGRESS(memnode);
+				_starpu_set_local_worker_key(worker);
+				_starpu_fetch_task_input_tail(task, j, worker);
+				_STARPU_TRACE_START_PROGRESS(memnode);
+			}
 
-			/* Execute the task */
-			res =  _starpu_src_common_execute(j, &worker_set->workers[i], mp_node);
-			switch (res)
+			if (j->task_size > 1)
 			{
-				case 0:
-					/* The task task has been launched with no error */
-					break;
-				case -EAGAIN:
-					_STARPU_DISP("ouch, this MP worker could not actually run task %p, putting it back...\n", tasks[i]);
-					_starpu_push_task_to_workers(worker_set->workers[i].task_transferring);
-					STARPU_ABORT();
+				/* A parallel task has to run alone: prevent more
+				 * tasks from coming, and wait for the pipeline to
+				 * be flushed before sending it */
+				worker->pipeline_stuck = 1;
+				if (worker->ntasks > 1)
 					continue;
-					break;
-				default:
-					STARPU_ASSERT(0);
 			}
 
-			_STARPU_TRACE_START_PROGRESS(memnode);
+			/* Reset it */
+			worker->task_transferring = NULL;
+			j->workerid = worker->workerid;
+
+			/* Pack the task, to be sent along the others */
+			_starpu_set_local_worker_key(worker);
+			buffers[njobs] = _starpu_src_common_pack_job(j, worker, mp_node, &buffer_sizes[njobs]);
+			njobs++;
 		}
 	}
 
+	if (njobs)
+	{
+		_STARPU_TRACE_END_PROGRESS(memnode);
+		_starpu_src_common_execute_jobs(mp_node, buffers, buffer_sizes, njobs);
+		_STARPU_TRACE_START_PROGRESS(memnode);
+	}
+
 	res |= __starpu_datawizard_progress(_STARPU_DATAWIZARD_DO_ALLOC, 1);
 
 	/* Handle message which have been store */
@@ -1237,6 +1504,27 @@ static void _starpu_src_common_worker_internal_work(struct _starpu_worker_set *
 	}
 }
 
+/* Set the number of tasks which can be sent in advance to the sink for the
+ * worker, so that the sink does not have to wait for the source between
+ * tasks, and input transfers overlap with execution */
+void _starpu_src_common_init_pipeline(struct _starpu_worker *worker, const char *envname)
+{
+	worker->pipeline_length = starpu_getenv_number_default(envname, 2);
+	if (worker->pipeline_length > STARPU_MAX_PIPELINE)
+	{
+		_STARPU_DISP("Warning: %s is %u, but STARPU_MAX_PIPELINE is only %u\n", envname, worker->pipeline_length, STARPU_MAX_PIPELINE);
+		worker->pipeline_length = STARPU_MAX_PIPELINE;
+	}
+#if !defined(STARPU_SIMGRID) && !defined(STARPU_NON_BLOCKING_DRIVERS)
+	if (worker->pipeline_length >= 1)
+	{
+		/* We need non-blocking drivers, to poll for task termination */
+		_STARPU_DISP("Warning: reducing %s to 0 because blocking drivers are enabled (and simgrid is not enabled)\n", envname);
+		worker->pipeline_length = 0;
+	}
+#endif
+}
+
 /* Function looping on the source node */
 void _starpu_src_common_workers_set(struct _starpu_worker_set * worker_set, int ndevices, struct _starpu_mp_node ** mp_node)
 {
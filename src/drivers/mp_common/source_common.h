@@ -53,6 +53,7 @@ void(* _starpu_src_common_get_cpu_func_from_job(const struct _starpu_mp_node *no
 struct _starpu_mp_node *_starpu_src_common_get_mp_node_from_memory_node(int memory_node);
 uintptr_t _starpu_src_common_allocate(enum starpu_worker_archtype archtype, int devid, size_t size, int flags);
 void _starpu_src_common_free(enum starpu_worker_archtype archtype, int devid, uintptr_t addr, size_t size, int flags);
+void _starpu_src_common_release_shared(struct _starpu_mp_node *mp_node);
 
 uintptr_t _starpu_src_common_map(unsigned dst_node, uintptr_t addr, size_t size);
 void _starpu_src_common_unmap(unsigned dst_node, uintptr_t addr, size_t size);
@@ -76,6 +77,7 @@ int _starpu_src_common_copy_data_sink_to_sink(uintptr_t src, size_t src_offset,
 					      uintptr_t dst, size_t dst_offset, enum starpu_worker_archtype dst_archtype, int dst_devid,
 					      size_t size, struct _starpu_async_channel *async_channel);
 
+void _starpu_src_common_init_pipeline(struct _starpu_worker *worker, const char *envname);
 void _starpu_src_common_init_switch_env(unsigned this);
 void _starpu_src_common_workers_set(struct _starpu_worker_set * worker_set, int ndevices, struct _starpu_mp_node ** mp_node);
 
@@ -300,6 +300,7 @@ void *_starpu_mpi_src_worker(void *arg)
 			struct _starpu_worker *worker = &config->workers[baseworkerid+i];
 			snprintf(worker->name, sizeof(worker->name), "MPI_MS %u core %u", devid, i);
 			snprintf(worker->short_name, sizeof(worker->short_name), "MPI_MS %u.%u", devid, i);
+			_starpu_src_common_init_pipeline(worker, "STARPU_MPI_MS_PIPELINE");
 		}
 
 		{
@@ -16,6 +16,8 @@
 
 #include <sys/socket.h>
 #include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/uio.h>
 #include <sys/un.h>
 #ifdef HAVE_UNISTD_H
 #include <unistd.h>
@@ -41,6 +43,8 @@
 
 #define NITER 32
 #define SIZE_BANDWIDTH (1024*1024)
+/* Size of the buffers used to read ahead from the sync and notif sockets */
+#define RECV_BUFFER_SIZE 4096
 
 #define _SELECT_DEBUG 0
 #if _SELECT_DEBUG
@@ -92,6 +96,11 @@ int _starpu_tcpip_mp_has_local()
 	return 0;
 }
 
+int _starpu_tcpip_common_is_local(int peer_id)
+{
+	return local_flag[peer_id];
+}
+
 MULTILIST_CREATE_TYPE(_starpu_tcpip_ms_request, event); /*_starpu_tcpip_ms_request_multilist_event*/
 MULTILIST_CREATE_TYPE(_starpu_tcpip_ms_request, thread); /*_starpu_tcpip_ms_request_multilist_thread*/
 MULTILIST_CREATE_TYPE(_starpu_tcpip_ms_request, pending); /*_starpu_tcpip_ms_request_multilist_pending*/
@@ -899,6 +908,12 @@ void _starpu_tcpip_common_mp_deinit()
 			close(tcpip_sock[i].notif_sock);
 		}
 	}
+	int i;
+	for (i=0; i<nb_sink+1; i++)
+	{
+		free(tcpip_sock[i].sync_buffer.buf);
+		free(tcpip_sock[i].notif_buffer.buf);
+	}
 	free(tcpip_sock);
 	free(local_flag);
 	_starpu_spin_destroy(&ListLock);
@@ -934,12 +949,49 @@ void _starpu_tcpip_common_mp_initialize_src_sink(struct _starpu_mp_node *node)
 		node->nb_cores = ntcpipcores;
 }
 
+/* Same as read(), but small reads are served from a buffer which gets filled
+ * with whatever the socket has available, so that several messages (e.g. a
+ * command and its argument, or a series of notifications) can be received
+ * with only one system call */
+static starpu_ssize_t _starpu_tcpip_common_read_ahead(int fd, struct _starpu_tcpip_recv_buffer *rb, void *buf, size_t count)
+{
+	starpu_ssize_t res;
+
+	if (rb->start == rb->end)
+	{
+		if (count >= RECV_BUFFER_SIZE)
+			/* Large message, no need to copy it */
+			return read(fd, buf, count);
+
+		if (!rb->buf)
+			_STARPU_MALLOC(rb->buf, RECV_BUFFER_SIZE);
+		res = read(fd, rb->buf, RECV_BUFFER_SIZE);
+		if (res <= 0)
+			return res;
+		rb->start = 0;
+		rb->end = res;
+	}
+
+	res = STARPU_MIN((starpu_ssize_t) count, rb->end - rb->start);
+	memcpy(buf, rb->buf + rb->start, res);
+	rb->start += res;
+	return res;
+}
+
+static int _starpu_tcpip_common_has_read_ahead(const struct _starpu_tcpip_recv_buffer *rb)
+{
+	return rb->start < rb->end;
+}
+
 int _starpu_tcpip_common_recv_is_ready(const struct _starpu_mp_node *mp_node)
 {
 	fd_set set;
 	int fd = mp_node->mp_connection.tcpip_mp_connection->sync_sock;
 	int res;
 
+	if (_starpu_tcpip_common_has_read_ahead(&mp_node->mp_connection.tcpip_mp_connection->sync_buffer))
+		return 1;
+
 	struct timeval tv =
 	{
 		.tv_sec = 0,
@@ -962,6 +1014,9 @@ int _starpu_tcpip_common_notif_recv_is_ready(const struct _starpu_mp_node *mp_no
 	int fd = mp_node->mp_connection.tcpip_mp_connection->notif_sock;
 	int res;
 
+	if (_starpu_tcpip_common_has_read_ahead(&mp_node->mp_connection.tcpip_mp_connection->notif_buffer))
+		return 1;
+
 	struct timeval tv =
 	{
 		.tv_sec = 0,
@@ -1009,6 +1064,10 @@ void _starpu_tcpip_common_wait(struct _starpu_mp_node *mp_node)
 	int fd_max = 0;
 	int res;
 
+	if (_starpu_tcpip_common_has_read_ahead(&mp_node->mp_connection.tcpip_mp_connection->sync_buffer))
+		/* A command was already received */
+		return;
+
 	FD_ZERO(&reads);
 	FD_ZERO(&writes);
 
@@ -1046,6 +1105,7 @@ static void __starpu_tcpip_common_recv(const struct _starpu_mp_node *node, void
 static void _starpu_tcpip_common_action_socket(what_t what, const char * whatstr, int is_sender, const struct _starpu_mp_node *node, struct _starpu_tcpip_socket *remote_sock, void *msg, int len, void * event, int notif);
 static void _starpu_tcpip_common_send_to_socket(const struct _starpu_mp_node *node, struct _starpu_tcpip_socket *dst_sock, void *msg, int len, void * event, int notif);
 static void _starpu_tcpip_common_recv_from_socket(const struct _starpu_mp_node *node, struct _starpu_tcpip_socket *src_sock, void *msg, int len, void * event, int notif);
+static void _starpu_tcpip_common_sendv_to_socket(const struct _starpu_mp_node *node, int sock, struct iovec *iov, int iovcnt);
 
 /* SEND */
 void _starpu_tcpip_common_mp_send(const struct _starpu_mp_node *node, void *msg, int len)
@@ -1058,6 +1118,16 @@ void _starpu_tcpip_common_nt_send(const struct _starpu_mp_node *node, void *msg,
 	__starpu_tcpip_common_send(node, msg, len, NULL, 1);
 }
 
+void _starpu_tcpip_common_mp_sendv(const struct _starpu_mp_node *node, struct iovec *iov, int iovcnt)
+{
+	_starpu_tcpip_common_sendv_to_socket(node, node->mp_connection.tcpip_mp_connection->sync_sock, iov, iovcnt);
+}
+
+void _starpu_tcpip_common_nt_sendv(const struct _starpu_mp_node *node, struct iovec *iov, int iovcnt)
+{
+	_starpu_tcpip_common_sendv_to_socket(node, node->mp_connection.tcpip_mp_connection->notif_sock, iov, iovcnt);
+}
+
 /* SEND to source node */
 void _starpu_tcpip_common_send(const struct _starpu_mp_node *node, void *msg, int len, void * event)
 {
@@ -1081,6 +1151,32 @@ static void _starpu_tcpip_common_send_to_socket(const struct _starpu_mp_node *no
 	_starpu_tcpip_common_action_socket((what_t)write, "send", 1, node, dst_sock, msg, len, event, notif);
 }
 
+/* Synchronously send several buffers with as few system calls as possible */
+static void _starpu_tcpip_common_sendv_to_socket(const struct _starpu_mp_node *node, int sock, struct iovec *iov, int iovcnt)
+{
+	while (iovcnt)
+	{
+		starpu_ssize_t res;
+		while((res = writev(sock, iov, iovcnt)) == -1 && errno == EINTR)
+		;
+		STARPU_ASSERT_MSG(res != 0 && !(res == -1 && errno == ECONNRESET), "TCP/IP Master/Slave noticed that %s (peer %d) has exited unexpectedly", node->kind == STARPU_NODE_TCPIP_SOURCE ? "the master" : "some slave", node->peer_id);
+		STARPU_ASSERT_MSG(res > 0, "TCP/IP Master/Slave cannot send %d buffers at once!, the result of writev is %ld, the error is %s ", iovcnt, (long) res, strerror(errno));
+
+		/* Skip what was sent */
+		while (iovcnt && res >= (starpu_ssize_t) iov->iov_len)
+		{
+			res -= iov->iov_len;
+			iov++;
+			iovcnt--;
+		}
+		if (iovcnt)
+		{
+			iov->iov_base = (char*) iov->iov_base + res;
+			iov->iov_len -= res;
+		}
+	}
+}
+
 
 /* RECV */
 void _starpu_tcpip_common_mp_recv(const struct _starpu_mp_node *node, void *msg, int len)
@@ -1193,7 +1289,8 @@ static void _starpu_tcpip_common_action_socket(what_t what, const char * whatstr
 			int res, offset = 0;
 			while(offset < len)
 			{
-				while((res = what(remote_sock->sync_sock, (char*)msg+offset, len-offset)) == -1 && errno == EINTR)
+				while((res = is_sender ? what(remote_sock->sync_sock, (char*)msg+offset, len-offset)
+						       : _starpu_tcpip_common_read_ahead(remote_sock->sync_sock, &remote_sock->sync_buffer, (char*)msg+offset, len-offset)) == -1 && errno == EINTR)
 				;
 				_TCPIP_PRINT("msg after write is %x, res is %d\n", *((int *) (uintptr_t)msg), res);
 				STARPU_ASSERT_MSG(res != 0 && !(res == -1 && errno == ECONNRESET), "TCP/IP Master/Slave noticed that %s (peer %d) has exited unexpectedly", node->kind == STARPU_NODE_TCPIP_SOURCE ? "the master" : "some slave", node->peer_id);
@@ -1207,7 +1304,8 @@ static void _starpu_tcpip_common_action_socket(what_t what, const char * whatstr
 			int res, offset = 0;
 			while(offset < len)
 			{
-				while((res = what(remote_sock->notif_sock, (char*)msg+offset, len-offset)) == -1 && errno == EINTR)
+				while((res = is_sender ? what(remote_sock->notif_sock, (char*)msg+offset, len-offset)
+						       : _starpu_tcpip_common_read_ahead(remote_sock->notif_sock, &remote_sock->notif_buffer, (char*)msg+offset, len-offset)) == -1 && errno == EINTR)
 				;
 				_TCPIP_PRINT("msg after write is %x, res is %d\n", *((int *) (uintptr_t)msg), res);
 				STARPU_ASSERT_MSG(res != 0 && !(res == -1 && errno == ECONNRESET), "TCP/IP Master/Slave noticed that %s (peer %d) has exited unexpectedly", node->kind == STARPU_NODE_TCPIP_SOURCE ? "the master" : "some slave", node->peer_id);
@@ -1336,7 +1434,7 @@ void _starpu_tcpip_common_barrier(void)
 		for(i=1; i<nb_sink+1; i++)
 		{
 			//_TCPIP_PRINT("slave socket in sock list is %d\n", sock_list[i]);
-			ret=read(tcpip_sock[i].sync_sock, &buf, 1);
+			ret=_starpu_tcpip_common_read_ahead(tcpip_sock[i].sync_sock, &tcpip_sock[i].sync_buffer, &buf, 1);
 			//printf("ret2 is %d\n", ret);
 			STARPU_ASSERT_MSG(ret > 0, "Cannot read from slave!");
 		}
@@ -1356,7 +1454,7 @@ void _starpu_tcpip_common_barrier(void)
 		ret=write(tcpip_sock[0].sync_sock, &buf, 1);
 		//printf("ret1 is %d\n", ret);
 		STARPU_ASSERT_MSG(ret > 0, "Cannot write to master!");
-		ret=read(tcpip_sock[0].sync_sock, &buf, 1);
+		ret=_starpu_tcpip_common_read_ahead(tcpip_sock[0].sync_sock, &tcpip_sock[0].sync_buffer, &buf, 1);
 		//printf("ret4 is %d\n", ret);
 		STARPU_ASSERT_MSG(ret > 0, "Cannot read from master!");
 	}
@@ -1405,7 +1503,7 @@ void _starpu_tcpip_common_measure_bandwidth_latency(double timing_dtod[STARPU_MA
 					ret = write(tcpip_sock[receiver].sync_sock, buf, SIZE_BANDWIDTH);
 					STARPU_ASSERT_MSG(ret == SIZE_BANDWIDTH, "short write!");
 					STARPU_ASSERT_MSG(ret > 0, "Bandwidth of TCP/IP Master/Slave cannot be measured !");
-					ret = read(tcpip_sock[receiver].sync_sock, buf, 1);
+					ret = _starpu_tcpip_common_read_ahead(tcpip_sock[receiver].sync_sock, &tcpip_sock[receiver].sync_buffer, buf, 1);
 					STARPU_ASSERT_MSG(ret > 0, "Bandwidth of TCP/IP Master/Slave cannot be measured !");
 				}
 				end = starpu_timing_now();
@@ -1417,7 +1515,7 @@ void _starpu_tcpip_common_measure_bandwidth_latency(double timing_dtod[STARPU_MA
 				{
 					ret = write(tcpip_sock[receiver].sync_sock, buf, 1);
 					STARPU_ASSERT_MSG(ret > 0, "Bandwidth of TCP/IP Master/Slave cannot be measured !");
-					ret = read(tcpip_sock[receiver].sync_sock, buf, 1);
+					ret = _starpu_tcpip_common_read_ahead(tcpip_sock[receiver].sync_sock, &tcpip_sock[receiver].sync_buffer, buf, 1);
 					STARPU_ASSERT_MSG(ret > 0, "Bandwidth of TCP/IP Master/Slave cannot be measured !");
 				}
 				end = starpu_timing_now();
@@ -1436,7 +1534,7 @@ void _starpu_tcpip_common_measure_bandwidth_latency(double timing_dtod[STARPU_MA
 					size_t pending = SIZE_BANDWIDTH;
 					while (pending)
 					{
-						ret = read(tcpip_sock[sender].sync_sock, buf, SIZE_BANDWIDTH);
+						ret = _starpu_tcpip_common_read_ahead(tcpip_sock[sender].sync_sock, &tcpip_sock[sender].sync_buffer, buf, SIZE_BANDWIDTH);
 						STARPU_ASSERT_MSG(ret > 0, "Bandwidth of TCP/IP Master/Slave cannot be measured !");
 						pending -= ret;
 					}
@@ -1447,7 +1545,7 @@ void _starpu_tcpip_common_measure_bandwidth_latency(double timing_dtod[STARPU_MA
 				/* measure latency sender to receiver */
 				for (iter = 0; iter < NITER; iter++)
 				{
-					ret = read(tcpip_sock[sender].sync_sock, buf, 1);
+					ret = _starpu_tcpip_common_read_ahead(tcpip_sock[sender].sync_sock, &tcpip_sock[sender].sync_buffer, buf, 1);
 					STARPU_ASSERT_MSG(ret > 0, "Bandwidth of TCP/IP Master/Slave cannot be measured !");
 					ret = write(tcpip_sock[sender].sync_sock, buf, 1);
 					STARPU_ASSERT_MSG(ret > 0, "Bandwidth of TCP/IP Master/Slave cannot be measured !");
@@ -1471,8 +1569,8 @@ void _starpu_tcpip_common_measure_bandwidth_latency(double timing_dtod[STARPU_MA
 		/* the master node receives the data */
 		if (index_sink == 0)
 		{
-			read(tcpip_sock[sender].sync_sock, timing_dtod[sender], sizeof(timing_dtod[sender]));
-			read(tcpip_sock[sender].sync_sock, latency_dtod[sender], sizeof(latency_dtod[sender]));
+			_starpu_tcpip_common_read_ahead(tcpip_sock[sender].sync_sock, &tcpip_sock[sender].sync_buffer, timing_dtod[sender], sizeof(timing_dtod[sender]));
+			_starpu_tcpip_common_read_ahead(tcpip_sock[sender].sync_sock, &tcpip_sock[sender].sync_buffer, latency_dtod[sender], sizeof(latency_dtod[sender]));
 		}
 
 print:
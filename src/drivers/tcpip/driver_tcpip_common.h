@@ -28,6 +28,14 @@
 
 extern int _starpu_tcpip_common_multiple_thread;
 
+/* data which was read from a socket but not consumed yet */
+struct _starpu_tcpip_recv_buffer
+{
+	char *buf;
+	int start;
+	int end;
+};
+
 struct _starpu_tcpip_socket
 {
 	/* socket used for synchronous communications*/
@@ -41,11 +49,16 @@ struct _starpu_tcpip_socket
 	/* how many times is this message split up to send */
 	unsigned nbsend;
 	unsigned nback;
+	/* data read ahead from sync_sock and notif_sock */
+	struct _starpu_tcpip_recv_buffer sync_buffer;
+	struct _starpu_tcpip_recv_buffer notif_buffer;
 };
 
 extern struct _starpu_tcpip_socket *tcpip_sock;
 
 int _starpu_tcpip_mp_has_local();
+/** Whether the peer is connected through a local socket, i.e. runs on the same machine */
+int _starpu_tcpip_common_is_local(int peer_id);
 
 int _starpu_tcpip_common_mp_init();
 void _starpu_tcpip_common_mp_deinit();
@@ -66,9 +79,11 @@ void _starpu_tcpip_common_recv(const struct _starpu_mp_node *node, void *msg, in
 
 void _starpu_tcpip_common_mp_send(const struct _starpu_mp_node *node, void *msg, int len);
 void _starpu_tcpip_common_mp_recv(const struct _starpu_mp_node *node, void *msg, int len);
+void _starpu_tcpip_common_mp_sendv(const struct _starpu_mp_node *node, struct iovec *iov, int iovcnt);
 
 void _starpu_tcpip_common_nt_send(const struct _starpu_mp_node *node, void *msg, int len);
 void _starpu_tcpip_common_nt_recv(const struct _starpu_mp_node *node, void *msg, int len);
+void _starpu_tcpip_common_nt_sendv(const struct _starpu_mp_node *node, struct iovec *iov, int iovcnt);
 
 void _starpu_tcpip_common_recv_from_device(const struct _starpu_mp_node *node, int devid, void *msg, int len, void * event);
 void _starpu_tcpip_common_send_to_device(const struct _starpu_mp_node *node, int devid, void *msg, int len, void * event);
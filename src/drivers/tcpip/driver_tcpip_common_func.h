@@ -159,6 +159,13 @@ enum errcase {SOCK_INIT, SOCK_GETADDRINFO, SOCK_GETADDRINFO_LOCAL};
 			zc;						\
 		})
 
+/* Commands are small messages which wait for an answer, do not let the
+ * Nagle algorithm delay them */
+#define SETSOCKOPT_NODELAY(sockfd) ({ \
+			int one = 1;					\
+			if (setsockopt(sockfd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one)) != 0) \
+				perror("setsockopt nodelay");		\
+		})
 
 /* This function contains all steps to initialize a socket before connect and accept steps.
  * When we call this function, we need to indicate that it is for master-slave (master = 1)
@@ -224,6 +231,7 @@ static inline int master_accept(int *sink_sock, int source_sock, int local_sock,
 	socklen_t sink_addr_size = sizeof(sink_addr);
 
 	*sink_sock = ACCEPT(source_sock, (struct sockaddr*)&sink_addr, &sink_addr_size);
+	SETSOCKOPT_NODELAY(*sink_sock);
 
 	if (zerocopy != NULL)
 	{
@@ -286,6 +294,7 @@ static inline int slave_connect(int *source_sock, struct addrinfo *cur, struct s
 		*source_sock = SOCKET(AF_INET, SOCK_STREAM, 0, SOCK_INIT);
 		CONNECT(*source_sock, (struct sockaddr*)&(*source_addr), sizeof(*source_addr), 0);
 	}
+	SETSOCKOPT_NODELAY(*source_sock);
 
 	if (zerocopy != NULL)
 	{
@@ -239,7 +239,10 @@ void _starpu_deinit_tcpip_config(struct _starpu_machine_config *config)
 void _starpu_tcpip_source_init(struct _starpu_mp_node *node)
 {
 	_starpu_tcpip_common_mp_initialize_src_sink(node);
-	//TODO
+#ifdef HAVE_MMAP
+	/* The sink runs on the same machine, let it share its allocations with us */
+	node->shared_memory = _starpu_tcpip_common_is_local(node->peer_id) && starpu_getenv_number_default("STARPU_TCPIP_MS_SHARED_MEMORY", 1);
+#endif
 }
 
 
@@ -294,6 +297,7 @@ void *_starpu_tcpip_src_worker(void *arg)
 			struct _starpu_worker *worker = &config->workers[baseworkerid+i];
 			snprintf(worker->name, sizeof(worker->name), "TCPIP_MS %u core %u", devid, i);
 			snprintf(worker->short_name, sizeof(worker->short_name), "TCPIP_MS %u.%u", devid, i);
+			_starpu_src_common_init_pipeline(worker, "STARPU_TCPIP_MS_PIPELINE");
 		}
 
 
@@ -21,12 +21,16 @@
  * bound of the performance that could have theoretically been achieved
  */
 
+#include <ctype.h>
+#include <errno.h>
 #include <starpu.h>
 #include <starpu_config.h>
 #include <profiling/bound.h>
 #include <core/jobs.h>
 #include <core/workers.h>
 #include <datawizard/memory_nodes.h>
+#include <common/uthash.h>
+#include <common/knobs.h>
 
 #ifdef STARPU_HAVE_GLPK_H
 #include <glpk.h>
@@ -34,7 +38,7 @@
 
 /* TODO: output duration between starpu_bound_start and starpu_bound_stop */
 
-/* TODO: compute critical path and introduce it in the LP */
+/* TODO: introduce the critical path in the LP */
 
 /*
  * Record without dependencies: just count each kind of task
@@ -49,16 +53,34 @@
  * - the total number of tasks of a given kind is equal to the number run by the
  *   application.
  */
-struct bound_task_pool
+struct bound_task_pool_key
 {
 	/* Which codelet has been executed */
 	struct starpu_codelet *cl;
 	/* Task footprint key (for history-based perfmodel) */
 	uint32_t footprint;
+};
+
+struct bound_task_pool
+{
+	/* Kind of the tasks, zeroed before being filled, since it is hashed
+	 * with its padding */
+	struct bound_task_pool_key key;
 	/* Number of tasks of this kind */
 	unsigned long n;
+	/* Expected duration (us) on each worker type, NAN if it can not run there */
+	double durations[STARPU_NARCH];
+	/* Fastest expected duration (us) */
+	double best;
+	/* Whether the durations are known on all worker types which can run it */
+	int calibrated;
+	/* Value of n from which to query the performance models again, while
+	 * they are not calibrated */
+	unsigned long next_query;
 	/* Other task kinds */
 	struct bound_task_pool *next;
+	/* Hashed by key */
+	UT_hash_handle hh;
 };
 
 /*
@@ -108,6 +130,8 @@ struct bound_task
 
 	/* Other tasks */
 	struct bound_task *next;
+	/* Hashed by id */
+	UT_hash_handle hh;
 };
 
 struct bound_tag_dep
@@ -117,9 +141,45 @@ struct bound_tag_dep
 	struct bound_tag_dep *next;
 };
 
-static struct bound_task_pool *task_pools, *last;
-static struct bound_task *tasks;
+/*
+ * Streaming bounds, computed whatever the recording mode
+ *
+ * Each task gets an earliest completion time, computed on the fly from the
+ * completion times of the tasks it depends on, plus its fastest expected
+ * duration. Tasks being submitted after the tasks they depend on, this is a
+ * longest-path computation over the DAG which does not need to keep the DAG
+ * itself: only the completion time of each task is kept. The area bound only
+ * needs to accumulate the expected durations.
+ */
+struct bound_cp_task
+{
+	/* Unique ID */
+	unsigned long id;
+	/* Earliest start time (us), according to the dependencies recorded so far */
+	double start;
+	/* Earliest completion time (us), NAN until the task gets submitted */
+	double end;
+	UT_hash_handle hh;
+};
+
+static struct bound_task_pool *task_pools, *last, *task_pools_hash;
+static struct bound_task *tasks, *tasks_hash;
 static struct bound_tag_dep *tag_deps;
+static struct bound_cp_task *cp_tasks;
+/* Entries of terminated tasks are only kept for the last CP_FINISHED_KEEP of
+ * them, for the tasks submitted later which depend on them through data */
+#define CP_FINISHED_KEEP 1024
+static unsigned long cp_finished[CP_FINISHED_KEEP];
+static unsigned long cp_nfinished;
+/* Length of the critical path (us) */
+static double cp_length;
+/* Sum of the fastest expected durations of the tasks (us) */
+static double area_best;
+/* Sum of the expected durations of the tasks on each worker type (us) */
+static double area_arch[STARPU_NARCH];
+/* Number of tasks recorded while their performance models were not all
+ * calibrated, which makes the bounds incomplete */
+static unsigned long cp_nuncalibrated;
 int _starpu_bound_recording;
 static int recorddeps;
 static int recordprio;
@@ -131,19 +191,32 @@ static void _starpu_bound_clear(int record, int deps, int prio)
 	struct bound_task_pool *tp;
 	struct bound_task *t;
 	struct bound_tag_dep *td;
+	struct bound_cp_task *cp, *c, *c_tmp;
+	enum starpu_worker_archtype type;
 
 	STARPU_PTHREAD_MUTEX_LOCK(&mutex);
 
 	tp = task_pools;
 	task_pools = NULL;
 	last = NULL;
+	HASH_CLEAR(hh, task_pools_hash);
 
 	t = tasks;
 	tasks = NULL;
+	HASH_CLEAR(hh, tasks_hash);
 
 	td = tag_deps;
 	tag_deps = NULL;
 
+	cp = cp_tasks;
+	cp_tasks = NULL;
+	cp_nfinished = 0;
+	cp_nuncalibrated = 0;
+	cp_length = 0.;
+	area_best = 0.;
+	for (type = 0; type < STARPU_NARCH; type++)
+		area_arch[type] = 0.;
+
 	_starpu_bound_recording = record;
 	recorddeps = deps;
 	recordprio = prio;
@@ -181,6 +254,12 @@ static void _starpu_bound_clear(int record, int deps, int prio)
 		free(td);
 		td = next;
 	}
+
+	HASH_ITER(hh, cp, c, c_tmp)
+	{
+		HASH_DEL(cp, c);
+		free(c);
+	}
 }
 
 void starpu_bound_clear(void)
@@ -270,6 +349,101 @@ static void new_task(struct _starpu_job *j)
 	t->next = tasks;
 	j->bound_task = t;
 	tasks = t;
+	HASH_ADD(hh, tasks_hash, id, sizeof(t->id), t);
+}
+
+/* Get the streaming bound entry of the job, creating it if needed */
+static struct bound_cp_task *cp_task(struct _starpu_job *j)
+{
+	struct bound_cp_task *c;
+	unsigned long id = j->job_id;
+
+	HASH_FIND(hh, cp_tasks, &id, sizeof(id), c);
+	if (!c)
+	{
+		_STARPU_MALLOC(c, sizeof(*c));
+		c->id = id;
+		c->start = 0.;
+		c->end = NAN;
+		HASH_ADD(hh, cp_tasks, id, sizeof(c->id), c);
+	}
+	return c;
+}
+
+/* Job J depends on job of id ID, push its earliest start time accordingly */
+static void cp_dep(struct _starpu_job *j, unsigned long id)
+{
+	struct bound_cp_task *dep, *c;
+
+	HASH_FIND(hh, cp_tasks, &id, sizeof(id), dep);
+	if (!dep || isnan(dep->end))
+		/* Not recorded, or not submitted yet, we can not take it into account */
+		return;
+
+	c = cp_task(j);
+	if (dep->end > c->start)
+		c->start = dep->end;
+}
+
+/* Compute the expected duration (us) of the job on each worker type, NAN if
+ * it can not run there, and the fastest one in *BEST. Return whether all
+ * durations are known */
+static int cp_durations(struct _starpu_job *j, double durations[STARPU_NARCH], double *best)
+{
+	enum starpu_worker_archtype type;
+	int calibrated = 1;
+
+	*best = NAN;
+
+	for (type = 0; type < STARPU_NARCH; type++)
+	{
+		/* Workers of the same type are assumed to be alike */
+		int workerid = starpu_worker_get_by_type(type, 0);
+		unsigned nimpl;
+
+		durations[type] = NAN;
+		if (workerid < 0)
+			continue;
+
+		struct starpu_perfmodel_arch *arch = starpu_worker_get_perf_archtype(workerid, STARPU_NMAX_SCHED_CTXS);
+		for (nimpl = 0; nimpl < STARPU_MAXIMPLEMENTATIONS; nimpl++)
+		{
+			if (!starpu_worker_can_execute_task(workerid, j->task, nimpl))
+				continue;
+			double length = starpu_task_expected_length(j->task, arch, nimpl);
+			if (isnan(length))
+				calibrated = 0;
+			else if (isnan(durations[type]) || length < durations[type])
+				durations[type] = length;
+		}
+		if (!isnan(durations[type]) && (isnan(*best) || durations[type] < *best))
+			*best = durations[type];
+	}
+	return calibrated;
+}
+
+/* Job J was submitted, with all its dependencies already recorded */
+static void cp_record(struct _starpu_job *j, const double durations[STARPU_NARCH], double best)
+{
+	struct bound_cp_task *c = cp_task(j);
+	enum starpu_worker_archtype type;
+
+	for (type = 0; type < STARPU_NARCH; type++)
+	{
+		if (isnan(durations[type]))
+			/* This worker type alone can not process all tasks */
+			area_arch[type] = INFINITY;
+		else
+			area_arch[type] += durations[type];
+	}
+
+	if (isnan(best))
+		/* Not calibrated anywhere, only keep the dependencies */
+		best = 0.;
+	area_best += best;
+	c->end = c->start + best;
+	if (c->end > cp_length)
+		cp_length = c->end;
 }
 
 /* A new task was submitted, record it */
@@ -290,39 +464,97 @@ void _starpu_bound_record(struct _starpu_job *j)
 	}
 
 	if (recorddeps)
-	{
 		new_task(j);
-	}
-	else
+
+	/* Task kinds are always aggregated, for the linear programming
+	 * problem which does not consider dependencies, and for the
+	 * expected durations */
 	{
 		struct bound_task_pool *tp;
 
 		_starpu_compute_buffers_footprint(j->task->cl?j->task->cl->model:NULL, NULL, 0, j);
 
-		if (last && last->cl == j->task->cl && last->footprint == j->footprint)
+		if (last && last->key.cl == j->task->cl && last->key.footprint == j->footprint)
 			tp = last;
 		else
-			for (tp = task_pools; tp; tp = tp->next)
-				if (tp->cl == j->task->cl && tp->footprint == j->footprint)
-					break;
+		{
+			struct bound_task_pool_key key;
+			memset(&key, 0, sizeof(key));
+			key.cl = j->task->cl;
+			key.footprint = j->footprint;
+			HASH_FIND(hh, task_pools_hash, &key, sizeof(key), tp);
+		}
 
 		if (!tp)
 		{
-			_STARPU_MALLOC(tp, sizeof(*tp));
-			tp->cl = j->task->cl;
-			tp->footprint = j->footprint;
+			_STARPU_CALLOC(tp, 1, sizeof(*tp));
+			tp->key.cl = j->task->cl;
+			tp->key.footprint = j->footprint;
 			tp->n = 0;
 			tp->next = task_pools;
 			task_pools = tp;
+			HASH_ADD(hh, task_pools_hash, key, sizeof(tp->key), tp);
 		}
+		last = tp;
 
 		/* One more task of this kind */
 		tp->n++;
+
+		/* Expected durations only depend on the kind of task, so only
+		 * query the performance models until they are all known. While
+		 * they are not, the miss is kept for twice as many tasks as
+		 * there were so far, so that the models get queried only a
+		 * logarithmic number of times. */
+		if (!tp->calibrated && tp->n >= tp->next_query)
+		{
+			tp->calibrated = cp_durations(j, tp->durations, &tp->best);
+			tp->next_query = 2 * tp->n;
+		}
+
+		if (!tp->calibrated)
+			cp_nuncalibrated++;
+		cp_record(j, tp->durations, tp->best);
 	}
 
 	STARPU_PTHREAD_MUTEX_UNLOCK(&mutex);
 }
 
+/* A task terminated, only keep its streaming bound entry for a while */
+void _starpu_bound_job_terminated(struct _starpu_job *j)
+{
+	struct bound_cp_task *c;
+	unsigned long id = j->job_id;
+
+	if (STARPU_LIKELY(!_starpu_bound_recording))
+		return;
+
+	if (!good_job(j))
+		return;
+
+	STARPU_PTHREAD_MUTEX_LOCK(&mutex);
+	HASH_FIND(hh, cp_tasks, &id, sizeof(id), c);
+	if (c)
+	{
+		unsigned slot = cp_nfinished % CP_FINISHED_KEEP;
+		if (cp_nfinished >= CP_FINISHED_KEEP)
+		{
+			/* Drop the entry of an older terminated task, tasks
+			 * which will depend on it will just not take it into
+			 * account */
+			struct bound_cp_task *old;
+			HASH_FIND(hh, cp_tasks, &cp_finished[slot], sizeof(cp_finished[slot]), old);
+			if (old)
+			{
+				HASH_DEL(cp_tasks, old);
+				free(old);
+			}
+		}
+		cp_finished[slot] = id;
+		cp_nfinished++;
+	}
+	STARPU_PTHREAD_MUTEX_UNLOCK(&mutex);
+}
+
 /* A tag dependency was emitted, record it */
 void _starpu_bound_tag_dep(starpu_tag_t id, starpu_tag_t dep_id)
 {
@@ -353,7 +585,7 @@ void _starpu_bound_task_dep(struct _starpu_job *j, struct _starpu_job *dep_j)
 	struct bound_task *t;
 	int i;
 
-	if (!_starpu_bound_recording || !recorddeps)
+	if (!_starpu_bound_recording)
 		return;
 
 	if (!good_job(j) || !good_job(dep_j))
@@ -361,7 +593,14 @@ void _starpu_bound_task_dep(struct _starpu_job *j, struct _starpu_job *dep_j)
 
 	STARPU_PTHREAD_MUTEX_LOCK(&mutex);
 	/* Re-check, this time with mutex held */
-	if (!_starpu_bound_recording || !recorddeps)
+	if (!_starpu_bound_recording)
+	{
+		STARPU_PTHREAD_MUTEX_UNLOCK(&mutex);
+		return;
+	}
+
+	cp_dep(j, dep_j->job_id);
+	if (!recorddeps)
 	{
 		STARPU_PTHREAD_MUTEX_UNLOCK(&mutex);
 		return;
@@ -388,10 +627,8 @@ static struct bound_task *find_job(unsigned long id)
 {
 	struct bound_task *t;
 
-	for (t = tasks; t; t = t->next)
-		if (t->id == id)
-			return t;
-	return NULL;
+	HASH_FIND(hh, tasks_hash, &id, sizeof(id), t);
+	return t;
 }
 
 /* Job J depends on previous job of id ID (which is already finished) */
@@ -400,7 +637,7 @@ void _starpu_bound_job_id_dep_size(size_t size, struct _starpu_job *j, unsigned
 	struct bound_task *t, *dep_t;
 	int i;
 
-	if (!_starpu_bound_recording || !recorddeps)
+	if (!_starpu_bound_recording)
 		return;
 
 	if (!good_job(j))
@@ -408,7 +645,14 @@ void _starpu_bound_job_id_dep_size(size_t size, struct _starpu_job *j, unsigned
 
 	STARPU_PTHREAD_MUTEX_LOCK(&mutex);
 	/* Re-check, this time with mutex held */
-	if (!_starpu_bound_recording || !recorddeps)
+	if (!_starpu_bound_recording)
+	{
+		STARPU_PTHREAD_MUTEX_UNLOCK(&mutex);
+		return;
+	}
+
+	cp_dep(j, id);
+	if (!recorddeps)
 	{
 		STARPU_PTHREAD_MUTEX_UNLOCK(&mutex);
 		return;
@@ -442,13 +686,14 @@ void _starpu_bound_job_id_dep_size(size_t size, struct _starpu_job *j, unsigned
 
 void _starpu_bound_job_id_dep(starpu_data_handle_t handle, struct _starpu_job *j, unsigned long id)
 {
-	if (!_starpu_bound_recording || !recorddeps)
+	if (!_starpu_bound_recording)
 		return;
 
 	if (!good_job(j))
 		return;
 
-	_starpu_bound_job_id_dep_size(_starpu_data_get_size(handle), j, id);
+	/* The data size is only needed for the complete DAG */
+	_starpu_bound_job_id_dep_size(recorddeps ? _starpu_data_get_size(handle) : 0, j, id);
 }
 
 void starpu_bound_stop(void)
@@ -469,12 +714,12 @@ static void _starpu_get_tasks_times(int nw, int nt, double *times)
 		{
 			struct _starpu_job j =
 			{
-				.footprint = tp->footprint,
+				.footprint = tp->key.footprint,
 				.footprint_is_computed = 1,
 			};
 			struct starpu_perfmodel_arch* arch = starpu_worker_get_perf_archtype(w, STARPU_NMAX_SCHED_CTXS);
-			double length = _starpu_history_based_job_expected_perf(tp->cl->model, arch, &j, j.nimpl)
-			              - _starpu_history_based_job_expected_deviation(tp->cl->model, arch, &j, j.nimpl);
+			double length = _starpu_history_based_job_expected_perf(tp->key.cl->model, arch, &j, j.nimpl)
+			              - _starpu_history_based_job_expected_deviation(tp->key.cl->model, arch, &j, j.nimpl);
 			if (isnan(length))
 				times[w*nt+t] = NAN;
 			else
@@ -854,11 +1099,11 @@ void starpu_bound_print_lp(FILE *output)
 			for (t = 0, tp = task_pools; tp; t++, tp = tp->next)
 			{
 				int got_one = 0;
-				fprintf(output, "/* task %s key %x */\n0", _starpu_codelet_get_model_name(tp->cl), (unsigned) tp->footprint);
+				fprintf(output, "/* task %s key %x */\n0", _starpu_codelet_get_model_name(tp->key.cl), (unsigned) tp->key.footprint);
 				for (w = 0; w < nw; w++)
 				{
 					if (isnan(times[w*nt+t]))
-						_STARPU_MSG("Warning: task %s has no performance measurement for worker %d.\n", _starpu_codelet_get_model_name(tp->cl), w);
+						_STARPU_MSG("Warning: task %s has no performance measurement for worker %d.\n", _starpu_codelet_get_model_name(tp->key.cl), w);
 					else
 					{
 						got_one = 1;
@@ -867,11 +1112,11 @@ void starpu_bound_print_lp(FILE *output)
 				}
 				fprintf(output, " = %lu;\n", tp->n);
 				if (!got_one)
-					_STARPU_MSG("Warning: task %s has no performance measurement for any worker, system will not be solvable!\n", _starpu_codelet_get_model_name(tp->cl));
+					_STARPU_MSG("Warning: task %s has no performance measurement for any worker, system will not be solvable!\n", _starpu_codelet_get_model_name(tp->key.cl));
 				/* Show actual values */
 				fprintf(output, "/*");
 				for (w = 0; w < nw; w++)
-					fprintf(output, "\t+%lu", tp->cl->per_worker_stats[w]);
+					fprintf(output, "\t+%lu", tp->key.cl->per_worker_stats[w]);
 				fprintf(output, "\t*/\n\n");
 			}
 
@@ -949,7 +1194,7 @@ void starpu_bound_print_mps(FILE *output)
 		fprintf(output, "*\n* And we have to have computed exactly all tasks\n*\n");
 		for (t = 0, tp = task_pools; tp; t++, tp = tp->next)
 		{
-			fprintf(output, "* task %s key %x\n", _starpu_codelet_get_model_name(tp->cl), (unsigned) tp->footprint);
+			fprintf(output, "* task %s key %x\n", _starpu_codelet_get_model_name(tp->key.cl), (unsigned) tp->key.footprint);
 			fprintf(output, " E  T%d\n", t);
 		}
 
@@ -1085,7 +1330,7 @@ static glp_prob *_starpu_bound_glp_resolve(int integer)
 		{
 			char name[32], title[64];
 			starpu_worker_get_name(w, name, sizeof(name));
-			snprintf(title, sizeof(title), "task %s key %x", _starpu_codelet_get_model_name(tp->cl), (unsigned) tp->footprint);
+			snprintf(title, sizeof(title), "task %s key %x", _starpu_codelet_get_model_name(tp->key.cl), (unsigned) tp->key.footprint);
 			glp_set_row_name(lp, nw+t+1, title);
 			for (w = 0; w < nw; w++)
 			{
@@ -1127,6 +1372,13 @@ static glp_prob *_starpu_bound_glp_resolve(int integer)
 /* Print the computed bound as well as the optimized distribution of tasks */
 void starpu_bound_print(FILE *output, int integer)
 {
+	double critical_path, area;
+
+	if (starpu_bound_compute_critical_path(&critical_path, &area, NULL))
+		fprintf(output, "Some performance models are not calibrated, the following bounds are incomplete\n");
+	fprintf(output, "Critical path: %f ms\n", critical_path);
+	fprintf(output, "Area bound: %f ms\n", area);
+
 #ifdef STARPU_HAVE_GLPK_H
 	if (recorddeps)
 	{
@@ -1154,7 +1406,7 @@ void starpu_bound_print(FILE *output, int integer)
 
 		for (t = 0, tp = task_pools; tp; t++, tp = tp->next)
 		{
-			fprintf(output, "%s key %x\n", _starpu_codelet_get_model_name(tp->cl), (unsigned) tp->footprint);
+			fprintf(output, "%s key %x\n", _starpu_codelet_get_model_name(tp->key.cl), (unsigned) tp->key.footprint);
 			for (w = 0; w < nw; w++)
 				if (integer)
 					fprintf(output, "\tw%dt%dn %f", w, t, glp_mip_col_val(lp, colnum(w, t)));
@@ -1207,3 +1459,88 @@ void starpu_bound_compute(double *res, double *integer_res, int integer)
 	*res = 0.;
 #endif /* STARPU_HAVE_GLPK_H */
 }
+
+/* Return the streaming bounds, in ms, and whether they are incomplete */
+int starpu_bound_compute_critical_path(double *critical_path, double *area, double *per_arch_area)
+{
+	enum starpu_worker_archtype type;
+	unsigned nworkers = starpu_worker_get_count();
+	int ret;
+
+	STARPU_PTHREAD_MUTEX_LOCK(&mutex);
+	if (critical_path)
+		*critical_path = cp_length / 1000.;
+	if (area)
+		*area = nworkers ? area_best / nworkers / 1000. : 0.;
+	if (per_arch_area)
+		for (type = 0; type < STARPU_NARCH; type++)
+		{
+			int n = starpu_worker_get_count_by_type(type);
+			if (n <= 0)
+				per_arch_area[type] = INFINITY;
+			else
+				per_arch_area[type] = area_arch[type] / n / 1000.;
+		}
+	ret = cp_nuncalibrated ? -EAGAIN : 0;
+	STARPU_PTHREAD_MUTEX_UNLOCK(&mutex);
+	return ret;
+}
+
+/* - */
+
+/* global counters */
+static int __g_critical_path;
+static int __g_area;
+static int __g_incomplete;
+static int __g_arch_area[STARPU_NARCH];
+static char __g_arch_area_name[STARPU_NARCH][64];
+
+static void global_sample_updater(struct starpu_perf_counter_sample *sample, void *context)
+{
+	STARPU_ASSERT(context == NULL); /* no context for the global updater */
+	(void)context;
+
+	double critical_path, area, per_arch_area[STARPU_NARCH];
+	enum starpu_worker_archtype type;
+
+	if (!_starpu_bound_recording && !cp_length)
+		/* Nothing recorded */
+		return;
+
+	int incomplete = starpu_bound_compute_critical_path(&critical_path, &area, per_arch_area) != 0;
+	_starpu_perf_counter_sample_set_int32_value(sample, __g_incomplete, incomplete);
+	_starpu_perf_counter_sample_set_double_value(sample, __g_critical_path, critical_path);
+	_starpu_perf_counter_sample_set_double_value(sample, __g_area, area);
+	for (type = 0; type < STARPU_NARCH; type++)
+		if (__g_arch_area[type] >= 0)
+			_starpu_perf_counter_sample_set_double_value(sample, __g_arch_area[type], per_arch_area[type]);
+}
+
+void _starpu__bound_c__register_counters(void)
+{
+	const enum starpu_perf_counter_scope scope = starpu_perf_counter_scope_global;
+	enum starpu_worker_archtype type;
+
+	__STARPU_PERF_COUNTER_REG("starpu.bound", scope, g_critical_path, double, "length of the critical path of the tasks recorded since starpu_bound_start() (ms)");
+	__STARPU_PERF_COUNTER_REG("starpu.bound", scope, g_area, double, "area bound of the tasks recorded since starpu_bound_start(), with each task on its fastest worker type (ms)");
+	__STARPU_PERF_COUNTER_REG("starpu.bound", scope, g_incomplete, int32, "1 if some tasks were recorded while their performance models were not calibrated, the bounds being then lower than they should");
+	for (type = 0; type < STARPU_NARCH; type++)
+	{
+		const char *arch_name = starpu_driver_info[type].name_var;
+		char *c;
+
+		if (!arch_name)
+		{
+			/* No driver for this worker type */
+			__g_arch_area[type] = -1;
+			continue;
+		}
+		snprintf(__g_arch_area_name[type], sizeof(__g_arch_area_name[type]), "starpu.bound.g_%s_area", arch_name);
+		for (c = __g_arch_area_name[type]; *c; c++)
+			*c = tolower(*c);
+		__g_arch_area[type] = _starpu_perf_counter_register(scope, __g_arch_area_name[type], starpu_perf_counter_type_double,
+				"area bound of the tasks recorded since starpu_bound_start(), using only the workers of this type (ms)");
+	}
+
+	_starpu_perf_counter_register_updater(scope, global_sample_updater);
+}
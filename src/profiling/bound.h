@@ -31,6 +31,9 @@ extern int _starpu_bound_recording;
 /** Record task for bound computation */
 extern void _starpu_bound_record(struct _starpu_job *j);
 
+/** Task terminated, forget about it */
+extern void _starpu_bound_job_terminated(struct _starpu_job *j);
+
 /** Record tag dependency: id depends on dep_id */
 extern void _starpu_bound_tag_dep(starpu_tag_t id, starpu_tag_t dep_id);
 
@@ -520,7 +520,7 @@ static void unregister_ram_pointer(starpu_data_handle_t handle, unsigned node)
 void starpu_omp_handle_unregister(starpu_data_handle_t handle)
 {
 	unsigned node;
-	for (node = 0; node < STARPU_MAXNODES; node++)
+	for (node = 0; node < handle->nreplicates; node++)
 	{
 		struct _starpu_data_replicate *local = &handle->per_node[node];
 		STARPU_ASSERT(!local->refcnt);
@@ -2773,7 +2773,7 @@ void starpu_omp_vector_annotate(starpu_data_handle_t handle, uint32_t slice_base
 {
 	unsigned node;
 
-	for (node = 0; node < STARPU_MAXNODES; node++)
+	for (node = 0; node < handle->nreplicates; node++)
 	{
 		struct starpu_vector_interface *vector_interface = (struct starpu_vector_interface *)
 			starpu_data_get_interface_on_node(handle, node);
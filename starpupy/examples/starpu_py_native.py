@@ -0,0 +1,96 @@
+# StarPU --- Runtime system for heterogeneous multicore architectures.
+#
+# Copyright (C) 2023  Universit'e de Bordeaux, CNRS (LaBRI UMR 5800), Inria
+#
+# StarPU is free software; you can redistribute it and/or modify
+# it under the terms of the GNU Lesser General Public License as published by
+# the Free Software Foundation; either version 2.1 of the License, or (at
+# your option) any later version.
+#
+# StarPU is distributed in the hope that it will be useful, but
+# WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+#
+# See the GNU Lesser General Public License in COPYING.LGPL for more details.
+#
+
+# Check that functions marked with starpu.native run their native entry point
+# when the arguments allow it, and the Python function otherwise
+
+import starpu
+from starpu import starpupy
+from starpu import Handle
+import asyncio
+import array
+import ctypes
+
+try:
+        starpu.init()
+except Exception as e:
+        print(e)
+        exit(77)
+
+if starpupy.worker_get_count_by_type(starpu.STARPU_MPI_MS_WORKER) >= 1 or starpupy.worker_get_count_by_type(starpu.STARPU_TCPIP_MS_WORKER) >= 1:
+	print("This program does not work in MS mode")
+	starpu.shutdown()
+	exit(77)
+
+# the native entry point, built with ctypes so that the test does not need numba
+NATIVE_PROTO = ctypes.CFUNCTYPE(None, ctypes.POINTER(ctypes.c_void_p), ctypes.POINTER(ctypes.c_int64), ctypes.c_int32, ctypes.POINTER(ctypes.c_int64), ctypes.c_int32, ctypes.POINTER(ctypes.c_double), ctypes.c_int32)
+
+native_calls = 0
+
+def fill_native(buffers, sizes, nbuffers, iscalars, niscalars, fscalars, nfscalars):
+	global native_calls
+	native_calls += 1
+	assert nbuffers == 1 and sizes[0] == 2 * 8
+	assert niscalars == 1 and nfscalars == 1
+	a = ctypes.cast(buffers[0], ctypes.POINTER(ctypes.c_int64))
+	a[0] = iscalars[0]
+	a[1] = int(fscalars[0] * 2)
+
+fill_native_c = NATIVE_PROTO(fill_native)
+fill_address = ctypes.cast(fill_native_c, ctypes.c_void_p).value
+
+# the Python version of the same function, called when the native one can not be
+@starpu.native(address=fill_address)
+def fill(a, n, f):
+	return "python"
+
+# not marked with starpu.native, the address attribute must be ignored
+def fill_unmarked(a, n, f):
+	return "python"
+fill_unmarked.address = fill_address
+
+async def main():
+	a = array.array('q', [0, 0])
+	a_h = Handle(a)
+	big = 2**53 + 1
+
+	# native path, the integer must not go through a double
+	res = await(starpu.task_submit(modes={id(a_h): "RW"})(fill, a_h, big, 1.5))
+	assert res is None, res
+	assert native_calls == 1, native_calls
+	values = a_h.get()
+	assert values[0] == big, values[0]
+	assert values[1] == 3, values[1]
+
+	# some argument is not a scalar, fall back to the Python function
+	res = await(starpu.task_submit(modes={id(a_h): "RW"})(fill, a_h, "string", 1.5))
+	assert res == "python", res
+
+	# integer which does not fit in int64, fall back to the Python function
+	res = await(starpu.task_submit(modes={id(a_h): "RW"})(fill, a_h, 2**70, 1.5))
+	assert res == "python", res
+
+	# not marked as native
+	res = await(starpu.task_submit(modes={id(a_h): "RW"})(fill_unmarked, a_h, big, 1.5))
+	assert res == "python", res
+
+	assert native_calls == 1, native_calls
+
+	a_h.unregister()
+
+asyncio.run(main())
+
+starpu.shutdown()
@@ -47,3 +47,11 @@ def set_access(func, **kwargs):
 
 
 
+
+# mark func as compiled to native code, tasks may then call its entry point
+# (func.address, e.g. for numba.cfunc, unless address is given) without the GIL
+def native(address=None):
+	def native_decorator(func):
+		setattr(func, 'starpu_native', func.address if address is None else address)
+		return func
+	return native_decorator
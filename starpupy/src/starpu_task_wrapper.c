@@ -133,10 +133,251 @@ static pthread_t thread_id;
 static PyThreadState *orig_thread_states[STARPU_NMAXWORKERS];
 static PyThreadState *new_thread_states[STARPU_NMAXWORKERS];
 
+/* STARPUPY_FUNC_CACHE: keep the pickled version of the submitted functions,
+ * at most STARPUPY_FUNC_CACHE_SIZE of them, the least recently used ones
+ * being evicted first */
+static int func_cache_enabled = 0;
+static Py_ssize_t func_cache_size = 256;
+static PyObject *func_pickle_cache = NULL; /*function -> cloudpickled bytes, in the main interpreter*/
+static PyObject *func_cache[STARPU_NMAXWORKERS]; /*cloudpickled bytes -> function, in each sub-interpreter*/
+
+/* A cloudpickle stream always starts with the PROTO opcode (0x80), this
+ * first byte tells the compact encoding of argument lists apart */
+#define STARPUPY_ARGS_COMPACT 'S'
+
+/* Codelet of the tasks whose function is compiled to native code, it is
+ * called without the GIL. This is freed by starpupy_native_cb_func */
+struct starpupy_native_codelet
+{
+	struct starpu_codelet cl; /*must be first*/
+	void (*func)(void **buffers, int64_t *sizes, int32_t nbuffers, int64_t *iscalars, int32_t niscalars, double *fscalars, int32_t nfscalars);
+	int32_t niscalars;
+	int32_t nfscalars;
+	double *fscalars; /*points after the niscalars integers in iscalars*/
+	int64_t iscalars[];
+};
+
 /*********************************************************************************************/
 
 static uint32_t where_inter = STARPU_CPU;
 
+/*encode argList without cloudpickle when it only contains handle tokens and plain scalars, return 0 otherwise. arg_data has to be freed*/
+static int starpupy_args_compact_dumps(PyObject *argList, char **arg_data, Py_ssize_t *arg_data_size)
+{
+	Py_ssize_t nargs = PyTuple_Size(argList);
+	/*one tag byte, and at most 8 bytes per argument*/
+	char *buf = malloc(1 + nargs * (1 + sizeof(int64_t)));
+	char *ptr = buf;
+	Py_ssize_t i;
+
+	*ptr++ = STARPUPY_ARGS_COMPACT;
+	for(i=0; i < nargs; i++)
+	{
+		PyObject *obj = PyTuple_GetItem(argList, i);
+		if (strcmp(Py_TYPE(obj)->tp_name, "Handle_token") == 0)
+		{
+			*ptr++ = 'h';
+		}
+		else if (obj == Py_None)
+		{
+			*ptr++ = 'n';
+		}
+		else if (PyBool_Check(obj))
+		{
+			*ptr++ = (obj == Py_True) ? 'T' : 'F';
+		}
+		else if (PyLong_CheckExact(obj))
+		{
+			int overflow;
+			int64_t val = PyLong_AsLongLongAndOverflow(obj, &overflow);
+			if (overflow)
+				break;
+			*ptr++ = 'i';
+			memcpy(ptr, &val, sizeof(val));
+			ptr += sizeof(val);
+		}
+		else if (PyFloat_CheckExact(obj))
+		{
+			double val = PyFloat_AS_DOUBLE(obj);
+			*ptr++ = 'd';
+			memcpy(ptr, &val, sizeof(val));
+			ptr += sizeof(val);
+		}
+		else
+			break;
+	}
+
+	if (i < nargs)
+	{
+		/*some argument needs cloudpickle*/
+		free(buf);
+		return 0;
+	}
+
+	*arg_data = buf;
+	*arg_data_size = ptr - buf;
+	return 1;
+}
+
+/*decode the argument list encoded by starpupy_args_compact_dumps, handle tokens are replaced by Ellipsis, return a new reference*/
+static PyObject *starpupy_args_compact_loads(char *arg_data, size_t arg_data_size)
+{
+	char *ptr = arg_data + 1;
+	char *end = arg_data + arg_data_size;
+	PyObject *list = PyList_New(0);
+
+	while (ptr < end)
+	{
+		PyObject *obj;
+		char tag = *ptr++;
+		switch (tag)
+		{
+			case 'h':
+				obj = Py_Ellipsis;
+				Py_INCREF(obj);
+				break;
+			case 'n':
+				obj = Py_None;
+				Py_INCREF(obj);
+				break;
+			case 'T':
+				obj = Py_True;
+				Py_INCREF(obj);
+				break;
+			case 'F':
+				obj = Py_False;
+				Py_INCREF(obj);
+				break;
+			case 'i':
+			{
+				int64_t val;
+				memcpy(&val, ptr, sizeof(val));
+				ptr += sizeof(val);
+				obj = PyLong_FromLongLong(val);
+				break;
+			}
+			case 'd':
+			{
+				double val;
+				memcpy(&val, ptr, sizeof(val));
+				ptr += sizeof(val);
+				obj = PyFloat_FromDouble(val);
+				break;
+			}
+			default:
+				STARPU_ASSERT_MSG(0, "unexpected argument tag %c\n", tag);
+		}
+		PyList_Append(list, obj);
+		Py_DECREF(obj);
+	}
+
+	PyObject *argList = PyList_AsTuple(list);
+	Py_DECREF(list);
+	return argList;
+}
+
+/*look key up in the cache, and mark it as most recently used, return a new reference or NULL*/
+static PyObject *starpupy_func_cache_get(PyObject *cache, PyObject *key)
+{
+	PyObject *value = PyDict_GetItem(cache, key);
+	if (!value)
+		return NULL;
+
+	/*protect borrowed reference*/
+	Py_INCREF(value);
+	/*dicts keep the insertion order, move it to the end*/
+	if (PyDict_DelItem(cache, key) || PyDict_SetItem(cache, key, value))
+		PyErr_Clear();
+	return value;
+}
+
+/*add key to the cache, evicting the least recently used entries beyond func_cache_size*/
+static void starpupy_func_cache_put(PyObject *cache, PyObject *key, PyObject *value)
+{
+	if (PyDict_SetItem(cache, key, value))
+	{
+		/*unhashable keys are just not cached*/
+		PyErr_Clear();
+		return;
+	}
+
+	while (PyDict_Size(cache) > func_cache_size)
+	{
+		Py_ssize_t pos = 0;
+		PyObject *oldest, *oldest_value;
+		if (!PyDict_Next(cache, &pos, &oldest, &oldest_value))
+			break;
+		/*protect borrowed reference while removing it*/
+		Py_INCREF(oldest);
+		if (PyDict_DelItem(cache, oldest))
+			PyErr_Clear();
+		Py_DECREF(oldest);
+	}
+}
+
+/*load the function pickled by the main interpreter, through the cache of the current sub-interpreter if enabled, return a new reference*/
+static PyObject *starpupy_func_loads(char *func_data, size_t func_data_size)
+{
+	if (!func_cache_enabled)
+		return starpu_cloudpickle_loads(func_data, func_data_size);
+
+	unsigned workerid = starpu_worker_get_id_check();
+	if (!func_cache[workerid])
+		func_cache[workerid] = PyDict_New();
+
+	PyObject *func_bytes = PyBytes_FromStringAndSize(func_data, func_data_size);
+	PyObject *pFunc = starpupy_func_cache_get(func_cache[workerid], func_bytes);
+	if (!pFunc)
+	{
+		pFunc = PyObject_CallFunctionObjArgs(loads, func_bytes, NULL);
+		if (pFunc)
+			starpupy_func_cache_put(func_cache[workerid], func_bytes, pFunc);
+	}
+	Py_DECREF(func_bytes);
+
+	return pFunc;
+}
+
+/*pickle the function, through the cache of the main interpreter if enabled, return the reference of PyBytes which must be kept while using func_data*/
+static PyObject *starpupy_func_dumps(PyObject *func_py, char **func_data, Py_ssize_t *func_data_size)
+{
+	if (!func_cache_enabled)
+		return starpu_cloudpickle_dumps(func_py, func_data, func_data_size);
+
+	if (!func_pickle_cache)
+		func_pickle_cache = PyDict_New();
+
+	PyObject *func_bytes = starpupy_func_cache_get(func_pickle_cache, func_py);
+	if (func_bytes)
+		PyBytes_AsStringAndSize(func_bytes, func_data, func_data_size);
+	else
+	{
+		/*unhashable callables make PyDict_GetItem fail silently*/
+		func_bytes = starpu_cloudpickle_dumps(func_py, func_data, func_data_size);
+		if (func_bytes)
+			starpupy_func_cache_put(func_pickle_cache, func_py, func_bytes);
+	}
+
+	return func_bytes;
+}
+
+/*return the entry point of a function compiled to native code, which was given by the starpu.native decorator as the integer "starpu_native" attribute, NULL otherwise*/
+static void *starpupy_native_address(PyObject *func_py)
+{
+	void *ptr = NULL;
+
+	if (!PyObject_HasAttrString(func_py, "starpu_native"))
+		return NULL;
+
+	PyObject *address = PyObject_GetAttrString(func_py, "starpu_native");
+	if (address && PyLong_Check(address))
+		ptr = PyLong_AsVoidPtr(address);
+	Py_XDECREF(address);
+	PyErr_Clear();
+
+	return ptr;
+}
+
 /* prologue_callback_func*/
 void starpupy_prologue_cb_func(void *cl_arg)
 {
@@ -270,12 +511,21 @@ void starpupy_prologue_cb_func(void *cl_arg)
 		{
 			/*repack func_data*/
 			starpu_codelet_pack_arg(&data, func_data, func_data_size);
-			/*use cloudpickle to dump argList*/
 			Py_ssize_t arg_data_size;
 			char* arg_data;
-			PyObject *arg_bytes = starpu_cloudpickle_dumps(argList, &arg_data, &arg_data_size);
-			starpu_codelet_pack_arg(&data, arg_data, arg_data_size);
-			Py_DECREF(arg_bytes);
+			if (starpupy_args_compact_dumps(argList, &arg_data, &arg_data_size))
+			{
+				/*only handles and scalars, no need for cloudpickle*/
+				starpu_codelet_pack_arg(&data, arg_data, arg_data_size);
+				free(arg_data);
+			}
+			else
+			{
+				/*use cloudpickle to dump argList*/
+				PyObject *arg_bytes = starpu_cloudpickle_dumps(argList, &arg_data, &arg_data_size);
+				starpu_codelet_pack_arg(&data, arg_data, arg_data_size);
+				Py_DECREF(arg_bytes);
+			}
 			Py_DECREF(argList);
 		}
 		else if (fut_flag)
@@ -315,6 +565,7 @@ void starpupy_codelet_func(void *descr[], void *cl_arg)
 	PyObject *pFunc;
 	PyObject *argList; /*argument list of python function passed in*/
 	int h_flag; /*detect return value is handle or not*/
+	int compact_args = 0; /*handle tokens are encoded as Ellipsis*/
 
 	/*make sure we own the GIL*/
 	PyGILState_STATE state = PyGILState_Ensure();
@@ -333,13 +584,19 @@ void starpupy_codelet_func(void *descr[], void *cl_arg)
 		/*get func_py char**/
 		starpu_codelet_pick_arg(&data, (void**)&func_data, &func_data_size);
 		/*use cloudpickle to load function (maybe only function name), return a new reference*/
-		pFunc=starpu_cloudpickle_loads(func_data, func_data_size);
+		pFunc=starpupy_func_loads(func_data, func_data_size);
 		if (!pFunc)
 			print_exception("cloudpickle could not unpack the function from the main interpreter");
 		/*get argList char**/
 		starpu_codelet_pick_arg(&data, (void**)&arg_data, &arg_data_size);
-		/*use cloudpickle to load argList*/
-		argList=starpu_cloudpickle_loads(arg_data, arg_data_size);
+		if (arg_data_size > 0 && arg_data[0] == STARPUPY_ARGS_COMPACT)
+		{
+			compact_args = 1;
+			argList=starpupy_args_compact_loads(arg_data, arg_data_size);
+		}
+		else
+			/*use cloudpickle to load argList*/
+			argList=starpu_cloudpickle_loads(arg_data, arg_data_size);
 		if (!argList)
 			print_exception("cloudpickle could not unpack the argument list from the main interpreter");
 	}
@@ -405,7 +662,7 @@ void starpupy_codelet_func(void *descr[], void *cl_arg)
 		/*protect borrowed reference, is decremented in the end of the loop*/
 		Py_INCREF(obj);
 		const char* tp = Py_TYPE(obj)->tp_name;
-		if(strcmp(tp, "Handle_token") == 0)
+		if((compact_args && obj == Py_Ellipsis) || strcmp(tp, "Handle_token") == 0)
 		{
 			/*if one of arguments is Handle, replace the Handle argument to the object*/
 			if ((task->handles[h_index] && STARPUPY_PYOBJ_CHECK(task->handles[h_index])) || STARPUPY_PYOBJ_CHECK_INTERFACE(descr[h_index]))
@@ -668,6 +925,103 @@ void starpupy_cb_func(void *v)
 	free(task->cl);
 }
 
+/*function passed to starpu_codelet.cpu_func when the python function is compiled to native code, the kernel directly gets the StarPU buffers and the GIL is not needed*/
+void starpupy_native_codelet_func(void *descr[], void *cl_arg)
+{
+	(void)cl_arg;
+	struct starpu_task *task = starpu_task_get_current();
+	struct starpupy_native_codelet *native_cl = (struct starpupy_native_codelet *) task->cl;
+	int32_t nbuffers = STARPU_TASK_GET_NBUFFERS(task);
+	void *buffers[STARPU_NMAXBUFS];
+	int64_t sizes[STARPU_NMAXBUFS];
+	int32_t i;
+
+	for(i=0; i < nbuffers; i++)
+	{
+		buffers[i] = STARPUPY_BUF_GET_PYBUF(descr[i]);
+		sizes[i] = STARPUPY_BUF_GET_NBUF(descr[i]);
+	}
+
+	native_cl->func(buffers, sizes, nbuffers, native_cl->iscalars, native_cl->niscalars, native_cl->fscalars, native_cl->nfscalars);
+
+	/*the kernel returns nothing, pack the None result as starpupy_codelet_func does*/
+	struct starpu_codelet_pack_arg_data data_ret;
+	starpu_codelet_pack_arg_init(&data_ret);
+	char* rv_data=NULL;
+	Py_ssize_t rv_data_size=0;
+	starpu_codelet_pack_arg(&data_ret, &rv_data_size, sizeof(rv_data_size));
+	starpu_codelet_pack_arg(&data_ret, &rv_data, sizeof(rv_data));
+	starpu_codelet_pack_arg_fini(&data_ret, &task->cl_ret, &task->cl_ret_size);
+	task->cl_ret_free = 1;
+}
+
+void starpupy_native_cb_func(void *v)
+{
+	(void)v;
+	struct starpu_task *task = starpu_task_get_current();
+
+	/*there is no prologue to free the name*/
+	free((void*)task->name);
+	/*deallocate task*/
+	free(task->cl);
+}
+
+/*switch func_cl to starpupy_native_codelet_func if all arguments are buffer handles or scalars, return the new codelet, or NULL if the task has to run the python function*/
+static struct starpupy_native_codelet *starpupy_native_codelet_prepare(struct starpu_codelet *func_cl, void *native_func, PyObject *argList, struct starpu_task *task, int nbuffer)
+{
+	Py_ssize_t nargs = PyTuple_Size(argList);
+	int32_t niscalars = 0, nfscalars = 0;
+	Py_ssize_t i;
+
+	for(i=0; i < nbuffer; i++)
+		if (!STARPUPY_BUF_CHECK(task->handles[i]))
+			return NULL;
+
+	for(i=0; i < nargs; i++)
+	{
+		PyObject *obj = PyTuple_GetItem(argList, i);
+		if (strcmp(Py_TYPE(obj)->tp_name, "Handle_token") == 0)
+			continue;
+		if (PyFloat_Check(obj))
+			nfscalars++;
+		else if (PyLong_Check(obj))
+		{
+			/*integers which do not fit in int64_t go through the interpreter*/
+			int overflow;
+			(void) PyLong_AsLongLongAndOverflow(obj, &overflow);
+			if (overflow)
+				return NULL;
+			niscalars++;
+		}
+		else
+			return NULL;
+	}
+
+	struct starpupy_native_codelet *native_cl = realloc(func_cl, sizeof(*native_cl) + niscalars * sizeof(int64_t) + nfscalars * sizeof(double));
+	STARPU_ASSERT(native_cl);
+	native_cl->func = native_func;
+	native_cl->niscalars = 0;
+	native_cl->nfscalars = 0;
+	native_cl->fscalars = (double *) &native_cl->iscalars[niscalars];
+	for(i=0; i < nargs; i++)
+	{
+		PyObject *obj = PyTuple_GetItem(argList, i);
+		if (strcmp(Py_TYPE(obj)->tp_name, "Handle_token") == 0)
+			continue;
+		if (PyFloat_Check(obj))
+			native_cl->fscalars[native_cl->nfscalars++] = PyFloat_AsDouble(obj);
+		else
+			native_cl->iscalars[native_cl->niscalars++] = PyLong_AsLongLong(obj);
+	}
+	PyErr_Clear();
+
+	native_cl->cl.cpu_funcs[0] = &starpupy_native_codelet_func;
+	/*the entry point only makes sense in this process, do not let master-slave workers run it*/
+	native_cl->cl.cpu_funcs_name[0] = NULL;
+
+	return native_cl;
+}
+
 /***********************************************************************************/
 /*PyObject*->struct starpu_task**/
 static struct starpu_task *PyTask_AsTask(PyObject *obj)
@@ -821,29 +1175,10 @@ static PyObject* starpu_task_submit_wrapper(PyObject *self, PyObject *args)
 	(void)self;
 	/*first argument in args is always the python function passed in*/
 	PyObject *func_py = PyTuple_GetItem(args, 0);
-	/*protect borrowed reference, used in codelet pack, in case multi-interpreter, decremented after cloudpickle_dumps, otherwise decremented in starpupy_codelet_func*/
+	/*protect borrowed reference, used in codelet pack, in case multi-interpreter or native function, decremented after packing, otherwise decremented in starpupy_codelet_func*/
 	Py_INCREF(func_py);
-
-	/*Initialize struct starpu_codelet_pack_arg_data*/
-	struct starpu_codelet_pack_arg_data data;
-	starpu_codelet_pack_arg_init(&data);
-
-	if(active_multi_interpreter)
-	{
-		/*use cloudpickle to dump func_py*/
-		Py_ssize_t func_data_size;
-		char* func_data;
-		PyObject *func_bytes = starpu_cloudpickle_dumps(func_py, &func_data, &func_data_size);
-		starpu_codelet_pack_arg(&data, func_data, func_data_size);
-		Py_DECREF(func_bytes);
-		/*decrement the ref obtained from args passed in*/
-		Py_DECREF(func_py);
-	}
-	else
-	{
-		/*if there is no multi interpreter only pack func_py*/
-		starpu_codelet_pack_arg(&data, &func_py, sizeof(func_py));
-	}
+	/*entry point if the function is compiled to native code*/
+	void *native_func = starpupy_native_address(func_py);
 
 	PyObject *loop;
 	PyObject *fut;
@@ -1318,8 +1653,48 @@ static PyObject* starpu_task_submit_wrapper(PyObject *self, PyObject *args)
 	Py_DECREF(pInstanceToken);
 	func_cl->nbuffers = nbuffer;
 
-	/*pack argList*/
-	starpu_codelet_pack_arg(&data, &argList, sizeof(argList));
+	/*native functions do not need the GIL when all arguments are buffers or scalars*/
+	struct starpupy_native_codelet *native_cl = NULL;
+	if (native_func && h_flag == 0)
+		native_cl = starpupy_native_codelet_prepare(func_cl, native_func, argList, task, nbuffer);
+	if (native_cl)
+		func_cl = &native_cl->cl;
+
+	/*Initialize struct starpu_codelet_pack_arg_data*/
+	struct starpu_codelet_pack_arg_data data;
+	starpu_codelet_pack_arg_init(&data);
+
+	if(native_cl)
+	{
+		/*func_py and argList are not used, keep their place in cl_arg*/
+		PyObject *unused = NULL;
+		starpu_codelet_pack_arg(&data, &unused, sizeof(unused));
+		starpu_codelet_pack_arg(&data, &unused, sizeof(unused));
+		Py_DECREF(func_py);
+		Py_DECREF(argList);
+	}
+	else
+	{
+		if(active_multi_interpreter)
+		{
+			/*use cloudpickle to dump func_py*/
+			Py_ssize_t func_data_size;
+			char* func_data;
+			PyObject *func_bytes = starpupy_func_dumps(func_py, &func_data, &func_data_size);
+			starpu_codelet_pack_arg(&data, func_data, func_data_size);
+			Py_DECREF(func_bytes);
+			/*decrement the ref obtained from args passed in*/
+			Py_DECREF(func_py);
+		}
+		else
+		{
+			/*if there is no multi interpreter only pack func_py*/
+			starpu_codelet_pack_arg(&data, &func_py, sizeof(func_py));
+		}
+
+		/*pack argList*/
+		starpu_codelet_pack_arg(&data, &argList, sizeof(argList));
+	}
 	/*pack fut*/
 	starpu_codelet_pack_arg(&data, &fut, sizeof(fut));
 	/*pack loop*/
@@ -1398,9 +1773,17 @@ static PyObject* starpu_task_submit_wrapper(PyObject *self, PyObject *args)
 	starpu_codelet_pack_arg_fini(&data, &task->cl_arg, &task->cl_arg_size);
 	task->cl_arg_free = 1;
 
-	task->prologue_callback_func=&starpupy_prologue_cb_func;
+	if (native_cl)
+	{
+		/*there are no Future arguments to wait for*/
+		task->callback_func=&starpupy_native_cb_func;
+	}
+	else
+	{
+		task->prologue_callback_func=&starpupy_prologue_cb_func;
+		task->callback_func=&starpupy_cb_func;
+	}
 	task->epilogue_callback_func=&starpupy_epilogue_cb_func;
-	task->callback_func=&starpupy_cb_func;
 
 	/*call starpu_task_submit method*/
 	int ret;
@@ -1573,6 +1956,8 @@ static void del_inter(void* arg)
 	PyThreadState *new_thread_state = new_thread_states[workerid];
 
 	PyEval_RestoreThread(new_thread_state); // reacquires the GIL
+	/*the cached functions belong to this interpreter*/
+	Py_CLEAR(func_cache[workerid]);
 	Py_EndInterpreter(new_thread_state);
 
 	PyThreadState_Swap(orig_thread_states[workerid]);
@@ -1717,6 +2102,9 @@ static PyObject* starpu_shutdown_wrapper(PyObject *self, PyObject *args)
 
 	Py_DECREF(perf_dict);
 
+	/*drop the pickled functions*/
+	Py_CLEAR(func_pickle_cache);
+
 	/*gc module import*/
 	PyObject *gc_module = PyImport_ImportModule("gc");
 	if (gc_module == NULL)
@@ -1925,6 +2313,10 @@ PyMODINIT_FUNC PyInit_starpupy(void)
 		|| starpu_getenv_number("STARPU_TCPIP_MS_SLAVES") > 0)
 		active_multi_interpreter = 1;
 #endif
+	func_cache_enabled = starpu_getenv_number_default("STARPUPY_FUNC_CACHE", 0);
+	func_cache_size = starpu_getenv_number_default("STARPUPY_FUNC_CACHE_SIZE", func_cache_size);
+	if (func_cache_size < 1)
+		func_cache_size = 1;
 
 	main_thread = pthread_self();
 
@@ -0,0 +1,155 @@
+/* StarPU --- Runtime system for heterogeneous multicore architectures.
+ *
+ * Copyright (C) 2023       Université de Bordeaux, CNRS (LaBRI UMR 5800), Inria
+ *
+ * StarPU is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or (at
+ * your option) any later version.
+ *
+ * StarPU is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU Lesser General Public License in COPYING.LGPL for more details.
+ */
+
+#include <starpu.h>
+#include "../helper.h"
+
+/*
+ * Test that starpu_data_acquire_on_node_array_cb calls the callback only once,
+ * after all the handles are available, and that the dependencies with tasks
+ * are properly enforced.
+ */
+
+#define N 64
+
+unsigned values[N];
+starpu_data_handle_t handles[N];
+unsigned ncallbacks;
+int failed;
+
+void increment_cpu(void *descr[], void *arg)
+{
+	(void)arg;
+	unsigned *val = (unsigned *)STARPU_VARIABLE_GET_PTR(descr[0]);
+	(*val)++;
+}
+
+static struct starpu_codelet increment_cl =
+{
+	.cpu_funcs = {increment_cpu},
+	.cpu_funcs_name = {"increment_cpu"},
+	.modes = {STARPU_RW},
+	.nbuffers = 1,
+	.name = "increment",
+};
+
+static void callback_w(void *arg)
+{
+	unsigned expected = (uintptr_t) arg;
+	unsigned i;
+
+	STARPU_ATOMIC_ADD(&ncallbacks, 1);
+	for (i = 0; i < N; i++)
+	{
+		if (values[i] != i + expected)
+		{
+			FPRINTF(stderr, "value %u is %u instead of %u\n", i, values[i], i + expected);
+			failed = 1;
+		}
+		values[i] += 100;
+	}
+	starpu_data_release_on_node_array(N, handles, STARPU_MAIN_RAM);
+}
+
+static void callback_r(void *arg)
+{
+	unsigned expected = (uintptr_t) arg;
+	unsigned i;
+
+	STARPU_ATOMIC_ADD(&ncallbacks, 1);
+	for (i = 0; i < N; i++)
+	{
+		if (values[i] != i + expected)
+		{
+			FPRINTF(stderr, "value %u is %u instead of %u\n", i, values[i], i + expected);
+			failed = 1;
+		}
+	}
+	starpu_data_release_on_node_array(N, handles, STARPU_MAIN_RAM);
+}
+
+static int submit_increments(void)
+{
+	unsigned i;
+
+	for (i = 0; i < N; i++)
+	{
+		int ret = starpu_task_insert(&increment_cl, STARPU_RW, handles[i], 0);
+		if (ret == -ENODEV)
+			return ret;
+		STARPU_CHECK_RETURN_VALUE(ret, "starpu_task_insert");
+	}
+	return 0;
+}
+
+int main(int argc, char **argv)
+{
+	int ret;
+	unsigned i;
+
+	ret = starpu_initialize(NULL, &argc, &argv);
+	if (ret == -ENODEV) return STARPU_TEST_SKIPPED;
+	STARPU_CHECK_RETURN_VALUE(ret, "starpu_init");
+
+	for (i = 0; i < N; i++)
+	{
+		values[i] = i;
+		starpu_variable_data_register(&handles[i], STARPU_MAIN_RAM, (uintptr_t)&values[i], sizeof(values[i]));
+	}
+
+	if (submit_increments() == -ENODEV)
+		goto enodev;
+	starpu_data_acquire_on_node_array_cb(N, handles, STARPU_MAIN_RAM, STARPU_RW, callback_w, (void*)(uintptr_t) 1);
+	if (submit_increments() == -ENODEV)
+		goto enodev;
+	starpu_data_acquire_on_node_array_cb(N, handles, STARPU_MAIN_RAM, STARPU_R, callback_r, (void*)(uintptr_t) 102);
+
+	/* This one has to wait for the application to release one of the handles */
+	starpu_data_acquire(handles[N/2], STARPU_W);
+	values[N/2]++;
+	starpu_data_acquire_on_node_array_cb(N, handles, STARPU_MAIN_RAM, STARPU_R, callback_r, (void*)(uintptr_t) 102);
+	starpu_sleep(0.01);
+	STARPU_ASSERT(ncallbacks <= 2);
+	values[N/2]--;
+	starpu_data_release(handles[N/2]);
+
+	/* These have to wait for the callback to release the handles */
+	if (submit_increments() == -ENODEV)
+		goto enodev;
+
+	starpu_task_wait_for_all();
+
+	for (i = 0; i < N; i++)
+	{
+		starpu_data_unregister(handles[i]);
+		if (values[i] != i + 103)
+		{
+			FPRINTF(stderr, "final value %u is %u instead of %u\n", i, values[i], i + 103);
+			failed = 1;
+		}
+	}
+
+	starpu_shutdown();
+
+	FPRINTF(stderr, "%u callbacks\n", ncallbacks);
+	return (!failed && ncallbacks == 3) ? EXIT_SUCCESS : EXIT_FAILURE;
+
+enodev:
+	for (i = 0; i < N; i++)
+		starpu_data_unregister(handles[i]);
+	starpu_shutdown();
+	return STARPU_TEST_SKIPPED;
+}
@@ -0,0 +1,114 @@
+/* StarPU --- Runtime system for heterogeneous multicore architectures.
+ *
+ * Copyright (C) 2023       Université de Bordeaux, CNRS (LaBRI UMR 5800), Inria
+ *
+ * StarPU is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or (at
+ * your option) any later version.
+ *
+ * StarPU is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU Lesser General Public License in COPYING.LGPL for more details.
+ */
+
+#include <starpu.h>
+#include <stdlib.h>
+#include "../helper.h"
+
+/*
+ * Register many variables at once with several threads, work on them, and
+ * unregister them at once
+ */
+
+#if !defined(STARPU_HAVE_SETENV) || !defined(STARPU_USE_CPU)
+#warning setenv or CPU workers are not available, skipping test
+int main(void)
+{
+	return STARPU_TEST_SKIPPED;
+}
+#else
+
+#ifdef STARPU_QUICK_CHECK
+#define N 1024
+#else
+#define N 16384
+#endif
+
+static void increment_cpu(void *descr[], void *arg)
+{
+	(void)arg;
+	int *val = (int *)STARPU_VARIABLE_GET_PTR(descr[0]);
+	(*val)++;
+}
+
+static struct starpu_codelet increment_cl =
+{
+	.cpu_funcs = {increment_cpu},
+	.nbuffers = 1,
+	.modes = {STARPU_RW},
+	.name = "increment",
+};
+
+int main(void)
+{
+	static int values[N];
+	static struct starpu_variable_interface interfaces[N];
+	static starpu_data_handle_t handles[N];
+	struct starpu_conf conf;
+	unsigned i;
+	int ret;
+
+	/* Initialize the handles with several threads */
+	setenv("STARPU_PARTITION_NTHREADS", "4", 1);
+
+	starpu_conf_init(&conf);
+	starpu_conf_noworker(&conf);
+	conf.ncpus = -1;
+
+	ret = starpu_init(&conf);
+	if (ret == -ENODEV) return STARPU_TEST_SKIPPED;
+	STARPU_CHECK_RETURN_VALUE(ret, "starpu_init");
+
+	for (i = 0; i < N; i++)
+	{
+		values[i] = i;
+		interfaces[i].id = STARPU_VARIABLE_INTERFACE_ID;
+		interfaces[i].ptr = (uintptr_t) &values[i];
+		interfaces[i].dev_handle = (uintptr_t) &values[i];
+		interfaces[i].offset = 0;
+		interfaces[i].elemsize = sizeof(values[i]);
+	}
+	starpu_data_register_array(N, handles, STARPU_MAIN_RAM, interfaces, &starpu_interface_variable_ops);
+
+	for (i = 0; i < N; i++)
+	{
+		STARPU_ASSERT(starpu_variable_get_local_ptr(handles[i]) == (uintptr_t) &values[i]);
+		ret = starpu_task_insert(&increment_cl, STARPU_RW, handles[i], 0);
+		if (ret == -ENODEV) goto enodev;
+		STARPU_CHECK_RETURN_VALUE(ret, "starpu_task_insert");
+	}
+
+	/* The unregistration waits for the tasks */
+	starpu_data_unregister_submit_array(N, handles);
+	starpu_task_wait_for_all();
+	starpu_shutdown();
+
+	ret = EXIT_SUCCESS;
+	for (i = 0; i < N; i++)
+		if (values[i] != (int) i + 1)
+		{
+			FPRINTF(stderr, "value %u is %d instead of %u\n", i, values[i], i + 1);
+			ret = EXIT_FAILURE;
+			break;
+		}
+	return ret;
+
+enodev:
+	starpu_data_unregister_submit_array(N, handles);
+	starpu_shutdown();
+	return STARPU_TEST_SKIPPED;
+}
+#endif
@@ -0,0 +1,222 @@
+/* StarPU --- Runtime system for heterogeneous multicore architectures.
+ *
+ * Copyright (C) 2023       Université de Bordeaux, CNRS (LaBRI UMR 5800), Inria
+ *
+ * StarPU is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or (at
+ * your option) any later version.
+ *
+ * StarPU is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU Lesser General Public License in COPYING.LGPL for more details.
+ */
+
+#include <starpu.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include "../helper.h"
+
+#if STARPU_MAXNODES == 1
+/* Cannot register a disk */
+int main(int argc, char **argv)
+{
+	return STARPU_TEST_SKIPPED;
+}
+#else
+/*
+ * Check that the built-in codec gets back compressible and incompressible
+ * data, and that data stored on a compress disk are read back unchanged,
+ * with starpu_disk_compress_get_stats() accounting for the compression.
+ */
+
+/* Several chunks of the compress backend, and a partial one */
+#define NX	(80*1024)
+#define SIZE	(NX*sizeof(uint32_t))
+
+static void fill(uint32_t *val, int compressible)
+{
+	uint32_t seed = 42;
+	unsigned i;
+
+	for (i = 0; i < NX; i++)
+	{
+		if (compressible)
+			val[i] = i / 1024;
+		else
+		{
+			seed = seed * 1103515245 + 12345;
+			val[i] = seed ^ (seed >> 16) * 2654435761U;
+		}
+	}
+}
+
+static int test_codec(struct starpu_disk_compress_codec *codec, int compressible)
+{
+	uint32_t *src, *back;
+	char *dst;
+	size_t size;
+	int ret;
+
+	src = malloc(SIZE);
+	back = malloc(SIZE);
+	/* Leave some room for the worst case */
+	dst = malloc(2*SIZE);
+	fill(src, compressible);
+
+	size = codec->compress(src, SIZE, dst, 2*SIZE);
+	STARPU_ASSERT(size > 0);
+	if (compressible)
+		STARPU_ASSERT_MSG(size < SIZE/4, "%s only compressed %lu bytes into %lu bytes", codec->name, (unsigned long) SIZE, (unsigned long) size);
+	ret = codec->decompress(dst, size, back, SIZE);
+	STARPU_ASSERT(ret == 0);
+	STARPU_ASSERT(!memcmp(src, back, SIZE));
+
+	/* The codec has to tell when the result does not fit */
+	size = codec->compress(src, SIZE, dst, SIZE);
+	if (!compressible)
+		STARPU_ASSERT_MSG(size == 0, "%s compressed random data from %lu bytes into %lu bytes", codec->name, (unsigned long) SIZE, (unsigned long) size);
+	else
+	{
+		STARPU_ASSERT(size > 0 && size <= SIZE);
+		ret = codec->decompress(dst, size, back, SIZE);
+		STARPU_ASSERT(ret == 0);
+		STARPU_ASSERT(!memcmp(src, back, SIZE));
+	}
+
+	free(src);
+	free(back);
+	free(dst);
+	return 0;
+}
+
+/* Store the data on the disk, and read it back */
+static int round_trip(unsigned dd, int compressible, struct starpu_disk_compress_stats *stats)
+{
+	starpu_data_handle_t ram_handle, disk_handle;
+	uint32_t *src, *back;
+	uintptr_t obj;
+	int ret;
+
+	src = malloc(SIZE);
+	back = malloc(SIZE);
+	fill(src, compressible);
+	memset(back, 0, SIZE);
+
+	obj = starpu_malloc_on_node(dd, SIZE);
+	STARPU_ASSERT(obj);
+
+	/* Write it, unregistering the disk handle writes it back to the disk */
+	starpu_vector_data_register(&ram_handle, STARPU_MAIN_RAM, (uintptr_t) src, NX, sizeof(uint32_t));
+	starpu_vector_data_register(&disk_handle, dd, obj, NX, sizeof(uint32_t));
+	ret = starpu_data_cpy(disk_handle, ram_handle, 0, NULL, NULL);
+	STARPU_CHECK_RETURN_VALUE(ret, "starpu_data_cpy");
+	starpu_data_unregister(disk_handle);
+	starpu_data_unregister(ram_handle);
+
+	/* And read it */
+	starpu_vector_data_register(&ram_handle, STARPU_MAIN_RAM, (uintptr_t) back, NX, sizeof(uint32_t));
+	starpu_vector_data_register(&disk_handle, dd, obj, NX, sizeof(uint32_t));
+	ret = starpu_data_cpy(ram_handle, disk_handle, 0, NULL, NULL);
+	STARPU_CHECK_RETURN_VALUE(ret, "starpu_data_cpy");
+	starpu_data_unregister(disk_handle);
+	starpu_data_unregister(ram_handle);
+
+	starpu_free_on_node(dd, obj, SIZE);
+
+	ret = memcmp(src, back, SIZE) ? EXIT_FAILURE : EXIT_SUCCESS;
+	if (ret)
+		FPRINTF(stderr, "%s data were not read back correctly\n", compressible ? "Compressible" : "Incompressible");
+	free(src);
+	free(back);
+
+	STARPU_ASSERT(starpu_disk_compress_get_stats(dd, stats) == 0);
+	return ret;
+}
+
+int dotest(struct starpu_disk_compress_parameter *param)
+{
+	struct starpu_disk_compress_stats stats, prev;
+	int ret;
+
+	struct starpu_conf conf;
+	ret = starpu_conf_init(&conf);
+	if (ret == -EINVAL)
+		return EXIT_FAILURE;
+	conf.precedence_over_environment_variables = 1;
+	starpu_conf_noworker(&conf);
+	conf.ncpus = 1;
+	conf.nmpi_ms = 0;
+	conf.ntcpip_ms = 0;
+	ret = starpu_init(&conf);
+	if (ret == -ENODEV)
+		return STARPU_TEST_SKIPPED;
+
+	int dd = starpu_disk_register(&starpu_disk_compress_ops, param, STARPU_DISK_SIZE_MIN);
+	/* can't write on /tmp/ */
+	if (dd == -ENOENT)
+	{
+		starpu_shutdown();
+		return STARPU_TEST_SKIPPED;
+	}
+
+	/* Only registered with the compress backend */
+	STARPU_ASSERT(starpu_disk_compress_get_stats(STARPU_MAIN_RAM, &stats) == -EINVAL);
+	STARPU_ASSERT(starpu_disk_compress_get_stats(dd, &prev) == 0);
+
+	ret = round_trip(dd, 1, &stats);
+	if (ret)
+		goto out;
+	STARPU_ASSERT(stats.written - prev.written >= SIZE);
+	STARPU_ASSERT(stats.read - prev.read >= SIZE);
+	STARPU_ASSERT_MSG((stats.written_stored - prev.written_stored) * 4 < stats.written - prev.written, "Compressible data were stored as %lu bytes out of %lu", (unsigned long) (stats.written_stored - prev.written_stored), (unsigned long) (stats.written - prev.written));
+	STARPU_ASSERT(stats.read_stored - prev.read_stored < stats.read - prev.read);
+	STARPU_ASSERT(stats.nuncompressed == prev.nuncompressed);
+
+	prev = stats;
+	ret = round_trip(dd, 0, &stats);
+	if (ret)
+		goto out;
+	/* Incompressible chunks are stored as they are */
+	STARPU_ASSERT(stats.nuncompressed > prev.nuncompressed);
+	STARPU_ASSERT(stats.written_stored - prev.written_stored == stats.written - prev.written);
+	STARPU_ASSERT(stats.read_stored - prev.read_stored == stats.read - prev.read);
+
+out:
+	starpu_shutdown();
+	return ret;
+}
+
+int main(void)
+{
+	int ret;
+	int ret2;
+	char s[128];
+
+#ifdef STARPU_HAVE_SETENV
+	setenv("STARPU_CALIBRATE_MINIMUM", "1", 1);
+#endif
+
+	test_codec(&starpu_disk_compress_lz_codec, 1);
+	test_codec(&starpu_disk_compress_lz_codec, 0);
+
+	snprintf(s, sizeof(s), "/tmp/%s-disk-XXXXXX", getenv("USER"));
+	if (!_starpu_mkdtemp(s))
+	{
+		FPRINTF(stderr, "Cannot make directory <%s>\n", s);
+		return STARPU_TEST_SKIPPED;
+	}
+
+	struct starpu_disk_compress_parameter param = { .ops = &starpu_disk_unistd_ops, .parameter = s };
+	ret = dotest(&param);
+
+	ret2 = rmdir(s);
+	if (ret2 < 0)
+		STARPU_CHECK_RETURN_VALUE(-errno, "rmdir '%s'\n", s);
+	return ret;
+}
+#endif
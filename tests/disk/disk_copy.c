@@ -185,6 +185,9 @@ int main(void)
 
 	ret = merge_result(ret, dotest(&starpu_disk_stdio_ops, s));
 	ret = merge_result(ret, dotest(&starpu_disk_unistd_ops, s));
+	ret = merge_result(ret, dotest(&starpu_disk_slab_ops, s));
+	struct starpu_disk_compress_parameter compress = { .ops = &starpu_disk_unistd_ops, .parameter = s };
+	ret = merge_result(ret, dotest(&starpu_disk_compress_ops, &compress));
 #ifdef STARPU_LINUX_SYS
 	ret = merge_result(ret, dotest(&starpu_disk_unistd_o_direct_ops, s));
 #endif
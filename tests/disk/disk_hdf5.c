@@ -0,0 +1,302 @@
+/* StarPU --- Runtime system for heterogeneous multicore architectures.
+ *
+ * Copyright (C) 2023       Université de Bordeaux, CNRS (LaBRI UMR 5800), Inria
+ *
+ * StarPU is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or (at
+ * your option) any later version.
+ *
+ * StarPU is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU Lesser General Public License in COPYING.LGPL for more details.
+ */
+
+#include <starpu.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <unistd.h>
+#include "../helper.h"
+
+#ifdef STARPU_HAVE_HDF5
+#include <hdf5.h>
+#endif
+
+#if STARPU_MAXNODES == 1 || !defined(STARPU_HAVE_HDF5) || !defined(STARPU_HAVE_SETENV)
+/* Cannot register a HDF5 disk */
+int main(int argc, char **argv)
+{
+	return STARPU_TEST_SKIPPED;
+}
+#else
+/*
+ * Have several HDF5 threads read and write pieces of the same datasets
+ * concurrently, both for a dataset allocated by StarPU and for a dataset
+ * created by the application, which is smaller than the data and thus has
+ * to be extended while keeping its content.
+ */
+
+#define NTHREADS	"4"
+#define NPARTS		8
+#ifdef STARPU_QUICK_CHECK
+#define NX		(NPARTS*1024)
+#else
+#define NX		(NPARTS*64*1024)
+#endif
+
+static void fill_cpu(void *descr[], void *arg)
+{
+	int *val = (int *)STARPU_VECTOR_GET_PTR(descr[0]);
+	unsigned n = STARPU_VECTOR_GET_NX(descr[0]);
+	int first;
+	unsigned i;
+
+	starpu_codelet_unpack_args(arg, &first);
+	for (i = 0; i < n; i++)
+		val[i] = first + i;
+}
+
+static void increment_cpu(void *descr[], void *arg)
+{
+	(void)arg;
+	int *val = (int *)STARPU_VECTOR_GET_PTR(descr[0]);
+	unsigned n = STARPU_VECTOR_GET_NX(descr[0]);
+	unsigned i;
+
+	for (i = 0; i < n; i++)
+		val[i]++;
+}
+
+static struct starpu_codelet fill_cl =
+{
+	.cpu_funcs = {fill_cpu},
+	.nbuffers = 1,
+	.modes = {STARPU_W},
+	.name = "fill",
+};
+
+static struct starpu_codelet increment_cl =
+{
+	.cpu_funcs = {increment_cpu},
+	.nbuffers = 1,
+	.modes = {STARPU_RW},
+	.name = "increment",
+};
+
+/* Increment the first parts of the data stored on the disk, and overwrite
+ * the last ones with first + index, all of them concurrently */
+static int work_on_parts(starpu_data_handle_t handle, unsigned dd, unsigned nincrement, int first)
+{
+	struct starpu_data_filter f =
+	{
+		.filter_func = starpu_vector_filter_block,
+		.nchildren = NPARTS,
+	};
+	unsigned part;
+	int ret;
+
+	starpu_data_partition(handle, &f);
+	for (part = 0; part < NPARTS; part++)
+	{
+		starpu_data_handle_t sub = starpu_data_get_sub_data(handle, 1, part);
+		if (part < nincrement)
+			ret = starpu_task_insert(&increment_cl, STARPU_RW, sub, 0);
+		else
+		{
+			int part_first = first + part * (NX/NPARTS);
+			ret = starpu_task_insert(&fill_cl, STARPU_W, sub, STARPU_VALUE, &part_first, sizeof(part_first), 0);
+		}
+		if (ret == -ENODEV)
+			return ret;
+		STARPU_CHECK_RETURN_VALUE(ret, "starpu_task_insert");
+	}
+	/* Gather the pieces on the disk */
+	starpu_data_unpartition(handle, dd);
+	return 0;
+}
+
+/* Data allocated by StarPU, first filled from the tasks, then incremented */
+static int test_alloc(unsigned dd)
+{
+	starpu_data_handle_t handle, ram_handle;
+	int *back;
+	unsigned i;
+	int ret;
+
+	uintptr_t obj = starpu_malloc_on_node(dd, NX*sizeof(int));
+	STARPU_ASSERT(obj);
+	starpu_vector_data_register(&handle, dd, obj, NX, sizeof(int));
+
+	ret = work_on_parts(handle, dd, 0, 0);
+	if (ret == 0)
+		ret = work_on_parts(handle, dd, NPARTS, 0);
+	if (ret == -ENODEV)
+	{
+		starpu_data_unregister(handle);
+		starpu_free_on_node(dd, obj, NX*sizeof(int));
+		return STARPU_TEST_SKIPPED;
+	}
+
+	back = calloc(NX, sizeof(int));
+	starpu_vector_data_register(&ram_handle, STARPU_MAIN_RAM, (uintptr_t) back, NX, sizeof(int));
+	ret = starpu_data_cpy(ram_handle, handle, 0, NULL, NULL);
+	STARPU_CHECK_RETURN_VALUE(ret, "starpu_data_cpy");
+	starpu_data_unregister(ram_handle);
+	starpu_data_unregister(handle);
+	starpu_free_on_node(dd, obj, NX*sizeof(int));
+
+	ret = EXIT_SUCCESS;
+	for (i = 0; i < NX; i++)
+		if (back[i] != (int) i + 1)
+		{
+			FPRINTF(stderr, "Allocated data: value %u is %d instead of %d\n", i, back[i], i + 1);
+			ret = EXIT_FAILURE;
+			break;
+		}
+	free(back);
+	return ret;
+}
+
+/* Dataset created by the application with only the first half of the data,
+ * the second half is written by the tasks */
+static int test_open(unsigned dd, char *base, const char *name)
+{
+	starpu_data_handle_t handle;
+	int *val;
+	hsize_t dims[1] = {NX/2};
+	unsigned i;
+	herr_t status;
+	int ret;
+
+	val = malloc(NX*sizeof(int));
+	for (i = 0; i < NX/2; i++)
+		val[i] = i;
+
+	/* Written with the default, contiguous, layout */
+	hid_t file = H5Fopen(base, H5F_ACC_RDWR, H5P_DEFAULT);
+	STARPU_ASSERT(file >= 0);
+	hid_t dataspace = H5Screate_simple(1, dims, NULL);
+	hid_t dataset = H5Dcreate2(file, name, H5T_NATIVE_INT, dataspace, H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT);
+	STARPU_ASSERT(dataset >= 0);
+	status = H5Dwrite(dataset, H5T_NATIVE_INT, H5S_ALL, H5S_ALL, H5P_DEFAULT, val);
+	STARPU_ASSERT(status >= 0);
+	H5Dclose(dataset);
+	H5Sclose(dataspace);
+	H5Fclose(file);
+
+	void *obj = starpu_disk_open(dd, (void *) name, NX*sizeof(int));
+	STARPU_ASSERT(obj);
+	starpu_vector_data_register(&handle, dd, (uintptr_t) obj, NX, sizeof(int));
+	ret = work_on_parts(handle, dd, NPARTS/2, 1000000);
+	starpu_data_unregister(handle);
+	starpu_disk_close(dd, obj, NX*sizeof(int));
+	if (ret == -ENODEV)
+	{
+		free(val);
+		return STARPU_TEST_SKIPPED;
+	}
+
+	/* Check the content from the file */
+	file = H5Fopen(base, H5F_ACC_RDONLY, H5P_DEFAULT);
+	STARPU_ASSERT(file >= 0);
+	dataset = H5Dopen2(file, name, H5P_DEFAULT);
+	STARPU_ASSERT(dataset >= 0);
+	dataspace = H5Dget_space(dataset);
+	H5Sget_simple_extent_dims(dataspace, dims, NULL);
+	H5Sclose(dataspace);
+	if (dims[0] == NX)
+		status = H5Dread(dataset, H5T_NATIVE_INT, H5S_ALL, H5S_ALL, H5P_DEFAULT, val);
+	H5Dclose(dataset);
+	H5Fclose(file);
+
+	if (dims[0] != NX)
+	{
+		FPRINTF(stderr, "Opened dataset has %lu elements instead of %u\n", (unsigned long) dims[0], NX);
+		free(val);
+		return EXIT_FAILURE;
+	}
+	STARPU_ASSERT(status >= 0);
+
+	ret = EXIT_SUCCESS;
+	for (i = 0; i < NX; i++)
+	{
+		int expected = i < NX/2 ? (int) i + 1 : 1000000 + (int) i;
+		if (val[i] != expected)
+		{
+			FPRINTF(stderr, "Opened dataset: value %u is %d instead of %d\n", i, val[i], expected);
+			ret = EXIT_FAILURE;
+			break;
+		}
+	}
+	free(val);
+	return ret;
+}
+
+int main(void)
+{
+	int ret;
+	int ret2;
+	char s[128];
+	char base[256];
+
+	setenv("STARPU_CALIBRATE_MINIMUM", "1", 1);
+	/* Several threads perform the transfers */
+	setenv("STARPU_HDF5_NTHREADS", NTHREADS, 1);
+
+	snprintf(s, sizeof(s), "/tmp/%s-disk-XXXXXX", getenv("USER"));
+	if (!_starpu_mkdtemp(s))
+	{
+		FPRINTF(stderr, "Cannot make directory <%s>\n", s);
+		return STARPU_TEST_SKIPPED;
+	}
+	snprintf(base, sizeof(base), "%s/STARPU_HDF5_file.h5", s);
+
+	/* Create the file, so that it is opened and kept by the disk */
+	hid_t file = H5Fcreate(base, H5F_ACC_TRUNC, H5P_DEFAULT, H5P_DEFAULT);
+	if (file < 0)
+	{
+		FPRINTF(stderr, "Cannot create HDF5 file <%s>\n", base);
+		rmdir(s);
+		return STARPU_TEST_SKIPPED;
+	}
+	H5Fclose(file);
+
+	struct starpu_conf conf;
+	ret = starpu_conf_init(&conf);
+	if (ret == -EINVAL)
+		return EXIT_FAILURE;
+	conf.precedence_over_environment_variables = 1;
+	starpu_conf_noworker(&conf);
+	conf.ncpus = 4;
+	ret = starpu_init(&conf);
+	if (ret == -ENODEV)
+	{
+		ret = STARPU_TEST_SKIPPED;
+		goto out;
+	}
+
+	int dd = starpu_disk_register(&starpu_disk_hdf5_ops, (void *) base, STARPU_DISK_SIZE_MIN);
+	/* can't write on /tmp/ */
+	if (dd < 0)
+	{
+		starpu_shutdown();
+		ret = STARPU_TEST_SKIPPED;
+		goto out;
+	}
+
+	ret = test_alloc(dd);
+	if (ret == EXIT_SUCCESS)
+		ret = test_open(dd, base, "STARPU_HDF5_half_dataset");
+
+	starpu_shutdown();
+
+out:
+	unlink(base);
+	ret2 = rmdir(s);
+	if (ret2 < 0)
+		STARPU_CHECK_RETURN_VALUE(-errno, "rmdir '%s'\n", s);
+	return ret;
+}
+#endif
@@ -0,0 +1,179 @@
+/* StarPU --- Runtime system for heterogeneous multicore architectures.
+ *
+ * Copyright (C) 2023       Université de Bordeaux, CNRS (LaBRI UMR 5800), Inria
+ *
+ * StarPU is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or (at
+ * your option) any later version.
+ *
+ * StarPU is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU Lesser General Public License in COPYING.LGPL for more details.
+ */
+
+#include <starpu.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include "../helper.h"
+
+/*
+ * Measure how fast tiles get evicted to and fetched back from a HDF5 disk,
+ * with several numbers of HDF5 threads: twice as much data as the available
+ * memory is repeatedly worked on, and the throughput of the tiles going
+ * through the disk is printed.
+ */
+
+#ifdef STARPU_QUICK_CHECK
+#  define NDATA 16
+#  define NITER 2
+#elif !defined(STARPU_LONG_CHECK)
+#  define NDATA 32
+#  define NITER 4
+#else
+#  define NDATA 64
+#  define NITER 16
+#endif
+#define MEMSIZE 8
+#define MEMSIZE_STR "8"
+/* Twice as much data as available memory */
+#define TILESIZE ((MEMSIZE*1024*1024*2) / NDATA)
+
+#if STARPU_MAXNODES == 1 || !defined(STARPU_HAVE_HDF5) || !defined(STARPU_HAVE_SETENV)
+/* Cannot register a HDF5 disk */
+int main(int argc, char **argv)
+{
+	return STARPU_TEST_SKIPPED;
+}
+#else
+
+static void inc(void *buffers[], void *args)
+{
+	(void)args;
+	char *val = (char *) STARPU_VECTOR_GET_PTR(buffers[0]);
+	unsigned n = STARPU_VECTOR_GET_NX(buffers[0]);
+	unsigned i;
+
+	for (i = 0; i < n; i += 4096)
+		val[i]++;
+}
+
+static struct starpu_codelet inc_cl =
+{
+	.cpu_funcs = { inc },
+	.nbuffers = 1,
+	.modes = { STARPU_RW },
+	.name = "inc",
+};
+
+static void zero(void *buffers[], void *args)
+{
+	(void)args;
+	memset((void *) STARPU_VECTOR_GET_PTR(buffers[0]), 0, STARPU_VECTOR_GET_NX(buffers[0]));
+}
+
+static struct starpu_codelet zero_cl =
+{
+	.cpu_funcs = { zero },
+	.nbuffers = 1,
+	.modes = { STARPU_W },
+	.name = "zero",
+};
+
+static int dotest(char *base, const char *nthreads)
+{
+	starpu_data_handle_t handles[NDATA];
+	unsigned i, iter;
+	double start, end;
+	int ret;
+
+	setenv("STARPU_HDF5_NTHREADS", nthreads, 1);
+
+	struct starpu_conf conf;
+	ret = starpu_conf_init(&conf);
+	if (ret == -EINVAL)
+		return EXIT_FAILURE;
+	conf.precedence_over_environment_variables = 1;
+	starpu_conf_noworker(&conf);
+	conf.ncpus = -1;
+	ret = starpu_init(&conf);
+	if (ret == -ENODEV)
+		return STARPU_TEST_SKIPPED;
+
+	int dd = starpu_disk_register(&starpu_disk_hdf5_ops, (void *) base, STARPU_DISK_SIZE_MIN);
+	/* can't write on /tmp/ */
+	if (dd < 0)
+	{
+		starpu_shutdown();
+		return STARPU_TEST_SKIPPED;
+	}
+
+	for (i = 0; i < NDATA; i++)
+	{
+		starpu_vector_data_register(&handles[i], -1, 0, TILESIZE, sizeof(char));
+		ret = starpu_task_insert(&zero_cl, STARPU_W, handles[i], 0);
+		if (ret == -ENODEV) goto enodev;
+		STARPU_CHECK_RETURN_VALUE(ret, "starpu_task_insert");
+	}
+	starpu_task_wait_for_all();
+
+	/* Go through all the tiles in turn, so that each of them has to be
+	 * fetched back from the disk, and another one evicted */
+	start = starpu_timing_now();
+	for (iter = 0; iter < NITER; iter++)
+		for (i = 0; i < NDATA; i++)
+		{
+			ret = starpu_task_insert(&inc_cl, STARPU_RW, handles[i], 0);
+			if (ret == -ENODEV) goto enodev;
+			STARPU_CHECK_RETURN_VALUE(ret, "starpu_task_insert");
+		}
+	starpu_task_wait_for_all();
+	end = starpu_timing_now();
+
+	/* Each tile was read from and written to the disk */
+	FPRINTF(stdout, "%s HDF5 thread(s): %u tiles of %u KiB in %.2f ms, %.2f MB/s\n",
+		nthreads, NITER*NDATA, TILESIZE/1024, (end - start) / 1000.,
+		2. * NITER * NDATA * TILESIZE / (end - start));
+
+	for (i = 0; i < NDATA; i++)
+		starpu_data_unregister(handles[i]);
+	starpu_shutdown();
+	return EXIT_SUCCESS;
+
+enodev:
+	for (i = 0; i < NDATA; i++)
+		starpu_data_unregister(handles[i]);
+	starpu_shutdown();
+	return STARPU_TEST_SKIPPED;
+}
+
+int main(void)
+{
+	int ret;
+	int ret2;
+	char s[128];
+
+	setenv("STARPU_CALIBRATE_MINIMUM", "1", 1);
+	setenv("STARPU_LIMIT_CPU_MEM", MEMSIZE_STR, 1);
+
+	snprintf(s, sizeof(s), "/tmp/%s-disk-XXXXXX", getenv("USER"));
+	if (!_starpu_mkdtemp(s))
+	{
+		FPRINTF(stderr, "Cannot make directory <%s>\n", s);
+		return STARPU_TEST_SKIPPED;
+	}
+
+	ret = dotest(s, "1");
+	if (ret == EXIT_SUCCESS)
+		ret = dotest(s, "4");
+
+	ret2 = rmdir(s);
+	if (ret2 < 0)
+		STARPU_CHECK_RETURN_VALUE(-errno, "rmdir '%s'\n", s);
+	return ret;
+}
+#endif
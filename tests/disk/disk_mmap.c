@@ -0,0 +1,167 @@
+/* StarPU --- Runtime system for heterogeneous multicore architectures.
+ *
+ * Copyright (C) 2023       Université de Bordeaux, CNRS (LaBRI UMR 5800), Inria
+ *
+ * StarPU is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or (at
+ * your option) any later version.
+ *
+ * StarPU is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU Lesser General Public License in COPYING.LGPL for more details.
+ */
+
+#include <starpu.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <unistd.h>
+#include "../helper.h"
+
+#if STARPU_MAXNODES == 1
+/* Cannot register a disk */
+int main(int argc, char **argv)
+{
+	return STARPU_TEST_SKIPPED;
+}
+#else
+/*
+ * Check that with the mmap disk backend, data stored on the disk get mapped
+ * in main memory instead of being copied, and that the modifications made
+ * through the mapping reach the file.
+ */
+
+#define NX (16*1024)
+#define NITER 3
+
+void increment_cpu(void *descr[], void *arg)
+{
+	(void)arg;
+	int *val = (int *)STARPU_VECTOR_GET_PTR(descr[0]);
+	unsigned n = STARPU_VECTOR_GET_NX(descr[0]);
+	unsigned i;
+
+	for (i = 0; i < n; i++)
+		val[i]++;
+}
+
+static struct starpu_codelet increment_cl =
+{
+	.cpu_funcs = {increment_cpu},
+	.modes = {STARPU_RW},
+	.nbuffers = 1,
+};
+
+int main(void)
+{
+	int *A;
+	int ret, ret2;
+	unsigned i;
+	char s[128];
+	char path[256];
+	const char *name = "STARPU_DISK_MMAP_DATA";
+	int try = 1;
+
+#ifdef STARPU_HAVE_SETENV
+	setenv("STARPU_CALIBRATE_MINIMUM", "1", 1);
+#endif
+
+	snprintf(s, sizeof(s), "/tmp/%s-disk-XXXXXX", getenv("USER"));
+	if (!_starpu_mkdtemp(s))
+	{
+		FPRINTF(stderr, "Cannot make directory '%s'\n", s);
+		return STARPU_TEST_SKIPPED;
+	}
+	snprintf(path, sizeof(path), "%s/%s", s, name);
+
+	/* Store the data in a file */
+	A = malloc(NX*sizeof(int));
+	for (i = 0; i < NX; i++)
+		A[i] = i;
+	FILE *f = fopen(path, "wb+");
+	if (f == NULL)
+		goto enoent;
+	fwrite(A, sizeof(int), NX, f);
+	fclose(f);
+
+	struct starpu_conf conf;
+	ret = starpu_conf_init(&conf);
+	if (ret == -EINVAL)
+		return EXIT_FAILURE;
+	conf.precedence_over_environment_variables = 1;
+	starpu_conf_noworker(&conf);
+	conf.ncpus = 1;
+	conf.enable_map = 1;
+	ret = starpu_init(&conf);
+	if (ret == -ENODEV)
+	{
+		unlink(path);
+		rmdir(s);
+		free(A);
+		return STARPU_TEST_SKIPPED;
+	}
+
+	int new_dd = starpu_disk_register(&starpu_disk_mmap_ops, (void *) s, STARPU_DISK_SIZE_MIN);
+	/* can't write on /tmp/ */
+	if (new_dd == -ENOENT)
+	{
+		starpu_shutdown();
+		goto enoent;
+	}
+	unsigned dd = (unsigned) new_dd;
+
+	void *data = starpu_disk_open(dd, (void *) name, NX*sizeof(int));
+	starpu_data_handle_t handle;
+	starpu_vector_data_register(&handle, dd, (uintptr_t) data, NX, sizeof(int));
+
+	for (i = 0; i < NITER; i++)
+	{
+		ret = starpu_task_insert(&increment_cl, STARPU_RW, handle, 0);
+		STARPU_CHECK_RETURN_VALUE(ret, "starpu_task_insert");
+	}
+	starpu_task_wait_for_all();
+
+	if (!starpu_data_test_if_mapped_on_node(handle, STARPU_MAIN_RAM))
+	{
+		FPRINTF(stderr, "The data was not mapped in main memory\n");
+		try = 0;
+	}
+
+	starpu_data_unregister(handle);
+	starpu_disk_close(dd, data, NX*sizeof(int));
+	starpu_shutdown();
+
+	/* check results */
+	f = fopen(path, "rb");
+	if (f == NULL)
+		goto enoent;
+	size_t read = fread(A, sizeof(int), NX, f);
+	STARPU_ASSERT(read == NX);
+	fclose(f);
+
+	for (i = 0; i < NX; i++)
+		if (A[i] != (int) i + NITER)
+		{
+			FPRINTF(stderr, "Fail A[%u] %d != %d\n", i, A[i], (int) i + NITER);
+			try = 0;
+			break;
+		}
+
+	free(A);
+	unlink(path);
+	ret2 = rmdir(s);
+	if (ret2 < 0)
+		STARPU_CHECK_RETURN_VALUE(-errno, "rmdir '%s'\n", s);
+
+	return try ? EXIT_SUCCESS : EXIT_FAILURE;
+
+enoent:
+	FPRINTF(stderr, "Couldn't write data: ENOENT\n");
+	free(A);
+	unlink(path);
+	rmdir(s);
+	return STARPU_TEST_SKIPPED;
+}
+#endif
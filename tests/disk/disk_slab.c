@@ -0,0 +1,165 @@
+/* StarPU --- Runtime system for heterogeneous multicore architectures.
+ *
+ * Copyright (C) 2023       Université de Bordeaux, CNRS (LaBRI UMR 5800), Inria
+ *
+ * StarPU is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or (at
+ * your option) any later version.
+ *
+ * StarPU is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU Lesser General Public License in COPYING.LGPL for more details.
+ */
+
+#include <starpu.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <unistd.h>
+#include "../helper.h"
+
+#if STARPU_MAXNODES == 1
+/* Cannot register a disk */
+int main(int argc, char **argv)
+{
+	return STARPU_TEST_SKIPPED;
+}
+#else
+/*
+ * Allocate and free data on a slab disk in an order which fragments its
+ * file, and check with starpu_disk_slab_get_stats() that the free ranges get
+ * coalesced and reused.
+ */
+
+#define NOBJ	16
+#define SIZE	(64*1024)
+
+#define CHECK(cond) do { if (!(cond)) { FPRINTF(stderr, "%s:%d: '%s' failed\n", __FILE__, __LINE__, #cond); ret = EXIT_FAILURE; goto out; } } while (0)
+
+static int dotest(char *base)
+{
+	struct starpu_disk_slab_stats stats;
+	uintptr_t objs[NOBJ], big;
+	size_t file_size;
+	unsigned i;
+	int ret;
+
+	struct starpu_conf conf;
+	ret = starpu_conf_init(&conf);
+	if (ret == -EINVAL)
+		return EXIT_FAILURE;
+	conf.precedence_over_environment_variables = 1;
+	starpu_conf_noworker(&conf);
+	conf.ncpus = 1;
+	ret = starpu_init(&conf);
+	if (ret == -ENODEV)
+		return STARPU_TEST_SKIPPED;
+
+	int dd = starpu_disk_register(&starpu_disk_slab_ops, (void *) base, STARPU_DISK_SIZE_MIN);
+	/* can't write on /tmp/ */
+	if (dd == -ENOENT)
+	{
+		starpu_shutdown();
+		return STARPU_TEST_SKIPPED;
+	}
+
+	/* Only registered with the slab backend */
+	ret = starpu_disk_slab_get_stats(STARPU_MAIN_RAM, &stats);
+	CHECK(ret == -EINVAL);
+
+	ret = starpu_disk_slab_get_stats(dd, &stats);
+	CHECK(ret == 0);
+	CHECK(stats.used == 0 && stats.nobjects == 0 && stats.free == 0);
+	file_size = stats.file_size;
+
+	for (i = 0; i < NOBJ; i++)
+	{
+		objs[i] = starpu_malloc_on_node(dd, SIZE);
+		CHECK(objs[i]);
+	}
+	starpu_disk_slab_get_stats(dd, &stats);
+	CHECK(stats.nobjects == NOBJ && stats.used == NOBJ*SIZE);
+	CHECK(stats.nfree_extents == 0 && stats.free == 0);
+
+	/* Free one object out of two, keeping the last one: this leaves
+	 * holes which are too small for a bigger object */
+	for (i = 0; i < NOBJ; i += 2)
+		starpu_free_on_node(dd, objs[i], SIZE);
+	starpu_disk_slab_get_stats(dd, &stats);
+	CHECK(stats.nobjects == NOBJ/2 && stats.used == NOBJ/2*SIZE);
+	CHECK(stats.nfree_extents == NOBJ/2 && stats.free == NOBJ/2*SIZE);
+	CHECK(stats.largest_free == SIZE);
+	CHECK(stats.ncoalesced == 0);
+
+	/* Free the other ones but the last, the holes have to be merged into
+	 * one free range */
+	for (i = 1; i < NOBJ-1; i += 2)
+		starpu_free_on_node(dd, objs[i], SIZE);
+	starpu_disk_slab_get_stats(dd, &stats);
+	CHECK(stats.nobjects == 1 && stats.used == SIZE);
+	CHECK(stats.nfree_extents == 1 && stats.free == (NOBJ-1)*SIZE);
+	CHECK(stats.largest_free == stats.free);
+	CHECK(stats.ncoalesced == 2*(NOBJ/2-1));
+
+	/* This now fits in the merged range, without growing the file */
+	big = starpu_malloc_on_node(dd, (NOBJ-1)*SIZE);
+	CHECK(big);
+	starpu_disk_slab_get_stats(dd, &stats);
+	CHECK(stats.nobjects == 2 && stats.used == NOBJ*SIZE);
+	CHECK(stats.nfree_extents == 0 && stats.free == 0);
+	CHECK(stats.file_size == file_size);
+
+	/* Freeing everything gives back the whole file */
+	starpu_free_on_node(dd, big, (NOBJ-1)*SIZE);
+	starpu_free_on_node(dd, objs[NOBJ-1], SIZE);
+	starpu_disk_slab_get_stats(dd, &stats);
+	CHECK(stats.nobjects == 0 && stats.used == 0);
+	CHECK(stats.nfree_extents == 0 && stats.free == 0);
+
+	/* And it can be used again from the start */
+	for (i = 0; i < NOBJ; i++)
+	{
+		objs[i] = starpu_malloc_on_node(dd, SIZE);
+		CHECK(objs[i]);
+	}
+	starpu_disk_slab_get_stats(dd, &stats);
+	CHECK(stats.nobjects == NOBJ && stats.free == 0);
+	CHECK(stats.file_size == file_size);
+	for (i = 0; i < NOBJ; i++)
+		starpu_free_on_node(dd, objs[i], SIZE);
+
+	ret = EXIT_SUCCESS;
+out:
+	starpu_shutdown();
+	return ret;
+}
+
+int main(void)
+{
+	int ret;
+	int ret2;
+	char s[128];
+	char *ptr;
+
+#ifdef STARPU_HAVE_SETENV
+	setenv("STARPU_CALIBRATE_MINIMUM", "1", 1);
+#endif
+
+	snprintf(s, sizeof(s), "/tmp/%s-disk-XXXXXX", getenv("USER"));
+	ptr = _starpu_mkdtemp(s);
+	if (!ptr)
+	{
+		FPRINTF(stderr, "Cannot make directory <%s>\n", s);
+		return STARPU_TEST_SKIPPED;
+	}
+
+	ret = dotest(s);
+
+	ret2 = rmdir(s);
+	if (ret2 < 0)
+		STARPU_CHECK_RETURN_VALUE(-errno, "rmdir '%s'\n", s);
+	return ret;
+}
+#endif
@@ -0,0 +1,254 @@
+/* StarPU --- Runtime system for heterogeneous multicore architectures.
+ *
+ * Copyright (C) 2023       Université de Bordeaux, CNRS (LaBRI UMR 5800), Inria
+ *
+ * StarPU is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or (at
+ * your option) any later version.
+ *
+ * StarPU is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU Lesser General Public License in COPYING.LGPL for more details.
+ */
+
+#include <starpu.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <errno.h>
+#include <unistd.h>
+#include "../helper.h"
+
+#if STARPU_MAXNODES == 1
+/* Cannot register a disk */
+int main(int argc, char **argv)
+{
+	return STARPU_TEST_SKIPPED;
+}
+#else
+/*
+ * Store a result in the persistent store of a disk, and get it back after
+ * restarting StarPU.
+ */
+
+#define NX (16*1024)
+
+void init_cpu(void *descr[], void *arg)
+{
+	(void)arg;
+	int *val = (int *)STARPU_VECTOR_GET_PTR(descr[0]);
+	unsigned n = STARPU_VECTOR_GET_NX(descr[0]);
+	unsigned i;
+
+	for (i = 0; i < n; i++)
+		val[i] = i;
+}
+
+static struct starpu_codelet init_cl =
+{
+	.cpu_funcs = {init_cpu},
+	.modes = {STARPU_W},
+	.nbuffers = 1,
+};
+
+void increment_cpu(void *descr[], void *arg)
+{
+	(void)arg;
+	int *val = (int *)STARPU_VECTOR_GET_PTR(descr[0]);
+	unsigned n = STARPU_VECTOR_GET_NX(descr[0]);
+	unsigned i;
+
+	for (i = 0; i < n; i++)
+		val[i]++;
+}
+
+static struct starpu_codelet increment_cl =
+{
+	.cpu_funcs = {increment_cpu},
+	.modes = {STARPU_RW},
+	.nbuffers = 1,
+};
+
+/* Start StarPU and register the disk */
+static int start(struct starpu_disk_ops *ops, char *base, unsigned *dd)
+{
+	struct starpu_conf conf;
+	int ret = starpu_conf_init(&conf);
+	if (ret == -EINVAL)
+		return EXIT_FAILURE;
+	conf.precedence_over_environment_variables = 1;
+	starpu_conf_noworker(&conf);
+	conf.ncpus = 1;
+	conf.nmpi_ms = 0;
+	conf.ntcpip_ms = 0;
+	ret = starpu_init(&conf);
+	if (ret == -ENODEV)
+		return STARPU_TEST_SKIPPED;
+
+	int new_dd = starpu_disk_register(ops, (void *) base, STARPU_DISK_SIZE_MIN);
+	/* can't write on /tmp/ */
+	if (new_dd == -ENOENT)
+	{
+		starpu_shutdown();
+		return STARPU_TEST_SKIPPED;
+	}
+	*dd = (unsigned) new_dd;
+	return 0;
+}
+
+int dotest(struct starpu_disk_ops *ops, char *base)
+{
+	starpu_data_handle_t handle;
+	unsigned dd;
+	size_t size;
+	void *data;
+	unsigned i;
+	int ret;
+
+	/* First run: compute the result directly in the store */
+	ret = start(ops, base, &dd);
+	if (ret)
+		return ret;
+
+	data = starpu_disk_store_create(dd, "result", NX*sizeof(int));
+	STARPU_ASSERT(data);
+	starpu_vector_data_register(&handle, dd, (uintptr_t) data, NX, sizeof(int));
+	ret = starpu_task_insert(&init_cl, STARPU_W, handle, 0);
+	STARPU_CHECK_RETURN_VALUE(ret, "starpu_task_insert");
+	starpu_data_unregister(handle);
+	starpu_disk_close(dd, data, NX*sizeof(int));
+
+	STARPU_ASSERT(starpu_disk_store_open(dd, "missing", &size) == NULL && errno == ENOENT);
+
+	/* Names must stay in the directory of the disk */
+	STARPU_ASSERT(starpu_disk_store_create(dd, "../result", NX*sizeof(int)) == NULL && errno == EINVAL);
+	STARPU_ASSERT(starpu_disk_store_create(dd, "dir/result", NX*sizeof(int)) == NULL && errno == EINVAL);
+	STARPU_ASSERT(starpu_disk_store_create(dd, ".starpu_store", NX*sizeof(int)) == NULL && errno == EINVAL);
+	STARPU_ASSERT(starpu_disk_store_open(dd, "../result", &size) == NULL && errno == EINVAL);
+	STARPU_ASSERT(starpu_disk_store_remove(dd, "../result") == -EINVAL);
+	starpu_shutdown();
+
+	/* The index was replaced by the new one */
+	char index_new[256];
+	snprintf(index_new, sizeof(index_new), "%s/.starpu_store.new", base);
+	STARPU_ASSERT(access(index_new, F_OK) < 0);
+
+	/* Second run: get the result back from the store */
+	ret = start(ops, base, &dd);
+	if (ret)
+		return ret;
+
+	data = starpu_disk_store_open(dd, "result", &size);
+	STARPU_ASSERT(data);
+	STARPU_ASSERT(size == NX*sizeof(int));
+	starpu_vector_data_register(&handle, dd, (uintptr_t) data, NX, sizeof(int));
+	ret = starpu_task_insert(&increment_cl, STARPU_RW, handle, 0);
+	STARPU_CHECK_RETURN_VALUE(ret, "starpu_task_insert");
+
+	ret = starpu_data_acquire_on_node(handle, STARPU_MAIN_RAM, STARPU_R);
+	STARPU_CHECK_RETURN_VALUE(ret, "starpu_data_acquire_on_node");
+	int *val = (int *) starpu_data_get_local_ptr(handle);
+	for (i = 0; i < NX; i++)
+		if (val[i] != (int) i + 1)
+		{
+			FPRINTF(stderr, "Fail val[%u] %d != %d\n", i, val[i], (int) i + 1);
+			ret = EXIT_FAILURE;
+			break;
+		}
+	starpu_data_release_on_node(handle, STARPU_MAIN_RAM);
+
+	starpu_data_unregister(handle);
+	starpu_disk_close(dd, data, NX*sizeof(int));
+
+	/* And clean the store */
+	STARPU_ASSERT(starpu_disk_store_remove(dd, "result") == 0);
+	STARPU_ASSERT(starpu_disk_store_open(dd, "result", &size) == NULL);
+	STARPU_ASSERT(starpu_disk_store_remove(dd, "result") == -ENOENT);
+	starpu_shutdown();
+
+	char index[256];
+	snprintf(index, sizeof(index), "%s/.starpu_store", base);
+	unlink(index);
+
+	if (ret == 0)
+		FPRINTF(stderr, "TEST SUCCESS\n");
+	return ret;
+}
+
+/* The store is refused by backends which do not support it, and when its
+ * index is corrupted */
+int test_errors(char *base)
+{
+	char index[256];
+	unsigned dd;
+	size_t size;
+	FILE *f;
+	int ret;
+
+	ret = start(&starpu_disk_slab_ops, base, &dd);
+	if (ret)
+		return ret;
+	STARPU_ASSERT(starpu_disk_store_create(dd, "result", NX*sizeof(int)) == NULL && errno == ENOTSUP);
+	STARPU_ASSERT(starpu_disk_store_open(dd, "result", &size) == NULL && errno == ENOTSUP);
+	STARPU_ASSERT(starpu_disk_store_remove(dd, "result") == -ENOTSUP);
+	starpu_shutdown();
+
+	snprintf(index, sizeof(index), "%s/.starpu_store", base);
+	f = fopen(index, "w");
+	STARPU_ASSERT(f);
+	fprintf(f, "not an index\n");
+	fclose(f);
+
+	ret = start(&starpu_disk_unistd_ops, base, &dd);
+	if (ret == 0)
+	{
+		STARPU_ASSERT(starpu_disk_store_open(dd, "result", &size) == NULL && errno == EINVAL);
+		STARPU_ASSERT(starpu_disk_store_create(dd, "result", NX*sizeof(int)) == NULL && errno == EINVAL);
+		STARPU_ASSERT(starpu_disk_store_remove(dd, "result") == -EINVAL);
+		starpu_shutdown();
+	}
+	unlink(index);
+
+	if (ret == 0)
+		FPRINTF(stderr, "TEST SUCCESS\n");
+	return ret;
+}
+
+static int merge_result(int old, int new)
+{
+	if (new == EXIT_FAILURE)
+		return EXIT_FAILURE;
+	if (old == 0)
+		return 0;
+	return new;
+}
+
+int main(void)
+{
+	int ret = 0;
+	int ret2;
+	char s[128];
+
+#ifdef STARPU_HAVE_SETENV
+	setenv("STARPU_CALIBRATE_MINIMUM", "1", 1);
+#endif
+
+	snprintf(s, sizeof(s), "/tmp/%s-disk-XXXXXX", getenv("USER"));
+	if (!_starpu_mkdtemp(s))
+	{
+		FPRINTF(stderr, "Cannot make directory <%s>\n", s);
+		return STARPU_TEST_SKIPPED;
+	}
+
+	ret = merge_result(ret, dotest(&starpu_disk_stdio_ops, s));
+	ret = merge_result(ret, dotest(&starpu_disk_unistd_ops, s));
+	ret = merge_result(ret, test_errors(s));
+
+	ret2 = rmdir(s);
+	if (ret2 < 0)
+		STARPU_CHECK_RETURN_VALUE(-errno, "rmdir '%s'\n", s);
+	return ret;
+}
+#endif
@@ -279,6 +279,10 @@ int main(void)
 	if (ret == STARPU_TEST_SKIPPED) goto skipped;
 	ret = merge_result(ret, dotest(&starpu_disk_unistd_ops, s, starpu_my_vector_data_register, "unistd with pack/unpack vector ops"));
 	if (ret == STARPU_TEST_SKIPPED) goto skipped;
+	ret = merge_result(ret, dotest(&starpu_disk_slab_ops, s, starpu_vector_data_register, "slab with read/write vector ops"));
+	if (ret == STARPU_TEST_SKIPPED) goto skipped;
+	ret = merge_result(ret, dotest(&starpu_disk_slab_ops, s, starpu_my_vector_data_register, "slab with pack/unpack vector ops"));
+	if (ret == STARPU_TEST_SKIPPED) goto skipped;
 #ifdef STARPU_LINUX_SYS
 	ret = merge_result(ret, dotest(&starpu_disk_unistd_o_direct_ops, s, starpu_vector_data_register, "unistd_direct with read/write vector ops"));
 	if (ret == STARPU_TEST_SKIPPED) goto skipped;
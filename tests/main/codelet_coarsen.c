@@ -0,0 +1,181 @@
+/* StarPU --- Runtime system for heterogeneous multicore architectures.
+ *
+ * Copyright (C) 2023       Université de Bordeaux, CNRS (LaBRI UMR 5800), Inria
+ *
+ * StarPU is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or (at
+ * your option) any later version.
+ *
+ * StarPU is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU Lesser General Public License in COPYING.LGPL for more details.
+ */
+
+#include <starpu.h>
+#include "../helper.h"
+
+/*
+ * Submit many tiny tasks of a codelet which allows CPU workers to execute
+ * them in a row, mixed with tasks of another codelet, and check that each of
+ * them was popped once, executed once and had its callback called once.
+ * With only one CPU worker and all the tasks ready from the start, check
+ * that some tasks were popped ahead of the execution of the previous ones,
+ * i.e. that they were actually executed in a row.
+ */
+
+#ifdef STARPU_QUICK_CHECK
+#define NVARS	16
+#define NITER	16
+#else
+#define NVARS	64
+#define NITER	64
+#endif
+
+static unsigned ncallbacks;
+static unsigned npops[NITER*NVARS];
+static unsigned npopped, nexecuted, ncoarsened;
+
+void increment_cpu(void *descr[], void *arg)
+{
+	(void)arg;
+	unsigned *var = (unsigned *)STARPU_VARIABLE_GET_PTR(descr[0]);
+	unsigned *step = (unsigned *)STARPU_VARIABLE_GET_PTR(descr[1]);
+
+	*var += *step;
+
+	/* The next task was already popped */
+	if (npopped > nexecuted + 1)
+		ncoarsened++;
+	nexecuted++;
+}
+
+static struct starpu_codelet coarsen_cl =
+{
+	.cpu_funcs = {increment_cpu},
+	.modes = {STARPU_RW, STARPU_R},
+	.nbuffers = 2,
+	.flags = STARPU_CODELET_COARSEN,
+	.name = "coarsen",
+};
+
+static struct starpu_codelet other_cl =
+{
+	.cpu_funcs = {increment_cpu},
+	.modes = {STARPU_RW, STARPU_R},
+	.nbuffers = 2,
+	.name = "other",
+};
+
+static void callback(void *arg)
+{
+	(void)arg;
+	(void) STARPU_ATOMIC_ADD(&ncallbacks, 1);
+}
+
+static void pop_callback(void *arg)
+{
+	unsigned *n = arg;
+	(void) STARPU_ATOMIC_ADD(n, 1);
+	(void) STARPU_ATOMIC_ADD(&npopped, 1);
+}
+
+int main(void)
+{
+	starpu_data_handle_t handles[NVARS], step_handle;
+	unsigned vars[NVARS], step = 1;
+	unsigned i, iter, expected;
+	int ret;
+
+	struct starpu_conf conf;
+	starpu_conf_init(&conf);
+	/* Have one worker execute all the tasks */
+	conf.precedence_over_environment_variables = 1;
+	starpu_conf_noworker(&conf);
+	conf.ncpus = 1;
+	conf.sched_policy_name = "eager";
+
+	ret = starpu_init(&conf);
+	if (ret == -ENODEV) return STARPU_TEST_SKIPPED;
+	STARPU_CHECK_RETURN_VALUE(ret, "starpu_init");
+
+	if (starpu_cpu_worker_get_count() == 0)
+	{
+		starpu_shutdown();
+		return STARPU_TEST_SKIPPED;
+	}
+
+	starpu_variable_data_register(&step_handle, STARPU_MAIN_RAM, (uintptr_t)&step, sizeof(step));
+	for (i = 0; i < NVARS; i++)
+	{
+		vars[i] = 0;
+		starpu_variable_data_register(&handles[i], STARPU_MAIN_RAM, (uintptr_t)&vars[i], sizeof(vars[i]));
+	}
+
+	/* Make the first tasks ready at the same time */
+	starpu_pause();
+	for (iter = 0; iter < NITER; iter++)
+		for (i = 0; i < NVARS; i++)
+		{
+			/* The tasks of the other codelet interrupt the rows */
+			struct starpu_codelet *cl = (iter + i) % 4 ? &coarsen_cl : &other_cl;
+			ret = starpu_task_insert(cl,
+						 STARPU_RW, handles[i],
+						 STARPU_R, step_handle,
+						 STARPU_CALLBACK, callback,
+						 STARPU_PROLOGUE_CALLBACK_POP, pop_callback,
+						 STARPU_PROLOGUE_CALLBACK_POP_ARG_NFREE, &npops[iter*NVARS + i],
+						 0);
+			if (ret == -ENODEV)
+			{
+				starpu_resume();
+				goto enodev;
+			}
+			STARPU_CHECK_RETURN_VALUE(ret, "starpu_task_insert");
+		}
+	starpu_resume();
+
+	ret = starpu_task_wait_for_all();
+	STARPU_CHECK_RETURN_VALUE(ret, "starpu_task_wait_for_all");
+
+	for (i = 0; i < NVARS; i++)
+		starpu_data_unregister(handles[i]);
+	starpu_data_unregister(step_handle);
+	starpu_shutdown();
+
+	ret = EXIT_SUCCESS;
+	expected = NITER;
+	for (i = 0; i < NVARS; i++)
+		if (vars[i] != expected)
+		{
+			FPRINTF(stderr, "var %u is %u instead of %u\n", i, vars[i], expected);
+			ret = EXIT_FAILURE;
+		}
+	if (ncallbacks != NVARS*NITER)
+	{
+		FPRINTF(stderr, "%u callbacks were called instead of %u\n", ncallbacks, NVARS*NITER);
+		ret = EXIT_FAILURE;
+	}
+	for (i = 0; i < NVARS*NITER; i++)
+		if (npops[i] != 1)
+		{
+			FPRINTF(stderr, "the pop callback of task %u was called %u times\n", i, npops[i]);
+			ret = EXIT_FAILURE;
+		}
+	if (ncoarsened == 0 && starpu_getenv_number_default("STARPU_CPU_COARSEN_MAX", 8) > 1)
+	{
+		FPRINTF(stderr, "no task was executed in a row with the next one\n");
+		ret = EXIT_FAILURE;
+	}
+
+	return ret;
+
+enodev:
+	for (i = 0; i < NVARS; i++)
+		starpu_data_unregister(handles[i]);
+	starpu_data_unregister(step_handle);
+	starpu_shutdown();
+	return STARPU_TEST_SKIPPED;
+}
@@ -19,6 +19,11 @@
  * This reads a tasks.rec file and replays the recorded task graph.
  * Currently, this version is done to run with simgrid.
  *
+ * The file is first parsed in parallel into an array of records, which does
+ * not depend on StarPU being initialized. The records are then turned into
+ * StarPU tasks and submitted, possibly several times with different
+ * schedulers (what-if mode), without parsing the file again.
+ *
  * For further information, contact erwan.leria@inria.fr
  */
 
@@ -26,15 +31,18 @@
 #include <unistd.h>
 #include <stdio.h>
 #include <math.h>
+#include <pthread.h>
 
 #include <common/uthash.h>
 #include <common/utils.h>
 #include <starpu_scheduler.h>
-#include <common/rbtree.h>
 
 
 #define REPLAY_NMAX_DEPENDENCIES 8
 
+/* Minimum amount of the file parsed by a thread */
+#define REPLAY_MIN_CHUNK_SIZE (1<<20)
+
 #define ARRAY_DUP(in, out, n) memcpy(out, in, n * sizeof(*out))
 #define ARRAY_INIT(array, n) memset(array, 0, n * sizeof(*array))
 
@@ -55,56 +63,46 @@ enum task_type {NormalTask, WontUseTask};
 
 typedef unsigned long jobid_t;
 
-enum task_type control;
-static char *name = NULL;
-static char *model = NULL;
-static jobid_t jobid;
-static jobid_t *dependson;
-static long submitorder = -1;
-static starpu_tag_t tag;
-static int workerid;
-static uint32_t footprint;
-static double flops, total_flops = 0.;
-
-static double startTime; //start time (The instant when the task starts)
-static double endTime; //end time (The instant when the task ends)
-
-static int iteration = -1;
-
-static starpu_data_handle_t handles[STARPU_NMAXBUFS];
-static enum starpu_data_access_mode modes[STARPU_NMAXBUFS];
-static char normal_reg_signal[STARPU_NMAXBUFS];
-
-/* Use the following arrays when the number of data is greater than STARPU_NMAXBUFS */
-
-starpu_data_handle_t * handles_ptr;
-enum starpu_data_access_mode * modes_ptr;
-size_t * sizes_set;
-
-static size_t dependson_size;
-static size_t ndependson;
-
-static unsigned nb_parameters = 0; /* Number of parameters */
-static int alloc_mode; /* If alloc_mode value is 1, then the handles are stored in dyn_handles, else they are in handles */
-
-static int priority = 0;
-
-char * reg_signal = NULL; /* The register signal (0 or 1 coded on 8 bit) is used to know which handle of the task has to be registered in StarPU (in fact to avoid  handle twice)*/
-
-/* Record all tasks, hashed by jobid. */
-static struct task
+/* A record of the tasks.rec file, as parsed */
+struct rec
 {
-	struct starpu_rbtree_node node;
-	UT_hash_handle hh;
+	enum task_type control;
+	char *name;
+	char *model;
 	jobid_t jobid;
-	int iteration;
-	long submit_order;
+	/* Job ids this task depends on while parsing, then indexes in the
+	 * recs array of the tasks found among them */
 	jobid_t *deps;
 	size_t ndependson;
-	struct starpu_task task;
-	enum task_type type;
-	int reg_signal;
-} *tasks;
+	long submit_order;
+	starpu_tag_t tag;
+	int workerid;
+	uint32_t footprint;
+	double flops;
+	double start_time; /* The instant when the task starts */
+	double end_time; /* The instant when the task ends */
+	int iteration;
+	int priority;
+
+	unsigned nb_parameters;
+	/* Handles as they were in the original execution */
+	starpu_data_handle_t *handles;
+	enum starpu_data_access_mode *modes;
+	size_t *sizes;
+
+	/* Hashed by jobid, for normal tasks */
+	UT_hash_handle hh;
+};
+
+/* All records, in file order */
+static struct rec *recs;
+static size_t nrecs;
+/* Indexes in recs, in submission order */
+static size_t *submit_sequence;
+
+/* The tasks of the current replay, indexed like recs */
+static struct starpu_task *tasks;
+static double total_flops;
 
 /* Record handles */
 static struct handle
@@ -278,25 +276,6 @@ static struct starpu_data_interface_ops replay_interface_ops =
 };
 
 
-/* [SUBMITORDER] The tree of the submit order */
-
-static struct starpu_rbtree tree = STARPU_RBTREE_INITIALIZER;
-
-/* the cmp_fn arg for rb_tree_insert() */
-unsigned int diff(struct starpu_rbtree_node * left_elm, struct starpu_rbtree_node * right_elm)
-{
-	long oleft = ((struct task *) left_elm)->submit_order;
-	long oright = ((struct task *) right_elm)->submit_order;
-	if (oleft == -1 && oright == -1)
-	{
-		if (left_elm < right_elm)
-			return -1;
-		else
-			return 1;
-	}
-	return oleft - oright;
-}
-
 /* Settings for the perfmodel */
 struct task_arg
 {
@@ -408,751 +387,665 @@ static struct starpu_codelet cl =
 * * * * * * * * * * * * * * */
 
 
-/* The following function checks if the program has to use static or dynamic arrays*/
-static int set_alloc_mode(int total_parameters)
+/* [PARSING] Each thread parses a chunk of the file into its own array of records
+ *
+ * These are plain system threads, even in simgrid mode where starpu_pthread
+ * threads are simulated actors which would parse one after the other. */
+
+struct chunk
 {
-	return total_parameters <= STARPU_NMAXBUFS;
-}
+	/* Part of the file to be parsed, starting and ending on record boundaries */
+	char *start;
+	char *end;
+	struct rec *recs;
+	size_t nrecs;
+	size_t nallocated;
+	pthread_t thread;
+};
 
-/* According to the allocation mode, modify handles_ptr and modes_ptr in static or dynamic */
-static void arrays_managing(int mode)
+static void rec_init(struct rec *rec)
 {
-	if (mode)
-	{
-		handles_ptr = &handles[0];
-		modes_ptr = &modes[0];
-		reg_signal = &normal_reg_signal[0];
-	}
-	else
-	{
-		_STARPU_MALLOC(handles_ptr, sizeof(*handles_ptr) * nb_parameters);
-		_STARPU_MALLOC(modes_ptr, sizeof(*modes_ptr) * nb_parameters);
-		_STARPU_CALLOC(reg_signal, nb_parameters, sizeof(char));
+	memset(rec, 0, sizeof(*rec));
+	rec->control = NormalTask;
+	rec->submit_order = -1;
+	rec->tag = -1;
+	rec->workerid = -1;
+	rec->iteration = -1;
+}
 
-	}
+static void rec_clean(struct rec *rec)
+{
+	free(rec->name);
+	free(rec->model);
+	free(rec->deps);
+	free(rec->handles);
+	free(rec->modes);
+	free(rec->sizes);
 }
 
-static unsigned count_number_tokens(const char* buffer, const char* delim)
+static unsigned count_number_tokens(const char* buffer)
 {
-	char* dup = strdup(buffer);
-	int result = 0;
-	char* token = strtok(dup, delim);
-	while(token != NULL)
+	unsigned result = 0;
+	while (*buffer)
 	{
-		++result;
-		token = strtok(NULL, delim);
+		while (*buffer == ' ')
+			buffer++;
+		if (!*buffer)
+			break;
+		result++;
+		while (*buffer && *buffer != ' ')
+			buffer++;
 	}
-	free(dup);
 	return result;
 }
 
-/* Check if a handle hasn't been registered yet */
-static void variable_data_register_check(size_t * array_of_size, int nb_handles)
+/* Handles, Modes and Sizes lines must agree on the number of parameters */
+static void set_nb_parameters(struct rec *rec, const char *buffer)
 {
-	int h, i;
-	starpu_data_handle_t orig_handles[nb_handles];
+	unsigned nb_parameters_line = count_number_tokens(buffer);
 
-	ARRAY_DUP(handles_ptr, orig_handles, nb_handles);
+	if (rec->nb_parameters == 0)
+		rec->nb_parameters = nb_parameters_line;
+	else
+		STARPU_ASSERT(rec->nb_parameters == nb_parameters_line);
+}
 
-	for (h = 0 ; h < nb_handles ; h++)
+/* Record the information of line s (without its '\n') into rec */
+static void parse_line(struct rec *rec, char *s)
+{
+	char *saveptr;
+	char *token;
+	unsigned i;
+
+#define TEST(field) (!strncmp(s, field": ", strlen(field) + 2))
+
+	if(TEST("Control"))
 	{
-		if(reg_signal[h]) /* Get the register signal, if it's 1 do ... */
+		char * c = s+9;
+
+		if(!strncmp(c, "WontUse", 7))
 		{
-			struct handle * handles_cell;
+			rec->control = WontUseTask;
+			rec->nb_parameters = 1;
+		}
+		else
+			rec->control = NormalTask;
+	}
+	else if (TEST("Name"))
+	{
+		rec->name = strdup(s+6);
+	}
+	else if (TEST("Model"))
+	{
+		rec->model = strdup(s+7);
+	}
+	else if (TEST("JobId"))
+		rec->jobid = atol(s+7);
+	else if(TEST("SubmitOrder"))
+		rec->submit_order = atoi(s+13);
+	else if (TEST("DependsOn"))
+	{
+		char *c = s + 11;
+		size_t dependson_size = REPLAY_NMAX_DEPENDENCIES;
 
-			for (i = 0; i < h; i++)
+		_STARPU_MALLOC(rec->deps, dependson_size * sizeof(*rec->deps));
+		for (rec->ndependson = 0; ; rec->ndependson++)
+		{
+			char *next;
+			jobid_t dep = strtol(c, &next, 10);
+			if (next == c)
+				break;
+			if (rec->ndependson >= dependson_size)
 			{
-				/* Maybe we just registered it in this very h loop */
-				if (handles_ptr[h] == orig_handles[i])
-				{
-					handles_ptr[h] = handles_ptr[i];
-					break;
-				}
+				dependson_size *= 2;
+				_STARPU_REALLOC(rec->deps, dependson_size * sizeof(*rec->deps));
 			}
+			rec->deps[rec->ndependson] = dep;
+			c = next;
+		}
+	}
+	else if (TEST("Tag"))
+	{
+		rec->tag = strtol(s+5, NULL, 16);
+	}
+	else if (TEST("WorkerId"))
+	{
+		rec->workerid = atoi(s+10);
+	}
+	else if (TEST("Footprint"))
+	{
+		rec->footprint = strtoul(s+11, NULL, 16);
+	}
+	else if (TEST("Parameters"))
+	{
+		/* Nothing to do */
+	}
+	else if (TEST("Handles"))
+	{
+		char *buffer = s + 9;
+		set_nb_parameters(rec, buffer);
+		_STARPU_MALLOC(rec->handles, rec->nb_parameters * sizeof(*rec->handles));
 
-			if (i == h)
-			{
-				_STARPU_MALLOC(handles_cell, sizeof(*handles_cell));
-				STARPU_ASSERT(handles_cell != NULL);
-
-				handles_cell->handle = handles_ptr[h]; /* Get the hidden key (initial handle from the file) to store it as a key*/
-
-				replay_data_register(handles_ptr+h, handles_ptr[h],
-						modes_ptr[h] & STARPU_R ? STARPU_MAIN_RAM : -1,
-						array_of_size[h], array_of_size[h], array_of_size[h]);
-
-				handles_cell->mem_ptr = handles_ptr[h]; /* Store the new value of the handle into the hash table */
-
-				HASH_ADD(hh, handles_hash, handle, sizeof(handles_ptr[h]), handles_cell);
-			}
+		token = strtok_r(buffer, " ", &saveptr);
+		for (i = 0 ; i < rec->nb_parameters ; i++)
+		{
+			STARPU_ASSERT(token);
+			rec->handles[i] = (starpu_data_handle_t) strtol(token, NULL, 16);
+			token = strtok_r(NULL, " ", &saveptr);
 		}
 	}
-}
+	else if (TEST("Modes"))
+	{
+		char * buffer = s + 7;
+		unsigned mode_i = 0;
+		set_nb_parameters(rec, buffer);
+		_STARPU_CALLOC(rec->modes, rec->nb_parameters, sizeof(*rec->modes));
 
-void reset(void)
-{
-	control = NormalTask;
+		token = strtok_r(buffer, " ", &saveptr);
+		while (token != NULL && mode_i < rec->nb_parameters)
+		{
+			/* Subject to the names of starpu modes enumerator are not modified */
+			if (!strncmp(token, "RW", 2))
+				rec->modes[mode_i++] = STARPU_RW;
+			else if (!strncmp(token, "R", 1))
+				rec->modes[mode_i++] = STARPU_R;
+			else if (!strncmp(token, "W", 1))
+				rec->modes[mode_i++] = STARPU_W;
+			/* Other cases produce a warning*/
+			else
+				fprintf(stderr, "[Warning] A mode is different from R/W (jobid task : %lu)", rec->jobid);
+			token = strtok_r(NULL, " ", &saveptr);
+		}
+	}
+	else if (TEST("Sizes"))
+	{
+		char *  buffer = s + 7;
+		unsigned k = 0;
+		set_nb_parameters(rec, buffer);
+		_STARPU_MALLOC(rec->sizes, rec->nb_parameters * sizeof(*rec->sizes));
 
-	if (name != NULL)
+		token = strtok_r(buffer, " ", &saveptr);
+		while (token != NULL && k < rec->nb_parameters)
+		{
+			rec->sizes[k++] = strtol(token, NULL, 10);
+			token = strtok_r(NULL, " ", &saveptr);
+		}
+	}
+	else if (TEST("StartTime"))
 	{
-		free(name);
-		name = NULL;
+		rec->start_time = strtod(s+11, NULL);
 	}
-
-	if (model != NULL)
+	else if (TEST("EndTime"))
 	{
-		free(model);
-		model = NULL;
+		rec->end_time = strtod(s+9, NULL);
 	}
-
-	if (sizes_set != NULL)
+	else if (TEST("GFlop"))
+	{
+		rec->flops = 1000000000 * strtod(s+7, NULL);
+	}
+	else if (TEST("Iteration"))
 	{
-		free(sizes_set);
-		sizes_set = NULL;
+		rec->iteration = (unsigned) strtol(s+11, NULL, 10);
 	}
+	else if (TEST("Priority"))
+	{
+		rec->priority = strtol(s + 10, NULL, 10);
+	}
+#undef TEST
+}
 
-	if (reg_signal != NULL)
+/* Read line by line, and on empty line record the accumulated information */
+static void *parse_chunk(void *arg)
+{
+	struct chunk *chunk = arg;
+	char *s = chunk->start;
+	struct rec rec;
+	int empty = 1;
+
+	rec_init(&rec);
+	while (s < chunk->end)
 	{
-		if (!alloc_mode)
+		char *ln = memchr(s, '\n', chunk->end - s);
+		if (!ln)
+			/* Truncated line at the end of the file */
+			break;
+
+		if (ln == s)
 		{
-			free(reg_signal);
-			reg_signal = NULL;
+			/* Empty line, record task */
+			if (!empty)
+			{
+				if (chunk->nrecs == chunk->nallocated)
+				{
+					chunk->nallocated = chunk->nallocated ? 2 * chunk->nallocated : 1024;
+					_STARPU_REALLOC(chunk->recs, chunk->nallocated * sizeof(*chunk->recs));
+				}
+				chunk->recs[chunk->nrecs++] = rec;
+				rec_init(&rec);
+				empty = 1;
+			}
 		}
 		else
 		{
-			ARRAY_INIT(reg_signal, nb_parameters);
+			*ln = 0;
+			parse_line(&rec, s);
+			empty = 0;
 		}
+		s = ln + 1;
 	}
 
-	jobid = 0;
-	ndependson = 0;
-	tag = -1;
-	workerid = -1;
-	footprint = 0;
-	startTime = 0.0;
-	endTime = 0.0;
-
-	if (submitorder != -1)
-		submitorder = -1;
-
-	iteration = -1;
-	nb_parameters = 0;
-	alloc_mode = 1;
+	/* The last task was not terminated by an empty line, drop it */
+	rec_clean(&rec);
+	return NULL;
 }
 
-void fix_wontuse_handle(struct task * wontuseTask)
+static int cmp_submit_order(const void *a, const void *b)
 {
-	STARPU_ASSERT(wontuseTask);
-
-	if (!wontuseTask->reg_signal)
-		/* Data was already registered when we created this task, so it's already a handle */
-		return;
-
-	struct handle *handle_tmp;
-
-	/* Data was not registered when we created this task, so this is the application pointer, look it up now */
-	HASH_FIND(hh, handles_hash, &wontuseTask->task.handles[0], sizeof(wontuseTask->task.handles[0]), handle_tmp);
-
-	if (handle_tmp)
-		wontuseTask->task.handles[0] = handle_tmp->mem_ptr;
-	else
-		/* This data wasn't actually used, don't care about it */
-		wontuseTask->task.handles[0] = NULL;
+	size_t ia = *(const size_t *) a;
+	size_t ib = *(const size_t *) b;
+	long oa = recs[ia].submit_order;
+	long ob = recs[ib].submit_order;
+
+	/* Tasks without submit order first, then in file order */
+	if (oa != ob)
+		return oa < ob ? -1 : 1;
+	return ia < ib ? -1 : ia > ib;
 }
 
-/* Function that submits all the tasks (used when the program reaches EOF) */
-int submit_tasks(void)
+/* Parse the whole file with nthreads threads, and index the result */
+static void load_tasks_rec(const char *tasks_rec, unsigned nthreads)
 {
-	/* Add dependencies */
+	FILE *rec;
+	char *buffer;
+	long size;
+	unsigned i;
+	size_t n, k;
 
-	const struct starpu_rbtree * tmptree = &tree;
-	struct starpu_rbtree_node * currentNode = starpu_rbtree_first(tmptree);
-	long last_submitorder = 0;
+	rec = fopen(tasks_rec, "r");
+	if (!rec)
+	{
+		fprintf(stderr,"unable to open file %s: %s\n", tasks_rec, strerror(errno));
+		exit(EXIT_FAILURE);
+	}
+	fseek(rec, 0, SEEK_END);
+	size = ftell(rec);
+	rewind(rec);
+	_STARPU_MALLOC(buffer, size + 1);
+	if (fread(buffer, 1, size, rec) != (size_t) size)
+	{
+		fprintf(stderr,"unable to read file %s: %s\n", tasks_rec, strerror(errno));
+		exit(EXIT_FAILURE);
+	}
+	buffer[size] = 0;
+	fclose(rec);
+
+	if (nthreads > size / REPLAY_MIN_CHUNK_SIZE)
+		nthreads = size / REPLAY_MIN_CHUNK_SIZE;
+	if (nthreads < 1)
+		nthreads = 1;
+
+	/* Cut the file on empty lines, i.e. between records */
+	struct chunk chunks[nthreads];
+	memset(chunks, 0, sizeof(chunks));
+	chunks[0].start = buffer;
+	for (i = 1; i < nthreads; i++)
+	{
+		char *p = buffer + i * (size / nthreads);
+		if (p < chunks[i-1].start)
+			p = chunks[i-1].start;
+		char *sep = strstr(p - 1, "\n\n");
+		chunks[i].start = sep ? sep + 2 : buffer + size;
+		chunks[i-1].end = chunks[i].start;
+	}
+	chunks[nthreads-1].end = buffer + size;
 
-	while (currentNode != NULL)
+	for (i = 1; i < nthreads; i++)
 	{
-		struct task * currentTask = (struct task *) currentNode;
+		int ret = pthread_create(&chunks[i].thread, NULL, parse_chunk, &chunks[i]);
+		if (ret)
+		{
+			fprintf(stderr, "unable to create parsing thread: %s\n", strerror(ret));
+			exit(EXIT_FAILURE);
+		}
+	}
+	parse_chunk(&chunks[0]);
+	for (i = 1; i < nthreads; i++)
+		pthread_join(chunks[i].thread, NULL);
+	free(buffer);
+
+	/* Concatenate the records, in file order */
+	nrecs = 0;
+	for (i = 0; i < nthreads; i++)
+		nrecs += chunks[i].nrecs;
+	_STARPU_MALLOC(recs, nrecs * sizeof(*recs));
+	for (n = 0, i = 0; i < nthreads; i++)
+	{
+		memcpy(&recs[n], chunks[i].recs, chunks[i].nrecs * sizeof(*recs));
+		n += chunks[i].nrecs;
+		free(chunks[i].recs);
+	}
+	fprintf(stderr, "Read %lu tasks... done.\n", (unsigned long) nrecs);
 
-		if (currentTask->type == NormalTask)
+	/* Resolve dependencies once for all through a jobid index */
+	struct rec *jobids = NULL;
+	for (n = 0; n < nrecs; n++)
+	{
+		struct rec *r = &recs[n];
+		if (r->control == NormalTask)
+			HASH_ADD(hh, jobids, jobid, sizeof(r->jobid), r);
+	}
+	for (n = 0; n < nrecs; n++)
+	{
+		struct rec *r = &recs[n];
+		size_t j = 0;
+		if (r->control != NormalTask)
+			continue;
+		for (k = 0; k < r->ndependson; k++)
 		{
-			if (currentTask->submit_order != -1)
-			{
-				STARPU_ASSERT(currentTask->submit_order >= last_submitorder + 1);
+			struct rec *dep;
+			HASH_FIND(hh, jobids, &r->deps[k], sizeof(r->deps[k]), dep);
+			if (dep)
+				r->deps[j++] = dep - recs;
+		}
+		r->ndependson = j;
+	}
+	HASH_CLEAR(hh, jobids);
 
-				while (currentTask->submit_order > last_submitorder + 1)
-				{
-					/* Oops, some tasks were not submitted by original application, fake some */
-					struct starpu_task *task = starpu_task_create();
-					int ret;
-					task->cl = NULL;
-					task->name = "fake task for submit order";
-					ret = starpu_task_submit(task);
-					STARPU_ASSERT(ret == 0);
-					last_submitorder++;
-				}
-			}
+	_STARPU_MALLOC(submit_sequence, nrecs * sizeof(*submit_sequence));
+	for (n = 0; n < nrecs; n++)
+		submit_sequence[n] = n;
+	qsort(submit_sequence, nrecs, sizeof(*submit_sequence), cmp_submit_order);
+}
 
-			if (currentTask->ndependson > 0)
-			{
-				struct starpu_task * taskdeps[currentTask->ndependson];
-				unsigned i, j = 0;
+static void free_recs(void)
+{
+	size_t n;
+	for (n = 0; n < nrecs; n++)
+		rec_clean(&recs[n]);
+	free(recs);
+	recs = NULL;
+	nrecs = 0;
+	free(submit_sequence);
+	submit_sequence = NULL;
+}
 
-				for (i = 0; i < currentTask->ndependson; i++)
-				{
-					struct task * taskdep;
 
-					/*  Get the ith jobid of deps_jobid */
-					HASH_FIND(hh, tasks, &currentTask->deps[i], sizeof(jobid), taskdep);
+/* [REPLAY] Turn the records into tasks, and submit them */
 
-					if(taskdep)
-					{
-						taskdeps[j] = &taskdep->task;
-						j ++;
-					}
-				}
+/* Get the registered handle for the original handle, registering it if needed */
+static starpu_data_handle_t get_handle(starpu_data_handle_t orig_handle, enum starpu_data_access_mode mode, size_t size)
+{
+	struct handle *handles_cell;
 
-				starpu_task_declare_deps_array(&currentTask->task, j, taskdeps);
-			}
+	HASH_FIND(hh, handles_hash, &orig_handle, sizeof(orig_handle), handles_cell);
+	if (handles_cell == NULL)
+	{
+		_STARPU_MALLOC(handles_cell, sizeof(*handles_cell));
+		handles_cell->handle = orig_handle; /* The initial handle from the file is the key */
+		replay_data_register(&handles_cell->mem_ptr, orig_handle,
+				mode & STARPU_R ? STARPU_MAIN_RAM : -1,
+				size, size, size);
+		HASH_ADD(hh, handles_hash, handle, sizeof(orig_handle), handles_cell);
+	}
+	return handles_cell->mem_ptr;
+}
 
-			if (!(currentTask->iteration == -1))
-				starpu_iteration_push(currentTask->iteration);
+static struct perfmodel *get_perfmodel(struct rec *rec)
+{
+	struct perfmodel * realmodel;
 
-			applySchedRec(&currentTask->task, currentTask->submit_order);
-			if (currentTask->submit_order == -1)
-				currentTask->task.no_submitorder = 1;
-			int ret_val = starpu_task_submit(&currentTask->task);
+	if (!rec->model)
+		return NULL;
 
-			if (!(currentTask->iteration == -1))
-				starpu_iteration_pop();
+	HASH_FIND_STR(model_hash, rec->model, realmodel);
 
-			if (ret_val != 0)
-			{
-				fprintf(stderr, "\nWhile submitting task %ld (%s): return %d\n",
-						currentTask->submit_order,
-						currentTask->task.name? currentTask->task.name : "unknown",
-						ret_val);
-				return -1;
-			}
+	if (realmodel == NULL)
+	{
+		_STARPU_CALLOC(realmodel, 1, sizeof(struct perfmodel));
+		realmodel->model_name = strdup(rec->model);
 
+		starpu_perfmodel_init(&realmodel->perfmodel);
 
-			//fprintf(stderr, "submitting task %s (%lu, %llu)\n", currentTask->task.name?currentTask->task.name:"anonymous", currentTask->jobid, (unsigned long long) currentTask->task.tag_id);
-			if (!(currentTask->submit_order % 1000))
-			{
-				fprintf(stderr, "\rSubmitted task order %ld...", currentTask->submit_order);
-				fflush(stdout);
-			}
-			if (currentTask->submit_order != -1)
-				last_submitorder++;
-		}
+		int error = starpu_perfmodel_load_symbol(rec->model, &realmodel->perfmodel);
 
+		if (!error)
+		{
+			HASH_ADD_STR(model_hash, model_name, realmodel);
+		}
 		else
 		{
-			fix_wontuse_handle(currentTask); /* Add the handle in the wontuse task */
-			if (currentTask->task.handles[0])
-			{
-				starpu_data_wont_use(currentTask->task.handles[0]);
-				last_submitorder++;
-			}
+			fprintf(stderr, "[starpu][Warning] Error loading perfmodel symbol %s\n", rec->model);
+			fprintf(stderr, "[starpu][Warning] Taking only measurements from the given execution, and forcing execution on worker %d\n", rec->workerid);
+			starpu_perfmodel_unload_model(&realmodel->perfmodel);
+			free(realmodel->model_name);
+			free(realmodel);
+			realmodel = NULL;
 		}
-
-		currentNode = starpu_rbtree_next(currentNode);
-
 	}
-	fprintf(stderr, " done.\n");
-
-	return 1;
-}
-
-
-/* * * * * * * * * * * * * * * */
-/* * * * * * MAIN * * * * * * */
-/* * * * * * * * * * * * * * */
-
-static void usage(const char *program)
-{
-	fprintf(stderr,"Usage: %s [--static-workerid] tasks.rec [sched.rec]\n", program);
-	exit(EXIT_FAILURE);
+	return realmodel;
 }
 
-int main(int argc, char **argv)
+static void build_task(struct rec *rec, struct starpu_task *task)
 {
-	FILE *rec;
-	char *s;
-	const char *tasks_rec = NULL;
-	const char *sched_rec = NULL;
 	unsigned i;
-	size_t s_allocated = 128;
-
-	unsigned long nread_tasks = 0;
 
-	/* FIXME: we do not support data with sequential consistency disabled */
+	starpu_task_init(task);
+	task->name = rec->name;
 
-	_STARPU_MALLOC(s, s_allocated);
-	dependson_size = REPLAY_NMAX_DEPENDENCIES; /* Change the value of REPLAY_NMAX_DEPENCIES to modify the number of dependencies */
-	_STARPU_MALLOC(dependson, dependson_size * sizeof (* dependson));
-	alloc_mode = 1;
+	if (rec->control != NormalTask)
+		return;
 
-	for (i = 1; i < (unsigned) argc; i++)
+	if (rec->workerid >= 0)
 	{
-		if (!strcmp(argv[i], "--help") || !strcmp(argv[i], "-h"))
+		starpu_data_handle_t *handles;
+
+		task->priority = rec->priority;
+		task->cl = &cl;
+		if (static_workerid)
 		{
-			usage(argv[0]);
+			task->workerid = rec->workerid;
+			task->execute_on_a_specific_worker = 1;
 		}
-		else if (!strcmp(argv[i], "--static-workerid"))
+
+		STARPU_ASSERT_MSG(!rec->nb_parameters || (rec->handles && rec->modes && rec->sizes), "Task %lu lacks Handles, Modes or Sizes", rec->jobid);
+		if (rec->nb_parameters <= STARPU_NMAXBUFS)
 		{
-			static_workerid = 1;
+			ARRAY_DUP(rec->modes, task->modes, rec->nb_parameters);
+			handles = task->handles;
 		}
 		else
 		{
-			if (!tasks_rec)
-				tasks_rec = argv[i];
-			else if (!sched_rec)
-				sched_rec = argv[i];
-			else
-				usage(argv[0]);
+			_STARPU_MALLOC(task->dyn_modes, rec->nb_parameters * sizeof(*task->dyn_modes));
+			ARRAY_DUP(rec->modes, task->dyn_modes, rec->nb_parameters);
+			_STARPU_MALLOC(task->dyn_handles, rec->nb_parameters * sizeof(*task->dyn_handles));
+			handles = task->dyn_handles;
 		}
-	}
+		for (i = 0; i < rec->nb_parameters; i++)
+			handles[i] = get_handle(rec->handles[i], rec->modes[i], rec->sizes[i]);
+		task->nbuffers = rec->nb_parameters;
 
-	if (!tasks_rec)
-		usage(argv[0]);
-
-	if (sched_rec)
-		schedRecInit(sched_rec);
+		struct perfmodel * realmodel = get_perfmodel(rec);
 
-	rec = fopen(tasks_rec, "r");
-	if (!rec)
-	{
-		fprintf(stderr,"unable to open file %s: %s\n", tasks_rec, strerror(errno));
-		exit(EXIT_FAILURE);
-	}
+		struct starpu_perfmodel_arch *arch = starpu_worker_get_perf_archtype(rec->workerid, 0);
 
-	int ret = starpu_init(NULL);
-	if (ret == -ENODEV) goto enodev;
+		unsigned comb = starpu_perfmodel_arch_comb_add(arch->ndevices, arch->devices);
+		unsigned narch = starpu_perfmodel_get_narch_combs();
 
-	/* Read line by line, and on empty line submit the task with the accumulated information */
-	reset();
+		struct task_arg *arg;
+		_STARPU_MALLOC(arg, sizeof(struct task_arg) + sizeof(double) * narch);
+		arg->footprint = rec->footprint;
+		arg->narch = narch;
+		double * perfTime  = arg->perf;
 
-	double start = starpu_timing_now();
-	int linenum = 0;
-
-	while(1)
-	{
-		char *ln;
-
-		if (!fgets(s, s_allocated, rec))
+		if (realmodel == NULL)
 		{
-			fprintf(stderr, " done.\n");
-			int submitted = submit_tasks();
-
-			if (submitted == -1)
+			/* Erf, do without perfmodel, for execution there */
+			task->workerid = rec->workerid;
+			task->execute_on_a_specific_worker = 1;
+			for (i = 0; i < narch ; i++)
 			{
-				goto enodev;
+				if (i == comb)
+					perfTime[i] = rec->end_time - rec->start_time;
+				else
+					perfTime[i] = NAN;
 			}
-
-			goto eof;
 		}
-
-		while (!(ln = strchr(s, '\n')))
+		else
 		{
-			/* fprintf(stderr,"buffer size %d too small, doubling it\n", s_allocated); */
-			_STARPU_REALLOC(s, s_allocated * 2);
-
-			if (!fgets(s + s_allocated-1, s_allocated+1, rec))
+			int one = 0;
+			for (i = 0; i < narch ; i++)
 			{
-				fprintf(stderr, "\n");
-				int submitted = submit_tasks();
-
-				if (submitted == -1)
-				{
-					goto enodev;
-				}
-
-				goto eof;
+				arch = starpu_perfmodel_arch_comb_fetch(i);
+				perfTime[i] = starpu_perfmodel_history_based_expected_perf(&realmodel->perfmodel, arch, rec->footprint);
+				if (!(perfTime[i] == 0 || isnan(perfTime[i])))
+					one = 1;
+			}
+			if (!one)
+			{
+				fprintf(stderr, "We do not have any performance measurement for symbol '%s' for footprint %x, we can not execute this", rec->model, rec->footprint);
+				exit(EXIT_FAILURE);
 			}
-
-			s_allocated *= 2;
 		}
 
-		linenum++;
-
-		if (ln == s)
-		{
-			/* Empty line, do task */
-
-			struct task * task;
-			_STARPU_MALLOC(task, sizeof(*task));
-
-			starpu_task_init(&task->task);
-			task->deps = NULL;
-
-			task->submit_order = submitorder;
-
-			starpu_rbtree_node_init(&task->node);
-			starpu_rbtree_insert(&tree, &task->node, diff);
-
+		task->cl_arg = arg;
+		task->flops = rec->flops;
+		total_flops += rec->flops;
+	}
 
-			task->jobid = jobid;
-			task->iteration = iteration;
+	task->cl_arg_size = 0;
+	task->tag_id = rec->tag;
+	task->use_tag = 1;
+}
 
-			if (name != NULL)
-				task->task.name = strdup(name);
+/* Function that submits all the tasks, all lookups having been done beforehand */
+static int submit_tasks(void)
+{
+	long last_submitorder = 0;
+	size_t n;
 
-			task->type = control;
+	for (n = 0; n < nrecs; n++)
+	{
+		struct rec *rec = &recs[submit_sequence[n]];
+		struct starpu_task *task = &tasks[submit_sequence[n]];
 
-			if (control == NormalTask)
+		if (rec->control == NormalTask)
+		{
+			if (rec->submit_order != -1)
 			{
-				if (workerid >= 0)
-				{
-					task->task.priority = priority;
-					task->task.cl = &cl;
-					if (static_workerid)
-					{
-						task->task.workerid = workerid;
-						task->task.execute_on_a_specific_worker = 1;
-					}
-
-					if (alloc_mode)
-					{
-						/* Duplicating the handles stored (and registered in the current context) into the task */
-
-						ARRAY_DUP(modes_ptr, task->task.modes, nb_parameters);
-						ARRAY_DUP(modes_ptr, task->task.cl->modes, nb_parameters);
-						variable_data_register_check(sizes_set, nb_parameters);
-						ARRAY_DUP(handles_ptr, task->task.handles, nb_parameters);
-					}
-					else
-					{
-						task->task.dyn_modes = modes_ptr;
-						_STARPU_MALLOC(task->task.cl->dyn_modes, (sizeof(*task->task.cl->dyn_modes) * nb_parameters));
-						ARRAY_DUP(modes_ptr, task->task.cl->dyn_modes, nb_parameters);
-						variable_data_register_check(sizes_set, nb_parameters);
-						task->task.dyn_handles = handles_ptr;
-					}
-
-					task->task.nbuffers = nb_parameters;
-
-					struct perfmodel * realmodel;
-
-					HASH_FIND_STR(model_hash, model, realmodel);
-
-					if (realmodel == NULL)
-					{
-						int len = strlen(model);
-						_STARPU_CALLOC(realmodel, 1, sizeof(struct perfmodel));
-
-						_STARPU_MALLOC(realmodel->model_name, sizeof(char) * (len+1));
-						realmodel->model_name = strcpy(realmodel->model_name, model);
-
-						starpu_perfmodel_init(&realmodel->perfmodel);
-
-						int error = starpu_perfmodel_load_symbol(model, &realmodel->perfmodel);
-
-						if (!error)
-						{
-							HASH_ADD_STR(model_hash, model_name, realmodel);
-						}
-						else
-						{
-
-							fprintf(stderr, "[starpu][Warning] Error loading perfmodel symbol %s\n", model);
-							fprintf(stderr, "[starpu][Warning] Taking only measurements from the given execution, and forcing execution on worker %d\n", workerid);
-							starpu_perfmodel_unload_model(&realmodel->perfmodel);
-							free(realmodel->model_name);
-							free(realmodel);
-							realmodel = NULL;
-						}
-
-					}
-
-					struct starpu_perfmodel_arch *arch = starpu_worker_get_perf_archtype(workerid, 0);
-
-					unsigned comb = starpu_perfmodel_arch_comb_add(arch->ndevices, arch->devices);
-					unsigned narch = starpu_perfmodel_get_narch_combs();
-
-					struct task_arg *arg;
-					_STARPU_MALLOC(arg, sizeof(struct task_arg) + sizeof(double) * narch);
-					arg->footprint = footprint;
-					arg->narch = narch;
-					double * perfTime  = arg->perf;
-
-					if (realmodel == NULL)
-					{
-						/* Erf, do without perfmodel, for execution there */
-						task->task.workerid = workerid;
-						task->task.execute_on_a_specific_worker = 1;
-						for (i = 0; i < narch ; i++)
-						{
-							if (i == comb)
-								perfTime[i] = endTime - startTime;
-							else
-								perfTime[i] = NAN;
-						}
-					}
-					else
-					{
-						int one = 0;
-						for (i = 0; i < narch ; i++)
-						{
-							arch = starpu_perfmodel_arch_comb_fetch(i);
-							perfTime[i] = starpu_perfmodel_history_based_expected_perf(&realmodel->perfmodel, arch, footprint);
-							if (!(perfTime[i] == 0 || isnan(perfTime[i])))
-								one = 1;
-						}
-						if (!one)
-						{
-							fprintf(stderr, "We do not have any performance measurement for symbol '%s' for footprint %x, we can not execute this", model, footprint);
-							exit(EXIT_FAILURE);
-						}
-					}
-
-					task->task.cl_arg = arg;
-					task->task.flops = flops;
-					total_flops += flops;
-				}
+				STARPU_ASSERT(rec->submit_order >= last_submitorder + 1);
 
-				task->task.cl_arg_size = 0;
-				task->task.tag_id = tag;
-				task->task.use_tag = 1;
-
-				task->ndependson = ndependson;
-				if (ndependson > 0)
+				while (rec->submit_order > last_submitorder + 1)
 				{
-					_STARPU_MALLOC(task->deps, ndependson * sizeof (* task->deps));
-					ARRAY_DUP(dependson, task->deps, ndependson);
+					/* Oops, some tasks were not submitted by original application, fake some */
+					struct starpu_task *fake_task = starpu_task_create();
+					int ret;
+					fake_task->cl = NULL;
+					fake_task->name = "fake task for submit order";
+					ret = starpu_task_submit(fake_task);
+					STARPU_ASSERT(ret == 0);
+					last_submitorder++;
 				}
 			}
 
-			else
+			if (rec->ndependson > 0)
 			{
-				STARPU_ASSERT(nb_parameters == 1);
-				task->reg_signal = reg_signal[0];
-				ARRAY_DUP(handles_ptr, task->task.handles, nb_parameters);
-			}
+				struct starpu_task * taskdeps[rec->ndependson];
+				size_t i;
 
-			/* Add this task to task hash */
-			HASH_ADD(hh, tasks, jobid, sizeof(jobid), task);
+				for (i = 0; i < rec->ndependson; i++)
+					taskdeps[i] = &tasks[rec->deps[i]];
 
-			nread_tasks++;
-			if (!(nread_tasks % 1000))
-			{
-				fprintf(stderr, "\rRead task %lu...", nread_tasks);
-				fflush(stdout);
+				starpu_task_declare_deps_array(task, rec->ndependson, taskdeps);
 			}
 
-			reset();
-		}
+			if (!(rec->iteration == -1))
+				starpu_iteration_push(rec->iteration);
 
-		/* Record various information */
-#define TEST(field) (!strncmp(s, field": ", strlen(field) + 2))
+			applySchedRec(task, rec->submit_order);
+			if (rec->submit_order == -1)
+				task->no_submitorder = 1;
+			int ret_val = starpu_task_submit(task);
 
-		else if(TEST("Control"))
-		{
-			char * c = s+9;
+			if (!(rec->iteration == -1))
+				starpu_iteration_pop();
 
-			if(!strncmp(c, "WontUse", 7))
+			if (ret_val != 0)
 			{
-				control = WontUseTask;
-				nb_parameters = 1;
-				alloc_mode = set_alloc_mode(nb_parameters);
-				arrays_managing(alloc_mode);
+				fprintf(stderr, "\nWhile submitting task %ld (%s): return %d\n",
+						rec->submit_order,
+						task->name? task->name : "unknown",
+						ret_val);
+				return -1;
 			}
-			else
-				control = NormalTask;
-		}
-		else if (TEST("Name"))
-		{
-			*ln = 0;
-			name = strdup(s+6);
-		}
-		else if (TEST("Model"))
-		{
-			*ln = 0;
-			model = strdup(s+7);
-		}
-		else if (TEST("JobId"))
-			jobid = atol(s+7);
-		else if(TEST("SubmitOrder"))
-			submitorder = atoi(s+13);
-		else if (TEST("DependsOn"))
-		{
-			char *c = s + 11;
 
-			for (ndependson = 0; *c != '\n'; ndependson++)
+			if (!(rec->submit_order % 1000))
 			{
-				if (ndependson >= dependson_size)
-				{
-					dependson_size *= 2;
-					_STARPU_REALLOC(dependson, dependson_size * sizeof(*dependson));
-				}
-				dependson[ndependson] = strtol(c, &c, 10);
+				fprintf(stderr, "\rSubmitted task order %ld...", rec->submit_order);
+				fflush(stdout);
 			}
+			if (rec->submit_order != -1)
+				last_submitorder++;
 		}
-		else if (TEST("Tag"))
-		{
-			tag = strtol(s+5, NULL, 16);
-		}
-		else if (TEST("WorkerId"))
-		{
-			workerid = atoi(s+10);
-		}
-		else if (TEST("Footprint"))
-		{
-			footprint = strtoul(s+11, NULL, 16);
-		}
-		else if (TEST("Parameters"))
-		{
-			/* Nothing to do */
-		}
-		else if (TEST("Handles"))
+
+		else
 		{
-			*ln = 0;
-			char *buffer = s + 9;
-			const char *delim = " ";
-			unsigned nb_parameters_line = count_number_tokens(buffer, delim);
+			struct handle *handle_tmp = NULL;
 
-			if(nb_parameters == 0)
-			{
-				nb_parameters = nb_parameters_line;
-				arrays_managing(set_alloc_mode(nb_parameters));
-			}
-			else
-				STARPU_ASSERT(nb_parameters == nb_parameters_line);
+			/* Look the application pointer up, it may have been registered by any task */
+			if (rec->handles)
+				HASH_FIND(hh, handles_hash, &rec->handles[0], sizeof(rec->handles[0]), handle_tmp);
 
-			char* token = strtok(buffer, delim);
-			for (i = 0 ; i < nb_parameters ; i++)
+			/* Otherwise this data wasn't actually used, don't care about it */
+			if (handle_tmp)
 			{
-				STARPU_ASSERT(token);
-				struct handle *handles_cell; /* A cell of the hash table for the handles */
-				starpu_data_handle_t  handle_value = (starpu_data_handle_t) strtol(token, NULL, 16); /* Get the ith handle on the line (in the file) */
-
-				HASH_FIND(hh, handles_hash, &handle_value, sizeof(handle_value), handles_cell); /* Find if the handle_value was already registered as a key in the hash table */
-
-				/* If it wasn't, then add it to the hash table */
-				if (handles_cell == NULL)
-				{
-					/* Hide the initial handle from the file into the handles array to find it when necessary */
-					handles_ptr[i] = handle_value;
-					reg_signal[i] = 1;
-				}
-				else
-				{
-					handles_ptr[i] = handles_cell->mem_ptr;
-					reg_signal[i] = 0;
-				}
-
-				token = strtok(NULL, delim);
+				starpu_data_wont_use(handle_tmp->mem_ptr);
+				last_submitorder++;
 			}
 		}
-		else if (TEST("Modes"))
-		{
-			*ln = 0;
-			char * buffer = s + 7;
-			unsigned mode_i = 0;
-			const char * delim = " ";
-			unsigned nb_parameters_line = count_number_tokens(buffer, delim);
-
-			if(nb_parameters == 0)
-			{
-				nb_parameters = nb_parameters_line;
-				arrays_managing(set_alloc_mode(nb_parameters));
-			}
-			else
-				STARPU_ASSERT(nb_parameters == nb_parameters_line);
+	}
 
-			char* token = strtok(buffer, delim);
+	return 1;
+}
 
-			while (token != NULL && mode_i < nb_parameters)
-			{
-				/* Subject to the names of starpu modes enumerator are not modified */
-				if (!strncmp(token, "RW", 2))
-				{
-					*(modes_ptr+mode_i) = STARPU_RW;
-					mode_i++;
-				}
-				else if (!strncmp(token, "R", 1))
-				{
-					*(modes_ptr+mode_i) = STARPU_R;
-					mode_i++;
-				}
-				else if (!strncmp(token, "W", 1))
-				{
-					*(modes_ptr+mode_i) = STARPU_W;
-					mode_i++;
-				}
-				/* Other cases produce a warning*/
-				else
-				{
-					fprintf(stderr, "[Warning] A mode is different from R/W (jobid task : %lu)", jobid);
-				}
-				token = strtok(NULL, delim);
-			}
-		}
-		else if (TEST("Sizes"))
-		{
-			*ln = 0;
-			char *  buffer = s + 7;
-			const char * delim = " ";
-			unsigned nb_parameters_line = count_number_tokens(buffer, delim);
-			unsigned k = 0;
+/* Replay the whole task graph with scheduler sched (or the default one if NULL) */
+static int replay(const char *sched)
+{
+	size_t n;
+	int ret;
 
-			if(nb_parameters == 0)
-			{
-				nb_parameters = nb_parameters_line;
-				arrays_managing(set_alloc_mode(nb_parameters));
-			}
-			else
-				STARPU_ASSERT(nb_parameters == nb_parameters_line);
+	if (sched)
+		setenv("STARPU_SCHED", sched, 1);
 
-			_STARPU_MALLOC(sizes_set, nb_parameters * sizeof(size_t));
+	ret = starpu_init(NULL);
+	if (ret == -ENODEV)
+		return 77;
+	STARPU_CHECK_RETURN_VALUE(ret, "starpu_init");
 
-			char * token = strtok(buffer, delim);
-			while (token != NULL && k < nb_parameters)
-			{
-				sizes_set[k] = strtol(token, NULL, 10);
-				token = strtok(NULL, delim);
+	nexecuted_tasks = 0;
+	total_flops = 0.;
+	double start = starpu_timing_now();
 
-				k++;
-			}
-		}
-		else if (TEST("StartTime"))
-		{
-			startTime = strtod(s+11, NULL);
-		}
-		else if (TEST("EndTime"))
-		{
-			endTime = strtod(s+9, NULL);
-		}
-		else if (TEST("GFlop"))
-		{
-			flops = 1000000000 * strtod(s+7, NULL);
-		}
-		else if (TEST("Iteration"))
-		{
-			iteration = (unsigned) strtol(s+11, NULL, 10);
-		}
-		else if (TEST("Priority"))
-		{
-			priority = strtol(s + 10, NULL, 10);
-		}
-	}
+	_STARPU_CALLOC(tasks, nrecs, sizeof(*tasks));
+	for (n = 0; n < nrecs; n++)
+		build_task(&recs[n], &tasks[n]);
 
-eof:
+	ret = submit_tasks();
 
 	starpu_task_wait_for_all();
 	fprintf(stderr, " done.\n");
 
-	printf("%g ms", (starpu_timing_now() - start) / 1000.);
-	if (total_flops != 0.)
-		printf("\t%g GF/s", (total_flops / (starpu_timing_now() - start)) / 1000.);
-	printf("\n");
+	if (ret != -1)
+	{
+		if (sched)
+			printf("%s\t", sched);
+		printf("%g ms", (starpu_timing_now() - start) / 1000.);
+		if (total_flops != 0.)
+			printf("\t%g GF/s", (total_flops / (starpu_timing_now() - start)) / 1000.);
+		printf("\n");
+	}
 
 	/* FREE allocated memory */
 
-	free(dependson);
-	free(s);
-
-	/* End of FREE */
-
 	struct handle *handle=NULL, *handletmp=NULL;
 	HASH_ITER(hh, handles_hash, handle, handletmp)
 	{
@@ -1170,29 +1063,106 @@ eof:
 		free(model_s);
 	}
 
-	struct task *task=NULL, *tasktmp=NULL;
-	HASH_ITER(hh, tasks, task, tasktmp)
+	for (n = 0; n < nrecs; n++)
 	{
-		free(task->task.cl_arg);
-		free((char*)task->task.name);
+		free(tasks[n].cl_arg);
+		starpu_task_clean(&tasks[n]);
+	}
+	free(tasks);
+	tasks = NULL;
+
+	/* End of FREE */
+
+	starpu_shutdown();
+	return ret == -1 ? 77 : 0;
+}
+
+
+/* * * * * * * * * * * * * * * */
+/* * * * * * MAIN * * * * * * */
+/* * * * * * * * * * * * * * */
 
-		if (task->task.dyn_handles != NULL)
+static void usage(const char *program)
+{
+	fprintf(stderr,"Usage: %s [--static-workerid] [--parse-threads n] [--sched sched1[,sched2...]] tasks.rec [sched.rec]\n", program);
+	exit(EXIT_FAILURE);
+}
+
+int main(int argc, char **argv)
+{
+	const char *tasks_rec = NULL;
+	const char *sched_rec = NULL;
+	char *scheds = NULL;
+	unsigned nscheds = 0;
+	unsigned i;
+	long nthreads = sysconf(_SC_NPROCESSORS_ONLN);
+	int ret = 0;
+
+	/* FIXME: we do not support data with sequential consistency disabled */
+
+	for (i = 1; i < (unsigned) argc; i++)
+	{
+		if (!strcmp(argv[i], "--help") || !strcmp(argv[i], "-h"))
+		{
+			usage(argv[0]);
+		}
+		else if (!strcmp(argv[i], "--static-workerid"))
+		{
+			static_workerid = 1;
+		}
+		else if (!strcmp(argv[i], "--parse-threads"))
+		{
+			if (++i == (unsigned) argc)
+				usage(argv[0]);
+			nthreads = atol(argv[i]);
+		}
+		else if (!strcmp(argv[i], "--sched"))
 		{
-			free(task->task.dyn_handles);
-			free(task->task.dyn_modes);
+			char *c;
+			if (++i == (unsigned) argc)
+				usage(argv[0]);
+			scheds = strdup(argv[i]);
+			for (nscheds = 1, c = scheds; *c; c++)
+				if (*c == ',')
+					nscheds++;
 		}
+		else
+		{
+			if (!tasks_rec)
+				tasks_rec = argv[i];
+			else if (!sched_rec)
+				sched_rec = argv[i];
+			else
+				usage(argv[0]);
+		}
+	}
+
+	if (!tasks_rec)
+		usage(argv[0]);
 
-		HASH_DEL(tasks, task);
-		starpu_task_clean(&task->task);
-		free(task->deps);
-		starpu_rbtree_remove(&tree, &task->node);
-		free(task);
+	if (sched_rec && nscheds > 1)
+	{
+		fprintf(stderr, "A sched.rec file can not be used with several schedulers\n");
+		usage(argv[0]);
 	}
 
-	starpu_shutdown();
-	return 0;
+	if (sched_rec)
+		schedRecInit(sched_rec);
 
-enodev:
-	starpu_shutdown();
-	return 77;
+	load_tasks_rec(tasks_rec, nthreads < 1 ? 1 : nthreads);
+
+	if (!scheds)
+		ret = replay(NULL);
+	else
+	{
+		/* What-if mode: replay the same records with each scheduler */
+		char *saveptr;
+		char *sched;
+		for (sched = strtok_r(scheds, ",", &saveptr); sched && !ret; sched = strtok_r(NULL, ",", &saveptr))
+			ret = replay(sched);
+		free(scheds);
+	}
+
+	free_recs();
+	return ret;
 }